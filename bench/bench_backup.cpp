@@ -0,0 +1,1174 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+// Benchmarks do sistema de backup. Uso:
+//   ./bench_backup            executa todos
+//   ./bench_backup <nome>...  executa apenas os indicados
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "../include/armazem_chunks.hpp"
+#include "../include/backup.hpp"
+#include "../include/blake3.hpp"
+#include "../include/cache_diretorios.hpp"
+#include "../include/cifra.hpp"
+#include "../include/compressao.hpp"
+#include "../include/copia.hpp"
+#include "../include/delta.hpp"
+#include "../include/manifesto.hpp"
+#include "../include/metadados.hpp"
+#include "../include/percurso_arvore.hpp"
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
+#include "../include/relatorio.hpp"
+
+namespace fs = std::filesystem;
+
+/********************************************************************
+* Função: segundos_desde
+* Descrição
+* Tempo decorrido, em segundos, desde o instante informado.
+********************************************************************/
+
+static double segundos_desde(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+/********************************************************************
+* Função: gerar_manifesto
+* Descrição
+* Gera um Backup.parm sintético com 'linhas' caminhos relativos
+* espalhados por diretórios, se ele ainda não existir.
+********************************************************************/
+
+static fs::path gerar_manifesto(size_t linhas) {
+    fs::path caminho = fs::temp_directory_path() /
+        ("bench_backup_" + std::to_string(linhas) + ".parm");
+    if (fs::exists(caminho))
+        return caminho;
+    std::ofstream out(caminho, std::ios::binary);
+    char linha[96];
+    for (size_t i = 0; i < linhas; ++i) {
+        int n = snprintf(linha, sizeof(linha),
+            "projeto%03zu/modulo%02zu/arquivo_%08zu.txt\n",
+            i % 500, (i / 500) % 40, i);
+        out.write(linha, n);
+    }
+    return caminho;
+}
+
+/********************************************************************
+* Função: bench_manifesto
+* Descrição
+* Compara a leitura do Backup.parm com std::getline e com o
+* LeitorManifesto (mmap + busca vetorial) em cada núcleo disponível,
+* para manifestos de 1M e 10M linhas.
+********************************************************************/
+
+static void bench_manifesto() {
+    for (size_t linhas : {size_t(1000000), size_t(10000000)}) {
+        fs::path parm = gerar_manifesto(linhas);
+        double mb = fs::file_size(parm) / 1e6;
+        printf("manifesto %zu linhas (%.0f MB)\n", linhas, mb);
+
+        // Aquecimento do cache de páginas
+        {
+            std::ifstream in(parm, std::ios::binary);
+            std::vector<char> buf(1 << 20);
+            while (in.read(buf.data(), buf.size())) {}
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        size_t contadas = 0, bytes = 0;
+        std::ifstream in(parm);
+        for (std::string l; std::getline(in, l);) {
+            ++contadas;
+            bytes += l.size();
+        }
+        double tGetline = segundos_desde(t0);
+        printf("  %-12s %8.3f s  %8.0f MB/s  (%zu linhas)\n", "getline",
+               tGetline, mb / tGetline, contadas);
+
+        for (NucleoQuebras nucleo : {NucleoQuebras::ESCALAR,
+                                     NucleoQuebras::SSE2,
+                                     NucleoQuebras::AVX2}) {
+            t0 = std::chrono::steady_clock::now();
+            LeitorManifesto leitor(parm.string(), nucleo);
+            size_t contadasMapa = 0, bytesMapa = 0;
+            std::string_view l;
+            while (leitor.proxima_linha(&l)) {
+                ++contadasMapa;
+                bytesMapa += l.size();
+            }
+            double t = segundos_desde(t0);
+            printf("  %-12s %8.3f s  %8.0f MB/s  (%.1fx)%s\n",
+                   nome_nucleo(leitor.nucleo()), t, mb / t, tGetline / t,
+                   (contadasMapa != contadas || bytesMapa != bytes) ?
+                   "  DIVERGENTE" : "");
+        }
+    }
+}
+
+/********************************************************************
+* Função: bench_blake3
+* Descrição
+* Vazão do BLAKE3 sobre 256 MB em memória com cada núcleo vetorial
+* e com o pool de tarefas, e de blake3_arquivo lendo por read() e
+* por mmap um arquivo de 256 MB no cache de páginas.
+********************************************************************/
+
+static void bench_blake3() {
+    std::vector<uint8_t> dados(size_t(256) << 20);
+    for (size_t i = 0; i < dados.size(); ++i)
+        dados[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+    double mb = dados.size() / 1e6;
+    printf("blake3 %.0f MB\n", mb);
+
+    PoolTarefas pool;
+    struct Caso {
+        const char *nome;
+        NucleoBlake3 nucleo;
+        PoolTarefas *pool;
+    };
+    std::string referencia;
+    for (const Caso &c : {Caso{"portavel", NucleoBlake3::PORTAVEL, nullptr},
+                          Caso{"sse2", NucleoBlake3::SSE2, nullptr},
+                          Caso{"avx2", NucleoBlake3::AVX2, nullptr},
+                          Caso{"avx2+pool", NucleoBlake3::AVX2, &pool}}) {
+        auto t0 = std::chrono::steady_clock::now();
+        HasherBlake3 h(c.pool, c.nucleo);
+        h.atualizar(dados.data(), dados.size());
+        std::string hex = hex_digest(h.finalizar());
+        double t = segundos_desde(t0);
+        if (referencia.empty())
+            referencia = hex;
+        printf("  %-12s %8.3f s  %8.0f MB/s%s\n", c.nome, t, mb / t,
+               hex != referencia ? "  DIVERGENTE" : "");
+    }
+
+    fs::path arquivo = fs::temp_directory_path() / "bench_backup_blake3.bin";
+    std::ofstream(arquivo, std::ios::binary).write(
+        reinterpret_cast<const char *>(dados.data()), dados.size());
+    for (bool mmap : {false, true}) {
+        DigestBlake3 d;
+        blake3_arquivo(arquivo.string(), &d, &pool, mmap);  // aquecimento
+        auto t0 = std::chrono::steady_clock::now();
+        blake3_arquivo(arquivo.string(), &d, &pool, mmap);
+        double t = segundos_desde(t0);
+        printf("  %-12s %8.3f s  %8.0f MB/s%s\n",
+               mmap ? "arquivo-mmap" : "arquivo-read", t, mb / t,
+               hex_digest(d) != referencia ? "  DIVERGENTE" : "");
+    }
+    fs::remove(arquivo);
+}
+
+/********************************************************************
+* Função: bench_cdc
+* Descrição
+* Vazão do ChunkerFastCdc em uma thread (GB/s por núcleo) sobre
+* 512 MB aleatórios e taxa de deduplicação do ArmazemChunks para
+* duas versões de uma imagem de 256 MB que diferem em 64 blocos de
+* 4 KiB sobrescritos e 1 KiB inserido no início.
+********************************************************************/
+
+static void bench_cdc() {
+    std::vector<uint8_t> dados(size_t(512) << 20);
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < dados.size(); i += 8) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        std::memcpy(&dados[i], &x, 8);
+    }
+
+    ChunkerFastCdc chunker;
+    auto t0 = std::chrono::steady_clock::now();
+    size_t chunks = 0;
+    for (size_t pos = 0; pos < dados.size(); ++chunks)
+        pos += chunker.proximo_corte(dados.data() + pos, dados.size() - pos);
+    double t = segundos_desde(t0);
+    printf("cdc chunker %.0f MB: %8.3f s  %6.2f GB/s/núcleo  "
+           "(%zu chunks, média %.0f KiB)\n", dados.size() / 1e6, t,
+           dados.size() / 1e9 / t, chunks, dados.size() / 1024.0 / chunks);
+
+    fs::path dir = fs::temp_directory_path() / "bench_backup_cdc";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "armazem");
+    fs::path imagem = dir / "imagem.img";
+    dados.resize(size_t(256) << 20);
+    ArmazemChunks armazem((dir / "armazem").string());
+    EstatisticasArmazem antes;
+    for (int versao = 1; versao <= 2; ++versao) {
+        if (versao == 2) {
+            for (int k = 0; k < 64; ++k)
+                std::memset(&dados[(k * 7919 % 65536) * size_t(4096)],
+                            k, 4096);
+            dados.insert(dados.begin(), 1024, 0xAB);
+        }
+        std::ofstream(imagem, std::ios::binary).write(
+            reinterpret_cast<const char *>(dados.data()), dados.size());
+        t0 = std::chrono::steady_clock::now();
+        armazem.armazenar(imagem.string(), "imagem.img");
+        t = segundos_desde(t0);
+        EstatisticasArmazem e = armazem.estatisticas();
+        uint64_t logicos = e.bytesLogicos - antes.bytesLogicos;
+        uint64_t gravados = e.bytesGravados - antes.bytesGravados;
+        printf("  versão %d: %.0f MB lidos, %.2f MB gravados "
+               "(%llu chunks novos, %llu reaproveitados), %.3f s\n",
+               versao, logicos / 1e6, gravados / 1e6,
+               static_cast<unsigned long long>(  // NOLINT(runtime/int)
+                   e.chunksNovos - antes.chunksNovos),
+               static_cast<unsigned long long>(  // NOLINT(runtime/int)
+                   e.chunksReaproveitados - antes.chunksReaproveitados),
+               t);
+        antes = e;
+    }
+    printf("  taxa de deduplicação: %.2fx (%.0f MB lógicos, %.0f MB "
+           "gravados)\n", double(antes.bytesLogicos) / antes.bytesGravados,
+           antes.bytesLogicos / 1e6, antes.bytesGravados / 1e6);
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_delta
+* Descrição
+* Atualiza a cópia de um arquivo de 256 MB que recebeu 1 MB no fim
+* (caso típico de logs e bancos que só crescem), com copiar_arquivo
+* e com copiar_delta, comparando tempo e bytes gravados.
+********************************************************************/
+
+static void bench_delta() {
+    std::string dados(size_t(256) << 20, '\0');
+    uint64_t x = 88172645463325252ULL;
+    for (size_t i = 0; i < dados.size(); i += 8) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        std::memcpy(&dados[i], &x, 8);
+    }
+    fs::path dir = fs::temp_directory_path() / "bench_backup_delta";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::path origem = dir / "origem.log", copia = dir / "copia.log";
+    std::ofstream(origem, std::ios::binary) << dados
+        << std::string(1 << 20, 'a');
+    printf("delta %.0f MB + 1 MB acrescentado\n", dados.size() / 1e6);
+
+    for (bool delta : {false, true}) {
+        std::ofstream(copia, std::ios::binary) << dados;
+        auto t0 = std::chrono::steady_clock::now();
+        ResultadoDelta r;
+        EstrategiaCopia e = delta ?
+            copiar_delta(origem.string(), copia.string(), &r) :
+            copiar_arquivo(origem.string(), copia.string());
+        double t = segundos_desde(t0);
+        double gravados = delta ? r.bytesEscritos / 1e6 :
+            fs::file_size(origem) / 1e6;
+        printf("  %-16s %8.3f s  %10.2f MB gravados\n",
+               nome_estrategia(e), t, gravados);
+    }
+    fs::remove_all(dir);
+}
+
+struct Benchmark {
+    const char *nome;
+    std::function<void()> executar;
+};
+
+/********************************************************************
+* Função: bench_relatorio
+* Descrição
+* Guarda o resultado de 5 milhões de linhas em um vetor de pares
+* <std::string, int> e em um RelatorioBackup, medindo o heap usado
+* (mallinfo2) e o tempo de uma contagem por ação sobre cada um.
+********************************************************************/
+
+static void bench_relatorio() {
+    const size_t n = 5000000;
+    char nome[96];
+    auto gerar = [&nome](size_t i) {
+        int k = snprintf(nome, sizeof(nome),
+            "projeto%03zu/modulo%02zu/arquivo_%08zu.txt",
+            i % 500, (i / 500) % 40, i);
+        return std::string_view(nome, k);
+    };
+    printf("relatorio %zu linhas\n", n);
+
+    size_t contagem[7] = {};
+    {
+        size_t antes = mallinfo2().uordblks;
+        std::vector<std::pair<std::string, int>> vetor;
+        for (size_t i = 0; i < n; ++i)
+            vetor.emplace_back(std::string(gerar(i)), 1 + i % 6);
+        size_t heap = mallinfo2().uordblks - antes;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto &par : vetor)
+            ++contagem[par.second];
+        printf("  %-16s %10.1f MB  contagem %8.2f ms\n", "vetor",
+               heap / 1e6, segundos_desde(t0) * 1e3);
+    }
+    {
+        size_t antes = mallinfo2().uordblks;
+        RelatorioBackup relatorio;
+        for (size_t i = 0; i < n; ++i)
+            relatorio.adicionar(gerar(i), 1 + i % 6);
+        size_t heap = mallinfo2().uordblks - antes;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint8_t a : relatorio.acoes())
+            --contagem[a];
+        printf("  %-16s %10.1f MB  contagem %8.2f ms\n", "relatorio",
+               heap / 1e6, segundos_desde(t0) * 1e3);
+    }
+    if (std::any_of(contagem, contagem + 7, [](size_t c) { return c; }))
+        printf("  contagens divergentes\n");
+}
+
+/********************************************************************
+* Função: gerar_arvore
+* Descrição
+* Cria (se ainda não existir) uma árvore com 100 mil arquivos vazios
+* em 300 diretórios a 8 níveis de profundidade e devolve os nomes
+* relativos deles.
+********************************************************************/
+
+static fs::path gerar_arvore(std::vector<std::string> *nomes) {
+    const size_t arquivos = 100000, diretorios = 300;
+    fs::path raiz = fs::temp_directory_path() / "bench_backup_diretorios";
+    nomes->clear();
+    for (size_t i = 0; i < arquivos; ++i) {
+        size_t d = i % diretorios;
+        nomes->push_back("nivel1/nivel2/nivel3/nivel4/nivel5/nivel6/g" +
+            std::to_string(d / 20) + "/d" + std::to_string(d) + "/f" +
+            std::to_string(i));
+    }
+    if (!fs::exists(raiz / nomes->back())) {
+        fs::remove_all(raiz);
+        for (const std::string &n : *nomes) {
+            fs::create_directories((raiz / n).parent_path());
+            std::ofstream(raiz / n);
+        }
+    }
+    return raiz;
+}
+
+/********************************************************************
+* Função: bench_diretorios
+* Descrição
+* Sonda os arquivos da árvore de gerar_arvore pelo caminho completo
+* (sondar_metadados) e relativo ao pai aberto (CacheDiretorios).
+********************************************************************/
+
+static void bench_diretorios() {
+    std::vector<std::string> nomes;
+    fs::path raiz = gerar_arvore(&nomes);
+    printf("diretorios %zu arquivos em 300 diretórios\n", nomes.size());
+
+    const std::string r = raiz.string();
+    size_t existentes = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (const std::string &n : nomes)
+        existentes += sondar_metadados((raiz / n).string()).existe;
+    printf("  %-16s %8.3f s\n", "caminho", segundos_desde(t0));
+
+    CacheDiretorios cache(1024);
+    t0 = std::chrono::steady_clock::now();
+    for (const std::string &n : nomes)
+        existentes -= cache.sondar(r, n).existe;
+    printf("  %-16s %8.3f s  %zu aberturas\n", "cache",
+           segundos_desde(t0), size_t(cache.estatisticas().aberturas));
+    if (existentes != 0)
+        printf("  resultados divergentes\n");
+}
+
+/********************************************************************
+* Função: bench_listagem
+* Descrição
+* Restauração a partir de um Pen vazio sobre a árvore de
+* gerar_arvore, com um Backup.parm que lista os 100 mil arquivos e
+* outros 100 mil ausentes nos mesmos diretórios: sondando cada linha
+* e com a listagem dos diretórios (enumerarDiretorios).
+********************************************************************/
+
+static void bench_listagem() {
+    std::vector<std::string> nomes;
+    fs::path hd = gerar_arvore(&nomes);
+    fs::path dir = fs::temp_directory_path() / "bench_backup_listagem";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "pen");
+    fs::create_directories(dir / "destino");
+    fs::path parm = dir / "Backup.parm";
+    {
+        std::ofstream out(parm);
+        for (const std::string &n : nomes)
+            out << n << "\n" << n << "_ausente\n";
+    }
+    printf("listagem %zu linhas, metade ausente no HD, Pen vazio\n",
+           2 * nomes.size());
+
+    for (bool enumerar : {false, true}) {
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.enumerarDiretorios = enumerar;
+        opcoes.cacheDiretorios = 1024;
+        opcoes.estatisticas = &est;
+        auto t0 = std::chrono::steady_clock::now();
+        executar_backup(parm.string(), hd.string(), (dir / "pen").string(),
+                        (dir / "destino").string(), false, opcoes);
+        printf("  %-16s %8.3f s  %8zu sondagens  %4zu listados\n",
+               enumerar ? "listagem" : "sondagens", segundos_desde(t0),
+               size_t(est.chamadasMetadados),
+               size_t(est.diretoriosListados));
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_expansao
+* Descrição
+* Restauração a partir de um Pen vazio sobre a árvore de
+* gerar_arvore: com um Backup.parm gerado antes por uma varredura
+* (recursive_directory_iterator, como um find) e com uma única linha
+* de diretório expandida pelo próprio backup.
+********************************************************************/
+
+static void bench_expansao() {
+    std::vector<std::string> nomes;
+    fs::path hd = gerar_arvore(&nomes);
+    fs::path dir = fs::temp_directory_path() / "bench_backup_expansao";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "pen");
+    fs::create_directories(dir / "destino");
+    printf("expansao %zu arquivos\n", nomes.size());
+
+    for (bool expandir : {false, true}) {
+        fs::path parm = dir / "Backup.parm";
+        auto t0 = std::chrono::steady_clock::now();
+        {
+            std::ofstream out(parm);
+            if (expandir) {
+                out << "nivel1/\n";
+            } else {
+                for (const auto &e : fs::recursive_directory_iterator(hd))
+                    if (e.is_regular_file())
+                        out << e.path().lexically_relative(hd).string()
+                            << "\n";
+            }
+        }
+        double varredura = segundos_desde(t0);
+        auto resultado = executar_backup(parm.string(), hd.string(),
+            (dir / "pen").string(), (dir / "destino").string(), false);
+        printf("  %-16s %8.3f s  (varredura %.3f s)  %zu linhas\n",
+               expandir ? "linha-diretorio" : "find + manifesto",
+               segundos_desde(t0), varredura, resultado.size());
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_percurso
+* Descrição
+* Percorre uma árvore sintética de 1 milhão de arquivos em 50 mil
+* diretórios (criada uma vez em /tmp) contando os arquivos: com
+* recursive_directory_iterator, com PercursoArvore e com
+* PercursoParalelo em pools de vários tamanhos. O cache de dentries
+* já está quente depois da primeira passada, que é descartada.
+********************************************************************/
+
+static void bench_percurso() {
+    const size_t grupos = 50, porGrupo = 1000, arquivosPorDiretorio = 20;
+    fs::path raiz = fs::temp_directory_path() / "bench_backup_percurso";
+    auto diretorio = [&](size_t g, size_t d) {
+        return raiz / ("g" + std::to_string(g)) / ("d" + std::to_string(d));
+    };
+    fs::path ultimo = diretorio(grupos - 1, porGrupo - 1) /
+        ("f" + std::to_string(arquivosPorDiretorio - 1));
+    if (!fs::exists(ultimo)) {
+        fs::remove_all(raiz);
+        for (size_t g = 0; g < grupos; ++g)
+            for (size_t d = 0; d < porGrupo; ++d) {
+                fs::create_directories(diretorio(g, d));
+                for (size_t f = 0; f < arquivosPorDiretorio; ++f) {
+                    std::string n = (diretorio(g, d) /
+                                     ("f" + std::to_string(f))).string();
+                    close(open(n.c_str(), O_CREAT | O_WRONLY, 0644));
+                }
+            }
+    }
+    const size_t esperado = grupos * porGrupo * arquivosPorDiretorio;
+    printf("percurso %zu arquivos em %zu diretórios\n", esperado,
+           grupos * (porGrupo + 1) + 1);
+
+    const std::string r = raiz.string();
+    auto relatar = [&](const std::string &nome, double s, size_t n) {
+        printf("  %-16s %8.3f s  %6.2f M arquivos/s%s\n", nome.c_str(), s,
+               n / s / 1e6, n == esperado ? "" : "  contagem divergente");
+    };
+    for (int passada = 0; passada < 2; ++passada) {
+        size_t n = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const auto &e : fs::recursive_directory_iterator(raiz))
+            n += e.is_regular_file();
+        if (passada == 1)
+            relatar("recursive_dir_it", segundos_desde(t0), n);
+    }
+
+    std::string nome;
+    size_t n = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    PercursoArvore sequencial(r, "");
+    while (sequencial.proximo(&nome))
+        ++n;
+    relatar("PercursoArvore", segundos_desde(t0), n);
+
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        PoolTarefas pool(threads);
+        n = 0;
+        t0 = std::chrono::steady_clock::now();
+        {
+            PercursoParalelo paralelo(&pool, 4096);
+            paralelo.iniciar(r, "");
+            while (paralelo.proximo(&nome))
+                ++n;
+        }
+        relatar("paralelo x" + std::to_string(threads),
+                segundos_desde(t0), n);
+    }
+}
+
+/********************************************************************
+* Função: bench_pipeline
+* Descrição
+* Backup de 20 mil arquivos de 16 KiB (metade já atualizada no Pen)
+* pelo pool de tarefas e pelo pipeline de estágios, com a utilização
+* e a ocupação das filas de cada estágio.
+********************************************************************/
+
+static void bench_pipeline() {
+    const size_t arquivos = 20000;
+    fs::path dir = fs::temp_directory_path() / "bench_backup_pipeline";
+    fs::remove_all(dir);
+    for (const char *d : {"hd", "pen", "destino"})
+        fs::create_directories(dir / d);
+    const std::string bloco(16 * 1024, 'p');
+    {
+        std::ofstream parm(dir / "Backup.parm");
+        for (size_t i = 0; i < arquivos; ++i) {
+            std::string n = "f" + std::to_string(i);
+            parm << n << "\n";
+            std::ofstream(dir / "hd" / n) << bloco;
+            if (i % 2 == 0)
+                fs::copy_file(dir / "hd" / n, dir / "pen" / n);
+        }
+    }
+    printf("pipeline %zu arquivos de 16 KiB, metade a copiar\n", arquivos);
+
+    for (bool pipeline : {false, true}) {
+        fs::remove_all(dir / "destino");
+        fs::create_directories(dir / "destino");
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.pipeline = pipeline;
+        opcoes.estatisticas = &est;
+        auto t0 = std::chrono::steady_clock::now();
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "hd").string(), (dir / "pen").string(),
+                        (dir / "destino").string(), true, opcoes);
+        printf("  %-16s %8.3f s\n", pipeline ? "pipeline" : "pool",
+               segundos_desde(t0));
+        if (!pipeline)
+            continue;
+        const char *nomes[3] = {"metadados", "decisao", "copia"};
+        for (size_t k = 0; k < 3; ++k) {
+            const EstatisticasEstagio &e = est.estagios[k];
+            printf("    %-10s x%u %6zu itens  utilizacao %5.1f%%  "
+                   "bloqueado %7.3f s  fila %.1f/%zu (pico %zu)\n",
+                   nomes[k], e.trabalhadores, size_t(e.itens),
+                   100 * e.utilizacao, e.bloqueadoNs / 1e9, e.filaMedia,
+                   size_t(e.capacidadeFila), size_t(e.filaPico));
+        }
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_escalonamento
+* Descrição
+* Backup de 4 arquivos de 256 MiB e 20 mil arquivos de 4 KiB pelo
+* pipeline, sem e com o escalonamento da cópia por tamanho (fila de
+* grandes com trabalhadores reservados e partes de 32 MiB).
+********************************************************************/
+
+static void bench_escalonamento() {
+    const size_t grandes = 4, pequenos = 20000;
+    fs::path dir = fs::temp_directory_path() / "bench_backup_escalonamento";
+    fs::remove_all(dir);
+    for (const char *d : {"hd", "pen", "destino"})
+        fs::create_directories(dir / d);
+    {
+        std::ofstream parm(dir / "Backup.parm");
+        std::string bloco(1 << 20, 'g');
+        for (size_t i = 0; i < grandes; ++i) {
+            std::string n = "grande" + std::to_string(i);
+            std::ofstream out(dir / "hd" / n, std::ios::binary);
+            for (int m = 0; m < 256; ++m)
+                out << bloco;
+            parm << n << "\n";
+        }
+        bloco.resize(4096);
+        for (size_t i = 0; i < pequenos; ++i) {
+            std::string n = "p" + std::to_string(i);
+            std::ofstream(dir / "hd" / n) << bloco;
+            parm << n << "\n";
+        }
+    }
+    printf("escalonamento %zu x 256 MiB + %zu x 4 KiB\n", grandes,
+           pequenos);
+
+    for (bool escalonar : {false, true}) {
+        fs::remove_all(dir / "destino");
+        fs::create_directories(dir / "destino");
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.pipeline = true;
+        opcoes.trabalhadoresCopia = 4;
+        if (escalonar) {
+            opcoes.trabalhadoresCopia = 2;
+            opcoes.trabalhadoresGrandes = 2;
+            opcoes.limiteArquivoGrande = 16 << 20;
+            opcoes.tamanhoParteCopia = 32 << 20;
+        }
+        opcoes.estatisticas = &est;
+        auto t0 = std::chrono::steady_clock::now();
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "hd").string(), (dir / "pen").string(),
+                        (dir / "destino").string(), true, opcoes);
+        printf("  %-16s %8.3f s  %zu grandes em %zu partes\n",
+               escalonar ? "por tamanho" : "fila unica", segundos_desde(t0),
+               size_t(est.copiasGrandes), size_t(est.partesCopia));
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_copia_paralela
+* Descrição
+* Cópia de um arquivo de 1 GiB em um único fluxo (copiar_arquivo) e
+* em partes de 64 MiB por pools de vários tamanhos
+* (copiar_arquivo_em_partes), em GB/s.
+********************************************************************/
+
+static void bench_copia_paralela() {
+    const size_t mib = 1024;
+    fs::path dir = fs::temp_directory_path() / "bench_backup_copia";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    {
+        std::ofstream out(dir / "origem", std::ios::binary);
+        std::string bloco(1 << 20, '\0');
+        for (size_t m = 0; m < mib; ++m) {
+            for (size_t i = 0; i < bloco.size(); i += 4096)
+                bloco[i] = static_cast<char>(m + i);
+            out << bloco;
+        }
+    }
+    const std::string origem = (dir / "origem").string();
+    const std::string destino = (dir / "destino").string();
+    printf("copia_paralela %zu MiB\n", mib);
+
+    auto relatar = [&](const std::string &nome, double s, bool ok) {
+        printf("  %-16s %8.3f s  %6.2f GB/s%s\n", nome.c_str(), s,
+               mib * 1048576.0 / s / 1e9, ok ? "" : "  falhou");
+    };
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = copiar_arquivo(origem, destino) != COPIA_FALHOU;
+    relatar("fluxo unico", segundos_desde(t0), ok);
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        PoolTarefas pool(threads);
+        fs::remove(destino);
+        t0 = std::chrono::steady_clock::now();
+        ok = copiar_arquivo_em_partes(AT_FDCWD, origem.c_str(), AT_FDCWD,
+                                      destino.c_str(), &pool,
+                                      64 << 20) != COPIA_FALHOU;
+        relatar("partes x" + std::to_string(threads), segundos_desde(t0),
+                ok);
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_empacotamento
+* Descrição
+* Backup de 50 mil arquivos de 1 KiB para um destino vazio, com um
+* arquivo por origem e com empacotamento, e a restauração (A2) de
+* volta a partir de cada um.
+********************************************************************/
+
+static void bench_empacotamento() {
+    const size_t arquivos = 50000;
+    fs::path dir = fs::temp_directory_path() / "bench_backup_pacotes";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "hd");
+    {
+        std::ofstream parm(dir / "Backup.parm");
+        std::string bloco(1024, 'k');
+        for (size_t i = 0; i < arquivos; ++i) {
+            std::string n = "k" + std::to_string(i);
+            std::ofstream(dir / "hd" / n) << bloco;
+            parm << n << "\n";
+        }
+    }
+    printf("empacotamento %zu arquivos de 1 KiB\n", arquivos);
+
+    for (bool empacotar : {false, true}) {
+        fs::remove_all(dir / "pen");
+        fs::remove_all(dir / "restaurado");
+        fs::create_directories(dir / "pen");
+        fs::create_directories(dir / "restaurado");
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.empacotarAte = empacotar ? 64 * 1024 : 0;
+        opcoes.estatisticas = &est;
+        auto t0 = std::chrono::steady_clock::now();
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "hd").string(), (dir / "pen").string(),
+                        (dir / "pen").string(), true, opcoes);
+        double backup = segundos_desde(t0);
+        uint64_t empacotados = est.arquivosEmpacotados;
+        uint64_t pacotes = est.pacotesCriados;
+        t0 = std::chrono::steady_clock::now();
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "restaurado").string(),
+                        (dir / "pen").string(),
+                        (dir / "restaurado").string(), false, opcoes);
+        printf("  %-16s backup %7.3f s  restauracao %7.3f s  "
+               "%zu empacotados em %zu pacotes\n",
+               empacotar ? "pacotes" : "arquivo a arquivo", backup,
+               segundos_desde(t0), size_t(empacotados), size_t(pacotes));
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_compressao
+* Descrição
+* Backup de um arquivo de texto de 256 MiB e de um aleatório de 64
+* MiB para o destino, sem compressão e com zstd em vários níveis e
+* números de trabalhadores, com a taxa em MB/s de dados da origem e
+* os bytes gravados no destino.
+********************************************************************/
+
+static void bench_compressao() {
+    fs::path dir = fs::temp_directory_path() / "bench_backup_compressao";
+    fs::remove_all(dir);
+    for (const char *d : {"hd", "pen", "destino"})
+        fs::create_directories(dir / d);
+    {
+        std::ofstream texto(dir / "hd" / "texto", std::ios::binary);
+        std::string linhas;
+        for (uint64_t i = 0; i < (uint64_t(256) << 20);) {
+            linhas = std::to_string(i / 97) + " evento " +
+                std::to_string(i * 7919 % 100003) + " ok\n";
+            texto << linhas;
+            i += linhas.size();
+        }
+        std::string bloco(1 << 20, '\0');
+        uint32_t x = 1;
+        std::ofstream aleatorio(dir / "hd" / "aleatorio", std::ios::binary);
+        for (int m = 0; m < 64; ++m) {
+            for (char &c : bloco) {
+                x = x * 1664525 + 1013904223;
+                c = static_cast<char>(x >> 24);
+            }
+            aleatorio << bloco;
+        }
+        std::ofstream(dir / "Backup.parm") << "texto\naleatorio\n";
+    }
+    printf("compressao 256 MiB de texto + 64 MiB aleatorios%s\n",
+           zstd_disponivel() ? "" : " (sem libzstd)");
+
+    struct Caso {
+        const char *nome;
+        bool comprimir;
+        int nivel;
+        unsigned threads;
+    };
+    for (const Caso &c : {Caso{"sem compressao", false, 0, 0},
+                          Caso{"zstd 1 x1", true, 1, 1},
+                          Caso{"zstd 3 x1", true, 3, 1},
+                          Caso{"zstd 3 x4", true, 3, 4},
+                          Caso{"zstd 9 x4", true, 9, 4}}) {
+        fs::remove_all(dir / "destino");
+        fs::create_directories(dir / "destino");
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.comprimir = c.comprimir;
+        opcoes.nivelCompressao = c.nivel;
+        opcoes.threadsCompressao = c.threads;
+        opcoes.estatisticas = &est;
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "hd").string(), (dir / "pen").string(),
+                        (dir / "destino").string(), true, opcoes);
+        uint64_t gravados = 0;
+        for (const auto &e : fs::directory_iterator(dir / "destino"))
+            gravados += e.file_size();
+        printf("  %-16s %8.1f MB/s  %8.1f MiB gravados  "
+               "%zu comprimidos, %zu sem compressao\n", c.nome,
+               est.mbPorSegundo, gravados / 1048576.0,
+               size_t(est.arquivosComprimidos),
+               size_t(est.arquivosIncomprimiveis));
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_cifra
+* Descrição
+* Cópia de um arquivo de 512 MiB sem cifra e cifrada/decifrada com
+* AES-256-GCM e ChaCha20-Poly1305, em um fluxo e com pools de vários
+* tamanhos, comparadas a um memcpy do mesmo volume, em GB/s.
+********************************************************************/
+
+static void bench_cifra() {
+    const size_t mib = 512;
+    fs::path dir = fs::temp_directory_path() / "bench_backup_cifra";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    std::string bloco(1 << 20, '\0');
+    {
+        std::ofstream out(dir / "origem", std::ios::binary);
+        for (size_t m = 0; m < mib; ++m) {
+            for (size_t i = 0; i < bloco.size(); i += 64)
+                bloco[i] = static_cast<char>(m * 7 + i);
+            out << bloco;
+        }
+    }
+    const std::string origem = (dir / "origem").string();
+    const std::string cifrado = (dir / "cifrado").string();
+    const std::string destino = (dir / "destino").string();
+    const std::string chave(kTamanhoChaveCifra, 'k');
+    printf("cifra %zu MiB (preferido: %s)\n", mib,
+           algoritmo_preferido() == CIFRA_AES_256_GCM ? "aes-256-gcm" :
+           "chacha20-poly1305");
+
+    auto relatar = [&](const std::string &nome, double s, bool ok) {
+        printf("  %-28s %8.3f s  %6.2f GB/s%s\n", nome.c_str(), s,
+               mib * 1048576.0 / s / 1e9, ok ? "" : "  falhou");
+    };
+    std::string copia(bloco.size(), '\0');
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t m = 0; m < mib; ++m) {
+        bloco[m] = static_cast<char>(m);
+        std::memcpy(&copia[0], bloco.data(), bloco.size());
+    }
+    relatar("memcpy", segundos_desde(t0), copia[1] == bloco[1]);
+    t0 = std::chrono::steady_clock::now();
+    bool ok = copiar_arquivo(origem, destino) != COPIA_FALHOU;
+    relatar("copia sem cifra", segundos_desde(t0), ok);
+
+    struct Caso {
+        const char *nome;
+        AlgoritmoCifra algoritmo;
+    };
+    for (const Caso &c : {Caso{"aes-256-gcm", CIFRA_AES_256_GCM},
+                          Caso{"chacha20", CIFRA_CHACHA20_POLY1305}}) {
+        for (unsigned threads : {0u, 2u, 4u}) {
+            std::unique_ptr<PoolTarefas> pool;
+            if (threads > 0)
+                pool.reset(new PoolTarefas(threads));
+            std::string sufixo = threads ? " x" + std::to_string(threads) :
+                " fluxo";
+            t0 = std::chrono::steady_clock::now();
+            ok = cifrar_arquivo(origem, cifrado, chave, c.algoritmo,
+                                pool.get()) == COPIA_CIFRADA;
+            relatar(std::string("cifrar ") + c.nome + sufixo,
+                    segundos_desde(t0), ok);
+            t0 = std::chrono::steady_clock::now();
+            ok = decifrar_arquivo(cifrado, destino, chave, pool.get()) ==
+                COPIA_DECIFRADA;
+            relatar(std::string("decifrar ") + c.nome + sufixo,
+                    segundos_desde(t0), ok);
+        }
+    }
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_destinos
+* Descrição
+* Backup de 64 arquivos de 4 MiB para três destinos: três execuções
+* de executar_backup (cada arquivo lido três vezes) contra uma de
+* executar_backup_multiplo (lido uma vez). Antes de cada variante, o
+* cache de páginas dos arquivos do HD é descartado (fadvise), para
+* que as leituras venham do disco.
+********************************************************************/
+
+static void bench_destinos() {
+    fs::path dir = fs::temp_directory_path() / "bench_backup_destinos";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "hd");
+    const int kArquivos = 64;
+    {
+        std::string bloco(4 << 20, '\0');
+        uint32_t x = 7;
+        std::ofstream parm(dir / "Backup.parm");
+        for (int i = 0; i < kArquivos; ++i) {
+            for (char &c : bloco) {
+                x = x * 1664525 + 1013904223;
+                c = static_cast<char>(x >> 24);
+            }
+            std::string nome = "arquivo" + std::to_string(i);
+            std::ofstream(dir / "hd" / nome, std::ios::binary) << bloco;
+            parm << nome << '\n';
+        }
+    }
+    auto descartar_cache = [&dir] {
+        for (const auto &e : fs::directory_iterator(dir / "hd")) {
+            int fd = open(e.path().c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                continue;
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    };
+    std::vector<DestinoBackup> destinos;
+    for (const char *d : {"pen1", "pen2", "pen3"})
+        destinos.push_back({(dir / d).string(), (dir / d).string()});
+    auto recriar_destinos = [&destinos] {
+        for (const DestinoBackup &d : destinos) {
+            fs::remove_all(d.dirPen);
+            fs::create_directories(d.dirPen);
+        }
+    };
+    printf("destinos %d arquivos de 4 MiB para %zu destinos\n", kArquivos,
+           destinos.size());
+
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.estatisticas = &est;
+    recriar_destinos();
+    descartar_cache();
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t lidos = 0;
+    for (const DestinoBackup &d : destinos) {
+        executar_backup((dir / "Backup.parm").string(),
+                        (dir / "hd").string(), d.dirPen, d.dirDestino, true,
+                        opcoes);
+        lidos += est.bytesCopiados;
+    }
+    double t = segundos_desde(t0);
+    printf("  %-24s %8.3f s  %8.1f MiB lidos do HD\n",
+           "uma execucao por destino", t, lidos / 1048576.0);
+
+    recriar_destinos();
+    descartar_cache();
+    t0 = std::chrono::steady_clock::now();
+    executar_backup_multiplo((dir / "Backup.parm").string(),
+                             (dir / "hd").string(), destinos, opcoes);
+    t = segundos_desde(t0);
+    printf("  %-24s %8.3f s  %8.1f MiB lidos do HD, %.1f MiB gravados\n",
+           "multiplo", t, est.bytesCopiados / 1048576.0,
+           est.bytesGravadosDestinos / 1048576.0);
+    fs::remove_all(dir);
+}
+
+/********************************************************************
+* Função: bench_buffers
+* Descrição
+* Custo de obter e devolver um buffer de 2 MiB por "arquivo" (com uma
+* escrita em cada página, como faria a cópia), alocando com new a
+* cada vez ou pelo PoolBuffers, com 1 e 4 threads; para o pool, a
+* taxa de acerto, o pico de uso e os blocos em páginas enormes.
+********************************************************************/
+
+static void bench_buffers() {
+    const size_t kTamanho = 2 << 20;
+    const int kPorThread = 2000;
+    printf("buffers %d pedidos de 2 MiB por thread\n", kPorThread);
+    // volatile: senão as escritas em um buffer liberado logo em seguida
+    // podem ser eliminadas pelo compilador
+    auto tocar = [](char *p, size_t n) {
+        volatile char *v = p;
+        for (size_t i = 0; i < n; i += 4096)
+            v[i] = static_cast<char>(i);
+    };
+    for (unsigned numThreads : {1u, 4u}) {
+        auto medir = [numThreads](const std::function<void()> &corpo) {
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<std::thread> threads;
+            for (unsigned t = 0; t < numThreads; ++t)
+                threads.emplace_back(corpo);
+            for (auto &t : threads)
+                t.join();
+            return segundos_desde(t0) * 1e9 / (kPorThread * numThreads);
+        };
+        double tNew = medir([&tocar, kTamanho] {
+            for (int i = 0; i < kPorThread; ++i) {
+                std::unique_ptr<char[]> b(new char[kTamanho]);
+                tocar(b.get(), kTamanho);
+            }
+        });
+        PoolBuffers pool(kTamanho, size_t(64) << 20);
+        double tPool = medir([&tocar, &pool] {
+            for (int i = 0; i < kPorThread; ++i) {
+                BlocoBuffer b = pool.obter();
+                tocar(b.dados(), b.tamanho());
+            }
+        });
+        EstatisticasBuffers e = pool.estatisticas();
+        printf("  %u thread(s): new %8.0f ns  pool %8.0f ns  acerto %.3f  "
+               "pico %.0f MiB  %zu/%zu blocos em paginas enormes\n",
+               numThreads, tNew, tPool, e.taxaAcerto,
+               e.picoBytesEmUso / 1048576.0,
+               size_t(e.blocosPaginasEnormes), size_t(e.blocosReservados));
+    }
+}
+
+/********************************************************************
+* Função: mib_no_cache
+* Descrição
+* MiB de um arquivo presentes no cache de páginas (mincore).
+********************************************************************/
+
+static double mib_no_cache(const fs::path &p) {
+    int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    size_t tamanho = fs::file_size(p);
+    size_t pagina = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t paginas = 0;
+    void *m = tamanho ? mmap(nullptr, tamanho, PROT_READ, MAP_SHARED, fd, 0) :
+        MAP_FAILED;
+    if (m != MAP_FAILED) {
+        std::vector<unsigned char> v((tamanho + pagina - 1) / pagina);
+        if (mincore(m, tamanho, v.data()) == 0) {
+            for (unsigned char c : v)
+                paginas += c & 1;
+        }
+        munmap(m, tamanho);
+    }
+    close(fd);
+    return paginas * pagina / 1048576.0;
+}
+
+// "Cached:" de /proc/meminfo, em MiB.
+static double mib_cache_sistema() {
+    std::ifstream in("/proc/meminfo");
+    std::string chave;
+    uint64_t kib = 0;
+    while (in >> chave) {
+        if (chave == "Cached:" && in >> kib)
+            return kib / 1024.0;
+        in.ignore(256, '\n');
+    }
+    return 0;
+}
+
+/********************************************************************
+* Função: bench_sem_cache
+* Descrição
+* Cópia de um arquivo de 512 MiB (+ um resto que não completa um
+* setor) pela cadeia comum (copiar_arquivo) e sem cache de páginas
+* (copiar_arquivo_direto), partindo da origem fora do cache: vazão em
+* MB/s e quanto da origem, do destino e do cache do sistema ficou
+* ocupado depois de cada uma. Roda no diretório corrente, porque o
+* temporário pode ser um tmpfs, que não aceita O_DIRECT.
+********************************************************************/
+
+static void bench_sem_cache() {
+    fs::path dir = fs::current_path() / "bench_backup_sem_cache";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const size_t kTamanho = (size_t(512) << 20) + 123;
+    fs::path origem = dir / "origem", destino = dir / "destino";
+    {
+        std::string bloco(1 << 20, '\0');
+        uint32_t x = 3;
+        std::ofstream out(origem, std::ios::binary);
+        for (size_t escritos = 0; escritos < kTamanho;) {
+            for (char &c : bloco) {
+                x = x * 1664525 + 1013904223;
+                c = static_cast<char>(x >> 24);
+            }
+            size_t n = std::min(bloco.size(), kTamanho - escritos);
+            out.write(bloco.data(), n);
+            escritos += n;
+        }
+    }
+    printf("sem_cache 512 MiB em %s\n", dir.c_str());
+
+    struct Caso {
+        const char *nome;
+        EstrategiaCopia (*copiar)(const std::string &, const std::string &);
+    };
+    for (const Caso &c : {Caso{"copiar_arquivo", copiar_arquivo},
+                          Caso{"copiar_arquivo_direto",
+                               copiar_arquivo_direto}}) {
+        fs::remove(destino);
+        int fd = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        sync();
+        double cacheAntes = mib_cache_sistema();
+        double origemAntes = mib_no_cache(origem);
+        auto t0 = std::chrono::steady_clock::now();
+        EstrategiaCopia e = c.copiar(origem.string(), destino.string());
+        double t = segundos_desde(t0);
+        printf("  %-22s %-16s %8.1f MB/s  no cache: origem %.1f -> %.1f "
+               "MiB, destino %.1f MiB, sistema %+.1f MiB\n", c.nome,
+               nome_estrategia(e), kTamanho / t / 1e6, origemAntes,
+               mib_no_cache(origem), mib_no_cache(destino),
+               mib_cache_sistema() - cacheAntes);
+    }
+    fs::remove_all(dir);
+}
+
+int main(int argc, char **argv) {
+    const std::vector<Benchmark> benchmarks = {
+        {"manifesto", bench_manifesto},
+        {"blake3", bench_blake3},
+        {"cdc", bench_cdc},
+        {"delta", bench_delta},
+        {"relatorio", bench_relatorio},
+        {"diretorios", bench_diretorios},
+        {"listagem", bench_listagem},
+        {"expansao", bench_expansao},
+        {"percurso", bench_percurso},
+        {"pipeline", bench_pipeline},
+        {"escalonamento", bench_escalonamento},
+        {"copia_paralela", bench_copia_paralela},
+        {"empacotamento", bench_empacotamento},
+        {"compressao", bench_compressao},
+        {"cifra", bench_cifra},
+        {"destinos", bench_destinos},
+        {"buffers", bench_buffers},
+        {"sem_cache", bench_sem_cache},
+    };
+
+    for (const Benchmark &b : benchmarks) {
+        bool pedido = argc == 1;
+        for (int i = 1; i < argc; ++i)
+            pedido = pedido || std::strcmp(argv[i], b.nome) == 0;
+        if (pedido)
+            b.executar();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_ANEL_IO_URING_HPP_
+#define INCLUDE_ANEL_IO_URING_HPP_
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "metadados.hpp"
+
+class AnelIoUring {
+ public:
+    explicit AnelIoUring(unsigned entradas);
+    ~AnelIoUring();
+
+    AnelIoUring(const AnelIoUring &) = delete;
+    AnelIoUring &operator=(const AnelIoUring &) = delete;
+
+    bool disponivel() const { return fd_ >= 0; }
+    unsigned capacidade() const { return sqEntradas_; }
+    uint64_t chamadasEnter() const { return chamadasEnter_; }
+
+    struct io_uring_sqe *obter_sqe();
+    int submeter(unsigned minCompletas);
+    unsigned descartar_nao_submetidas();
+    bool proxima_cqe(struct io_uring_cqe *cqe);
+
+ private:
+    bool suporta_operacoes();
+    void liberar();
+
+    int fd_ = -1;
+    unsigned sqEntradas_ = 0;
+    void *sqAnel_ = nullptr;
+    void *cqAnel_ = nullptr;
+    size_t sqTamanho_ = 0;
+    size_t cqTamanho_ = 0;
+    struct io_uring_sqe *sqes_ = nullptr;
+    unsigned *sqCabeca_ = nullptr;
+    unsigned *sqCauda_ = nullptr;
+    unsigned *sqMascara_ = nullptr;
+    unsigned *sqVetor_ = nullptr;
+    unsigned *cqCabeca_ = nullptr;
+    unsigned *cqCauda_ = nullptr;
+    unsigned *cqMascara_ = nullptr;
+    struct io_uring_cqe *cqes_ = nullptr;
+    unsigned caudaLocal_ = 0;
+    unsigned submetidas_ = 0;
+    uint64_t chamadasEnter_ = 0;
+};
+
+// Cópia pendente de um lote: origem, destino e metadados da origem.
+// Os caminhos são relativos aos diretórios indicados.
+struct CopiaLote {
+    std::string origem;
+    std::string destino;
+    Metadados meta;
+    int dirOrigem = AT_FDCWD;
+    int dirDestino = AT_FDCWD;
+};
+
+bool sondar_lote_io_uring(AnelIoUring *anel,
+                          const std::vector<std::string> &caminhos,
+                          std::vector<Metadados> *saida,
+                          const std::vector<int> *diretorios = nullptr);
+
+void copiar_lote_io_uring(AnelIoUring *anel,
+                          const std::vector<CopiaLote> &copias,
+                          std::vector<bool> *copiado);
+
+#endif  // INCLUDE_ANEL_IO_URING_HPP_
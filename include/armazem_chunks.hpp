@@ -0,0 +1,75 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_ARMAZEM_CHUNKS_HPP_
+#define INCLUDE_ARMAZEM_CHUNKS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_set>
+
+// Limites de tamanho dos chunks (FastCDC com normalização).
+struct ParametrosCdc {
+    size_t minimo = 16 << 10;
+    size_t medio = 64 << 10;
+    size_t maximo = 256 << 10;
+};
+
+class ChunkerFastCdc {
+ public:
+    explicit ChunkerFastCdc(const ParametrosCdc &parametros = ParametrosCdc());
+
+    const ParametrosCdc &parametros() const { return parametros_; }
+    // Tamanho do próximo chunk no início de dados (<= tamanho)
+    size_t proximo_corte(const uint8_t *dados, size_t tamanho) const;
+
+ private:
+    ParametrosCdc parametros_;
+    uint64_t mascaraPequena_;  // antes do tamanho médio: corte mais difícil
+    uint64_t mascaraGrande_;   // depois dele: corte mais fácil
+};
+
+struct EstatisticasArmazem {
+    uint64_t arquivos = 0;
+    uint64_t bytesLogicos = 0;    // tamanho dos arquivos armazenados
+    uint64_t bytesGravados = 0;   // bytes de chunks novos
+    uint64_t chunksNovos = 0;
+    uint64_t chunksReaproveitados = 0;
+};
+
+// Armazém endereçado por conteúdo em dirDestino: os chunks ficam em
+// .chunks/xx/<blake3> e cada arquivo vira uma receita em .receitas/<nome>.
+class ArmazemChunks {
+ public:
+    explicit ArmazemChunks(const std::string &dirDestino,
+                           const ParametrosCdc &parametros = ParametrosCdc());
+
+    ArmazemChunks(const ArmazemChunks &) = delete;
+    ArmazemChunks &operator=(const ArmazemChunks &) = delete;
+
+    bool armazenar(const std::string &origem, const std::string &nome);
+    bool restaurar(const std::string &nome, const std::string &destino) const;
+    EstatisticasArmazem estatisticas() const;
+
+ private:
+    std::string caminho_chunk(const std::string &hex) const;
+    bool gravar_chunk(const uint8_t *dados, size_t tamanho,
+                      const std::string &hex);
+
+    std::string dirChunks_;
+    std::string dirReceitas_;
+    ChunkerFastCdc chunker_;
+
+    std::mutex mtx_;
+    std::unordered_set<std::string> conhecidos_;  // chunks já presentes
+    std::atomic<uint64_t> temporarios_{0};
+    std::atomic<uint64_t> arquivos_{0};
+    std::atomic<uint64_t> bytesLogicos_{0};
+    std::atomic<uint64_t> bytesGravados_{0};
+    std::atomic<uint64_t> chunksNovos_{0};
+    std::atomic<uint64_t> chunksReaproveitados_{0};
+};
+
+#endif  // INCLUDE_ARMAZEM_CHUNKS_HPP_
@@ -3,9 +3,12 @@
 #ifndef INCLUDE_BACKUP_HPP_
 #define INCLUDE_BACKUP_HPP_
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <utility>
+#include "relatorio.hpp"
 
 enum Acao {
     A1_COPIAR_HD_PEN = 1,
@@ -16,6 +19,153 @@ enum Acao {
     A6_IMPOSSIVEL
 };
 
+// Ocupação de um estágio do pipeline (OpcoesBackup::pipeline).
+struct EstatisticasEstagio {
+    unsigned trabalhadores = 0;
+    uint64_t itens = 0;        // entradas tratadas pelo estágio
+    uint64_t ocupadoNs = 0;    // soma do tempo dos trabalhadores tratando
+    uint64_t bloqueadoNs = 0;  // esperando vaga na fila seguinte
+    double utilizacao = 0;     // ocupadoNs / (trabalhadores * duração)
+    double filaMedia = 0;      // ocupação média da fila de entrada
+    uint64_t filaPico = 0;
+    uint64_t capacidadeFila = 0;
+};
+
+struct EstatisticasBackup {
+    uint64_t entradas = 0;            // linhas processadas do Backup.parm
+    uint64_t chamadasMetadados = 0;   // chamadas statx/stat emitidas
+    uint64_t chamadasIoUring = 0;     // io_uring_enter (modo io_uring)
+    uint64_t sondagensPenEvitadas = 0;  // dispensadas pelo índice de estado
+    uint64_t arquivosHasheados = 0;   // digests calculados (verificação)
+    uint64_t bytesHasheados = 0;
+    uint64_t digestsReaproveitados = 0;  // vindos do índice de estado
+    uint64_t bytesDeduplicados = 0;   // tamanho dos arquivos no armazém
+    uint64_t bytesChunksGravados = 0;  // só os chunks novos
+    uint64_t chunksNovos = 0;
+    uint64_t chunksReaproveitados = 0;
+    uint64_t bytesDeltaEscritos = 0;   // cópias A1 em modo delta
+    uint64_t bytesDeltaReaproveitados = 0;
+    uint64_t diretoriosAbertos = 0;   // openat de diretórios pelo cache
+    uint64_t acertosCacheDiretorios = 0;
+    uint64_t diretoriosListados = 0;  // lidos com getdents64
+    uint64_t sondagensEvitadasListagem = 0;  // ausentes pela listagem
+    uint64_t arquivosExpandidos = 0;  // vindos de linhas-padrão
+    uint64_t diretoriosPercorridos = 0;  // na expansão delas
+    bool manifestoCompiladoUsado = false;
+    // Estágios do pipeline: 0 = metadados, 1 = decisão, 2 = cópia
+    EstatisticasEstagio estagios[3];
+    uint64_t copiasGrandes = 0;  // copiados em partes (grandes)
+    uint64_t partesCopia = 0;    // intervalos copiados deles
+    uint64_t arquivosEmpacotados = 0;  // A1 anexados a pacotes
+    uint64_t bytesEmpacotados = 0;
+    uint64_t pacotesCriados = 0;
+    uint64_t bytesPacotesLiberados = 0;  // por compactar_pacotes
+    uint64_t arquivosDesempacotados = 0;  // A2 extraídos de pacotes
+    uint64_t arquivosComprimidos = 0;
+    uint64_t arquivosIncomprimiveis = 0;  // copiados sem compressão
+    uint64_t bytesOrigemComprimidos = 0;  // antes da compressão
+    uint64_t bytesComprimidosGravados = 0;
+    uint64_t arquivosDescomprimidos = 0;  // A2 de arquivos comprimidos
+    uint64_t arquivosCifrados = 0;
+    uint64_t bytesCifrados = 0;  // tamanho original dos cifrados
+    uint64_t arquivosDecifrados = 0;  // A2 de arquivos cifrados
+    uint64_t bytesCopiados = 0;  // lidos da origem nas cópias
+    uint64_t duracaoNs = 0;      // da execução inteira
+    double mbPorSegundo = 0;     // bytesCopiados / duração, em MB/s
+    // executar_backup_multiplo: soma do que foi gravado em cada destino
+    // (bytesCopiados conta cada arquivo lido uma vez só)
+    uint64_t bytesGravadosDestinos = 0;
+    // Buffers de PoolBuffers::global() pedidos durante a execução (cópia
+    // comum, hash, compressão e cifra)
+    uint64_t pedidosBuffers = 0;
+    uint64_t acertosBuffers = 0;   // blocos reaproveitados
+    uint64_t esperasBuffers = 0;   // esperaram no limite de memória
+    uint64_t picoBytesBuffers = 0;
+    double taxaAcertoBuffers = 0;  // acertosBuffers / pedidosBuffers
+    // <nome do arquivo, EstrategiaCopia> de cada cópia feita, na ordem
+    // em que terminaram (em executar_backup_multiplo, destino a destino)
+    std::vector<std::pair<std::string, int>> estrategias;
+};
+
+struct OpcoesBackup {
+    unsigned numThreads = 0;  // 0 = um trabalhador por núcleo
+    EstatisticasBackup *estatisticas = nullptr;  // preenchido se != nullptr
+    bool usarIoUring = false;  // lotes via io_uring, se o kernel suportar
+    // Manifesto gerado por compilar_manifesto; ignorado se desatualizado
+    std::string manifestoCompilado;
+    // Índice persistente em dirDestino com o estado da última execução
+    bool usarIndiceEstado = false;
+    // Compara o conteúdo (BLAKE3) quando os dois lados existem, em vez de
+    // decidir só pelas datas; os digests ficam no índice de estado (o de
+    // um arquivo comprimido ou cifrado é o do conteúdo original)
+    bool verificarConteudo = false;
+    bool verificacaoMmap = false;  // lê os arquivos por mmap ao calcular
+    // A1 grava chunks FastCDC e uma receita por arquivo em dirDestino,
+    // em vez de uma cópia inteira (ver ArmazemChunks)
+    bool deduplicar = false;
+    // A1 sobre um destino existente regrava só os blocos alterados
+    // (estilo rsync, ver copiar_delta)
+    bool copiaDelta = false;
+    // Quantos diretórios manter abertos (LRU) para sondar e copiar os
+    // arquivos relativos ao pai já aberto (openat/statx); 0 = desligado
+    size_t cacheDiretorios = 0;
+    // Agrupa as linhas pelo diretório pai e lê de uma vez os diretórios
+    // com poucas entradas além das listadas, dispensando a sondagem das
+    // que não existem
+    bool enumerarDiretorios = false;
+    // Trabalhadores dedicados a percorrer as árvores das linhas-padrão em
+    // paralelo (um diretório por tarefa); os arquivos expandidos saem em
+    // ordem não determinística. 0 = percurso sequencial, em ordem
+    unsigned threadsPercurso = 0;
+    // Processa as janelas em um pipeline de três estágios (metadados,
+    // decisão e cópia), cada um com seus trabalhadores e ligados por
+    // filas limitadas; tem precedência sobre numThreads e usarIoUring
+    bool pipeline = false;
+    unsigned trabalhadoresMetadados = 4;
+    unsigned trabalhadoresDecisao = 1;
+    unsigned trabalhadoresCopia = 2;
+    size_t capacidadeFilaPipeline = 1024;  // por fila entre estágios
+    // Escalonamento da cópia do pipeline por tamanho: arquivos a partir
+    // de limiteArquivoGrande bytes vão para uma fila própria, atendida
+    // por trabalhadoresGrandes trabalhadores reservados (os
+    // trabalhadoresCopia ficam com os pequenos, e quem está sem trabalho
+    // ajuda a outra fila), e são copiados em partes de tamanhoParteCopia
+    // bytes por vários trabalhadores ao mesmo tempo. Fora do pipeline,
+    // com o pool, os arquivos grandes são copiados em partes por um
+    // segundo pool, do mesmo tamanho. A cópia vai para um temporário
+    // pré-alocado, renomeado sobre o destino no fim. 0 = desligado
+    uint64_t limiteArquivoGrande = 0;
+    unsigned trabalhadoresGrandes = 1;
+    uint64_t tamanhoParteCopia = uint64_t(64) << 20;
+    // A1 de arquivos com até empacotarAte bytes são anexados a pacotes
+    // em dirDestino/.pacotes (ver EscritorPacotes) em vez de gerarem um
+    // arquivo cada; quando dirPen tem pacotes, os arquivos que só estão
+    // neles contam como presentes no Pen e A2 os extrai. 0 = desligado
+    uint64_t empacotarAte = 0;
+    // A1 grava os arquivos comprimidos (zstd, ver comprimir_arquivo), com
+    // o mesmo nome; os que quase não comprimem vão sem compressão. A2
+    // descomprime os arquivos comprimidos do Pen, com ou sem esta opção
+    bool comprimir = false;
+    int nivelCompressao = 3;
+    // Trabalhadores do zstd nos arquivos grandes; 0 = os núcleos divididos
+    // entre as cópias que podem comprimir ao mesmo tempo (1 no pool
+    // padrão)
+    unsigned threadsCompressao = 0;
+    // Com 32 bytes, A1 grava os arquivos cifrados com AEAD (AES-256-GCM,
+    // ou ChaCha20-Poly1305 sem AES-NI) em blocos independentes durante a
+    // própria cópia (ver cifrar_arquivo), com precedência sobre
+    // empacotamento, deduplicação, delta e compressão, que gravariam em
+    // claro; A2 decifra os arquivos cifrados do Pen com ela. Vazia = sem
+    // cifra
+    std::string chaveCifra;
+    // As cópias comuns não passam pelo cache de páginas (ver
+    // copiar_arquivo_direto), para que um backup grande não tire do
+    // cache o que os outros processos usam; tem precedência sobre
+    // usarIoUring e a cópia em partes. Os modos especiais (cifra,
+    // compressão etc.) continuam pelo cache
+    bool semCachePaginas = false;
+};
+
 std::vector<std::pair<std::string, int>> executar_backup(
     const std::string &backupParm,
     const std::string &dirHD,
@@ -23,4 +173,50 @@ std::vector<std::pair<std::string, int>> executar_backup(
     const std::string &dirDestino,
     bool backupSolicitado);
 
+std::vector<std::pair<std::string, int>> executar_backup(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes);
+
+// Recebe <nome do arquivo, código da ação> de cada linha processada.
+using ReceptorResultado = std::function<void(const std::string &, int)>;
+
+void executar_backup(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes,
+    const ReceptorResultado &receptor);
+
+RelatorioBackup executar_backup_relatorio(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes,
+    bool detalhado = false);
+
+// Um destino de executar_backup_multiplo: o Pen comparado com o HD e o
+// diretório em que as cópias são gravadas (normalmente o próprio Pen).
+struct DestinoBackup {
+    std::string dirPen;
+    std::string dirDestino;
+};
+
+// Backup (HD → Pen) para vários destinos de uma vez: cada arquivo é lido
+// uma só vez e gravado em todos os destinos que precisam dele, com a
+// decisão (A1/A4/A5...) tomada para cada destino. Retorna os resultados
+// de cada destino, na ordem de destinos.
+std::vector<std::vector<std::pair<std::string, int>>>
+executar_backup_multiplo(const std::string &backupParm,
+                         const std::string &dirHD,
+                         const std::vector<DestinoBackup> &destinos,
+                         const OpcoesBackup &opcoes);
+
 #endif  // INCLUDE_BACKUP_HPP_
@@ -0,0 +1,56 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_BLAKE3_HPP_
+#define INCLUDE_BLAKE3_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class PoolTarefas;
+
+using DigestBlake3 = std::array<uint8_t, 32>;
+
+// Rotina usada para comprimir vários chunks de uma vez.
+enum class NucleoBlake3 {
+    AUTOMATICO,  // AVX2 ou SSE2 conforme a CPU; portável fora do x86-64
+    PORTAVEL,
+    SSE2,        // 4 chunks em paralelo
+    AVX2         // 8 chunks em paralelo
+};
+
+class HasherBlake3 {
+ public:
+    explicit HasherBlake3(PoolTarefas *pool = nullptr,
+                          NucleoBlake3 nucleo = NucleoBlake3::AUTOMATICO);
+
+    void atualizar(const void *dados, size_t tamanho);
+    DigestBlake3 finalizar() const;
+
+ private:
+    void atualizar_chunk(const uint8_t *dados, size_t tamanho);
+    void concluir_chunk();
+    void empilhar_cv(const uint32_t cv[8], uint64_t totalChunks);
+
+    PoolTarefas *pool_;
+    NucleoBlake3 nucleo_;
+
+    // Chunk corrente (até 1024 bytes)
+    uint32_t cvChunk_[8];
+    uint64_t chunksConcluidos_ = 0;
+    uint8_t bloco_[64] = {};
+    uint32_t tamanhoBloco_ = 0;
+    uint32_t blocosComprimidos_ = 0;
+
+    // Pilha de valores de encadeamento das subárvores completas
+    uint32_t pilha_[54][8];
+    size_t alturaPilha_ = 0;
+};
+
+std::string hex_digest(const DigestBlake3 &digest);
+
+bool blake3_arquivo(const std::string &caminho, DigestBlake3 *digest,
+                    PoolTarefas *pool = nullptr, bool usarMmap = false);
+
+#endif  // INCLUDE_BLAKE3_HPP_
@@ -0,0 +1,73 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_CACHE_DIRETORIOS_HPP_
+#define INCLUDE_CACHE_DIRETORIOS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "metadados.hpp"
+
+// Descritor de um diretório aberto (O_PATH), fechado na destruição.
+class DescritorDiretorio {
+ public:
+    explicit DescritorDiretorio(int fd) : fd_(fd) {}
+    ~DescritorDiretorio();
+
+    DescritorDiretorio(const DescritorDiretorio &) = delete;
+    DescritorDiretorio &operator=(const DescritorDiretorio &) = delete;
+
+    int fd() const { return fd_; }
+
+ private:
+    int fd_;
+};
+
+// Um diretório descartado do cache continua aberto enquanto houver
+// quem o use.
+using DiretorioAberto = std::shared_ptr<const DescritorDiretorio>;
+
+struct EstatisticasCacheDiretorios {
+    uint64_t acertos = 0;
+    uint64_t aberturas = 0;  // openat de diretórios
+    uint64_t descartes = 0;  // saídas pelo limite do LRU
+};
+
+// Diretórios abertos de uma ou mais raízes, com limite LRU. Arquivos são
+// consultados e abertos relativos ao descritor do diretório pai, sem
+// resolver o caminho inteiro a cada chamada. Seguro entre threads.
+class CacheDiretorios {
+ public:
+    explicit CacheDiretorios(size_t capacidade);
+
+    CacheDiretorios(const CacheDiretorios &) = delete;
+    CacheDiretorios &operator=(const CacheDiretorios &) = delete;
+
+    // Diretório 'raiz/relativo' ("" = a própria raiz); nulo se falhar
+    DiretorioAberto abrir(const std::string &raiz, std::string_view relativo);
+    // Pai de 'raiz/nome' e o nome base dentro dele
+    DiretorioAberto pai(const std::string &raiz, std::string_view nome,
+                        std::string *base);
+    Metadados sondar(const std::string &raiz, std::string_view nome);
+
+    size_t tamanho() const;
+    EstatisticasCacheDiretorios estatisticas() const;
+
+ private:
+    using Entrada = std::pair<std::string, DiretorioAberto>;
+
+    size_t capacidade_;
+    std::list<Entrada> lru_;  // mais recente na frente
+    std::unordered_map<std::string_view, std::list<Entrada>::iterator>
+        porChave_;
+    EstatisticasCacheDiretorios estatisticas_;
+    mutable std::mutex mtx_;
+};
+
+#endif  // INCLUDE_CACHE_DIRETORIOS_HPP_
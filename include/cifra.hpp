@@ -0,0 +1,47 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_CIFRA_HPP_
+#define INCLUDE_CIFRA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "copia.hpp"
+
+class PoolTarefas;
+
+enum AlgoritmoCifra : uint8_t {
+    CIFRA_AES_256_GCM = 1,        // AES-NI/PCLMUL pelo OpenSSL (EVP)
+    CIFRA_CHACHA20_POLY1305 = 2   // sem AES em hardware
+};
+
+constexpr size_t kTamanhoChaveCifra = 32;
+
+// AES-256-GCM se a CPU tem AES-NI e PCLMUL, senão ChaCha20-Poly1305.
+AlgoritmoCifra algoritmo_preferido();
+
+// Um arquivo cifrado no destino tem o mesmo nome da origem: cabeçalho
+// "BKPCIF01" (algoritmo, tamanho do bloco, tamanho original e prefixo do
+// nonce) seguido de blocos independentes, cada um com a sua etiqueta de
+// autenticação, para que possam ser cifrados e decifrados em paralelo.
+constexpr size_t kTamanhoCabecalhoCifra = 32;
+bool arquivo_cifrado(const std::string &caminho);
+// Confere o cabeçalho já lido do início de um arquivo (tamanho = bytes
+// lidos) e dá o tamanho original.
+bool cabecalho_cifrado(const char *dados, size_t tamanho,
+                       uint64_t *tamanhoOriginal);
+
+// Cifra/decifra origem em destino (temporário renomeado no fim). Com o
+// pool, os blocos de arquivos grandes são divididos entre os
+// trabalhadores dele; o chamador não deve ser um deles.
+EstrategiaCopia cifrar_arquivo(const std::string &origem,
+                               const std::string &destino,
+                               const std::string &chave,
+                               AlgoritmoCifra algoritmo,
+                               PoolTarefas *pool = nullptr);
+EstrategiaCopia decifrar_arquivo(const std::string &origem,
+                                 const std::string &destino,
+                                 const std::string &chave,
+                                 PoolTarefas *pool = nullptr);
+
+#endif  // INCLUDE_CIFRA_HPP_
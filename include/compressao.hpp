@@ -0,0 +1,45 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_COMPRESSAO_HPP_
+#define INCLUDE_COMPRESSAO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "copia.hpp"
+
+// A libzstd é carregada em tempo de execução (dlopen): sem ela o backup
+// funciona normalmente, só não comprime nem descomprime.
+bool zstd_disponivel();
+
+// Um arquivo comprimido no destino tem o mesmo nome da origem e começa
+// pelo cabeçalho "BKPZST01" + tamanho original (u64), seguido de um
+// quadro zstd.
+constexpr size_t kTamanhoCabecalhoCompressao = 16;
+bool arquivo_comprimido(const std::string &caminho);
+// Confere o cabeçalho já lido do início de um arquivo (tamanho = bytes
+// lidos) e dá o tamanho original.
+bool cabecalho_comprimido(const char *dados, size_t tamanho,
+                          uint64_t *tamanhoOriginal);
+
+struct ResultadoCompressao {
+    bool comprimido = false;  // false: copiado sem compressão
+    uint64_t bytesOrigem = 0;
+    uint64_t bytesGravados = 0;
+};
+
+// Comprime origem em destino (com threads trabalhadores do zstd nos
+// arquivos grandes). Uma amostra do início é comprimida antes; se ela
+// quase não diminuir (dados já comprimidos), o arquivo é copiado sem
+// compressão por copiar_arquivo.
+EstrategiaCopia comprimir_arquivo(const std::string &origem,
+                                  const std::string &destino, int nivel,
+                                  unsigned threads,
+                                  ResultadoCompressao *resultado);
+
+// Recria em destino o conteúdo original de um arquivo comprimido.
+EstrategiaCopia descomprimir_arquivo(const std::string &origem,
+                                     const std::string &destino,
+                                     ResultadoCompressao *resultado);
+
+#endif  // INCLUDE_COMPRESSAO_HPP_
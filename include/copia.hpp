@@ -0,0 +1,94 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_COPIA_HPP_
+#define INCLUDE_COPIA_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum EstrategiaCopia : uint8_t {
+    COPIA_FALHOU = 0,
+    COPIA_REFLINK,          // ioctl FICLONE (sistemas CoW: XFS, btrfs)
+    COPIA_COPY_FILE_RANGE,  // cópia no kernel
+    COPIA_SENDFILE,
+    COPIA_LEITURA_ESCRITA,  // laço read/write em espaço de usuário
+    COPIA_IO_URING,         // feita pelo anel io_uring
+    COPIA_DEDUPLICADA,      // chunks no armazém do destino (ArmazemChunks)
+    COPIA_DELTA,            // só os blocos alterados, no próprio destino
+    COPIA_PARTICIONADA,     // intervalos copiados em paralelo
+    COPIA_EMPACOTADA,       // anexada a um pacote do destino
+    COPIA_DESEMPACOTADA,    // extraída de um pacote da origem
+    COPIA_COMPRIMIDA,       // gravada comprimida (zstd)
+    COPIA_DESCOMPRIMIDA,    // comprimida na origem, descomprimida
+    COPIA_CIFRADA,          // gravada cifrada (AEAD em blocos)
+    COPIA_DECIFRADA,        // cifrada na origem, decifrada
+    COPIA_MULTIPLA,         // lida uma vez, gravada em vários destinos
+    COPIA_DIRETA            // O_DIRECT, sem passar pelo cache de páginas
+};
+
+const char *nome_estrategia(EstrategiaCopia estrategia);
+
+EstrategiaCopia copiar_arquivo(const std::string &origem,
+                               const std::string &destino);
+EstrategiaCopia copiar_arquivo_em(int dirOrigem, const char *origem,
+                                  int dirDestino, const char *destino);
+
+// Cópia que não deixa o arquivo no cache de páginas: O_DIRECT na parte
+// alinhada ao setor e, no resto (ou onde O_DIRECT não é aceito), pread/
+// pwrite com o trecho copiado descartado do cache em seguida.
+EstrategiaCopia copiar_arquivo_direto(const std::string &origem,
+                                      const std::string &destino);
+
+class PoolTarefas;
+
+// Lê origem uma só vez e grava o conteúdo em todos os destinos, cada um
+// por um temporário renomeado no fim (com o pool, as gravações de um
+// bloco correm em paralelo com a leitura do seguinte). copiados recebe o
+// resultado de cada destino.
+EstrategiaCopia copiar_para_varios(const std::string &origem,
+                                   const std::vector<std::string> &destinos,
+                                   PoolTarefas *pool,
+                                   std::vector<bool> *copiados);
+
+// Cópia de um arquivo em intervalos independentes, que várias threads
+// podem copiar ao mesmo tempo: abrir prepara a origem e um temporário
+// pré-alocado ao lado do destino, copiar_intervalo é seguro entre
+// threads e concluir aplica as permissões e renomeia o temporário sobre
+// o destino. Se a cópia falhar, o destino anterior fica intacto.
+class CopiaParticionada {
+ public:
+    CopiaParticionada() = default;
+    ~CopiaParticionada();
+
+    CopiaParticionada(const CopiaParticionada &) = delete;
+    CopiaParticionada &operator=(const CopiaParticionada &) = delete;
+
+    // dirDestino deve continuar aberto até concluir
+    bool abrir(int dirOrigem, const char *origem, int dirDestino,
+               const char *destino);
+    uint64_t tamanho() const { return tamanho_; }
+    bool copiar_intervalo(uint64_t inicio, uint64_t fim);
+    EstrategiaCopia concluir();
+
+ private:
+    int fdOrigem_ = -1;
+    int fdDestino_ = -1;  // do temporário
+    int dirDestino_ = -1;
+    std::string destino_;
+    std::string temporario_;  // "" = ainda não criado
+    unsigned modo_ = 0;
+    uint64_t tamanho_ = 0;
+    std::atomic<bool> falhou_{false};
+};
+
+// Copia um arquivo em partes de tamanhoParte bytes, distribuídas entre
+// os trabalhadores do pool (o chamador também ajuda, e não deve ser um
+// deles).
+EstrategiaCopia copiar_arquivo_em_partes(int dirOrigem, const char *origem,
+                                         int dirDestino, const char *destino,
+                                         PoolTarefas *pool,
+                                         uint64_t tamanhoParte);
+
+#endif  // INCLUDE_COPIA_HPP_
@@ -0,0 +1,25 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_DELTA_HPP_
+#define INCLUDE_DELTA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "copia.hpp"
+
+struct ResultadoDelta {
+    uint64_t bytesEscritos = 0;        // gravados no destino
+    uint64_t bytesReaproveitados = 0;  // blocos do destino mantidos
+    size_t tamanhoBloco = 0;
+};
+
+// Bloco usado para um destino de 'tamanho' bytes (~raiz quadrada).
+size_t tamanho_bloco_delta(uint64_t tamanho);
+
+EstrategiaCopia copiar_delta(const std::string &origem,
+                             const std::string &destino,
+                             ResultadoDelta *resultado,
+                             size_t tamanhoBloco = 0);
+
+#endif  // INCLUDE_DELTA_HPP_
@@ -0,0 +1,111 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_FILA_LIMITADA_HPP_
+#define INCLUDE_FILA_LIMITADA_HPP_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Fila circular limitada para vários produtores e vários consumidores,
+// sem travas (algoritmo de D. Vyukov): cada célula tem um número de
+// sequência que diz se ela está livre para a volta corrente do produtor
+// ou preenchida para a do consumidor; produtores e consumidores só
+// disputam o próprio índice com um CAS.
+template <typename T>
+class FilaLimitada {
+ public:
+    explicit FilaLimitada(size_t capacidade);
+
+    FilaLimitada(const FilaLimitada &) = delete;
+    FilaLimitada &operator=(const FilaLimitada &) = delete;
+
+    bool inserir(T &&valor);  // false se a fila está cheia
+    bool retirar(T *valor);   // false se a fila está vazia
+    size_t capacidade() const { return mascara_ + 1; }
+    size_t ocupacao() const;  // aproximada, com uso concorrente
+
+ private:
+    struct Celula {
+        std::atomic<size_t> sequencia;
+        T valor;
+    };
+
+    std::unique_ptr<Celula[]> celulas_;
+    size_t mascara_;
+    alignas(64) std::atomic<size_t> cauda_{0};   // próxima inserção
+    alignas(64) std::atomic<size_t> cabeca_{0};  // próxima retirada
+};
+
+// A capacidade é arredondada para a potência de dois seguinte.
+template <typename T>
+FilaLimitada<T>::FilaLimitada(size_t capacidade) {
+    assert(capacidade >= 1);
+    size_t n = 2;
+    while (n < capacidade)
+        n *= 2;
+    celulas_.reset(new Celula[n]);
+    mascara_ = n - 1;
+    for (size_t i = 0; i < n; ++i)
+        celulas_[i].sequencia.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool FilaLimitada<T>::inserir(T &&valor) {
+    size_t pos = cauda_.load(std::memory_order_relaxed);
+    Celula *c;
+    for (;;) {
+        c = &celulas_[pos & mascara_];
+        size_t seq = c->sequencia.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) -
+            static_cast<intptr_t>(pos);
+        if (dif == 0) {
+            if (cauda_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = cauda_.load(std::memory_order_relaxed);
+        }
+    }
+    c->valor = std::move(valor);
+    c->sequencia.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool FilaLimitada<T>::retirar(T *valor) {
+    size_t pos = cabeca_.load(std::memory_order_relaxed);
+    Celula *c;
+    for (;;) {
+        c = &celulas_[pos & mascara_];
+        size_t seq = c->sequencia.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) -
+            static_cast<intptr_t>(pos + 1);
+        if (dif == 0) {
+            if (cabeca_.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return false;
+        } else {
+            pos = cabeca_.load(std::memory_order_relaxed);
+        }
+    }
+    *valor = std::move(c->valor);
+    c->sequencia.store(pos + mascara_ + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+size_t FilaLimitada<T>::ocupacao() const {
+    size_t cauda = cauda_.load(std::memory_order_relaxed);
+    size_t cabeca = cabeca_.load(std::memory_order_relaxed);
+    return (cauda > cabeca) ? cauda - cabeca : 0;
+}
+
+#endif  // INCLUDE_FILA_LIMITADA_HPP_
@@ -0,0 +1,52 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_INDICE_ESTADO_HPP_
+#define INCLUDE_INDICE_ESTADO_HPP_
+
+#include <array>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include "metadados.hpp"
+
+// Estado de um arquivo registrado na última execução.
+struct RegistroIndice {
+    Metadados hd;
+    Metadados pen;
+    bool temDigest = false;
+    std::array<uint8_t, 32> digest{};  // digest do conteúdo no HD
+    bool temDigestPen = false;
+    // Digest do conteúdo no Pen; se ele foi gravado comprimido ou
+    // cifrado, o do conteúdo original
+    std::array<uint8_t, 32> digestPen{};
+};
+
+class IndiceEstado {
+ public:
+    explicit IndiceEstado(const std::string &dirDestino);
+
+    IndiceEstado(const IndiceEstado &) = delete;
+    IndiceEstado &operator=(const IndiceEstado &) = delete;
+
+    const std::string &caminho() const { return caminho_; }
+    size_t tamanho() const { return anterior_.size(); }
+    const RegistroIndice *buscar(const std::string &nome) const;
+    void atualizar(const std::string &nome, const RegistroIndice &registro);
+    // Troca os metadados de um lado no registro desta execução, depois
+    // que a cópia o regravou; devolve se o lado ficou com digest.
+    bool atualizar_lado(const std::string &nome, bool ladoPen,
+                        const Metadados &meta,
+                        const std::array<uint8_t, 32> *conteudo = nullptr);
+    bool salvar();
+
+ private:
+    std::string caminho_;
+    std::unordered_map<std::string, RegistroIndice> anterior_;
+    std::unordered_map<std::string, RegistroIndice> novo_;
+    std::mutex mtx_;
+};
+
+bool mesmo_arquivo(const Metadados &a, const Metadados &b);
+
+#endif  // INCLUDE_INDICE_ESTADO_HPP_
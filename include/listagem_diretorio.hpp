@@ -0,0 +1,31 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_LISTAGEM_DIRETORIO_HPP_
+#define INCLUDE_LISTAGEM_DIRETORIO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Nomes de um diretório lidos de uma vez (getdents64), para responder a
+// existência de muitas entradas sem um statx por entrada ou percorrer o
+// diretório.
+class ListagemDiretorio {
+ public:
+    bool ler(int dirfd, const char *caminho);
+
+    size_t tamanho() const { return posicoes_.size(); }
+    std::string_view nome(size_t i) const;  // em ordem crescente
+    uint8_t tipo(size_t i) const;  // DT_REG, DT_DIR, DT_UNKNOWN...
+    bool contem(std::string_view nome) const;
+
+ private:
+    std::string nomes_;  // [tipo][nome]'\0' de cada entrada
+    std::vector<uint32_t> posicoes_;  // ordenadas pelo nome
+};
+
+bool vale_enumerar(size_t consultas, uint64_t tamanhoDiretorio);
+
+#endif  // INCLUDE_LISTAGEM_DIRETORIO_HPP_
@@ -0,0 +1,47 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_MANIFESTO_HPP_
+#define INCLUDE_MANIFESTO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Rotina usada para localizar as quebras de linha.
+enum class NucleoQuebras {
+    AUTOMATICO,  // AVX2 ou SSE2 conforme a CPU; escalar fora do x86-64
+    ESCALAR,
+    SSE2,
+    AVX2
+};
+
+const char *nome_nucleo(NucleoQuebras nucleo);
+
+class LeitorManifesto {
+ public:
+    explicit LeitorManifesto(const std::string &caminho,
+                             NucleoQuebras nucleo = NucleoQuebras::AUTOMATICO);
+    ~LeitorManifesto();
+
+    LeitorManifesto(const LeitorManifesto &) = delete;
+    LeitorManifesto &operator=(const LeitorManifesto &) = delete;
+
+    bool aberto() const { return aberto_; }
+    NucleoQuebras nucleo() const { return nucleo_; }
+    bool proxima_linha(std::string_view *linha);
+
+ private:
+    void carregar_bloco();
+
+    bool aberto_ = false;
+    NucleoQuebras nucleo_;
+    const char *dados_ = nullptr;
+    size_t tamanho_ = 0;
+    const char *fim_ = nullptr;
+    const char *posicao_ = nullptr;  // início da próxima linha
+    const char *bloco_ = nullptr;    // bloco de 64 bytes da máscara atual
+    uint64_t mascara_ = 0;           // bits = '\n' ainda não consumidos
+};
+
+#endif  // INCLUDE_MANIFESTO_HPP_
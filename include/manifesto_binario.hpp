@@ -0,0 +1,58 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_MANIFESTO_BINARIO_HPP_
+#define INCLUDE_MANIFESTO_BINARIO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Entrada do manifesto compilado: posição original no Backup.parm,
+// diretório pai (deduplicado; "/" ou "/..." nas linhas absolutas) e nome
+// base.
+struct EntradaCompilada {
+    uint32_t ordem;
+    uint32_t diretorio;
+    std::string_view pai;
+    std::string_view base;
+
+    std::string nome() const;
+};
+
+bool compilar_manifesto(const std::string &parmTexto,
+                        const std::string &parmBinario);
+
+class ManifestoBinario {
+ public:
+    ManifestoBinario(const std::string &parmBinario,
+                     const std::string &parmTexto);
+    ~ManifestoBinario();
+
+    ManifestoBinario(const ManifestoBinario &) = delete;
+    ManifestoBinario &operator=(const ManifestoBinario &) = delete;
+
+    bool valido() const { return valido_; }
+    uint32_t numEntradas() const { return numEntradas_; }
+    uint32_t numDiretorios() const { return numDiretorios_; }
+    std::string_view diretorio(uint32_t indice) const;
+    bool entrada(uint32_t indice, EntradaCompilada *saida) const;
+    // A linha na posição 'ordem' do Backup.parm (sem as vazias)
+    bool entrada_na_ordem(uint32_t ordem, EntradaCompilada *saida) const;
+
+ private:
+    std::string_view cadeia(uint64_t deslocamento) const;
+
+    bool valido_ = false;
+    const char *dados_ = nullptr;
+    size_t tamanho_ = 0;
+    uint32_t numEntradas_ = 0;
+    uint32_t numDiretorios_ = 0;
+    const char *diretorios_ = nullptr;
+    const char *entradas_ = nullptr;
+    const char *posicoes_ = nullptr;
+    const char *nomes_ = nullptr;
+    size_t tamanhoNomes_ = 0;
+};
+
+#endif  // INCLUDE_MANIFESTO_BINARIO_HPP_
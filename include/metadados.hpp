@@ -0,0 +1,30 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_METADADOS_HPP_
+#define INCLUDE_METADADOS_HPP_
+
+#include <sys/stat.h>
+#include <cstdint>
+#include <string>
+
+struct Metadados {
+    bool existe = false;
+    uint64_t tamanho = 0;
+    int64_t mtimeNs = 0;  // nanossegundos desde a época Unix
+    uint64_t inode = 0;
+    uint64_t dispositivo = 0;
+    uint32_t modo = 0;  // tipo e permissões (st_mode)
+};
+
+// Máscara de campos pedida ao statx pelas sondagens.
+#ifdef STATX_BASIC_STATS
+constexpr unsigned kMascaraStatx =
+    STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME | STATX_INO;
+
+Metadados metadados_de_statx(const struct statx &stx);
+#endif
+
+Metadados sondar_metadados(const std::string &caminho);
+Metadados sondar_metadados_em(int dirfd, const char *nome);
+
+#endif  // INCLUDE_METADADOS_HPP_
@@ -0,0 +1,97 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_PACOTES_HPP_
+#define INCLUDE_PACOTES_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include "metadados.hpp"
+
+// Posição e atributos de um arquivo guardado em um pacote.
+struct RegistroPacote {
+    uint32_t pacote = 0;  // número do arquivo de pacote
+    uint64_t deslocamento = 0;
+    uint64_t tamanho = 0;
+    int64_t mtimeNs = 0;
+    uint32_t modo = 0;
+};
+
+// Metadados de um arquivo que só existe em pacote: inode 0, que nenhum
+// arquivo real tem, distingue-os dos sondados.
+Metadados metadados_de_pacote(const RegistroPacote &registro);
+bool veio_de_pacote(const Metadados &meta);
+
+struct EstatisticasPacotes {
+    uint64_t arquivos = 0;
+    uint64_t bytes = 0;
+    uint64_t pacotes = 0;  // arquivos de pacote criados
+};
+
+// Pacotes de arquivos pequenos em <dir>/.pacotes: os conteúdos são
+// anexados em sequência a pacote-NNNNNN.dat e cada arquivo ganha um
+// registro (pacote, deslocamento, tamanho, data, modo, nome) no arquivo
+// indice; registros posteriores do mesmo nome substituem os anteriores.
+// Cada execução começa um pacote novo, sem reescrever os existentes; o
+// espaço dos substituídos é recuperado por compactar_pacotes.
+class EscritorPacotes {
+ public:
+    explicit EscritorPacotes(const std::string &dir,
+                             uint64_t tamanhoMaximo = uint64_t(1) << 30);
+    ~EscritorPacotes();
+
+    EscritorPacotes(const EscritorPacotes &) = delete;
+    EscritorPacotes &operator=(const EscritorPacotes &) = delete;
+
+    bool adicionar(const std::string &origem, const std::string &nome);
+    bool fechar();  // grava o que falta do índice
+    EstatisticasPacotes estatisticas() const;
+
+ private:
+    bool abrir_pacote();
+    bool gravar_indice();
+
+    std::string dir_;
+    uint64_t tamanhoMaximo_;
+    std::mutex mtx_;
+    uint32_t pacote_ = 0;
+    int fdPacote_ = -1;
+    uint64_t ocupado_ = 0;  // bytes já gravados no pacote corrente
+    int fdIndice_ = -1;
+    std::string registros_;  // ainda não gravados no índice
+    bool falhou_ = false;
+    std::atomic<uint64_t> arquivos_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> pacotes_{0};
+};
+
+// Regrava os pacotes de <dir>/.pacotes só com os arquivos vigentes quando
+// mais da metade deles (em bytes ou em registros) foi substituída;
+// retorna os bytes liberados (0 = nada feito).
+uint64_t compactar_pacotes(const std::string &dir,
+                           uint64_t tamanhoMaximo = uint64_t(1) << 30);
+
+// Índice dos pacotes de um diretório, carregado por inteiro; os pacotes
+// ficam abertos para as extrações, que podem ser concorrentes.
+class LeitorPacotes {
+ public:
+    explicit LeitorPacotes(const std::string &dir);
+    ~LeitorPacotes();
+
+    LeitorPacotes(const LeitorPacotes &) = delete;
+    LeitorPacotes &operator=(const LeitorPacotes &) = delete;
+
+    size_t tamanho() const { return registros_.size(); }
+    const RegistroPacote *buscar(const std::string &nome) const;
+    bool extrair(const std::string &nome, const std::string &destino) const;
+
+ private:
+    std::string dir_;
+    std::unordered_map<std::string, RegistroPacote> registros_;
+    std::unordered_map<uint32_t, int> pacotes_;  // número -> descritor
+};
+
+#endif  // INCLUDE_PACOTES_HPP_
@@ -0,0 +1,116 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_PERCURSO_ARVORE_HPP_
+#define INCLUDE_PERCURSO_ARVORE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "fila_limitada.hpp"
+#include "listagem_diretorio.hpp"
+#include "pool_tarefas.hpp"
+
+// Linhas do Backup.parm que se expandem em vários arquivos: diretórios
+// (com '/' no fim, equivalentes a "dir/**") e padrões com *, ? ou [...],
+// em que "**" casa com qualquer número de diretórios.
+bool eh_padrao(std::string_view linha);
+bool casar_padrao(std::string_view padrao, std::string_view nome);
+
+// Percurso em profundidade, sob demanda, dos arquivos (tudo que não é
+// diretório) de uma subárvore, em ordem lexicográfica por diretório.
+// Links simbólicos para diretórios não são seguidos.
+class PercursoArvore {
+ public:
+    // Arquivos que existem em 'raizExcluida' (mesmo nome relativo) são
+    // pulados; pode ser nulo
+    PercursoArvore(const std::string &raiz, const std::string &inicio,
+                   const std::string *raizExcluida = nullptr);
+
+    // Só desce aos diretórios que ainda podem casar com o padrão
+    void podar_por(const std::string &padrao) { padrao_ = padrao; }
+    bool proximo(std::string *nome);
+    size_t diretoriosLidos() const { return diretoriosLidos_; }
+
+ private:
+    struct Quadro {
+        std::string relativo;  // "" = a raiz
+        ListagemDiretorio listagem;
+        ListagemDiretorio excluidos;
+        size_t proximo = 0;
+    };
+
+    void entrar(const std::string &relativo);
+
+    std::string raiz_;
+    const std::string *raizExcluida_;
+    std::string padrao_;
+    std::vector<Quadro> pilha_;
+    size_t diretoriosLidos_ = 0;
+};
+
+// Percurso concorrente: cada diretório é uma tarefa do pool (os
+// trabalhadores roubam subdiretórios uns dos outros) e os arquivos
+// encontrados chegam ao consumidor por uma FilaLimitada, em ordem não
+// determinística. O pool deve ser exclusivo do percurso, pois as tarefas
+// esperam quando a fila enche.
+class PercursoParalelo {
+ public:
+    PercursoParalelo(PoolTarefas *pool, size_t capacidadeFila);
+    ~PercursoParalelo();
+
+    PercursoParalelo(const PercursoParalelo &) = delete;
+    PercursoParalelo &operator=(const PercursoParalelo &) = delete;
+
+    // Mesmos parâmetros de PercursoArvore; várias raízes podem ser
+    // percorridas ao mesmo tempo, com os nomes saindo na mesma fila
+    void iniciar(const std::string &raiz, const std::string &inicio,
+                 const std::string *raizExcluida = nullptr,
+                 const std::string &padrao = std::string());
+    bool proximo(std::string *nome);  // espera até haver nome ou acabar
+    size_t diretoriosLidos() const { return diretoriosLidos_.load(); }
+
+ private:
+    struct Raiz {
+        std::string raiz;
+        const std::string *raizExcluida;
+        std::string padrao;
+    };
+
+    void visitar(const Raiz *raiz, const std::string &relativo);
+    void entregar(std::string nome);
+
+    PoolTarefas *pool_;
+    FilaLimitada<std::string> fila_;
+    GrupoTarefas grupo_;
+    std::deque<Raiz> raizes_;
+    std::atomic<bool> cancelar_{false};
+    std::atomic<size_t> diretoriosLidos_{0};
+};
+
+// Expansão de uma linha-padrão: primeiro os arquivos do HD que casam,
+// depois os do Pen que não existem no HD. Com um pool, os dois lados são
+// percorridos em paralelo e a ordem deixa de ser determinística.
+class ExpansaoEntrada {
+ public:
+    ExpansaoEntrada(const std::string &dirHD, const std::string &dirPen,
+                    std::string_view linha, PoolTarefas *pool = nullptr);
+
+    bool proximo(std::string *nome);
+    size_t diretoriosLidos() const;
+
+ private:
+    std::string dirHD_;
+    std::string dirPen_;
+    std::string padrao_;
+    std::string prefixo_;  // diretório fixo antes do primeiro curinga
+    std::unique_ptr<PercursoArvore> hd_;
+    std::unique_ptr<PercursoArvore> pen_;
+    std::unique_ptr<PercursoParalelo> paralelo_;
+    bool noPen_ = false;
+};
+
+#endif  // INCLUDE_PERCURSO_ARVORE_HPP_
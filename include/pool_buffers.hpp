@@ -0,0 +1,115 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_POOL_BUFFERS_HPP_
+#define INCLUDE_POOL_BUFFERS_HPP_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+class PoolBuffers;
+
+// Buffer obtido de PoolBuffers, devolvido a ele ao ser destruído.
+class BlocoBuffer {
+ public:
+    BlocoBuffer() = default;
+    ~BlocoBuffer() { liberar(); }
+
+    BlocoBuffer(BlocoBuffer &&outro) noexcept { *this = std::move(outro); }
+    BlocoBuffer &operator=(BlocoBuffer &&outro) noexcept;
+    BlocoBuffer(const BlocoBuffer &) = delete;
+    BlocoBuffer &operator=(const BlocoBuffer &) = delete;
+
+    char *dados() const { return dados_; }
+    size_t tamanho() const { return tamanho_; }
+    explicit operator bool() const { return dados_ != nullptr; }
+    void liberar();
+
+ private:
+    friend class PoolBuffers;
+
+    PoolBuffers *dono_ = nullptr;
+    char *dados_ = nullptr;
+    size_t tamanho_ = 0;
+    bool excedente_ = false;  // fora do pool: desfeito ao ser liberado
+};
+
+struct EstatisticasBuffers {
+    uint64_t pedidos = 0;
+    uint64_t acertosCache = 0;   // do cache da própria thread
+    uint64_t acertosGlobal = 0;  // da lista global (ou de outro cache)
+    uint64_t alocacoes = 0;      // blocos novos mapeados
+    uint64_t esperas = 0;        // pedidos que esperaram no limite
+    uint64_t excedentes = 0;     // maiores que o bloco ou além do limite
+    uint64_t blocosReservados = 0;  // mapeados pelo pool agora
+    uint64_t blocosPaginasEnormes = 0;  // dos reservados, com MAP_HUGETLB
+    uint64_t bytesEmUso = 0;
+    uint64_t picoBytesEmUso = 0;  // desde a criação ou reiniciar_pico
+    double taxaAcerto = 0;        // (acertosCache + acertosGlobal) / pedidos
+};
+
+// Blocos de tamanho fixo, alinhados a 2 MiB quando o bloco é múltiplo de
+// 2 MiB (páginas enormes: MAP_HUGETLB se o sistema as reservou, senão
+// madvise(MADV_HUGEPAGE)), mapeados sob demanda até limiteBytes e
+// reaproveitados: cada thread tem um pequeno cache, e o que não cabe
+// nele vai para uma lista global. No limite, quem não tem nenhum buffer
+// do pool espera um ser devolvido; quem já tem um recebe um excedente
+// (evita que duas threads esperem uma pela outra).
+class PoolBuffers {
+ public:
+    PoolBuffers(size_t tamanhoBloco, size_t limiteBytes,
+                bool paginasEnormes = true);
+    ~PoolBuffers();
+
+    PoolBuffers(const PoolBuffers &) = delete;
+    PoolBuffers &operator=(const PoolBuffers &) = delete;
+
+    // Usado pelas cópias do backup: blocos de 2 MiB, até 256 MiB.
+    static PoolBuffers &global();
+
+    // Buffer com pelo menos 'tamanho' bytes (0 = um bloco inteiro);
+    // acima do tamanho do bloco, um excedente do tamanho pedido.
+    BlocoBuffer obter(size_t tamanho = 0);
+    size_t tamanhoBloco() const { return tamanhoBloco_; }
+    EstatisticasBuffers estatisticas() const;
+    void reiniciar_pico();
+
+ private:
+    friend class BlocoBuffer;
+
+    struct alignas(64) CacheThread {
+        std::mutex mtx;
+        std::vector<char *> livres;
+    };
+
+    CacheThread &cache_da_thread();
+    char *mapear(size_t tamanho, bool *paginasEnormes);
+    char *roubar_de_caches();
+    void devolver(BlocoBuffer *buffer);
+
+    const size_t tamanhoBloco_;
+    const size_t limiteBlocos_;
+    const bool paginasEnormes_;
+    std::unique_ptr<CacheThread[]> caches_;
+    mutable std::mutex mtx_;  // lista global, reservas e contadores
+    std::condition_variable cvLivre_;
+    std::vector<char *> livres_;
+    std::vector<char *> reservados_;
+    std::atomic<unsigned> esperando_{0};
+    uint64_t blocosPaginasEnormes_ = 0;
+    std::atomic<uint64_t> pedidos_{0};
+    std::atomic<uint64_t> acertosCache_{0};
+    std::atomic<uint64_t> acertosGlobal_{0};
+    std::atomic<uint64_t> alocacoes_{0};
+    std::atomic<uint64_t> esperas_{0};
+    std::atomic<uint64_t> excedentes_{0};
+    std::atomic<uint64_t> bytesEmUso_{0};
+    std::atomic<uint64_t> picoBytesEmUso_{0};
+};
+
+#endif  // INCLUDE_POOL_BUFFERS_HPP_
@@ -0,0 +1,61 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_POOL_TAREFAS_HPP_
+#define INCLUDE_POOL_TAREFAS_HPP_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+// Contador de tarefas pendentes de um lote submetido ao pool.
+struct GrupoTarefas {
+    std::atomic<size_t> pendentes{0};
+};
+
+class PoolTarefas {
+ public:
+    explicit PoolTarefas(unsigned numThreads = 0);
+    ~PoolTarefas();
+
+    PoolTarefas(const PoolTarefas &) = delete;
+    PoolTarefas &operator=(const PoolTarefas &) = delete;
+
+    void submeter(GrupoTarefas *grupo, std::function<void()> tarefa);
+    void aguardar(GrupoTarefas *grupo);
+    unsigned tamanho() const;
+
+ private:
+    struct Tarefa {
+        GrupoTarefas *grupo;
+        std::function<void()> funcao;
+    };
+
+    struct Fila {
+        std::mutex mtx;
+        std::deque<Tarefa> tarefas;
+    };
+
+    bool obter_tarefa(size_t indice, Tarefa *tarefa);
+    void executar(Tarefa *tarefa);
+    void laco_trabalhador(size_t indice);
+
+    std::vector<std::unique_ptr<Fila>> filas_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> proximaFila_{0};
+    std::atomic<size_t> disponiveis_{0};
+    std::atomic<bool> parar_{false};
+    std::mutex mtxSono_;
+    std::condition_variable cvSono_;
+    // Threads dormindo em aguardar, acordadas por submeter e pelo fim de
+    // um grupo; protegido por mtxSono_
+    size_t esperando_ = 0;
+    std::condition_variable cvEspera_;
+};
+
+#endif  // INCLUDE_POOL_TAREFAS_HPP_
@@ -0,0 +1,70 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#ifndef INCLUDE_RELATORIO_HPP_
+#define INCLUDE_RELATORIO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Resultado de uma execução em estrutura de arrays. Os textos ficam
+// contíguos em blocos de uma arena, e o diretório pai de cada nome é
+// guardado uma única vez; cada entrada ocupa 13 bytes mais o nome base
+// (e mais 16 se o relatório for detalhado).
+class RelatorioBackup {
+ public:
+    explicit RelatorioBackup(bool detalhado = false);
+
+    RelatorioBackup(RelatorioBackup &&) = default;
+    RelatorioBackup &operator=(RelatorioBackup &&) = default;
+
+    void adicionar(std::string_view nome, int acao, uint64_t bytes = 0,
+                   uint64_t duracaoNs = 0);
+    void reservar(size_t entradas);
+
+    size_t tamanho() const { return acoes_.size(); }
+    bool detalhado() const { return detalhado_; }
+    std::string nome(size_t i) const;
+    std::string_view diretorio(size_t i) const;  // "" se não houver
+    std::string_view base(size_t i) const;
+    int acao(size_t i) const { return acoes_[i]; }
+    uint64_t bytes(size_t i) const { return detalhado_ ? bytes_[i] : 0; }
+    uint64_t duracaoNs(size_t i) const {
+        return detalhado_ ? duracoes_[i] : 0;
+    }
+
+    // Colunas inteiras, para agregações sequenciais
+    const std::vector<uint8_t> &acoes() const { return acoes_; }
+    const std::vector<uint32_t> &colunaDiretorios() const {
+        return diretorioDe_;
+    }
+    const std::vector<uint64_t> &colunaBytes() const { return bytes_; }
+    const std::vector<uint64_t> &colunaDuracoes() const { return duracoes_; }
+    size_t numDiretorios() const { return diretorios_.size(); }
+
+    size_t contar(int acao) const;
+    uint64_t bytesTotais() const;
+    size_t memoria() const;  // bytes alocados pelo relatório
+
+ private:
+    uint64_t guardar(std::string_view texto);
+    std::string_view texto(uint64_t posicao) const;
+
+    bool detalhado_;
+    std::vector<std::unique_ptr<char[]>> blocos_;
+    size_t usadoNoBloco_ = 0;
+    // Posições na arena: bloco(28 bits) | deslocamento(20) | tamanho(16)
+    std::vector<uint64_t> bases_;
+    std::vector<uint32_t> diretorioDe_;
+    std::vector<uint8_t> acoes_;
+    std::vector<uint64_t> bytes_;     // só se detalhado
+    std::vector<uint64_t> duracoes_;  // só se detalhado
+    std::vector<uint64_t> diretorios_;
+    std::unordered_map<std::string_view, uint32_t> indiceDiretorio_;
+};
+
+#endif  // INCLUDE_RELATORIO_HPP_
@@ -0,0 +1,606 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/anel_io_uring.hpp"
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Tamanho de cada pedaço lido/escrito por operação de cópia.
+static constexpr uint32_t kPedacoCopia = 128 * 1024;
+
+// Tipos de operação codificados nos 3 bits baixos de user_data.
+enum TipoOperacao : uint64_t {
+    OP_ABRIR_ORIGEM = 0,
+    OP_ABRIR_DESTINO,
+    OP_LER,
+    OP_ESCREVER,
+    OP_FECHAR,
+    OP_ESCREVER_RESTO
+};
+
+static uint64_t codificar(size_t indice, TipoOperacao tipo) {
+    return (static_cast<uint64_t>(indice) << 3) | tipo;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::AnelIoUring
+* Descrição:
+*   Cria um anel io_uring usando diretamente as chamadas de sistema
+*   (sem liburing) e mapeia as filas de submissão e de conclusão. Se o
+*   kernel não oferecer io_uring, ou não suportar as operações usadas
+*   pelo backup (statx, openat, read, write, close), o anel fica
+*   indisponível e o chamador deve usar o caminho síncrono.
+*
+* Parâmetros:
+*   entradas - tamanho desejado da fila de submissão
+*
+* Assertivas de saída:
+*   disponivel() indica se o anel pode ser usado
+***************************************************************************/
+
+AnelIoUring::AnelIoUring(unsigned entradas) {
+    struct io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entradas, &p));
+    if (fd < 0)
+        return;
+
+    sqTamanho_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqTamanho_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool mapaUnico = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (mapaUnico)
+        sqTamanho_ = cqTamanho_ = std::max(sqTamanho_, cqTamanho_);
+
+    void *sq = mmap(nullptr, sqTamanho_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    void *cq = sq;
+    if (!mapaUnico) {
+        cq = mmap(nullptr, cqTamanho_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) {
+            munmap(sq, sqTamanho_);
+            close(fd);
+            return;
+        }
+    }
+    void *sqes = mmap(nullptr, p.sq_entries * sizeof(struct io_uring_sqe),
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        if (!mapaUnico)
+            munmap(cq, cqTamanho_);
+        munmap(sq, sqTamanho_);
+        close(fd);
+        return;
+    }
+
+    char *sqBase = static_cast<char *>(sq);
+    char *cqBase = static_cast<char *>(cq);
+    fd_ = fd;
+    sqEntradas_ = p.sq_entries;
+    sqAnel_ = sq;
+    cqAnel_ = cq;
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+    sqCabeca_ = reinterpret_cast<unsigned *>(sqBase + p.sq_off.head);
+    sqCauda_ = reinterpret_cast<unsigned *>(sqBase + p.sq_off.tail);
+    sqMascara_ = reinterpret_cast<unsigned *>(sqBase + p.sq_off.ring_mask);
+    sqVetor_ = reinterpret_cast<unsigned *>(sqBase + p.sq_off.array);
+    cqCabeca_ = reinterpret_cast<unsigned *>(cqBase + p.cq_off.head);
+    cqCauda_ = reinterpret_cast<unsigned *>(cqBase + p.cq_off.tail);
+    cqMascara_ = reinterpret_cast<unsigned *>(cqBase + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cqBase + p.cq_off.cqes);
+    caudaLocal_ = submetidas_ = *sqCauda_;
+
+    if (!suporta_operacoes())
+        liberar();
+}
+
+AnelIoUring::~AnelIoUring() {
+    liberar();
+}
+
+void AnelIoUring::liberar() {
+    if (fd_ < 0)
+        return;
+    munmap(sqes_, sqEntradas_ * sizeof(struct io_uring_sqe));
+    if (cqAnel_ != sqAnel_)
+        munmap(cqAnel_, cqTamanho_);
+    munmap(sqAnel_, sqTamanho_);
+    close(fd_);
+    fd_ = -1;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::suporta_operacoes
+* Descrição:
+*   Consulta o kernel (IORING_REGISTER_PROBE) para confirmar que todas as
+*   operações usadas pelo backup são suportadas.
+*
+* Valor retornado:
+*   true se statx, openat, read, write e close estão disponíveis
+***************************************************************************/
+
+bool AnelIoUring::suporta_operacoes() {
+    const unsigned numOps = 256;
+    size_t tamanho = sizeof(struct io_uring_probe) +
+        numOps * sizeof(struct io_uring_probe_op);
+    std::unique_ptr<char[]> memoria(new char[tamanho]());
+    auto *sonda = reinterpret_cast<struct io_uring_probe *>(memoria.get());
+
+    if (syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE,
+                sonda, numOps) < 0)
+        return false;
+
+    for (unsigned op : {IORING_OP_STATX, IORING_OP_OPENAT, IORING_OP_READ,
+                        IORING_OP_WRITE, IORING_OP_CLOSE}) {
+        if (op > sonda->last_op ||
+            !(sonda->ops[op].flags & IO_URING_OP_SUPPORTED))
+            return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::obter_sqe
+* Descrição:
+*   Reserva a próxima entrada livre da fila de submissão, já zerada.
+*
+* Valor retornado:
+*   Ponteiro para a entrada ou nullptr se a fila estiver cheia.
+*
+* Assertivas de entrada:
+*   disponivel()
+***************************************************************************/
+
+struct io_uring_sqe *AnelIoUring::obter_sqe() {
+    assert(disponivel());
+
+    unsigned cabeca = __atomic_load_n(sqCabeca_, __ATOMIC_ACQUIRE);
+    if (caudaLocal_ - cabeca >= sqEntradas_)
+        return nullptr;
+    unsigned indice = caudaLocal_ & *sqMascara_;
+    struct io_uring_sqe *sqe = &sqes_[indice];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqVetor_[indice] = indice;
+    ++caudaLocal_;
+    return sqe;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::submeter
+* Descrição:
+*   Publica as entradas reservadas e chama io_uring_enter uma única vez,
+*   opcionalmente aguardando um número mínimo de conclusões.
+*
+* Parâmetros:
+*   minCompletas - conclusões a aguardar (0 = não bloquear)
+*
+* Valor retornado:
+*   Número de entradas aceitas pelo kernel ou valor negativo em erro.
+***************************************************************************/
+
+int AnelIoUring::submeter(unsigned minCompletas) {
+    assert(disponivel());
+
+    __atomic_store_n(sqCauda_, caudaLocal_, __ATOMIC_RELEASE);
+    unsigned pendentes = caudaLocal_ - submetidas_;
+    int ret;
+    do {
+        ret = static_cast<int>(syscall(__NR_io_uring_enter, fd_, pendentes,
+            minCompletas, minCompletas ? IORING_ENTER_GETEVENTS : 0,
+            nullptr, 0));
+    } while (ret < 0 && errno == EINTR);
+    ++chamadasEnter_;
+    if (ret > 0)
+        submetidas_ += static_cast<unsigned>(ret);
+    return ret;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::descartar_nao_submetidas
+* Descrição:
+*   Retira da fila de submissão as entradas reservadas que o kernel ainda
+*   não aceitou (por exemplo, depois de um io_uring_enter que falhou),
+*   para que elas não sejam submetidas por uma chamada posterior.
+*
+* Valor retornado:
+*   Número de entradas retiradas
+***************************************************************************/
+
+unsigned AnelIoUring::descartar_nao_submetidas() {
+    assert(disponivel());
+
+    unsigned n = caudaLocal_ - submetidas_;
+    caudaLocal_ = submetidas_;
+    __atomic_store_n(sqCauda_, caudaLocal_, __ATOMIC_RELEASE);
+    return n;
+}
+
+/***************************************************************************
+* Função: AnelIoUring::proxima_cqe
+* Descrição:
+*   Copia e consome a próxima entrada da fila de conclusão, se houver.
+*
+* Parâmetros:
+*   cqe - recebe a conclusão
+*
+* Valor retornado:
+*   true se uma conclusão foi consumida
+***************************************************************************/
+
+bool AnelIoUring::proxima_cqe(struct io_uring_cqe *cqe) {
+    assert(disponivel());
+
+    unsigned cabeca = *cqCabeca_;
+    if (cabeca == __atomic_load_n(cqCauda_, __ATOMIC_ACQUIRE))
+        return false;
+    *cqe = cqes_[cabeca & *cqMascara_];
+    __atomic_store_n(cqCabeca_, cabeca + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/***************************************************************************
+* Função: drenar
+* Descrição:
+*   Depois de uma falha de io_uring_enter, retira da fila as entradas que
+*   o kernel não aceitou e espera as conclusões das que já estão em voo:
+*   elas ainda apontam para buffers e caminhos do chamador, que só podem
+*   ser liberados depois disso. As operações são de arquivos comuns e
+*   terminam sozinhas; se io_uring_enter continuar falhando, a fila de
+*   conclusão é consultada até que cheguem.
+*
+* Parâmetros:
+*   anel - anel disponível
+*   pendentes - operações reservadas ou em voo ainda sem conclusão
+*   tratar - chamado para cada conclusão (p. ex. para fechar um
+*            descritor aberto)
+***************************************************************************/
+
+template <typename Tratador>
+static void drenar(AnelIoUring *anel, unsigned pendentes, Tratador tratar) {
+    pendentes -= anel->descartar_nao_submetidas();
+    struct io_uring_cqe cqe;
+    while (pendentes > 0) {
+        while (pendentes > 0 && anel->proxima_cqe(&cqe)) {
+            --pendentes;
+            tratar(cqe);
+        }
+        if (pendentes > 0 && anel->submeter(1) < 0)
+            sched_yield();
+    }
+}
+
+/***************************************************************************
+* Função: colher
+* Descrição:
+*   Submete o que estiver pendente e consome exatamente 'quantidade'
+*   conclusões, chamando 'tratar' para cada uma. Se io_uring_enter
+*   falhar, as operações em voo são drenadas (ver drenar) antes de
+*   retornar.
+*
+* Valor retornado:
+*   false se io_uring_enter falhar
+***************************************************************************/
+
+template <typename Tratador>
+static bool colher(AnelIoUring *anel, unsigned quantidade, Tratador tratar) {
+    while (quantidade > 0) {
+        if (anel->submeter(1) < 0) {
+            drenar(anel, quantidade, tratar);
+            return false;
+        }
+        struct io_uring_cqe cqe;
+        while (quantidade > 0 && anel->proxima_cqe(&cqe)) {
+            --quantidade;
+            tratar(cqe);
+        }
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: sondar_lote_io_uring
+* Descrição:
+*   Obtém os metadados de vários caminhos submetendo operações STATX em
+*   lote: cada janela do tamanho da fila custa uma única chamada
+*   io_uring_enter, em vez de uma chamada statx por caminho.
+*
+* Parâmetros:
+*   anel - anel disponível
+*   caminhos - caminhos a consultar
+*   saida - recebe um Metadados por caminho, na mesma ordem
+*   diretorios - diretório ao qual cada caminho é relativo; nulo para
+*                caminhos relativos ao diretório corrente
+*
+* Valor retornado:
+*   false se o anel falhar; nesse caso saida não é confiável e o chamador
+*   deve repetir as sondagens de forma síncrona.
+*
+* Assertivas de entrada:
+*   anel != nullptr && anel->disponivel()
+***************************************************************************/
+
+bool sondar_lote_io_uring(AnelIoUring *anel,
+                          const std::vector<std::string> &caminhos,
+                          std::vector<Metadados> *saida,
+                          const std::vector<int> *diretorios) {
+    assert(anel != nullptr && anel->disponivel());
+
+    saida->assign(caminhos.size(), Metadados());
+    std::vector<struct statx> buffers(caminhos.size());
+
+    for (size_t ini = 0; ini < caminhos.size(); ini += anel->capacidade()) {
+        size_t fim = std::min(caminhos.size(),
+                              ini + anel->capacidade());
+        for (size_t i = ini; i < fim; ++i) {
+            struct io_uring_sqe *sqe = anel->obter_sqe();
+            if (sqe == nullptr)
+                return false;
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = diretorios ? (*diretorios)[i] : AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(caminhos[i].c_str());
+            sqe->len = kMascaraStatx;
+            sqe->off = reinterpret_cast<uint64_t>(&buffers[i]);
+            sqe->user_data = i;
+        }
+        bool ok = colher(anel, static_cast<unsigned>(fim - ini),
+            [&](const struct io_uring_cqe &cqe) {
+                if (cqe.res == 0)
+                    (*saida)[cqe.user_data] =
+                        metadados_de_statx(buffers[cqe.user_data]);
+            });
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+// Estado de uma cópia em andamento no anel.
+struct EstadoCopia {
+    int fdOrigem = -1;
+    int fdDestino = -1;
+    uint64_t deslocamento = 0;
+    uint32_t pedaco = 0;  // pedido pela operação em voo
+    int lidos = 0;        // resultado da leitura em voo
+    int escritos = 0;     // resultado da escrita em voo
+    unsigned aguardando = 0;  // conclusões que faltam para a operação
+    bool falhou = false;
+    std::unique_ptr<char[]> buffer;
+};
+
+/***************************************************************************
+* Função: enviar_pedaco
+* Descrição:
+*   Enfileira a leitura do próximo pedaço da origem encadeada
+*   (IOSQE_IO_LINK) à escrita do mesmo pedaço no destino. Até o tamanho
+*   sondado, lê só o que falta dele; depois, pede um pedaço inteiro, para
+*   descobrir se o arquivo cresceu. Uma leitura curta quebra o
+*   encadeamento e cancela a escrita (ver tratar_conclusao).
+*
+* Assertivas de entrada:
+*   há duas entradas livres na fila de submissão: copiar_lote_io_uring
+*   põe no máximo capacidade()/2 arquivos por onda, e cada um tem no
+*   máximo duas operações em voo (o par atual, ou a escrita avulsa de
+*   enviar_resto), que já foram concluídas quando este é chamado
+***************************************************************************/
+
+static void enviar_pedaco(AnelIoUring *anel, size_t indice,
+                          const CopiaLote &copia, EstadoCopia *estado) {
+    estado->pedaco = estado->deslocamento < copia.meta.tamanho ?
+        static_cast<uint32_t>(std::min<uint64_t>(kPedacoCopia,
+            copia.meta.tamanho - estado->deslocamento)) :
+        kPedacoCopia;
+    estado->aguardando = 2;
+
+    struct io_uring_sqe *ler = anel->obter_sqe();
+    struct io_uring_sqe *escrever = anel->obter_sqe();
+    assert(ler != nullptr && escrever != nullptr);
+
+    ler->opcode = IORING_OP_READ;
+    ler->fd = estado->fdOrigem;
+    ler->addr = reinterpret_cast<uint64_t>(estado->buffer.get());
+    ler->len = estado->pedaco;
+    ler->off = estado->deslocamento;
+    ler->flags = IOSQE_IO_LINK;
+    ler->user_data = codificar(indice, OP_LER);
+
+    escrever->opcode = IORING_OP_WRITE;
+    escrever->fd = estado->fdDestino;
+    escrever->addr = reinterpret_cast<uint64_t>(estado->buffer.get());
+    escrever->len = estado->pedaco;
+    escrever->off = estado->deslocamento;
+    escrever->user_data = codificar(indice, OP_ESCREVER);
+}
+
+// Enfileira a escrita avulsa dos bytes de uma leitura curta, cuja
+// escrita encadeada foi cancelada; a entrada é a do par já concluído
+// (mesma assertiva de enviar_pedaco).
+static void enviar_resto(AnelIoUring *anel, size_t indice,
+                         EstadoCopia *estado) {
+    estado->pedaco = static_cast<uint32_t>(estado->lidos);
+    estado->aguardando = 1;
+
+    struct io_uring_sqe *escrever = anel->obter_sqe();
+    assert(escrever != nullptr);
+    escrever->opcode = IORING_OP_WRITE;
+    escrever->fd = estado->fdDestino;
+    escrever->addr = reinterpret_cast<uint64_t>(estado->buffer.get());
+    escrever->len = estado->pedaco;
+    escrever->off = estado->deslocamento;
+    escrever->user_data = codificar(indice, OP_ESCREVER_RESTO);
+}
+
+/***************************************************************************
+* Função: tratar_conclusao
+* Descrição:
+*   Registra a conclusão de uma leitura ou escrita de uma cópia e, quando
+*   a operação em curso dela termina (o par leitura→escrita ou uma
+*   escrita avulsa), decide o passo seguinte: o próximo pedaço, a escrita
+*   avulsa do que uma leitura curta trouxe, o fim (leitura de 0 bytes) ou
+*   a falha. A cópia vai até a leitura que devolve 0, e não só até o
+*   tamanho sondado, de modo que um arquivo que cresceu é copiado
+*   inteiro.
+*
+* Valor retornado:
+*   Número de operações enfileiradas
+***************************************************************************/
+
+static unsigned tratar_conclusao(AnelIoUring *anel,
+                                 const struct io_uring_cqe &cqe,
+                                 const CopiaLote &copia,
+                                 EstadoCopia *e) {
+    size_t indice = cqe.user_data >> 3;
+    if ((cqe.user_data & 7) == OP_LER)
+        e->lidos = cqe.res;
+    else
+        e->escritos = cqe.res;
+    if (--e->aguardando > 0 || e->falhou)
+        return 0;
+
+    if ((cqe.user_data & 7) == OP_ESCREVER_RESTO) {
+        if (e->escritos != e->lidos) {
+            e->falhou = true;
+            return 0;
+        }
+    } else if (e->lidos < 0 ||
+               (e->lidos == static_cast<int>(e->pedaco) &&
+                e->escritos != e->lidos)) {
+        e->falhou = true;
+        return 0;
+    } else if (e->lidos < static_cast<int>(e->pedaco)) {
+        // Leitura curta: a escrita encadeada tem de ter sido cancelada
+        if (e->escritos != -ECANCELED)
+            e->falhou = true;
+        if (e->falhou || e->lidos == 0)
+            return 0;
+        enviar_resto(anel, indice, e);
+        return 1;
+    }
+    e->deslocamento += e->pedaco;
+    enviar_pedaco(anel, indice, copia, e);
+    return 2;
+}
+
+/***************************************************************************
+* Função: copiar_lote_io_uring
+* Descrição:
+*   Copia vários arquivos pelo anel, em ondas de até capacidade()/2
+*   arquivos: abre origens e destinos (OPENAT), mantém um par
+*   leitura→escrita encadeado em voo por arquivo até a leitura que
+*   devolve 0 e fecha todos os descritores (CLOSE), sempre em lote. Se
+*   io_uring_enter falhar, as operações em voo são drenadas antes de os
+*   buffers da onda serem liberados, e os descritores são fechados de
+*   forma síncrona.
+*
+* Parâmetros:
+*   anel - anel disponível
+*   copias - origem, destino e metadados da origem de cada cópia
+*   copiado - recebe true para cada cópia concluída pelo anel; as demais
+*             devem ser refeitas pelo caminho síncrono
+*
+* Assertivas de entrada:
+*   anel != nullptr && anel->disponivel()
+***************************************************************************/
+
+void copiar_lote_io_uring(AnelIoUring *anel,
+                          const std::vector<CopiaLote> &copias,
+                          std::vector<bool> *copiado) {
+    assert(anel != nullptr && anel->disponivel());
+
+    copiado->assign(copias.size(), false);
+    const size_t onda = std::max(1u, anel->capacidade() / 2);
+
+    for (size_t ini = 0; ini < copias.size(); ini += onda) {
+        size_t fim = std::min(copias.size(), ini + onda);
+        std::vector<EstadoCopia> estados(fim - ini);
+
+        // Abertura de origens e destinos
+        for (size_t i = ini; i < fim; ++i) {
+            struct io_uring_sqe *sqe = anel->obter_sqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = copias[i].dirOrigem;
+            sqe->addr = reinterpret_cast<uint64_t>(copias[i].origem.c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = codificar(i - ini, OP_ABRIR_ORIGEM);
+
+            sqe = anel->obter_sqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = copias[i].dirDestino;
+            sqe->addr = reinterpret_cast<uint64_t>(copias[i].destino.c_str());
+            sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            sqe->len = copias[i].meta.modo & 07777;
+            sqe->user_data = codificar(i - ini, OP_ABRIR_DESTINO);
+        }
+        bool ok = colher(anel, static_cast<unsigned>(2 * (fim - ini)),
+            [&](const struct io_uring_cqe &cqe) {
+                EstadoCopia &e = estados[cqe.user_data >> 3];
+                if (cqe.res < 0)
+                    e.falhou = true;
+                else if ((cqe.user_data & 7) == OP_ABRIR_ORIGEM)
+                    e.fdOrigem = cqe.res;
+                else
+                    e.fdDestino = cqe.res;
+            });
+
+        // Transferência dos dados
+        unsigned emVoo = 0;
+        for (size_t i = ini; ok && i < fim; ++i) {
+            EstadoCopia &e = estados[i - ini];
+            if (e.falhou)
+                continue;
+            e.buffer.reset(new char[kPedacoCopia]);
+            enviar_pedaco(anel, i - ini, copias[i], &e);
+            emVoo += 2;
+        }
+        while (ok && emVoo > 0) {
+            if (anel->submeter(1) < 0) {
+                ok = false;
+                drenar(anel, emVoo, [](const struct io_uring_cqe &) {});
+                break;
+            }
+            struct io_uring_cqe cqe;
+            while (anel->proxima_cqe(&cqe)) {
+                --emVoo;
+                size_t j = cqe.user_data >> 3;
+                emVoo += tratar_conclusao(anel, cqe, copias[ini + j],
+                                          &estados[j]);
+            }
+        }
+        // Fechamento dos descritores abertos
+        unsigned fechamentos = 0;
+        for (size_t j = 0; j < estados.size(); ++j) {
+            for (int fd : {estados[j].fdOrigem, estados[j].fdDestino}) {
+                if (fd < 0)
+                    continue;
+                if (!ok) {
+                    close(fd);
+                    continue;
+                }
+                struct io_uring_sqe *sqe = anel->obter_sqe();
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = fd;
+                sqe->user_data = codificar(j, OP_FECHAR);
+                ++fechamentos;
+            }
+        }
+        if (ok)
+            ok = colher(anel, fechamentos, [](const struct io_uring_cqe &) {});
+
+        for (size_t i = ini; i < fim; ++i)
+            (*copiado)[i] = ok && !estados[i - ini].falhou;
+    }
+}
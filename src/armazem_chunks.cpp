@@ -0,0 +1,370 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/armazem_chunks.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "../include/blake3.hpp"
+
+namespace fs = std::filesystem;
+
+// Receita (inteiros na ordem de bytes da máquina):
+//   magica[8] tamanhoTotal:u64 numChunks:u64
+//   numChunks x {digest[32] tamanho:u32}
+static constexpr char kMagicaReceita[8] = {'B', 'K', 'P', 'R', 'C', 'T',
+                                           '0', '1'};
+// Buffer de leitura dos arquivos armazenados.
+static constexpr size_t kTamanhoLeitura = 4 << 20;
+
+// Tabela do gear hash: 256 valores pseudoaleatórios fixos (splitmix64),
+// para que os cortes sejam os mesmos em qualquer execução.
+struct TabelaGear {
+    uint64_t g[256];
+};
+
+static constexpr TabelaGear montar_tabela_gear() {
+    TabelaGear t{};
+    uint64_t x = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 256; ++i) {
+        x += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        t.g[i] = z ^ (z >> 31);
+    }
+    return t;
+}
+
+static constexpr TabelaGear kGear = montar_tabela_gear();
+
+// Máscara com os 'bits' bits mais altos ligados: o gear hash desloca
+// para a esquerda, então os bits altos dependem dos últimos 64 bytes.
+static uint64_t mascara_alta(unsigned bits) {
+    return (bits == 0) ? 0 : ~uint64_t(0) << (64 - bits);
+}
+
+/***************************************************************************
+* Função: ChunkerFastCdc::ChunkerFastCdc
+* Descrição:
+*   Prepara o divisor FastCDC. Com tamanho médio 2^b, antes do médio o
+*   corte exige b + 2 bits zerados e depois dele b - 2 (normalização),
+*   concentrando os tamanhos perto do médio.
+*
+* Assertivas de entrada:
+*   0 < minimo <= medio <= maximo
+***************************************************************************/
+
+ChunkerFastCdc::ChunkerFastCdc(const ParametrosCdc &parametros)
+    : parametros_(parametros) {
+    assert(parametros.minimo > 0 && parametros.minimo <= parametros.medio &&
+           parametros.medio <= parametros.maximo);
+
+    unsigned bits = 0;
+    while ((size_t(2) << bits) <= parametros.medio)
+        ++bits;
+    mascaraPequena_ = mascara_alta(std::min(bits + 2, 63u));
+    mascaraGrande_ = mascara_alta(bits > 2 ? bits - 2 : 1);
+}
+
+/***************************************************************************
+* Função: ChunkerFastCdc::proximo_corte
+* Descrição:
+*   Procura o fim do chunk que começa em dados. Os primeiros 'minimo'
+*   bytes são pulados sem calcular o hash; depois, o gear hash avança um
+*   byte por vez (um deslocamento e uma soma) até zerar os bits da
+*   máscara ou atingir o máximo.
+*
+* Parâmetros:
+*   dados - início do chunk
+*   tamanho - bytes disponíveis; se forem o final do arquivo, um resto
+*             menor que o mínimo vira um chunk
+*
+* Valor retornado:
+*   Tamanho do chunk, entre 1 e min(tamanho, maximo).
+***************************************************************************/
+
+size_t ChunkerFastCdc::proximo_corte(const uint8_t *dados,
+                                     size_t tamanho) const {
+    if (tamanho <= parametros_.minimo)
+        return tamanho;
+    size_t limite = std::min(tamanho, parametros_.maximo);
+    size_t normal = std::min(limite, parametros_.medio);
+
+    uint64_t fp = 0;
+    size_t i = parametros_.minimo;
+    for (; i < normal; ++i) {
+        fp = (fp << 1) + kGear.g[dados[i]];
+        if ((fp & mascaraPequena_) == 0)
+            return i + 1;
+    }
+    for (; i < limite; ++i) {
+        fp = (fp << 1) + kGear.g[dados[i]];
+        if ((fp & mascaraGrande_) == 0)
+            return i + 1;
+    }
+    return limite;
+}
+
+template <typename T>
+static void anexar(std::string *saida, T v) {
+    saida->append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T>
+static T ler(const char *p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/***************************************************************************
+* Função: gravar_atomico
+* Descrição:
+*   Grava o conteúdo em um arquivo temporário e o renomeia para o nome
+*   final, para que leitores nunca vejam um arquivo pela metade.
+***************************************************************************/
+
+static bool gravar_atomico(const std::string &caminho,
+                           const std::string &temporario,
+                           const void *dados, size_t tamanho) {
+    FILE *f = fopen(temporario.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+    bool ok = fwrite(dados, 1, tamanho, f) == tamanho;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(temporario.c_str(), caminho.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: ArmazemChunks::ArmazemChunks
+* Descrição:
+*   Abre (criando, se preciso) o armazém de chunks do diretório destino.
+*
+* Parâmetros:
+*   dirDestino - diretório destino do backup
+*   parametros - limites de tamanho dos chunks
+*
+* Assertivas de entrada:
+*   dirDestino != ""
+***************************************************************************/
+
+ArmazemChunks::ArmazemChunks(const std::string &dirDestino,
+                             const ParametrosCdc &parametros)
+    : dirChunks_((fs::path(dirDestino) / ".chunks").string()),
+      dirReceitas_((fs::path(dirDestino) / ".receitas").string()),
+      chunker_(parametros) {
+    assert(!dirDestino.empty());
+
+    std::error_code ec;
+    fs::create_directories(dirChunks_, ec);
+    fs::create_directories(dirReceitas_, ec);
+}
+
+std::string ArmazemChunks::caminho_chunk(const std::string &hex) const {
+    return dirChunks_ + "/" + hex.substr(0, 2) + "/" + hex.substr(2);
+}
+
+/***************************************************************************
+* Função: ArmazemChunks::gravar_chunk
+* Descrição:
+*   Garante que o chunk de digest 'hex' está no armazém. Chunks já vistos
+*   nesta execução ou já presentes no disco não são regravados.
+*
+* Valor retornado:
+*   false se o chunk não pôde ser gravado
+***************************************************************************/
+
+bool ArmazemChunks::gravar_chunk(const uint8_t *dados, size_t tamanho,
+                                 const std::string &hex) {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (conhecidos_.count(hex) != 0) {
+            chunksReaproveitados_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    std::string caminho = caminho_chunk(hex);
+    if (access(caminho.c_str(), F_OK) != 0) {
+        std::error_code ec;
+        fs::create_directories(fs::path(caminho).parent_path(), ec);
+        std::string temporario = caminho + ".tmp" + std::to_string(
+            temporarios_.fetch_add(1, std::memory_order_relaxed));
+        if (!gravar_atomico(caminho, temporario, dados, tamanho))
+            return false;
+        chunksNovos_.fetch_add(1, std::memory_order_relaxed);
+        bytesGravados_.fetch_add(tamanho, std::memory_order_relaxed);
+    } else {
+        chunksReaproveitados_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    conhecidos_.insert(hex);
+    return true;
+}
+
+/***************************************************************************
+* Função: ArmazemChunks::armazenar
+* Descrição:
+*   Divide o arquivo de origem em chunks FastCDC, grava no armazém os
+*   chunks que ainda não existem e grava a receita do arquivo (lista de
+*   digests e tamanhos). Como os cortes dependem só do conteúdo, uma
+*   alteração local muda apenas os chunks ao redor dela. A leitura é
+*   feita em blocos de 4 MiB, com memória limitada mesmo para imagens
+*   de vários GB. Pode ser chamada de várias threads ao mesmo tempo.
+*
+* Parâmetros:
+*   origem - arquivo a armazenar
+*   nome - nome relativo do arquivo, usado para a receita
+*
+* Valor retornado:
+*   true se o arquivo e a receita foram gravados
+***************************************************************************/
+
+bool ArmazemChunks::armazenar(const std::string &origem,
+                              const std::string &nome) {
+    int fd = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::string receita(kMagicaReceita, sizeof(kMagicaReceita));
+    anexar(&receita, uint64_t(0));  // tamanho total, preenchido no fim
+    anexar(&receita, uint64_t(0));  // quantidade de chunks
+    uint64_t total = 0, quantidade = 0;
+
+    const size_t maximo = chunker_.parametros().maximo;
+    std::vector<uint8_t> buffer(std::max(kTamanhoLeitura, 2 * maximo));
+    size_t cheio = 0;
+    bool fim = false, ok = true;
+    while (ok && (!fim || cheio > 0)) {
+        while (!fim && cheio < buffer.size()) {
+            ssize_t n = read(fd, buffer.data() + cheio, buffer.size() - cheio);
+            if (n < 0) {
+                ok = false;
+                break;
+            }
+            fim = n == 0;
+            cheio += static_cast<size_t>(n);
+        }
+
+        // Sem o fim do arquivo, só corta enquanto cabe um chunk máximo
+        size_t pos = 0;
+        while (ok && pos < cheio && (fim || cheio - pos >= maximo)) {
+            size_t n = chunker_.proximo_corte(buffer.data() + pos,
+                                              cheio - pos);
+            HasherBlake3 h;
+            h.atualizar(buffer.data() + pos, n);
+            DigestBlake3 digest = h.finalizar();
+            ok = gravar_chunk(buffer.data() + pos, n, hex_digest(digest));
+            receita.append(reinterpret_cast<const char *>(digest.data()),
+                           digest.size());
+            anexar(&receita, static_cast<uint32_t>(n));
+            total += n;
+            ++quantidade;
+            pos += n;
+        }
+        std::memmove(buffer.data(), buffer.data() + pos, cheio - pos);
+        cheio -= pos;
+    }
+    close(fd);
+    if (!ok)
+        return false;
+
+    std::memcpy(&receita[8], &total, sizeof(total));
+    std::memcpy(&receita[16], &quantidade, sizeof(quantidade));
+    fs::path caminho = fs::path(dirReceitas_) / nome;
+    std::error_code ec;
+    fs::create_directories(caminho.parent_path(), ec);
+    std::string temporario = caminho.string() + ".tmp" + std::to_string(
+        temporarios_.fetch_add(1, std::memory_order_relaxed));
+    if (!gravar_atomico(caminho.string(), temporario, receita.data(),
+                        receita.size()))
+        return false;
+
+    arquivos_.fetch_add(1, std::memory_order_relaxed);
+    bytesLogicos_.fetch_add(total, std::memory_order_relaxed);
+    return true;
+}
+
+/***************************************************************************
+* Função: ArmazemChunks::restaurar
+* Descrição:
+*   Remonta um arquivo a partir da sua receita, conferindo o tamanho e o
+*   digest de cada chunk lido do armazém.
+*
+* Parâmetros:
+*   nome - nome relativo usado em armazenar
+*   destino - arquivo a gerar
+*
+* Valor retornado:
+*   false se a receita ou algum chunk estiver ausente ou corrompido
+***************************************************************************/
+
+bool ArmazemChunks::restaurar(const std::string &nome,
+                              const std::string &destino) const {
+    std::ifstream in(fs::path(dirReceitas_) / nome, std::ios::binary);
+    std::string receita((std::istreambuf_iterator<char>(in)),
+                        std::istreambuf_iterator<char>());
+    if (receita.size() < 24 ||
+        std::memcmp(receita.data(), kMagicaReceita, 8) != 0)
+        return false;
+    uint64_t total = ler<uint64_t>(&receita[8]);
+    uint64_t quantidade = ler<uint64_t>(&receita[16]);
+    if (quantidade != (receita.size() - 24) / 36 ||
+        (receita.size() - 24) % 36 != 0)
+        return false;
+
+    std::string temporario = destino + ".tmp";
+    FILE *out = fopen(temporario.c_str(), "wb");
+    if (out == nullptr)
+        return false;
+    bool ok = true;
+    uint64_t escritos = 0;
+    std::vector<char> chunk;
+    for (uint64_t i = 0; ok && i < quantidade; ++i) {
+        const char *p = receita.data() + 24 + i * 36;
+        DigestBlake3 esperado;
+        std::memcpy(esperado.data(), p, esperado.size());
+        uint32_t tamanho = ler<uint32_t>(p + 32);
+
+        std::ifstream c(caminho_chunk(hex_digest(esperado)),
+                        std::ios::binary);
+        chunk.resize(tamanho);
+        ok = c.read(chunk.data(), tamanho) && c.peek() == EOF;
+        HasherBlake3 h;
+        h.atualizar(chunk.data(), chunk.size());
+        ok = ok && h.finalizar() == esperado &&
+            fwrite(chunk.data(), 1, tamanho, out) == tamanho;
+        escritos += tamanho;
+    }
+    ok = (fclose(out) == 0) && ok && escritos == total;
+    if (!ok || rename(temporario.c_str(), destino.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
+
+EstatisticasArmazem ArmazemChunks::estatisticas() const {
+    EstatisticasArmazem e;
+    e.arquivos = arquivos_;
+    e.bytesLogicos = bytesLogicos_;
+    e.bytesGravados = bytesGravados_;
+    e.chunksNovos = chunksNovos_;
+    e.chunksReaproveitados = chunksReaproveitados_;
+    return e;
+}
@@ -1,16 +1,2022 @@
 // Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
 
 #include "../include/backup.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <filesystem>  // NOLINT(build/c++17)
 #include <vector>
 #include <string>
-#include <fstream>
+#include <string_view>
 #include <system_error>
 #include <cassert>
 #include <utility>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <unordered_set>
+#include "../include/anel_io_uring.hpp"
+#include "../include/armazem_chunks.hpp"
+#include "../include/blake3.hpp"
+#include "../include/cache_diretorios.hpp"
+#include "../include/cifra.hpp"
+#include "../include/compressao.hpp"
+#include "../include/copia.hpp"
+#include "../include/delta.hpp"
+#include "../include/fila_limitada.hpp"
+#include "../include/indice_estado.hpp"
+#include "../include/listagem_diretorio.hpp"
+#include "../include/manifesto.hpp"
+#include "../include/manifesto_binario.hpp"
+#include "../include/metadados.hpp"
+#include "../include/pacotes.hpp"
+#include "../include/percurso_arvore.hpp"
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
 
 namespace fs = std::filesystem;
 
+// Quantidade de linhas do Backup.parm tratadas por tarefa do pool.
+static constexpr size_t kEntradasPorTarefa = 64;
+// Linhas lidas e processadas por vez antes de entregar os resultados.
+static constexpr size_t kEntradasPorJanela = 8192;
+
+// Tamanho da fila do anel io_uring e linhas tratadas por lote nele
+// (cada linha gera até duas sondagens).
+static constexpr unsigned kEntradasAnel = 256;
+static constexpr size_t kEntradasPorLote = kEntradasAnel / 2;
+
+// Marca, criada no diretório de destino na primeira cópia gravada
+// comprimida ou cifrada, de que os arquivos dele podem precisar ser
+// descomprimidos ou decifrados.
+static constexpr char kMarcaTransformados[] = ".backup_transformados";
+
+// Resultado da comparação de conteúdo de uma entrada.
+enum class Conteudo {
+    NAO_VERIFICADO,  // modo desligado ou um dos lados não pôde ser lido
+    IGUAL,
+    DIFERENTE
+};
+
+// Formato em que um arquivo do Pen foi gravado, pelo cabeçalho dele.
+struct FormatoPen {
+    enum Tipo { COMUM, COMPRIMIDO, CIFRADO } tipo = COMUM;
+    uint64_t tamanhoOriginal = 0;  // do conteúdo antes da transformação
+};
+
+// Digests de uma entrada, calculados ou reaproveitados do índice.
+struct DigestsEntrada {
+    bool temHD = false;
+    bool temPen = false;
+    DigestBlake3 hd{};
+    DigestBlake3 pen{};
+};
+
+// Lados em que a listagem do diretório pai mostrou que a entrada não
+// existe (ResultadoEntrada::ausente).
+static constexpr uint8_t kAusenteHD = 1;
+static constexpr uint8_t kAusentePen = 2;
+
+// Resultado de uma linha do Backup.parm dentro de uma janela.
+struct ResultadoEntrada {
+    std::string nome;
+    int acao = 0;
+    uint64_t bytes = 0;      // bytes copiados (A1/A2 bem-sucedidas)
+    uint64_t duracaoNs = 0;  // só medido se ContextoBackup::medirEntradas
+    uint8_t ausente = 0;     // kAusenteHD | kAusentePen
+    bool expandida = false;  // veio de uma linha-padrão (ExpansaoEntrada)
+};
+
+using ReceptorInterno = std::function<void(const ResultadoEntrada &)>;
+
+
+// Dados compartilhados por todas as entradas de uma execução.
+struct ContextoBackup {
+    const std::string &dirHD;
+    const std::string &dirPen;
+    const std::string &dirDestino;
+    bool backupSolicitado;
+    std::vector<std::pair<std::string, int>> *estrategias;  // pode ser nulo
+    IndiceEstado *indice;  // pode ser nulo
+    ArmazemChunks *armazem;  // modo deduplicado; pode ser nulo
+    CacheDiretorios *diretorios;  // pode ser nulo
+    bool enumerarDiretorios;
+    bool dispensarPen;     // usa o Pen registrado no índice, se válido
+    bool copiaDelta;
+    bool medirEntradas;    // preenche ResultadoEntrada::duracaoNs
+    bool verificarConteudo;
+    bool verificacaoMmap;
+    PoolTarefas *pool;     // trata as linhas; pode ser nulo
+    // Divide o trabalho de um arquivo em tarefas (partes de uma cópia
+    // grande, digests, blocos cifrados). As tarefas de linha esperam por
+    // ele, por isso não é o pool delas; pode ser nulo
+    PoolTarefas *poolPartes = nullptr;
+    // Com poolPartes, arquivos a partir deste tamanho são copiados em
+    // partes paralelas (0 = nunca)
+    uint64_t limiteArquivoGrande = 0;
+    uint64_t tamanhoParteCopia = 0;
+    std::atomic<uint64_t> copiasGrandes{0};
+    std::atomic<uint64_t> partesCopia{0};
+    // A1 de até empacotarAte bytes vão para os pacotes do destino
+    EscritorPacotes *pacotes = nullptr;  // pode ser nulo
+    uint64_t empacotarAte = 0;
+    const LeitorPacotes *pacotesPen = nullptr;  // pode ser nulo
+    std::atomic<uint64_t> arquivosDesempacotados{0};
+    bool comprimir = false;  // A1 comprimido
+    int nivelCompressao = 0;
+    unsigned threadsCompressao = 0;
+    std::atomic<uint64_t> arquivosComprimidos{0};
+    std::atomic<uint64_t> arquivosIncomprimiveis{0};
+    std::atomic<uint64_t> bytesOrigemComprimidos{0};
+    std::atomic<uint64_t> bytesComprimidosGravados{0};
+    std::atomic<uint64_t> arquivosDescomprimidos{0};
+    // A1 cifrado se não vazia; A2 decifra com ela
+    std::string chaveCifra;
+    AlgoritmoCifra algoritmoCifra = CIFRA_AES_256_GCM;
+    std::atomic<uint64_t> arquivosCifrados{0};
+    std::atomic<uint64_t> bytesCifrados{0};
+    std::atomic<uint64_t> arquivosDecifrados{0};
+    bool semCache = false;  // cópias comuns por copiar_arquivo_direto
+    // O Pen tem a kMarcaTransformados; sem ela e sem chave, os arquivos
+    // dele são todos comuns e o cabeçalho deles não é lido
+    bool penTransformado = false;
+    std::atomic<bool> marcaGravada{false};
+    // dirDestino é o próprio Pen ou o próprio HD: as cópias alteram um
+    // dos lados comparados, e o índice é atualizado depois de cada uma
+    bool destinoEhPen = false;
+    bool destinoEhHD = false;
+    std::atomic<uint64_t> chamadasMetadados{0};
+    std::atomic<uint64_t> sondagensPenEvitadas{0};
+    std::atomic<uint64_t> diretoriosListados{0};
+    std::atomic<uint64_t> sondagensEvitadasListagem{0};
+    std::atomic<uint64_t> arquivosHasheados{0};
+    std::atomic<uint64_t> bytesHasheados{0};
+    std::atomic<uint64_t> digestsReaproveitados{0};
+    std::atomic<uint64_t> bytesDeltaEscritos{0};
+    std::atomic<uint64_t> bytesDeltaReaproveitados{0};
+    std::mutex mtxEstrategias;
+    // Listagens dos diretórios pai do HD e do Pen, guardadas para as
+    // janelas seguintes; raiz + '\0' + pai -> listagem (vazia se o pai
+    // não existe). Quando o destino é um dos lados, a cópia descarta a
+    // listagem do pai dela (ver descartar_listagem)
+    std::unordered_map<std::string,
+                       std::shared_ptr<const ListagemDiretorio>> listagens;
+    std::mutex mtxListagens;
+    // Diretórios pai já criados no destino para entradas expandidas
+    std::unordered_set<std::string> paisCriados;
+    std::mutex mtxPaisCriados;
+};
+
+/***************************************************************************
+* Função: pen_pelo_indice
+* Descrição:
+*   Se o índice de estado registra o arquivo do HD exatamente como está
+*   agora (inode, dispositivo, tamanho e data), o arquivo não mudou desde
+*   a última execução e os metadados do Pen registrados nela são usados
+*   no lugar de uma nova sondagem. Parte do princípio de que o Pen só é
+*   alterado pelo próprio backup.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   nome - nome relativo do arquivo
+*   hd - metadados atuais do HD
+*   pen - recebe os metadados registrados do Pen
+*
+* Valor retornado:
+*   true se a sondagem do Pen pode ser evitada
+***************************************************************************/
+
+static bool pen_pelo_indice(ContextoBackup *ctx, const std::string &nome,
+                            const Metadados &hd, Metadados *pen) {
+    if (ctx->indice == nullptr || !ctx->dispensarPen || !hd.existe)
+        return false;
+    const RegistroIndice *r = ctx->indice->buscar(nome);
+    if (r == nullptr || !mesmo_arquivo(r->hd, hd))
+        return false;
+    *pen = r->pen;
+    ctx->sondagensPenEvitadas.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/***************************************************************************
+* Função: registrar_estado
+* Descrição:
+*   Atualiza o índice de estado com os metadados vistos nesta execução.
+*   Os digests calculados agora são gravados; na falta deles, os do
+*   registro anterior são preservados para o lado que não mudou.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   nome - nome relativo do arquivo
+*   hd, pen - metadados atuais
+*   digests - digests desta execução; pode ser nulo
+***************************************************************************/
+
+static void registrar_estado(ContextoBackup *ctx, const std::string &nome,
+                             const Metadados &hd, const Metadados &pen,
+                             const DigestsEntrada *digests = nullptr) {
+    if (ctx->indice == nullptr || !hd.existe)
+        return;
+    RegistroIndice r;
+    r.hd = hd;
+    r.pen = pen;
+    const RegistroIndice *anterior = ctx->indice->buscar(nome);
+    if (digests != nullptr && digests->temHD) {
+        r.temDigest = true;
+        r.digest = digests->hd;
+    } else if (anterior != nullptr && anterior->temDigest &&
+               mesmo_arquivo(anterior->hd, hd)) {
+        r.temDigest = true;
+        r.digest = anterior->digest;
+    }
+    if (digests != nullptr && digests->temPen) {
+        r.temDigestPen = true;
+        r.digestPen = digests->pen;
+    } else if (anterior != nullptr && anterior->temDigestPen &&
+               mesmo_arquivo(anterior->pen, pen)) {
+        r.temDigestPen = true;
+        r.digestPen = anterior->digestPen;
+    }
+    ctx->indice->atualizar(nome, r);
+}
+
+// Uma cópia gravada no próprio Pen (ou HD) torna velha a listagem
+// guardada do diretório pai dela, que é descartada para ser lida de novo
+// na próxima janela que precisar.
+static void descartar_listagem(ContextoBackup *ctx, const std::string &nome,
+                               bool ladoPen) {
+    if (!ctx->enumerarDiretorios ||
+        !(ladoPen ? ctx->destinoEhPen : ctx->destinoEhHD))
+        return;
+    size_t barra = nome.rfind('/');
+    std::string chave(ladoPen ? ctx->dirPen : ctx->dirHD);
+    chave.push_back('\0');
+    if (barra != std::string::npos)
+        chave.append(nome, 0, barra);
+    std::lock_guard<std::mutex> lk(ctx->mtxListagens);
+    ctx->listagens.erase(chave);
+}
+
+/***************************************************************************
+* Função: registrar_gravado
+* Descrição:
+*   Depois de uma cópia bem-sucedida para um destino que é o próprio Pen
+*   (A1) ou o próprio HD (A2), sonda de novo o arquivo gravado e troca no
+*   índice os metadados daquele lado, registrados antes da cópia; sem
+*   isso, a execução seguinte veria o arquivo antigo pelo índice e o
+*   copiaria outra vez; a listagem guardada do pai também é descartada.
+*   O lado gravado fica com o digest do outro. No modo de verificação, o
+*   conteúdo de uma cópia comprimida ou cifrada só pode ser conferido
+*   depois por esse digest (comparar_transformado): se o registro não tem
+*   o do HD, ele é calculado agora.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   nome - nome relativo do arquivo
+*   acao - A1_COPIAR_HD_PEN ou A2_COPIAR_PEN_HD
+*   transformada - a cópia foi gravada comprimida ou cifrada
+***************************************************************************/
+
+static void registrar_gravado(ContextoBackup *ctx, const std::string &nome,
+                              Acao acao, bool transformada = false) {
+    bool ladoPen = acao == A1_COPIAR_HD_PEN;
+    descartar_listagem(ctx, nome, ladoPen);
+    if (ctx->indice == nullptr ||
+        !(ladoPen ? ctx->destinoEhPen : ctx->destinoEhHD))
+        return;
+    Metadados gravado = sondar_metadados(
+        (fs::path(ctx->dirDestino) / nome).string());
+    if (ctx->indice->atualizar_lado(nome, ladoPen, gravado) ||
+        !transformada || !ctx->verificarConteudo)
+        return;
+    DigestBlake3 digest;
+    std::string origem = (fs::path(ctx->dirHD) / nome).string();
+    uint64_t lidos = sondar_metadados(origem).tamanho;
+    if (!blake3_arquivo(origem, &digest, ctx->poolPartes,
+                        ctx->verificacaoMmap))
+        return;
+    ctx->arquivosHasheados.fetch_add(1, std::memory_order_relaxed);
+    ctx->bytesHasheados.fetch_add(lidos, std::memory_order_relaxed);
+    ctx->indice->atualizar_lado(nome, ladoPen, gravado, &digest);
+}
+
+/***************************************************************************
+* Função: digest_de
+* Descrição:
+*   Obtém o BLAKE3 de um lado da entrada: reaproveita o digest do índice
+*   se o registro ainda descreve o arquivo (mesmo inode, tamanho e data);
+*   senão, lê o arquivo.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   caminho - arquivo a ler
+*   meta - metadados atuais do arquivo
+*   registrado - metadados do registro anterior (nulo se não houver)
+*   temRegistrado, digestRegistrado - digest do registro anterior
+*   digest - recebe o digest
+*
+* Valor retornado:
+*   false se o arquivo não pôde ser lido
+***************************************************************************/
+
+static bool digest_de(ContextoBackup *ctx, const std::string &caminho,
+                      const Metadados &meta, const Metadados *registrado,
+                      bool temRegistrado,
+                      const DigestBlake3 &digestRegistrado,
+                      DigestBlake3 *digest) {
+    if (registrado != nullptr && temRegistrado &&
+        mesmo_arquivo(*registrado, meta)) {
+        *digest = digestRegistrado;
+        ctx->digestsReaproveitados.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (!blake3_arquivo(caminho, digest, ctx->poolPartes,
+                        ctx->verificacaoMmap))
+        return false;
+    ctx->arquivosHasheados.fetch_add(1, std::memory_order_relaxed);
+    ctx->bytesHasheados.fetch_add(meta.tamanho, std::memory_order_relaxed);
+    return true;
+}
+
+// Lê o cabeçalho de um arquivo do Pen uma única vez (um pread) e diz se
+// ele foi gravado comprimido ou cifrado.
+static FormatoPen ler_formato(const std::string &caminho) {
+    FormatoPen formato;
+    int fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return formato;
+    char cabecalho[std::max(kTamanhoCabecalhoCifra,
+                            kTamanhoCabecalhoCompressao)];
+    ssize_t n = pread(fd, cabecalho, sizeof(cabecalho), 0);
+    close(fd);
+    size_t lidos = (n > 0) ? static_cast<size_t>(n) : 0;
+    if (cabecalho_comprimido(cabecalho, lidos, &formato.tamanhoOriginal))
+        formato.tipo = FormatoPen::COMPRIMIDO;
+    else if (cabecalho_cifrado(cabecalho, lidos, &formato.tamanhoOriginal))
+        formato.tipo = FormatoPen::CIFRADO;
+    return formato;
+}
+
+// Os arquivos do Pen podem estar comprimidos ou cifrados?
+static bool pen_pode_ser_transformado(const ContextoBackup *ctx) {
+    return ctx->penTransformado || !ctx->chaveCifra.empty();
+}
+
+// Cria a kMarcaTransformados no destino, uma vez por execução.
+static void marcar_transformado(ContextoBackup *ctx) {
+    if (ctx->marcaGravada.exchange(true, std::memory_order_relaxed))
+        return;
+    int fd = open((fs::path(ctx->dirDestino) / kMarcaTransformados).c_str(),
+                  O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0)
+        close(fd);
+}
+
+/***************************************************************************
+* Função: comparar_transformado
+* Descrição:
+*   Parte de comparar_conteudo para tamanhos diferentes: um arquivo do
+*   Pen comprimido ou cifrado é comparado pelo conteúdo original, com o
+*   tamanho do cabeçalho dele e o digest registrado no índice quando ele
+*   foi copiado (registrar_gravado). Um arquivo comum tem mesmo
+*   conteúdo diferente.
+*
+* Valor retornado:
+*   Conteudo::NAO_VERIFICADO se o arquivo é transformado e o índice não
+*   tem o digest dele.
+***************************************************************************/
+
+static Conteudo comparar_transformado(ContextoBackup *ctx,
+                                      const std::string &nome,
+                                      const Metadados &hd,
+                                      const Metadados &pen,
+                                      DigestsEntrada *digests) {
+    if (!pen_pode_ser_transformado(ctx))
+        return Conteudo::DIFERENTE;
+    FormatoPen formato = ler_formato(
+        (fs::path(ctx->dirPen) / nome).string());
+    if (formato.tipo == FormatoPen::COMUM)
+        return Conteudo::DIFERENTE;
+    if (formato.tamanhoOriginal != hd.tamanho)
+        return Conteudo::DIFERENTE;
+    const RegistroIndice *r = (ctx->indice != nullptr) ?
+        ctx->indice->buscar(nome) : nullptr;
+    if (r == nullptr || !r->temDigestPen || !mesmo_arquivo(r->pen, pen))
+        return Conteudo::NAO_VERIFICADO;
+    digests->temPen = true;
+    digests->pen = r->digestPen;
+    ctx->digestsReaproveitados.fetch_add(1, std::memory_order_relaxed);
+    digests->temHD = digest_de(ctx, (fs::path(ctx->dirHD) / nome).string(),
+        hd, &r->hd, r->temDigest, r->digest, &digests->hd);
+    if (!digests->temHD)
+        return Conteudo::NAO_VERIFICADO;
+    return (digests->hd == digests->pen) ? Conteudo::IGUAL :
+        Conteudo::DIFERENTE;
+}
+
+/***************************************************************************
+* Função: comparar_conteudo
+* Descrição:
+*   No modo de verificação, compara o conteúdo dos dois lados de uma
+*   entrada. Tamanhos diferentes já bastam para concluir que diferem,
+*   salvo se o arquivo do Pen estiver comprimido ou cifrado (ver
+*   comparar_transformado); com o mesmo tamanho, os digests BLAKE3 são
+*   comparados.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   nome - nome relativo do arquivo
+*   hd, pen - metadados atuais
+*   digests - recebe os digests obtidos, para o índice de estado
+*
+* Valor retornado:
+*   Conteudo::NAO_VERIFICADO se o modo estiver desligado, se faltar um
+*   dos lados ou se um deles não puder ser lido.
+***************************************************************************/
+
+static Conteudo comparar_conteudo(ContextoBackup *ctx,
+                                  const std::string &nome,
+                                  const Metadados &hd, const Metadados &pen,
+                                  DigestsEntrada *digests) {
+    if (!ctx->verificarConteudo || !hd.existe || !pen.existe)
+        return Conteudo::NAO_VERIFICADO;
+    if (hd.tamanho != pen.tamanho)
+        return comparar_transformado(ctx, nome, hd, pen, digests);
+
+    const RegistroIndice *r = (ctx->indice != nullptr) ?
+        ctx->indice->buscar(nome) : nullptr;
+    digests->temHD = digest_de(ctx, (fs::path(ctx->dirHD) / nome).string(),
+        hd, r ? &r->hd : nullptr, r && r->temDigest,
+        r ? r->digest : digests->hd, &digests->hd);
+    digests->temPen = digest_de(ctx,
+        (fs::path(ctx->dirPen) / nome).string(), pen,
+        r ? &r->pen : nullptr, r && r->temDigestPen,
+        r ? r->digestPen : digests->pen, &digests->pen);
+    if (!digests->temHD || !digests->temPen)
+        return Conteudo::NAO_VERIFICADO;
+    return (digests->hd == digests->pen) ? Conteudo::IGUAL :
+        Conteudo::DIFERENTE;
+}
+
+/***************************************************************************
+* Função: registrar_copia
+* Descrição:
+*   Anota a estratégia usada na cópia de um arquivo, se a execução
+*   estiver coletando estatísticas.
+***************************************************************************/
+
+static void registrar_copia(ContextoBackup *ctx, const std::string &nome,
+                            EstrategiaCopia estrategia) {
+    if (ctx->estrategias == nullptr)
+        return;
+    std::lock_guard<std::mutex> lk(ctx->mtxEstrategias);
+    ctx->estrategias->emplace_back(nome, static_cast<int>(estrategia));
+}
+
+/***************************************************************************
+* Função: eh_copia_especial
+* Descrição:
+*   Indica se a cópia de uma entrada é feita por um dos modos que não
+*   usam a cópia comum (ver copiar_especial), e por isso não pode ser
+*   dividida em partes. Em A2, não lê o arquivo: basta que ele possa
+*   estar cifrado ou comprimido (pen_pode_ser_transformado).
+***************************************************************************/
+
+static bool eh_copia_especial(const ContextoBackup *ctx,
+                              const std::string &nome, Acao acao,
+                              const Metadados &hd, const Metadados &pen) {
+    if (acao == A2_COPIAR_PEN_HD)
+        return (ctx->pacotesPen != nullptr && veio_de_pacote(pen)) ||
+            pen_pode_ser_transformado(ctx);
+    return !ctx->chaveCifra.empty() || ctx->armazem != nullptr ||
+        ctx->copiaDelta || ctx->comprimir ||
+        (ctx->pacotes != nullptr && hd.tamanho <= ctx->empacotarAte);
+}
+
+/***************************************************************************
+* Função: copiar_a2_especial
+* Descrição:
+*   A2 de um arquivo que só existe nos pacotes do Pen (extraído), de um
+*   arquivo cifrado (decifrado com a chave da execução) ou de um
+*   comprimido (descomprimido). O cabeçalho é lido uma vez, e só se o Pen
+*   tem a kMarcaTransformados ou a execução tem chave.
+*
+* Valor retornado:
+*   false se o arquivo do Pen é comum (a cópia comum deve ser feita pelo
+*   chamador)
+***************************************************************************/
+
+static bool copiar_a2_especial(ContextoBackup *ctx, const std::string &nome,
+                               const Metadados &pen,
+                               EstrategiaCopia *estrategia) {
+    std::string origem = (fs::path(ctx->dirPen) / nome).string();
+    std::string destino = (fs::path(ctx->dirDestino) / nome).string();
+    std::atomic<uint64_t> *contador;
+    bool dePacote = ctx->pacotesPen != nullptr && veio_de_pacote(pen);
+    FormatoPen formato;
+    if (!dePacote && pen_pode_ser_transformado(ctx))
+        formato = ler_formato(origem);
+    if (dePacote) {
+        *estrategia = ctx->pacotesPen->extrair(nome, destino) ?
+            COPIA_DESEMPACOTADA : COPIA_FALHOU;
+        contador = &ctx->arquivosDesempacotados;
+    } else if (formato.tipo == FormatoPen::CIFRADO) {
+        *estrategia = decifrar_arquivo(origem, destino, ctx->chaveCifra,
+                                       ctx->poolPartes);
+        contador = &ctx->arquivosDecifrados;
+    } else if (formato.tipo == FormatoPen::COMPRIMIDO) {
+        ResultadoCompressao rc;
+        *estrategia = descomprimir_arquivo(origem, destino, &rc);
+        contador = &ctx->arquivosDescomprimidos;
+    } else {
+        return false;
+    }
+    if (*estrategia != COPIA_FALHOU)
+        contador->fetch_add(1, std::memory_order_relaxed);
+    registrar_copia(ctx, nome, *estrategia);
+    return true;
+}
+
+/***************************************************************************
+* Função: copiar_especial
+* Descrição:
+*   Trata as cópias dos modos que não usam a cópia comum: em A2, ver
+*   copiar_a2_especial; em A1, a cifra (que tem precedência, para que
+*   nada vá em claro para o destino), o empacotamento de um arquivo
+*   pequeno, a gravação no armazém deduplicado, a atualização delta do
+*   destino existente ou a compressão.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   nome - nome relativo do arquivo
+*   acao - A1_COPIAR_HD_PEN ou A2_COPIAR_PEN_HD
+*   hd, pen - metadados usados na decisão
+*   estrategia - recebe a estratégia usada
+*
+* Valor retornado:
+*   false se nenhum desses modos se aplicar (a cópia comum deve ser
+*   feita pelo chamador)
+***************************************************************************/
+
+static bool copiar_especial(ContextoBackup *ctx, const std::string &nome,
+                            Acao acao, const Metadados &hd,
+                            const Metadados &pen,
+                            EstrategiaCopia *estrategia) {
+    if (acao == A2_COPIAR_PEN_HD)
+        return copiar_a2_especial(ctx, nome, pen, estrategia);
+    if (!eh_copia_especial(ctx, nome, acao, hd, pen))
+        return false;
+    std::string origem = (fs::path(ctx->dirHD) / nome).string();
+    std::string destino = (fs::path(ctx->dirDestino) / nome).string();
+    if (!ctx->chaveCifra.empty()) {
+        *estrategia = cifrar_arquivo(origem, destino, ctx->chaveCifra,
+                                     ctx->algoritmoCifra, ctx->poolPartes);
+        registrar_copia(ctx, nome, *estrategia);
+        if (*estrategia != COPIA_FALHOU) {
+            marcar_transformado(ctx);
+            ctx->arquivosCifrados.fetch_add(1, std::memory_order_relaxed);
+            ctx->bytesCifrados.fetch_add(hd.tamanho,
+                                         std::memory_order_relaxed);
+        }
+        return true;
+    }
+    if (ctx->pacotes != nullptr && hd.tamanho <= ctx->empacotarAte) {
+        *estrategia = ctx->pacotes->adicionar(origem, nome) ?
+            COPIA_EMPACOTADA : COPIA_FALHOU;
+        registrar_copia(ctx, nome, *estrategia);
+        return true;
+    }
+    if (ctx->armazem != nullptr) {
+        *estrategia = ctx->armazem->armazenar(origem, nome) ?
+            COPIA_DEDUPLICADA : COPIA_FALHOU;
+        registrar_copia(ctx, nome, *estrategia);
+        return true;
+    }
+    if (ctx->copiaDelta) {
+        ResultadoDelta r;
+        *estrategia = copiar_delta(origem, destino, &r);
+        registrar_copia(ctx, nome, *estrategia);
+        ctx->bytesDeltaEscritos.fetch_add(r.bytesEscritos,
+                                          std::memory_order_relaxed);
+        ctx->bytesDeltaReaproveitados.fetch_add(r.bytesReaproveitados,
+                                                std::memory_order_relaxed);
+        return true;
+    }
+    ResultadoCompressao rc;
+    *estrategia = comprimir_arquivo(origem, destino, ctx->nivelCompressao,
+                                    ctx->threadsCompressao, &rc);
+    registrar_copia(ctx, nome, *estrategia);
+    if (*estrategia == COPIA_FALHOU)
+        return true;
+    if (rc.comprimido)
+        marcar_transformado(ctx);
+    (rc.comprimido ? ctx->arquivosComprimidos :
+        ctx->arquivosIncomprimiveis).fetch_add(1, std::memory_order_relaxed);
+    ctx->bytesOrigemComprimidos.fetch_add(rc.bytesOrigem,
+                                          std::memory_order_relaxed);
+    ctx->bytesComprimidosGravados.fetch_add(rc.bytesGravados,
+                                            std::memory_order_relaxed);
+    return true;
+}
+
+/***************************************************************************
+* Função: pen_do_pacote
+* Descrição:
+*   Com pacotes no Pen, um arquivo guardado neles conta como presente no
+*   Pen, com a data e o tamanho registrados, se não houver um arquivo
+*   avulso mais recente com o mesmo nome.
+***************************************************************************/
+
+static void pen_do_pacote(const ContextoBackup *ctx,
+                          const std::string &nome, Metadados *pen) {
+    if (ctx->pacotesPen == nullptr)
+        return;
+    const RegistroPacote *r = ctx->pacotesPen->buscar(nome);
+    if (r != nullptr && (!pen->existe || r->mtimeNs > pen->mtimeNs))
+        *pen = metadados_de_pacote(*r);
+}
+
+/***************************************************************************
+* Função: garantir_pai_destino
+* Descrição:
+*   Cria no destino o diretório pai de uma entrada expandida, uma única
+*   vez por diretório na execução.
+***************************************************************************/
+
+static void garantir_pai_destino(ContextoBackup *ctx,
+                                 const std::string &nome) {
+    size_t barra = nome.rfind('/');
+    if (barra == std::string::npos)
+        return;
+    std::string pai = nome.substr(0, barra);
+    {
+        std::lock_guard<std::mutex> lk(ctx->mtxPaisCriados);
+        if (!ctx->paisCriados.insert(pai).second)
+            return;
+    }
+    std::error_code ec;
+    fs::create_directories(fs::path(ctx->dirDestino) / pai, ec);
+}
+
+/***************************************************************************
+* Função: sondar_lado
+* Descrição:
+*   Metadados de um arquivo do HD, do Pen ou do destino: relativos ao
+*   diretório pai em cache, se houver cache, ou pelo caminho completo.
+***************************************************************************/
+
+static Metadados sondar_lado(ContextoBackup *ctx, const std::string &raiz,
+                             const std::string &nome) {
+    if (ctx->diretorios != nullptr)
+        return ctx->diretorios->sondar(raiz, nome);
+    return sondar_metadados((fs::path(raiz) / nome).string());
+}
+
+/***************************************************************************
+* Função: copiar_para_destino
+* Descrição:
+*   Cópia comum de um arquivo do HD ou do Pen para o destino. Com o cache
+*   de diretórios, origem e destino são abertos relativos aos pais já
+*   abertos; se um deles não puder ser aberto, usa os caminhos completos.
+*   No modo sem cache de páginas, a cópia é a de copiar_arquivo_direto.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   raizOrigem - dirHD ou dirPen
+*   nome - nome relativo do arquivo
+*
+* Valor retornado:
+*   Estratégia que concluiu a cópia, ou COPIA_FALHOU.
+***************************************************************************/
+
+static EstrategiaCopia copiar_para_destino(ContextoBackup *ctx,
+                                           const std::string &raizOrigem,
+                                           const std::string &nome) {
+    if (ctx->semCache)
+        return copiar_arquivo_direto(
+            (fs::path(raizOrigem) / nome).string(),
+            (fs::path(ctx->dirDestino) / nome).string());
+    if (ctx->diretorios != nullptr) {
+        std::string base;
+        DiretorioAberto origem = ctx->diretorios->pai(raizOrigem, nome,
+                                                      &base);
+        DiretorioAberto destino = ctx->diretorios->pai(ctx->dirDestino,
+                                                       nome, &base);
+        if (origem != nullptr && destino != nullptr)
+            return copiar_arquivo_em(origem->fd(), base.c_str(),
+                                     destino->fd(), base.c_str());
+    }
+    return copiar_arquivo((fs::path(raizOrigem) / nome).string(),
+                          (fs::path(ctx->dirDestino) / nome).string());
+}
+
+/***************************************************************************
+* Função: decidir_acao
+* Descrição:
+*   Aplica a tabela de decisão aos metadados já obtidos do HD e do Pen,
+*   sem acessar o sistema de arquivos.
+*
+* Parâmetros:
+*   hd - metadados do arquivo no HD
+*   pen - metadados do arquivo no Pen
+*   backupSolicitado - true para backup (HD → Pen), false para restauração
+*   conteudo - resultado da verificação de conteúdo. Se verificado, o
+*              conteúdo igual dispensa a cópia e o diferente é copiado
+*              também quando as datas coincidem.
+*
+* Valor retornado:
+*   Código da ação a executar (enum Acao). Apenas A1 e A2 exigem cópia.
+***************************************************************************/
+
+static Acao decidir_acao(const Metadados &hd, const Metadados &pen,
+                         bool backupSolicitado,
+                         Conteudo conteudo = Conteudo::NAO_VERIFICADO) {
+    if (!hd.existe && !pen.existe)
+        return A6_IMPOSSIVEL;
+
+    if (conteudo == Conteudo::IGUAL)
+        return A4_NADA;
+    if (conteudo == Conteudo::DIFERENTE) {
+        if (backupSolicitado)
+            return (hd.mtimeNs >= pen.mtimeNs) ? A1_COPIAR_HD_PEN : A5_ERRO;
+        return (pen.mtimeNs >= hd.mtimeNs) ? A2_COPIAR_PEN_HD : A4_NADA;
+    }
+
+    if (backupSolicitado) {
+        if (hd.existe && !pen.existe)
+            return A1_COPIAR_HD_PEN;
+        else if (hd.existe && pen.existe && hd.mtimeNs > pen.mtimeNs)
+            return A1_COPIAR_HD_PEN;
+        else if (hd.existe && pen.existe && pen.mtimeNs > hd.mtimeNs)
+            return A5_ERRO;
+        return A4_NADA;
+    }
+
+    // modo restauração
+    if (!hd.existe && pen.existe)
+        return A2_COPIAR_PEN_HD;
+    else if (hd.existe && pen.existe && pen.mtimeNs > hd.mtimeNs)
+        return A2_COPIAR_PEN_HD;
+    return A4_NADA;
+}
+
+/***************************************************************************
+* Função: sondar_entrada
+* Descrição:
+*   Obtém os metadados dos dois lados de uma linha do Backup.parm, com
+*   uma única sondagem (statx) por lado, reaproveitada tanto para a
+*   existência quanto para a data de modificação. A do Pen é dispensada
+*   quando o índice de estado mostra que o arquivo do HD não mudou, e a
+*   de um lado que a listagem do pai mostrou não existir, sempre. Um
+*   arquivo guardado nos pacotes do Pen conta como presente nele.
+*
+* Parâmetros:
+*   entrada - linha do Backup.parm
+*   ctx - diretórios, modo e contadores da execução
+*   hd, pen - recebem os metadados de cada lado
+***************************************************************************/
+
+static void sondar_entrada(const ResultadoEntrada &entrada,
+                           ContextoBackup *ctx, Metadados *hd,
+                           Metadados *pen) {
+    const std::string &nomeArquivo = entrada.nome;
+    if (entrada.ausente & kAusenteHD) {
+        ctx->sondagensEvitadasListagem.fetch_add(1,
+                                                 std::memory_order_relaxed);
+    } else {
+        *hd = sondar_lado(ctx, ctx->dirHD, nomeArquivo);
+        ctx->chamadasMetadados.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (entrada.ausente & kAusentePen) {
+        ctx->sondagensEvitadasListagem.fetch_add(1,
+                                                 std::memory_order_relaxed);
+    } else if (!pen_pelo_indice(ctx, nomeArquivo, *hd, pen)) {
+        *pen = sondar_lado(ctx, ctx->dirPen, nomeArquivo);
+        ctx->chamadasMetadados.fetch_add(1, std::memory_order_relaxed);
+    }
+    pen_do_pacote(ctx, nomeArquivo, pen);
+}
+
+/***************************************************************************
+* Função: decidir_entrada
+* Descrição:
+*   Aplica a tabela de decisão aos metadados de uma linha. No modo de
+*   verificação, o conteúdo dos dois lados também é comparado; o estado
+*   é registrado no índice, se houver.
+*
+* Valor retornado:
+*   Código da ação a executar (enum Acao).
+***************************************************************************/
+
+static Acao decidir_entrada(const ResultadoEntrada &entrada,
+                            ContextoBackup *ctx, const Metadados &hd,
+                            const Metadados &pen) {
+    DigestsEntrada digests;
+    Conteudo conteudo = comparar_conteudo(ctx, entrada.nome, hd, pen,
+                                          &digests);
+    registrar_estado(ctx, entrada.nome, hd, pen, &digests);
+    return decidir_acao(hd, pen, ctx->backupSolicitado, conteudo);
+}
+
+/***************************************************************************
+* Função: copiar_entrada
+* Descrição:
+*   Executa a cópia de uma linha classificada como A1 ou A2. Os arquivos
+*   pequenos (empacotarAte) vão para pacotes e os que só existem nos
+*   pacotes do Pen são extraídos deles; no modo deduplicado, A1 grava
+*   chunks no armazém em vez de copiar; no modo delta, regrava só os
+*   blocos alterados do destino. Com o pool, um
+*   arquivo grande é copiado em partes paralelas pelos trabalhadores dele
+*   (copiar_arquivo_em_partes). Para entradas expandidas de uma
+*   linha-padrão, o diretório pai é criado no destino antes da cópia.
+*
+* Parâmetros:
+*   entrada - linha do Backup.parm
+*   ctx - contexto da execução
+*   acao - A1_COPIAR_HD_PEN ou A2_COPIAR_PEN_HD
+*   hd, pen - metadados usados na decisão
+*
+* Valor retornado:
+*   Tamanho do arquivo copiado, ou 0 se a cópia falhou.
+***************************************************************************/
+
+static uint64_t copiar_entrada(const ResultadoEntrada &entrada,
+                               ContextoBackup *ctx, Acao acao,
+                               const Metadados &hd, const Metadados &pen) {
+    assert(acao == A1_COPIAR_HD_PEN || acao == A2_COPIAR_PEN_HD);
+
+    const std::string &nomeArquivo = entrada.nome;
+    if (entrada.expandida)
+        garantir_pai_destino(ctx, nomeArquivo);
+    EstrategiaCopia estrategia;
+    if (!copiar_especial(ctx, nomeArquivo, acao, hd, pen, &estrategia)) {
+        const std::string &raiz = (acao == A1_COPIAR_HD_PEN) ?
+            ctx->dirHD : ctx->dirPen;
+        uint64_t tamanho = (acao == A1_COPIAR_HD_PEN) ? hd.tamanho :
+            pen.tamanho;
+        if (ctx->poolPartes != nullptr && ctx->limiteArquivoGrande > 0 &&
+            tamanho >= ctx->limiteArquivoGrande && !ctx->semCache) {
+            estrategia = copiar_arquivo_em_partes(AT_FDCWD,
+                (fs::path(raiz) / nomeArquivo).c_str(), AT_FDCWD,
+                (fs::path(ctx->dirDestino) / nomeArquivo).c_str(),
+                ctx->poolPartes, ctx->tamanhoParteCopia);
+            ctx->copiasGrandes.fetch_add(1, std::memory_order_relaxed);
+            ctx->partesCopia.fetch_add(
+                (tamanho + ctx->tamanhoParteCopia - 1) /
+                    ctx->tamanhoParteCopia, std::memory_order_relaxed);
+        } else {
+            estrategia = copiar_para_destino(ctx, raiz, nomeArquivo);
+        }
+        registrar_copia(ctx, nomeArquivo, estrategia);
+    }
+    if (estrategia == COPIA_FALHOU)
+        return 0;
+    registrar_gravado(ctx, nomeArquivo, acao,
+                      estrategia == COPIA_COMPRIMIDA ||
+                          estrategia == COPIA_CIFRADA);
+    return (acao == A1_COPIAR_HD_PEN) ? hd.tamanho : pen.tamanho;
+}
+
+/***************************************************************************
+* Função: processar_entrada
+* Descrição:
+*   Trata uma única linha do Backup.parm do início ao fim: sonda os dois
+*   lados, aplica a tabela de decisão e executa a cópia correspondente,
+*   se houver.
+*
+* Parâmetros:
+*   entrada - linha do Backup.parm (nome relativo, lados que a listagem
+*             do pai já mostrou não existir, origem expandida)
+*   ctx - diretórios, modo e contadores da execução
+*   bytes - recebe o tamanho do arquivo copiado (0 se não houve cópia)
+*
+* Valor retornado:
+*   Código da ação executada (enum Acao).
+*
+* Assertivas de entrada:
+*   entrada.nome != ""
+***************************************************************************/
+
+static Acao processar_entrada(const ResultadoEntrada &entrada,
+                              ContextoBackup *ctx, uint64_t *bytes) {
+    assert(!entrada.nome.empty());
+
+    Metadados hd, pen;
+    sondar_entrada(entrada, ctx, &hd, &pen);
+    Acao acao = decidir_entrada(entrada, ctx, hd, pen);
+    *bytes = 0;
+    if (acao == A1_COPIAR_HD_PEN || acao == A2_COPIAR_PEN_HD)
+        *bytes = copiar_entrada(entrada, ctx, acao, hd, pen);
+    return acao;
+}
+
+// Caminhos de um lote para as chamadas *at: o nome base relativo ao pai
+// aberto no cache (mantido aberto até o fim do lote) ou, sem cache, o
+// caminho completo relativo a AT_FDCWD.
+struct CaminhosLote {
+    std::vector<std::string> nomes;
+    std::vector<int> diretorios;
+    std::vector<DiretorioAberto> abertos;
+
+    void adicionar(ContextoBackup *ctx, const std::string &raiz,
+                   const std::string &nome);
+    size_t size() const { return nomes.size(); }
+    void clear() {
+        nomes.clear();
+        diretorios.clear();
+    }
+};
+
+void CaminhosLote::adicionar(ContextoBackup *ctx, const std::string &raiz,
+                             const std::string &nome) {
+    std::string base;
+    DiretorioAberto pai = (ctx->diretorios != nullptr) ?
+        ctx->diretorios->pai(raiz, nome, &base) : nullptr;
+    if (pai != nullptr) {
+        nomes.push_back(std::move(base));
+        diretorios.push_back(pai->fd());
+        abertos.push_back(std::move(pai));
+    } else {
+        nomes.push_back((fs::path(raiz) / nome).string());
+        diretorios.push_back(AT_FDCWD);
+    }
+}
+
+/***************************************************************************
+* Função: sondar_lote
+* Descrição:
+*   Sonda um lote de caminhos pelo anel io_uring; se o anel falhar, refaz
+*   as sondagens uma a uma.
+***************************************************************************/
+
+static void sondar_lote(AnelIoUring *anel, const CaminhosLote &caminhos,
+                        std::vector<Metadados> *metas) {
+    if (sondar_lote_io_uring(anel, caminhos.nomes, metas,
+                             &caminhos.diretorios))
+        return;
+    metas->clear();
+    for (size_t i = 0; i < caminhos.size(); ++i)
+        metas->push_back(sondar_metadados_em(caminhos.diretorios[i],
+                                             caminhos.nomes[i].c_str()));
+}
+
+/***************************************************************************
+* Função: processar_com_io_uring
+* Descrição:
+*   Variante de processamento que roda na thread chamadora e usa o anel
+*   io_uring: para cada lote de linhas, as sondagens do HD são submetidas
+*   juntas, depois as do Pen que o índice de estado não dispensou; a
+*   tabela de decisão é aplicada e as cópias do lote são feitas pelo
+*   anel. Se o anel falhar, as sondagens e cópias afetadas são refeitas
+*   pelo caminho síncrono.
+*
+* Parâmetros:
+*   resultados - linhas do Backup.parm; recebe o código de cada ação
+*   ctx - diretórios, modo e contadores da execução
+*   anel - anel io_uring disponível
+*
+* Assertivas de entrada:
+*   anel->disponivel()
+***************************************************************************/
+
+static void processar_com_io_uring(std::vector<ResultadoEntrada> *resultados,
+                                   ContextoBackup *ctx, AnelIoUring *anel) {
+    assert(anel->disponivel());
+
+    for (size_t ini = 0; ini < resultados->size();
+         ini += kEntradasPorLote) {
+        size_t fim = std::min(ini + kEntradasPorLote, resultados->size());
+        auto t0 = std::chrono::steady_clock::now();
+
+        // Primeiro o HD; o Pen só para as linhas sem registro válido
+        // no índice de estado. Os lados que a listagem já mostrou não
+        // existir não são sondados
+        CaminhosLote caminhos;
+        std::vector<size_t> sondadas;
+        uint64_t evitadas = 0;
+        for (size_t i = ini; i < fim; ++i) {
+            if ((*resultados)[i].ausente & kAusenteHD) {
+                ++evitadas;
+                continue;
+            }
+            sondadas.push_back(i - ini);
+            caminhos.adicionar(ctx, ctx->dirHD, (*resultados)[i].nome);
+        }
+        std::vector<Metadados> metasHD(fim - ini), sondados;
+        sondar_lote(anel, caminhos, &sondados);
+        for (size_t k = 0; k < sondadas.size(); ++k)
+            metasHD[sondadas[k]] = sondados[k];
+        uint64_t chamadas = caminhos.size();
+
+        std::vector<Metadados> metasPen(fim - ini);
+        sondadas.clear();
+        caminhos.clear();
+        for (size_t i = ini; i < fim; ++i) {
+            const std::string &nome = (*resultados)[i].nome;
+            if ((*resultados)[i].ausente & kAusentePen) {
+                ++evitadas;
+                continue;
+            }
+            if (pen_pelo_indice(ctx, nome, metasHD[i - ini],
+                                &metasPen[i - ini]))
+                continue;
+            sondadas.push_back(i - ini);
+            caminhos.adicionar(ctx, ctx->dirPen, nome);
+        }
+        sondar_lote(anel, caminhos, &sondados);
+        for (size_t k = 0; k < sondadas.size(); ++k)
+            metasPen[sondadas[k]] = sondados[k];
+        for (size_t i = ini; i < fim; ++i)
+            pen_do_pacote(ctx, (*resultados)[i].nome, &metasPen[i - ini]);
+        chamadas += caminhos.size();
+        ctx->chamadasMetadados += chamadas;
+        ctx->sondagensEvitadasListagem += evitadas;
+
+        std::vector<CopiaLote> copias;
+        std::vector<size_t> linhaDaCopia;
+        for (size_t i = ini; i < fim; ++i) {
+            const std::string &nome = (*resultados)[i].nome;
+            const Metadados &hd = metasHD[i - ini];
+            const Metadados &pen = metasPen[i - ini];
+            Acao acao = decidir_entrada((*resultados)[i], ctx, hd, pen);
+            (*resultados)[i].acao = static_cast<int>(acao);
+            (*resultados)[i].bytes = 0;
+            if (acao != A1_COPIAR_HD_PEN && acao != A2_COPIAR_PEN_HD)
+                continue;
+            bool doHD = acao == A1_COPIAR_HD_PEN;
+            if ((*resultados)[i].expandida)
+                garantir_pai_destino(ctx, nome);
+            EstrategiaCopia estrategia;
+            if (copiar_especial(ctx, nome, acao, hd, pen, &estrategia)) {
+                if (estrategia != COPIA_FALHOU) {
+                    (*resultados)[i].bytes = doHD ? hd.tamanho : pen.tamanho;
+                    registrar_gravado(ctx, nome, acao,
+                                      estrategia == COPIA_COMPRIMIDA ||
+                                          estrategia == COPIA_CIFRADA);
+                }
+                continue;
+            }
+            CaminhosLote par;
+            par.adicionar(ctx, doHD ? ctx->dirHD : ctx->dirPen, nome);
+            par.adicionar(ctx, ctx->dirDestino, nome);
+            copias.push_back({par.nomes[0], par.nomes[1], doHD ? hd : pen,
+                              par.diretorios[0], par.diretorios[1]});
+            caminhos.abertos.insert(caminhos.abertos.end(),
+                                    par.abertos.begin(), par.abertos.end());
+            linhaDaCopia.push_back(i);
+        }
+
+        std::vector<bool> copiado;
+        copiar_lote_io_uring(anel, copias, &copiado);
+        for (size_t k = 0; k < copias.size(); ++k) {
+            EstrategiaCopia estrategia = copiado[k] ? COPIA_IO_URING :
+                copiar_arquivo_em(copias[k].dirOrigem,
+                                  copias[k].origem.c_str(),
+                                  copias[k].dirDestino,
+                                  copias[k].destino.c_str());
+            ResultadoEntrada &r = (*resultados)[linhaDaCopia[k]];
+            registrar_copia(ctx, r.nome, estrategia);
+            if (estrategia == COPIA_FALHOU)
+                continue;
+            r.bytes = copias[k].meta.tamanho;
+            registrar_gravado(ctx, r.nome, static_cast<Acao>(r.acao));
+        }
+
+        // No lote, as entradas são tratadas juntas: cada uma recebe uma
+        // fração igual do tempo dele
+        if (ctx->medirEntradas) {
+            uint64_t ns = std::chrono::duration_cast<
+                std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+            for (size_t i = ini; i < fim; ++i)
+                (*resultados)[i].duracaoNs = ns / (fim - ini);
+        }
+    }
+}
+
+// Linhas do Backup.parm entregues em janelas, na ordem original, sem
+// manter o manifesto inteiro em memória.
+class FonteManifesto {
+ public:
+    FonteManifesto(const std::string &backupParm,
+                   const std::string &manifestoCompilado,
+                   const std::string &dirHD, const std::string &dirPen,
+                   PoolTarefas *poolPercurso = nullptr);
+
+    bool compiladoUsado() const { return compiladoUsado_; }
+    bool proxima_janela(size_t maximo,
+                        std::vector<ResultadoEntrada> *janela);
+    uint64_t arquivosExpandidos() const { return arquivosExpandidos_; }
+    uint64_t diretoriosPercorridos() const {
+        return diretoriosPercorridos_;
+    }
+
+ private:
+    bool proxima_linha(std::string *linha);
+
+    std::unique_ptr<ManifestoBinario> bin_;
+    uint32_t proxima_ = 0;  // linhas já lidas do binário
+    const std::string &backupParm_;
+    std::unique_ptr<LeitorManifesto> texto_;
+    const std::string &dirHD_;
+    const std::string &dirPen_;
+    PoolTarefas *poolPercurso_;
+    std::unique_ptr<ExpansaoEntrada> expansao_;  // linha-padrão em curso
+    uint64_t arquivosExpandidos_ = 0;
+    uint64_t diretoriosPercorridos_ = 0;
+    bool compiladoUsado_ = false;
+};
+
+/***************************************************************************
+* Função: FonteManifesto::FonteManifesto
+* Descrição:
+*   Abre o manifesto compilado, se houver um válido e atualizado, ou o
+*   Backup.parm textual. Só o cabeçalho do binário é conferido aqui, sem
+*   percorrer as entradas: cada uma é conferida ao ser lida (ver
+*   proxima_linha).
+*
+* Parâmetros:
+*   backupParm - Backup.parm textual
+*   manifestoCompilado - manifesto compilado ("" = não usar)
+*   dirHD, dirPen - raízes em que as linhas-padrão são expandidas
+*   poolPercurso - pool para expandi-las em paralelo; nulo = sequencial
+***************************************************************************/
+
+FonteManifesto::FonteManifesto(const std::string &backupParm,
+                               const std::string &manifestoCompilado,
+                               const std::string &dirHD,
+                               const std::string &dirPen,
+                               PoolTarefas *poolPercurso)
+    : backupParm_(backupParm), dirHD_(dirHD), dirPen_(dirPen),
+      poolPercurso_(poolPercurso) {
+    if (!manifestoCompilado.empty()) {
+        bin_.reset(new ManifestoBinario(manifestoCompilado, backupParm));
+        compiladoUsado_ = bin_->valido();
+        if (compiladoUsado_)
+            return;
+        bin_.reset();
+    }
+    texto_.reset(new LeitorManifesto(backupParm));
+}
+
+/***************************************************************************
+* Função: FonteManifesto::proxima_linha
+* Descrição:
+*   Entrega a próxima linha não vazia, do binário (na ordem do
+*   Backup.parm, pela tabela de posições) ou do texto. Uma entrada
+*   corrompida no binário faz a leitura continuar pelo texto, a partir
+*   da mesma linha: o texto não mudou desde a compilação (o cabeçalho
+*   confere), então as linhas já entregues são as primeiras dele.
+*
+* Valor retornado:
+*   false quando não há mais linhas
+***************************************************************************/
+
+bool FonteManifesto::proxima_linha(std::string *linha) {
+    if (bin_) {
+        if (proxima_ == bin_->numEntradas())
+            return false;
+        EntradaCompilada e;
+        if (bin_->entrada_na_ordem(proxima_, &e) &&
+            !(e.pai.empty() && e.base.empty())) {
+            ++proxima_;
+            *linha = e.nome();
+            return true;
+        }
+        bin_.reset();
+        texto_.reset(new LeitorManifesto(backupParm_));
+        std::string_view pular;
+        for (uint32_t i = 0; i < proxima_ && texto_->aberto() &&
+             texto_->proxima_linha(&pular);)
+            if (!pular.empty())
+                ++i;
+    }
+    std::string_view texto;
+    while (texto_->aberto() && texto_->proxima_linha(&texto)) {
+        if (texto.empty())
+            continue;
+        linha->assign(texto);
+        return true;
+    }
+    return false;
+}
+
+/***************************************************************************
+* Função: FonteManifesto::proxima_janela
+* Descrição:
+*   Preenche a janela com até 'maximo' linhas não vazias seguintes, na
+*   ordem do Backup.parm, cada uma ainda sem resultado. Uma linha-padrão
+*   (diretório com '/' no fim ou nome com curingas) é substituída pelos
+*   arquivos que casam com ela, descobertos à medida que a janela é
+*   preenchida: a expansão pode continuar pelas janelas seguintes, sem
+*   que a lista inteira seja montada antes.
+*
+* Valor retornado:
+*   false quando não há mais linhas
+***************************************************************************/
+
+bool FonteManifesto::proxima_janela(
+    size_t maximo, std::vector<ResultadoEntrada> *janela) {
+    janela->clear();
+    std::string linha;
+    while (janela->size() < maximo) {
+        if (expansao_) {
+            if (expansao_->proximo(&linha)) {
+                janela->push_back({std::move(linha)});
+                janela->back().expandida = true;
+                ++arquivosExpandidos_;
+                continue;
+            }
+            diretoriosPercorridos_ += expansao_->diretoriosLidos();
+            expansao_.reset();
+        }
+        if (!proxima_linha(&linha))
+            break;
+        if (eh_padrao(linha))
+            expansao_.reset(new ExpansaoEntrada(dirHD_, dirPen_, linha,
+                                                poolPercurso_));
+        else
+            janela->push_back({std::move(linha)});
+    }
+    return !janela->empty();
+}
+
+/***************************************************************************
+* Função: listar_lado
+* Descrição:
+*   Para as linhas de uma janela que têm o mesmo diretório pai, marca as
+*   que não existem em um dos lados (HD ou Pen). Se o pai não existe,
+*   nenhuma delas existe; senão, o diretório é lido de uma vez
+*   (getdents64) quando o tamanho dele é pequeno para o número de
+*   linhas (ver vale_enumerar); senão, todas ficam para a sondagem
+*   individual. A listagem é guardada e atende as janelas seguintes; um
+*   diretório não listado é reavaliado na próxima janela em que aparecer.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   raiz - dirHD ou dirPen
+*   pai - diretório pai relativo à raiz ("" = a raiz)
+*   indices - linhas da janela com esse pai
+*   janela - linhas da janela; recebe a marca em ausente
+*   marca - kAusenteHD ou kAusentePen
+***************************************************************************/
+
+static void listar_lado(ContextoBackup *ctx, const std::string &raiz,
+                        std::string_view pai,
+                        const std::vector<uint32_t> &indices,
+                        std::vector<ResultadoEntrada> *janela,
+                        uint8_t marca) {
+    std::string chave(raiz);
+    chave.push_back('\0');
+    chave.append(pai);
+    std::shared_ptr<const ListagemDiretorio> guardada;
+    {
+        std::lock_guard<std::mutex> lk(ctx->mtxListagens);
+        auto it = ctx->listagens.find(chave);
+        if (it != ctx->listagens.end())
+            guardada = it->second;
+    }
+
+    if (guardada == nullptr) {
+        int dirfd = AT_FDCWD;
+        std::string caminho = pai.empty() ? raiz :
+            (fs::path(raiz) / pai).string();
+        DiretorioAberto aberto;
+        if (ctx->diretorios != nullptr) {
+            aberto = ctx->diretorios->abrir(raiz, pai);
+            if (aberto != nullptr) {
+                dirfd = aberto->fd();
+                caminho = ".";
+            }
+        }
+        struct stat st;
+        auto nova = std::make_shared<ListagemDiretorio>();
+        bool paiExiste = fstatat(dirfd, caminho.c_str(), &st, 0) == 0;
+        if (!paiExiste && errno != ENOENT && errno != ENOTDIR)
+            return;
+        if (paiExiste && S_ISDIR(st.st_mode)) {
+            if (!vale_enumerar(indices.size(),
+                               static_cast<uint64_t>(st.st_size)) ||
+                !nova->ler(dirfd, caminho.c_str()))
+                return;
+            ctx->diretoriosListados.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lk(ctx->mtxListagens);
+        guardada = ctx->listagens.emplace(std::move(chave),
+                                          std::move(nova)).first->second;
+    }
+
+    for (uint32_t i : indices) {
+        ResultadoEntrada &r = (*janela)[i];
+        std::string_view base = std::string_view(r.nome).substr(
+            pai.empty() ? 0 : pai.size() + 1);
+        if (!guardada->contem(base))
+            r.ausente |= marca;
+    }
+}
+
+/***************************************************************************
+* Função: marcar_ausentes
+* Descrição:
+*   Modo de listagem de diretórios: agrupa as linhas da janela pelo
+*   diretório pai e, para cada grupo, marca as que não existem no HD e no
+*   Pen, de modo que elas não precisem de uma sondagem cada. Os grupos
+*   são divididos entre os trabalhadores do pool, se houver. Linhas cujo
+*   nome base é vazio, "." ou "..", e as de um arquivo na raiz do sistema
+*   ("/arquivo"), ficam sempre para a sondagem.
+*
+* Parâmetros:
+*   janela - linhas da janela
+*   ctx - contexto da execução
+***************************************************************************/
+
+static void marcar_ausentes(std::vector<ResultadoEntrada> *janela,
+                            ContextoBackup *ctx) {
+    std::unordered_map<std::string_view, std::vector<uint32_t>> porPai;
+    for (uint32_t i = 0; i < janela->size(); ++i) {
+        std::string_view nome = (*janela)[i].nome;
+        size_t barra = nome.rfind('/');
+        std::string_view pai = (barra == std::string_view::npos) ?
+            std::string_view() : nome.substr(0, barra);
+        std::string_view base = (barra == std::string_view::npos) ?
+            nome : nome.substr(barra + 1);
+        if (barra == 0 || base.empty() || base == "." || base == "..")
+            continue;
+        porPai[pai].push_back(i);
+    }
+
+    GrupoTarefas grupo;
+    for (const auto &par : porPai) {
+        auto tarefa = [ctx, janela, &par] {
+            listar_lado(ctx, ctx->dirHD, par.first, par.second, janela,
+                        kAusenteHD);
+            listar_lado(ctx, ctx->dirPen, par.first, par.second, janela,
+                        kAusentePen);
+        };
+        if (ctx->pool != nullptr)
+            ctx->pool->submeter(&grupo, tarefa);
+        else
+            tarefa();
+    }
+    if (ctx->pool != nullptr)
+        ctx->pool->aguardar(&grupo);
+}
+
+// Classifica e copia uma linha, medindo o tempo dela se pedido.
+static void tratar_linha(ResultadoEntrada *r, ContextoBackup *ctx) {
+    auto t0 = ctx->medirEntradas ? std::chrono::steady_clock::now() :
+        std::chrono::steady_clock::time_point();
+    r->acao = static_cast<int>(processar_entrada(*r, ctx, &r->bytes));
+    if (ctx->medirEntradas)
+        r->duracaoNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+}
+
+/***************************************************************************
+* Função: processar_com_pool
+* Descrição:
+*   Classifica e copia as linhas da janela em paralelo: cada tarefa trata
+*   um bloco contíguo de linhas e grava o resultado na posição
+*   correspondente.
+***************************************************************************/
+
+static void processar_com_pool(std::vector<ResultadoEntrada> *janela,
+                               ContextoBackup *ctx, PoolTarefas *pool) {
+    GrupoTarefas grupo;
+    for (size_t ini = 0; ini < janela->size(); ini += kEntradasPorTarefa) {
+        size_t fim = std::min(ini + kEntradasPorTarefa, janela->size());
+        pool->submeter(&grupo, [janela, ctx, ini, fim] {
+            for (size_t i = ini; i < fim; ++i)
+                tratar_linha(&(*janela)[i], ctx);
+        });
+    }
+    pool->aguardar(&grupo);
+}
+
+/***************************************************************************
+* Função: separar_repetidas
+* Descrição:
+*   Retira da janela as linhas cujo nome repete o de uma linha anterior
+*   dela. Tratadas ao mesmo tempo que a primeira, as duas gravariam o
+*   mesmo destino; elas ficam para devolver_repetidas, que as trata uma
+*   a uma, em ordem, depois do resto da janela.
+*
+* Parâmetros:
+*   janela - linhas da janela; perde as repetidas
+*   posicoes - recebe a posição original de cada repetida
+*   repetidas - recebe as linhas retiradas
+***************************************************************************/
+
+static void separar_repetidas(std::vector<ResultadoEntrada> *janela,
+                              std::vector<size_t> *posicoes,
+                              std::vector<ResultadoEntrada> *repetidas) {
+    posicoes->clear();
+    repetidas->clear();
+    std::unordered_set<std::string_view> vistos;
+    vistos.reserve(janela->size());
+    for (size_t i = 0; i < janela->size(); ++i)
+        if (!vistos.insert((*janela)[i].nome).second)
+            posicoes->push_back(i);
+    if (posicoes->empty())
+        return;
+
+    std::vector<ResultadoEntrada> restantes;
+    restantes.reserve(janela->size() - posicoes->size());
+    size_t k = 0;
+    for (size_t i = 0; i < janela->size(); ++i) {
+        if (k < posicoes->size() && (*posicoes)[k] == i) {
+            repetidas->push_back(std::move((*janela)[i]));
+            ++k;
+        } else {
+            restantes.push_back(std::move((*janela)[i]));
+        }
+    }
+    janela->swap(restantes);
+}
+
+// Devolve as linhas retiradas por separar_repetidas, já tratadas, às
+// posições originais da janela.
+static void reinserir_repetidas(std::vector<ResultadoEntrada> *janela,
+                                const std::vector<size_t> &posicoes,
+                                std::vector<ResultadoEntrada> *repetidas) {
+    if (posicoes.empty())
+        return;
+    std::vector<ResultadoEntrada> completa;
+    completa.reserve(janela->size() + repetidas->size());
+    size_t k = 0, j = 0;
+    for (size_t i = 0; i < janela->size() + repetidas->size(); ++i) {
+        if (k < posicoes.size() && posicoes[k] == i)
+            completa.push_back(std::move((*repetidas)[k++]));
+        else
+            completa.push_back(std::move((*janela)[j++]));
+    }
+    janela->swap(completa);
+}
+
+// Trata as linhas retiradas por separar_repetidas, na ordem e na thread
+// chamadora, e as devolve à janela. A marca de ausência da listagem é
+// descartada: a primeira linha pode ter criado o arquivo.
+static void devolver_repetidas(std::vector<ResultadoEntrada> *janela,
+                               const std::vector<size_t> &posicoes,
+                               std::vector<ResultadoEntrada> *repetidas,
+                               ContextoBackup *ctx) {
+    for (ResultadoEntrada &r : *repetidas) {
+        r.ausente = 0;
+        tratar_linha(&r, ctx);
+    }
+    reinserir_repetidas(janela, posicoes, repetidas);
+}
+
+static uint64_t ns_desde(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - t0).count();
+}
+
+// Indica se dois caminhos levam ao mesmo diretório (falso se um deles
+// não existe).
+static bool mesmo_diretorio(const std::string &a, const std::string &b) {
+    std::error_code ec;
+    return !a.empty() && !b.empty() && fs::equivalent(a, b, ec);
+}
+
+// Trabalhadores do zstd por arquivo comprimido: os pedidos, ou os
+// núcleos divididos entre as cópias que podem estar comprimindo ao mesmo
+// tempo. No pool padrão (um trabalhador por núcleo) isso dá 1, e só
+// quando as cópias são feitas uma a uma um arquivo grande usa todos.
+static unsigned threads_compressao(unsigned pedidas,
+                                   unsigned copiasSimultaneas) {
+    if (pedidas > 0)
+        return pedidas;
+    unsigned nucleos = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::max(nucleos / std::max(copiasSimultaneas, 1u), 1u);
+}
+
+// Uso de PoolBuffers::global() desde 'antes' (o pico é o da execução, se
+// reiniciado no início dela).
+static void preencher_buffers(const EstatisticasBuffers &antes,
+                              EstatisticasBackup *est) {
+    EstatisticasBuffers agora = PoolBuffers::global().estatisticas();
+    est->pedidosBuffers = agora.pedidos - antes.pedidos;
+    est->acertosBuffers = agora.acertosCache + agora.acertosGlobal -
+        antes.acertosCache - antes.acertosGlobal;
+    est->esperasBuffers = agora.esperas - antes.esperas;
+    est->picoBytesBuffers = agora.picoBytesEmUso;
+    est->taxaAcertoBuffers = est->pedidosBuffers == 0 ? 0 :
+        double(est->acertosBuffers) / est->pedidosBuffers;
+}
+
+// Contador de eventos para quem espera uma fila sem travas ficar não
+// vazia (ou não cheia): a thread lê a época com preparar, confere a fila
+// de novo e, se ela ainda não serve, dorme em esperar até a época mudar.
+// Quem altera a fila chama avisar, que só toma a trava quando há alguém
+// preparado, de modo que o caminho sem espera continua sem travas.
+class ContadorEventos {
+ public:
+    uint64_t preparar() {
+        esperando_.fetch_add(1);
+        return epoca_.load();
+    }
+    void cancelar() { esperando_.fetch_sub(1); }
+    void esperar(uint64_t epoca) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        cv_.wait(lk, [this, epoca] { return epoca_.load() != epoca; });
+        esperando_.fetch_sub(1);
+    }
+    void avisar() {
+        epoca_.fetch_add(1);
+        if (esperando_.load() == 0)
+            return;
+        std::lock_guard<std::mutex> lk(mtx_);
+        cv_.notify_all();
+    }
+
+ private:
+    std::atomic<uint64_t> epoca_{0};
+    std::atomic<unsigned> esperando_{0};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+};
+
+// Insere na fila, dormindo em 'vaga' enquanto ela estiver cheia, e
+// avisa 'chegada'. Devolve o tempo de espera em ns.
+template <typename T>
+static uint64_t inserir_esperando(FilaLimitada<T> *fila, T valor,
+                                  ContadorEventos *vaga,
+                                  ContadorEventos *chegada) {
+    uint64_t bloqueado = 0;
+    if (!fila->inserir(std::move(valor))) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (;;) {
+            uint64_t epoca = vaga->preparar();
+            if (fila->inserir(std::move(valor))) {
+                vaga->cancelar();
+                break;
+            }
+            vaga->esperar(epoca);
+        }
+        bloqueado = ns_desde(t0);
+    }
+    chegada->avisar();
+    return bloqueado;
+}
+
+struct ItemPipeline;
+
+// Intervalo [inicio, fim) de um arquivo grande, tratado por um
+// trabalhador da cópia.
+struct ParteCopia {
+    ItemPipeline *item = nullptr;
+    uint64_t inicio = 0;
+    uint64_t fim = 0;
+};
+
+// Cópia de um arquivo grande: a abertura é a primeira tarefa da fila de
+// grandes, e quem a pega divide o arquivo em partes e devolve as demais
+// à fila; quem copia a última parte conclui a linha.
+struct CopiaGrande {
+    ParteCopia abertura;
+    CopiaParticionada copia;
+    std::vector<ParteCopia> partes;
+    std::atomic<size_t> restantes{0};
+};
+
+// Linha da janela em trânsito pelo pipeline, com o que cada estágio
+// produz para o seguinte.
+struct ItemPipeline {
+    ResultadoEntrada *entrada = nullptr;
+    Metadados hd, pen;
+    Conteudo conteudo = Conteudo::NAO_VERIFICADO;
+    DigestsEntrada digests;
+    Acao acao = A4_NADA;
+    std::chrono::steady_clock::time_point inicio;
+    std::unique_ptr<CopiaGrande> grande;  // só na fila de grandes
+};
+
+// Pipeline de três estágios (metadados → decisão → cópia) com
+// trabalhadores próprios, ligados por filas limitadas sem travas: um
+// estágio com a fila seguinte cheia espera (contrapressão), de modo que
+// as sondagens não se adiantam indefinidamente às cópias. Quem não tem
+// trabalho, ou vaga na fila seguinte, dorme no ContadorEventos dela. Com
+// o escalonamento por tamanho, a cópia tem uma segunda fila, de partes
+// de arquivos grandes, e trabalhadores reservados para cada uma.
+class PipelineBackup {
+ public:
+    PipelineBackup(ContextoBackup *ctx, const OpcoesBackup &opcoes);
+    ~PipelineBackup();
+
+    PipelineBackup(const PipelineBackup &) = delete;
+    PipelineBackup &operator=(const PipelineBackup &) = delete;
+
+    void processar(std::vector<ResultadoEntrada> *janela);
+    void encerrar();
+    void estatisticas(EstatisticasEstagio saida[3], uint64_t *copiasGrandes,
+                      uint64_t *partesCopia) const;
+
+ private:
+    struct Estagio {
+        explicit Estagio(size_t capacidade) : fila(capacidade) {}
+
+        FilaLimitada<ItemPipeline *> fila;  // entrada do estágio
+        ContadorEventos chegada;  // na cópia, também a fila de grandes
+        ContadorEventos vaga;
+        std::vector<std::thread> threads;
+        std::atomic<uint64_t> itens{0};
+        std::atomic<uint64_t> ocupadoNs{0};
+        std::atomic<uint64_t> bloqueadoNs{0};
+        std::atomic<uint64_t> somaFila{0};
+        std::atomic<uint64_t> amostrasFila{0};
+        std::atomic<uint64_t> picoFila{0};
+    };
+
+    void laco(size_t estagio);
+    void laco_copia(bool preferirGrandes);
+    bool retirar_copia(bool preferirGrandes, ItemPipeline **item,
+                       ParteCopia **parte);
+    uint64_t tratar(size_t estagio, ItemPipeline *item);
+    uint64_t enviar(size_t destino, ItemPipeline *item);
+    bool eh_grande(const ItemPipeline &item) const;
+    void abrir_grande(ItemPipeline *item);
+    void copiar_parte(ParteCopia *parte);
+    void concluir(ItemPipeline *item);
+
+    ContextoBackup *ctx_;
+    std::vector<std::unique_ptr<Estagio>> estagios_;
+    FilaLimitada<ParteCopia *> filaGrandes_;
+    ContadorEventos vagaGrandes_;
+    uint64_t limiteGrande_;
+    uint64_t tamanhoParte_;
+    std::atomic<uint64_t> copiasGrandes_{0};
+    std::atomic<uint64_t> partesCopia_{0};
+    std::atomic<size_t> concluidos_{0};
+    size_t total_ = 0;  // linhas da janela em andamento
+    std::mutex mtxConcluidos_;
+    std::condition_variable cvConcluidos_;
+    std::atomic<bool> parar_{false};
+    uint64_t duracaoNs_ = 0;  // tempo total com janelas em andamento
+};
+
+/***************************************************************************
+* Função: PipelineBackup::PipelineBackup
+* Descrição:
+*   Cria as filas dos três estágios e inicia os trabalhadores de cada um,
+*   que ficam ativos entre as janelas. Com o escalonamento por tamanho, a
+*   cópia ganha os trabalhadores reservados aos arquivos grandes.
+*
+* Parâmetros:
+*   ctx - contexto da execução
+*   opcoes - larguras dos estágios (mínimo 1), capacidade das filas e
+*            parâmetros do escalonamento por tamanho
+***************************************************************************/
+
+PipelineBackup::PipelineBackup(ContextoBackup *ctx,
+                               const OpcoesBackup &opcoes)
+    : ctx_(ctx),
+      filaGrandes_(std::max<size_t>(opcoes.capacidadeFilaPipeline, 1)),
+      limiteGrande_(opcoes.limiteArquivoGrande),
+      tamanhoParte_(std::max<uint64_t>(opcoes.tamanhoParteCopia, 1)) {
+    const unsigned larguras[3] = {opcoes.trabalhadoresMetadados,
+                                  opcoes.trabalhadoresDecisao,
+                                  opcoes.trabalhadoresCopia};
+    for (size_t k = 0; k < 3; ++k)
+        estagios_.emplace_back(new Estagio(
+            std::max<size_t>(opcoes.capacidadeFilaPipeline, 1)));
+    for (size_t k = 0; k < 2; ++k)
+        for (unsigned t = 0; t < std::max(larguras[k], 1u); ++t)
+            estagios_[k]->threads.emplace_back(&PipelineBackup::laco, this,
+                                               k);
+    std::vector<std::thread> &copia = estagios_[2]->threads;
+    for (unsigned t = 0; t < std::max(larguras[2], 1u); ++t)
+        copia.emplace_back(&PipelineBackup::laco_copia, this, false);
+    if (limiteGrande_ > 0)
+        for (unsigned t = 0; t < std::max(opcoes.trabalhadoresGrandes, 1u);
+             ++t)
+            copia.emplace_back(&PipelineBackup::laco_copia, this, true);
+}
+
+PipelineBackup::~PipelineBackup() {
+    encerrar();
+}
+
+// Termina os trabalhadores, entre janelas e com as filas vazias; depois
+// disso, as estatísticas estão completas (a última linha de uma janela
+// acorda processar antes de o trabalhador dela somar os contadores).
+void PipelineBackup::encerrar() {
+    parar_.store(true);
+    for (auto &e : estagios_)
+        e->chegada.avisar();
+    for (auto &e : estagios_)
+        for (auto &t : e->threads)
+            if (t.joinable())
+                t.join();
+}
+
+void PipelineBackup::laco(size_t estagio) {
+    Estagio &e = *estagios_[estagio];
+    for (;;) {
+        ItemPipeline *item;
+        if (!e.fila.retirar(&item)) {
+            uint64_t epoca = e.chegada.preparar();
+            if (e.fila.retirar(&item)) {
+                e.chegada.cancelar();
+            } else if (parar_.load()) {
+                e.chegada.cancelar();
+                return;
+            } else {
+                e.chegada.esperar(epoca);
+                continue;
+            }
+        }
+        e.vaga.avisar();
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t bloqueado = tratar(estagio, item);
+        e.ocupadoNs.fetch_add(ns_desde(t0) - bloqueado,
+                              std::memory_order_relaxed);
+        e.bloqueadoNs.fetch_add(bloqueado, std::memory_order_relaxed);
+        e.itens.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/***************************************************************************
+* Função: PipelineBackup::tratar
+* Descrição:
+*   Executa a parte de um estágio sobre uma linha e a passa adiante: os
+*   metadados (e, no modo de verificação, os digests, que são o trabalho
+*   pesado e por isso ficam no estágio mais largo) seguem para a decisão,
+*   e só as linhas A1/A2 chegam ao estágio de cópia, na fila de grandes
+*   ou na comum.
+*
+* Valor retornado:
+*   Tempo, em ns, que o estágio esperou por vaga na fila seguinte.
+***************************************************************************/
+
+uint64_t PipelineBackup::tratar(size_t estagio, ItemPipeline *item) {
+    ResultadoEntrada &r = *item->entrada;
+    switch (estagio) {
+    case 0:
+        if (ctx_->medirEntradas)
+            item->inicio = std::chrono::steady_clock::now();
+        sondar_entrada(r, ctx_, &item->hd, &item->pen);
+        item->conteudo = comparar_conteudo(ctx_, r.nome, item->hd,
+                                           item->pen, &item->digests);
+        return enviar(1, item);
+    case 1:
+        registrar_estado(ctx_, r.nome, item->hd, item->pen, &item->digests);
+        item->acao = decidir_acao(item->hd, item->pen,
+                                  ctx_->backupSolicitado, item->conteudo);
+        r.acao = static_cast<int>(item->acao);
+        r.bytes = 0;
+        if (item->acao != A1_COPIAR_HD_PEN &&
+            item->acao != A2_COPIAR_PEN_HD) {
+            concluir(item);
+            return 0;
+        }
+        if (eh_grande(*item)) {
+            item->grande.reset(new CopiaGrande());
+            item->grande->abertura.item = item;
+            return inserir_esperando(&filaGrandes_,
+                                     &item->grande->abertura, &vagaGrandes_,
+                                     &estagios_[2]->chegada);
+        }
+        return enviar(2, item);
+    default:
+        r.bytes = copiar_entrada(r, ctx_, item->acao, item->hd, item->pen);
+        concluir(item);
+        return 0;
+    }
+}
+
+// Insere na fila do estágio de destino, esperando enquanto ela estiver
+// cheia, e amostra a ocupação dela. Devolve o tempo de espera em ns.
+uint64_t PipelineBackup::enviar(size_t destino, ItemPipeline *item) {
+    Estagio &e = *estagios_[destino];
+    uint64_t bloqueado = inserir_esperando(&e.fila, item, &e.vaga,
+                                           &e.chegada);
+    uint64_t ocupacao = e.fila.ocupacao();
+    e.somaFila.fetch_add(ocupacao, std::memory_order_relaxed);
+    e.amostrasFila.fetch_add(1, std::memory_order_relaxed);
+    uint64_t pico = e.picoFila.load(std::memory_order_relaxed);
+    while (ocupacao > pico &&
+           !e.picoFila.compare_exchange_weak(pico, ocupacao,
+                                             std::memory_order_relaxed)) {
+    }
+    return bloqueado;
+}
+
+/***************************************************************************
+* Função: PipelineBackup::laco_copia
+* Descrição:
+*   Laço de um trabalhador da cópia. Cada um tem uma fila preferida (a
+*   de arquivos pequenos ou a de partes de arquivos grandes) e só
+*   recorre à outra quando a sua está vazia; como as partes têm tamanho
+*   limitado, ajudar nunca prende um trabalhador dos pequenos por muito
+*   tempo. Assim, poucos arquivos enormes não bloqueiam a fila de
+*   pequenos e vice-versa.
+*
+* Parâmetros:
+*   preferirGrandes - trabalhador reservado aos arquivos grandes
+***************************************************************************/
+
+void PipelineBackup::laco_copia(bool preferirGrandes) {
+    Estagio &e = *estagios_[2];
+    for (;;) {
+        ItemPipeline *item = nullptr;
+        ParteCopia *parte = nullptr;
+        if (!retirar_copia(preferirGrandes, &item, &parte)) {
+            uint64_t epoca = e.chegada.preparar();
+            if (retirar_copia(preferirGrandes, &item, &parte)) {
+                e.chegada.cancelar();
+            } else if (parar_.load()) {
+                e.chegada.cancelar();
+                return;
+            } else {
+                e.chegada.esperar(epoca);
+                continue;
+            }
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        if (item != nullptr) {
+            tratar(2, item);
+            e.itens.fetch_add(1, std::memory_order_relaxed);
+        } else if (parte == &parte->item->grande->abertura) {
+            abrir_grande(parte->item);
+            e.itens.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            copiar_parte(parte);
+        }
+        e.ocupadoNs.fetch_add(ns_desde(t0), std::memory_order_relaxed);
+    }
+}
+
+// Retira da fila preferida ou, vazia, da outra, e avisa a vaga aberta.
+bool PipelineBackup::retirar_copia(bool preferirGrandes, ItemPipeline **item,
+                                   ParteCopia **parte) {
+    Estagio &e = *estagios_[2];
+    if (preferirGrandes ? filaGrandes_.retirar(parte) :
+                          e.fila.retirar(item)) {
+        (preferirGrandes ? vagaGrandes_ : e.vaga).avisar();
+        return true;
+    }
+    if (preferirGrandes ? e.fila.retirar(item) :
+                          filaGrandes_.retirar(parte)) {
+        (preferirGrandes ? e.vaga : vagaGrandes_).avisar();
+        return true;
+    }
+    return false;
+}
+
+// Cópias dos pacotes, do armazém, do modo delta, comprimidas e cifradas
+// não são divididas (a cifra usa o pool, quando há, por conta própria).
+bool PipelineBackup::eh_grande(const ItemPipeline &item) const {
+    if (limiteGrande_ == 0 || ctx_->semCache)
+        return false;
+    bool doHD = item.acao == A1_COPIAR_HD_PEN;
+    return (doHD ? item.hd : item.pen).tamanho >= limiteGrande_ &&
+        !eh_copia_especial(ctx_, item.entrada->nome, item.acao, item.hd,
+                           item.pen);
+}
+
+/***************************************************************************
+* Função: PipelineBackup::abrir_grande
+* Descrição:
+*   Primeira tarefa de um arquivo grande: abre origem e destino, divide
+*   o arquivo em partes de tamanhoParte_ bytes e devolve todas menos a
+*   primeira à fila de grandes, para que outros trabalhadores as copiem
+*   em paralelo; a primeira é copiada aqui. Partes que não cabem na fila
+*   também são copiadas aqui, em vez de esperar.
+***************************************************************************/
+
+void PipelineBackup::abrir_grande(ItemPipeline *item) {
+    CopiaGrande &g = *item->grande;
+    ResultadoEntrada &r = *item->entrada;
+    copiasGrandes_.fetch_add(1, std::memory_order_relaxed);
+    if (r.expandida)
+        garantir_pai_destino(ctx_, r.nome);
+    const std::string &raiz = (item->acao == A1_COPIAR_HD_PEN) ?
+        ctx_->dirHD : ctx_->dirPen;
+    std::string origem = (fs::path(raiz) / r.nome).string();
+    std::string destino = (fs::path(ctx_->dirDestino) / r.nome).string();
+    if (!g.copia.abrir(AT_FDCWD, origem.c_str(), AT_FDCWD,
+                       destino.c_str())) {
+        registrar_copia(ctx_, r.nome, COPIA_FALHOU);
+        r.bytes = 0;
+        concluir(item);
+        return;
+    }
+
+    const uint64_t tamanho = g.copia.tamanho();
+    for (uint64_t ini = 0; ini < tamanho || g.partes.empty();
+         ini += tamanhoParte_)
+        g.partes.push_back({item, ini, std::min(ini + tamanhoParte_,
+                                                tamanho)});
+    g.restantes.store(g.partes.size(), std::memory_order_relaxed);
+    for (size_t k = 1; k < g.partes.size(); ++k) {
+        ParteCopia *parte = &g.partes[k];
+        if (filaGrandes_.inserir(std::move(parte)))
+            estagios_[2]->chegada.avisar();
+        else
+            copiar_parte(parte);
+    }
+    copiar_parte(&g.partes[0]);
+}
+
+// Copia uma parte; quem copia a última fecha o arquivo e conclui a linha.
+void PipelineBackup::copiar_parte(ParteCopia *parte) {
+    ItemPipeline *item = parte->item;
+    CopiaGrande &g = *item->grande;
+    g.copia.copiar_intervalo(parte->inicio, parte->fim);
+    partesCopia_.fetch_add(1, std::memory_order_relaxed);
+    if (g.restantes.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    ResultadoEntrada &r = *item->entrada;
+    EstrategiaCopia estrategia = g.copia.concluir();
+    registrar_copia(ctx_, r.nome, estrategia);
+    r.bytes = (estrategia == COPIA_FALHOU) ? 0 : g.copia.tamanho();
+    if (estrategia != COPIA_FALHOU)
+        registrar_gravado(ctx_, r.nome, item->acao);
+    concluir(item);
+}
+
+// A última linha da janela acorda processar.
+void PipelineBackup::concluir(ItemPipeline *item) {
+    if (ctx_->medirEntradas)
+        item->entrada->duracaoNs = ns_desde(item->inicio);
+    if (concluidos_.fetch_add(1, std::memory_order_acq_rel) + 1 != total_)
+        return;
+    std::lock_guard<std::mutex> lk(mtxConcluidos_);
+    cvConcluidos_.notify_one();
+}
+
+/***************************************************************************
+* Função: PipelineBackup::processar
+* Descrição:
+*   Passa as linhas da janela pelo pipeline e dorme até a última
+*   concluir. A thread chamadora alimenta o primeiro estágio e também
+*   sofre a contrapressão quando ele não dá vazão.
+*
+* Parâmetros:
+*   janela - linhas a tratar; recebem ação, bytes e duração
+***************************************************************************/
+
+void PipelineBackup::processar(std::vector<ResultadoEntrada> *janela) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<ItemPipeline> itens(janela->size());
+    concluidos_.store(0, std::memory_order_relaxed);
+    total_ = itens.size();
+    for (size_t i = 0; i < itens.size(); ++i) {
+        itens[i].entrada = &(*janela)[i];
+        enviar(0, &itens[i]);
+    }
+    std::unique_lock<std::mutex> lk(mtxConcluidos_);
+    cvConcluidos_.wait(lk, [this] {
+        return concluidos_.load(std::memory_order_acquire) == total_;
+    });
+    duracaoNs_ += ns_desde(t0);
+}
+
+/***************************************************************************
+* Função: PipelineBackup::estatisticas
+* Descrição:
+*   Ocupação de cada estágio: itens tratados, tempo trabalhando e
+*   bloqueado, fração do tempo total em que os trabalhadores estiveram
+*   ocupados e ocupação média e máxima da fila de entrada. Um estágio
+*   com utilização alta e fila cheia é o gargalo e pede mais largura.
+*   Também informa quantos arquivos passaram pela fila de grandes e em
+*   quantas partes.
+*
+* Assertivas de entrada:
+*   encerrar() já foi chamada
+***************************************************************************/
+
+void PipelineBackup::estatisticas(EstatisticasEstagio saida[3],
+                                  uint64_t *copiasGrandes,
+                                  uint64_t *partesCopia) const {
+    *copiasGrandes = copiasGrandes_;
+    *partesCopia = partesCopia_;
+    for (size_t k = 0; k < 3; ++k) {
+        const Estagio &e = *estagios_[k];
+        EstatisticasEstagio &s = saida[k];
+        s.trabalhadores = static_cast<unsigned>(e.threads.size());
+        s.itens = e.itens;
+        s.ocupadoNs = e.ocupadoNs;
+        s.bloqueadoNs = e.bloqueadoNs;
+        s.utilizacao = (duracaoNs_ == 0) ? 0 :
+            static_cast<double>(s.ocupadoNs) /
+                (static_cast<double>(duracaoNs_) * s.trabalhadores);
+        s.filaMedia = (e.amostrasFila == 0) ? 0 :
+            static_cast<double>(e.somaFila) / e.amostrasFila;
+        s.filaPico = e.picoFila;
+        s.capacidadeFila = e.fila.capacidade();
+    }
+}
+
 /***************************************************************************
 * Função: executar_backup
 * Descrição:
@@ -61,83 +2067,684 @@ std::vector<std::pair<std::string, int>> executar_backup(
     const std::string &dirPen,
     const std::string &dirDestino,
     bool backupSolicitado) {
+    return executar_backup(backupParm, dirHD, dirPen, dirDestino,
+        backupSolicitado, OpcoesBackup());
+}
+
+/***************************************************************************
+* Função: executar_backup (com opções)
+* Descrição:
+*   Mesma semântica da versão sem opções, mas as linhas do Backup.parm
+*   são classificadas e copiadas em paralelo por um pool de tarefas com
+*   roubo de trabalho. Cada tarefa trata um bloco contíguo de linhas e
+*   grava o resultado na posição correspondente, de modo que o vetor
+*   retornado mantém a ordem do Backup.parm. Linhas repetidas são
+*   tratadas uma a uma, depois da primeira (ver separar_repetidas), como
+*   na versão sem opções de antes. Implementada sobre a versão com
+*   receptor, acumulando os resultados.
+*
+* Parâmetros:
+*   backupParm, dirHD, dirPen, dirDestino, backupSolicitado - como acima
+*   opcoes - opcoes.numThreads define o número de trabalhadores
+*            (0 = um por núcleo); se opcoes.estatisticas != nullptr,
+*            recebe a contagem de entradas e de chamadas de metadados;
+*            opcoes.usarIoUring processa em lotes pelo io_uring quando o
+*            kernel oferece suporte (senão, usa o pool);
+*            opcoes.manifestoCompilado indica um manifesto gerado por
+*            compilar_manifesto, usado se estiver atualizado;
+*            opcoes.usarIndiceEstado mantém o índice de estado em
+*            dirDestino e evita sondar o Pen de arquivos inalterados;
+*            opcoes.verificarConteudo compara o BLAKE3 dos dois lados e
+*            só copia quando o conteúdo difere, guardando os digests no
+*            índice de estado; opcoes.deduplicar grava as cópias A1
+*            como chunks no armazém de dirDestino; opcoes.copiaDelta
+*            atualiza destinos existentes regravando só o que mudou;
+*            opcoes.pipeline trata as linhas no pipeline de estágios
+*            (PipelineBackup), com as larguras e filas indicadas;
+*            opcoes.semCachePaginas copia sem encher o cache de páginas
+*
+* Valor retornado:
+*   Vetor de pares <nome do arquivo, código da ação>, na ordem do
+*   Backup.parm.
+*
+* Assertivas de entrada:
+*   backupParm != ""
+*   dirHD != ""
+*   dirDestino != ""
+***************************************************************************/
+
+std::vector<std::pair<std::string, int>> executar_backup(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes) {
+    std::vector<std::pair<std::string, int>> resultados;
+    executar_backup(backupParm, dirHD, dirPen, dirDestino, backupSolicitado,
+        opcoes, [&resultados](const std::string &nome, int acao) {
+            resultados.emplace_back(nome, acao);
+        });
+    return resultados;
+}
+
+/***************************************************************************
+* Função: executar_em_janelas
+* Descrição:
+*   Núcleo comum das versões de executar_backup: o Backup.parm é lido e
+*   processado em janelas de linhas, e o receptor é chamado para cada
+*   linha assim que a janela dela termina, na ordem do Backup.parm. A
+*   memória usada fica limitada ao tamanho da janela, qualquer que seja
+*   o número de linhas.
+*
+* Parâmetros:
+*   backupParm, dirHD, dirPen, dirDestino, backupSolicitado, opcoes -
+*       como em executar_backup
+*   medirEntradas - mede o tempo gasto em cada entrada
+*   receptor - chamado com o resultado de cada linha, sempre na thread
+*              chamadora
+*
+* Assertivas de entrada:
+*   backupParm != ""
+*   dirHD != ""
+*   dirDestino != ""
+*   opcoes.chaveCifra vazia ou com kTamanhoChaveCifra bytes
+***************************************************************************/
+
+static void executar_em_janelas(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes,
+    bool medirEntradas,
+    const ReceptorInterno &receptor) {
     assert(!backupParm.empty());
     assert(!dirHD.empty());
     assert(!dirDestino.empty());
+    assert(opcoes.chaveCifra.empty() ||
+           opcoes.chaveCifra.size() == kTamanhoChaveCifra);
 
-    std::vector<std::pair<std::string, int>> resultados;
     std::error_code ec;
-
     if (!fs::exists(fs::path(backupParm), ec)) {
-        resultados.emplace_back(std::make_pair("Backup.parm",
-            static_cast<int>(Acao::A6_IMPOSSIVEL)));
-        return resultados;
+        receptor({"Backup.parm", static_cast<int>(Acao::A6_IMPOSSIVEL)});
+        return;
     }
+    auto inicio = std::chrono::steady_clock::now();
+    EstatisticasBuffers buffersAntes = PoolBuffers::global().estatisticas();
+    PoolBuffers::global().reiniciar_pico();
 
-    std::ifstream parmFile(backupParm);  // le o arquivo .parm
-    std::string nomeArquivo;
+    // Separado do pool de cópia: as tarefas do percurso esperam quando a
+    // fila de arquivos encontrados enche
+    std::unique_ptr<PoolTarefas> poolPercurso;
+    if (opcoes.threadsPercurso > 0)
+        poolPercurso.reset(new PoolTarefas(opcoes.threadsPercurso));
+    FonteManifesto fonte(backupParm, opcoes.manifestoCompilado, dirHD,
+                         dirPen, poolPercurso.get());
 
-    while (std::getline(parmFile, nomeArquivo)) {
-        if (nomeArquivo.empty())
-            continue;
+    std::unique_ptr<IndiceEstado> indice;
+    if (opcoes.usarIndiceEstado || opcoes.verificarConteudo)
+        indice.reset(new IndiceEstado(dirDestino));
+
+    std::unique_ptr<ArmazemChunks> armazem;
+    if (opcoes.deduplicar)
+        armazem.reset(new ArmazemChunks(dirDestino));
+
+    std::unique_ptr<CacheDiretorios> diretorios;
+    if (opcoes.cacheDiretorios > 0)
+        diretorios.reset(new CacheDiretorios(opcoes.cacheDiretorios));
+
+    std::unique_ptr<EscritorPacotes> pacotes;
+    if (opcoes.empacotarAte > 0 && backupSolicitado)
+        pacotes.reset(new EscritorPacotes(dirDestino));
+    std::unique_ptr<LeitorPacotes> pacotesPen;
+    if (!dirPen.empty() && fs::exists(fs::path(dirPen) / ".pacotes", ec)) {
+        pacotesPen.reset(new LeitorPacotes(dirPen));
+        if (pacotesPen->tamanho() == 0)
+            pacotesPen.reset();
+    }
+
+    ContextoBackup ctx{dirHD, dirPen, dirDestino, backupSolicitado,
+        opcoes.estatisticas ? &opcoes.estatisticas->estrategias : nullptr,
+        indice.get(), armazem.get(), diretorios.get(),
+        opcoes.enumerarDiretorios, opcoes.usarIndiceEstado,
+        opcoes.copiaDelta, medirEntradas, opcoes.verificarConteudo,
+        opcoes.verificacaoMmap, nullptr};
+    if (ctx.estrategias != nullptr)
+        ctx.estrategias->clear();
+    // Na restauração, uma cópia para o próprio Pen não é registrada de
+    // novo no índice (registrar_gravado), que então não vale para ele
+    ctx.destinoEhPen = mesmo_diretorio(dirDestino, dirPen);
+    ctx.destinoEhHD = mesmo_diretorio(dirDestino, dirHD);
+    ctx.dispensarPen = opcoes.usarIndiceEstado &&
+        (backupSolicitado || !ctx.destinoEhPen);
+    uint64_t chamadasIoUring = 0;
+
+    std::unique_ptr<PipelineBackup> pipeline;
+    if (opcoes.pipeline)
+        pipeline.reset(new PipelineBackup(&ctx, opcoes));
+    std::unique_ptr<AnelIoUring> anel;
+    if (opcoes.usarIoUring && !pipeline && !opcoes.semCachePaginas)
+        anel.reset(new AnelIoUring(kEntradasAnel));
+    if (anel && !anel->disponivel())
+        anel.reset();
+    std::unique_ptr<PoolTarefas> pool, poolPartes;
+    if (!anel && !pipeline)
+        pool.reset(new PoolTarefas(opcoes.numThreads));
+    if (pool && (opcoes.limiteArquivoGrande > 0 ||
+                 opcoes.verificarConteudo || !opcoes.chaveCifra.empty()))
+        poolPartes.reset(new PoolTarefas(pool->tamanho()));
+    ctx.pool = pool.get();
+    ctx.poolPartes = poolPartes.get();
+    ctx.limiteArquivoGrande = opcoes.limiteArquivoGrande;
+    ctx.tamanhoParteCopia = std::max<uint64_t>(opcoes.tamanhoParteCopia, 1);
+    ctx.pacotes = pacotes.get();
+    ctx.empacotarAte = opcoes.empacotarAte;
+    ctx.pacotesPen = pacotesPen.get();
+    ctx.comprimir = opcoes.comprimir;
+    ctx.chaveCifra = opcoes.chaveCifra;
+    ctx.algoritmoCifra = algoritmo_preferido();
+    ctx.semCache = opcoes.semCachePaginas;
+    ctx.penTransformado = !dirPen.empty() &&
+        fs::exists(fs::path(dirPen) / kMarcaTransformados, ec);
+    ctx.nivelCompressao = opcoes.nivelCompressao;
+    unsigned copiasSimultaneas = pool ? pool->tamanho() : pipeline ?
+        opcoes.trabalhadoresCopia + std::max(opcoes.trabalhadoresGrandes, 1u) :
+        1;
+    ctx.threadsCompressao = threads_compressao(opcoes.threadsCompressao,
+                                               copiasSimultaneas);
+
+    std::vector<ResultadoEntrada> janela, repetidas;
+    std::vector<size_t> posicoesRepetidas;
+    uint64_t entradas = 0, bytesCopiados = 0;
+    while (fonte.proxima_janela(kEntradasPorJanela, &janela)) {
+        separar_repetidas(&janela, &posicoesRepetidas, &repetidas);
+        if (ctx.enumerarDiretorios)
+            marcar_ausentes(&janela, &ctx);
+        if (pipeline)
+            pipeline->processar(&janela);
+        else if (anel)
+            processar_com_io_uring(&janela, &ctx, anel.get());
+        else
+            processar_com_pool(&janela, &ctx, pool.get());
+        devolver_repetidas(&janela, posicoesRepetidas, &repetidas, &ctx);
+        for (const ResultadoEntrada &r : janela) {
+            bytesCopiados += r.bytes;
+            receptor(r);
+        }
+        entradas += janela.size();
+    }
+    if (anel)
+        chamadasIoUring = anel->chamadasEnter();
+    EstatisticasEstagio estagios[3];
+    uint64_t copiasGrandes = 0, partesCopia = 0;
+    if (pipeline) {
+        pipeline->encerrar();
+        pipeline->estatisticas(estagios, &copiasGrandes, &partesCopia);
+    }
+    pipeline.reset();
+    pool.reset();
+    poolPartes.reset();
+    ctx.pool = nullptr;
+    ctx.poolPartes = nullptr;
+
+    if (indice)
+        indice->salvar();
+    EstatisticasPacotes ep;
+    uint64_t bytesPacotesLiberados = 0;
+    if (pacotes) {
+        if (pacotes->fechar())
+            bytesPacotesLiberados = compactar_pacotes(dirDestino);
+        ep = pacotes->estatisticas();
+    }
+
+    if (opcoes.estatisticas != nullptr) {
+        opcoes.estatisticas->sondagensPenEvitadas = ctx.sondagensPenEvitadas;
+        opcoes.estatisticas->entradas = entradas;
+        opcoes.estatisticas->chamadasMetadados = ctx.chamadasMetadados;
+        opcoes.estatisticas->chamadasIoUring = chamadasIoUring;
+        opcoes.estatisticas->arquivosHasheados = ctx.arquivosHasheados;
+        opcoes.estatisticas->bytesHasheados = ctx.bytesHasheados;
+        opcoes.estatisticas->digestsReaproveitados =
+            ctx.digestsReaproveitados;
+        EstatisticasArmazem ea;
+        if (armazem)
+            ea = armazem->estatisticas();
+        opcoes.estatisticas->bytesDeduplicados = ea.bytesLogicos;
+        opcoes.estatisticas->bytesChunksGravados = ea.bytesGravados;
+        opcoes.estatisticas->chunksNovos = ea.chunksNovos;
+        opcoes.estatisticas->chunksReaproveitados = ea.chunksReaproveitados;
+        opcoes.estatisticas->bytesDeltaEscritos = ctx.bytesDeltaEscritos;
+        opcoes.estatisticas->bytesDeltaReaproveitados =
+            ctx.bytesDeltaReaproveitados;
+        opcoes.estatisticas->manifestoCompiladoUsado =
+            fonte.compiladoUsado();
+        opcoes.estatisticas->arquivosExpandidos = fonte.arquivosExpandidos();
+        opcoes.estatisticas->diretoriosPercorridos =
+            fonte.diretoriosPercorridos();
+        EstatisticasCacheDiretorios ed;
+        if (diretorios)
+            ed = diretorios->estatisticas();
+        opcoes.estatisticas->diretoriosAbertos = ed.aberturas;
+        opcoes.estatisticas->diretoriosListados = ctx.diretoriosListados;
+        opcoes.estatisticas->sondagensEvitadasListagem =
+            ctx.sondagensEvitadasListagem;
+        opcoes.estatisticas->acertosCacheDiretorios = ed.acertos;
+        std::copy(estagios, estagios + 3, opcoes.estatisticas->estagios);
+        opcoes.estatisticas->copiasGrandes = copiasGrandes +
+            ctx.copiasGrandes;
+        opcoes.estatisticas->partesCopia = partesCopia + ctx.partesCopia;
+        opcoes.estatisticas->arquivosEmpacotados = ep.arquivos;
+        opcoes.estatisticas->bytesEmpacotados = ep.bytes;
+        opcoes.estatisticas->pacotesCriados = ep.pacotes;
+        opcoes.estatisticas->bytesPacotesLiberados = bytesPacotesLiberados;
+        opcoes.estatisticas->arquivosDesempacotados =
+            ctx.arquivosDesempacotados;
+        opcoes.estatisticas->arquivosComprimidos = ctx.arquivosComprimidos;
+        opcoes.estatisticas->arquivosIncomprimiveis =
+            ctx.arquivosIncomprimiveis;
+        opcoes.estatisticas->bytesOrigemComprimidos =
+            ctx.bytesOrigemComprimidos;
+        opcoes.estatisticas->bytesComprimidosGravados =
+            ctx.bytesComprimidosGravados;
+        opcoes.estatisticas->arquivosDescomprimidos =
+            ctx.arquivosDescomprimidos;
+        opcoes.estatisticas->arquivosCifrados = ctx.arquivosCifrados;
+        opcoes.estatisticas->bytesCifrados = ctx.bytesCifrados;
+        opcoes.estatisticas->arquivosDecifrados = ctx.arquivosDecifrados;
+        uint64_t duracaoNs = std::max<uint64_t>(ns_desde(inicio), 1);
+        opcoes.estatisticas->bytesCopiados = bytesCopiados;
+        opcoes.estatisticas->duracaoNs = duracaoNs;
+        opcoes.estatisticas->mbPorSegundo = bytesCopiados * 1e3 / duracaoNs;
+        preencher_buffers(buffersAntes, opcoes.estatisticas);
+    }
+}
+
+/***************************************************************************
+* Função: executar_backup (com receptor)
+* Descrição:
+*   Versão em fluxo: o receptor é chamado para cada linha assim que a
+*   janela dela termina, na ordem do Backup.parm, de modo que o chamador
+*   acompanha o progresso durante a execução sem que os resultados se
+*   acumulem em memória.
+*
+* Parâmetros:
+*   backupParm, dirHD, dirPen, dirDestino, backupSolicitado, opcoes -
+*       como na versão que retorna o vetor
+*   receptor - chamado com <nome do arquivo, código da ação> de cada
+*              linha, sempre na thread chamadora
+*
+* Assertivas de entrada:
+*   receptor não vazio
+***************************************************************************/
+
+void executar_backup(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes,
+    const ReceptorResultado &receptor) {
+    assert(receptor);
+    executar_em_janelas(backupParm, dirHD, dirPen, dirDestino,
+        backupSolicitado, opcoes, false,
+        [&receptor](const ResultadoEntrada &r) {
+            receptor(r.nome, r.acao);
+        });
+}
+
+/***************************************************************************
+* Função: executar_backup_relatorio
+* Descrição:
+*   Mesma execução, com o resultado em um RelatorioBackup compacto: os
+*   nomes ficam contíguos na arena do relatório e as ações em um array
+*   de uint8_t, sem uma std::string alocada por linha.
+*
+* Parâmetros:
+*   backupParm, dirHD, dirPen, dirDestino, backupSolicitado, opcoes -
+*       como na versão que retorna o vetor
+*   detalhado - guarda também os bytes copiados e o tempo de cada linha
+*               (no modo io_uring, o tempo do lote dividido entre as
+*               linhas dele)
+*
+* Valor retornado:
+*   Relatório com uma entrada por linha, na ordem do Backup.parm.
+***************************************************************************/
+
+RelatorioBackup executar_backup_relatorio(
+    const std::string &backupParm,
+    const std::string &dirHD,
+    const std::string &dirPen,
+    const std::string &dirDestino,
+    bool backupSolicitado,
+    const OpcoesBackup &opcoes,
+    bool detalhado) {
+    RelatorioBackup relatorio(detalhado);
+    executar_em_janelas(backupParm, dirHD, dirPen, dirDestino,
+        backupSolicitado, opcoes, detalhado,
+        [&relatorio](const ResultadoEntrada &r) {
+            relatorio.adicionar(r.nome, r.acao, r.bytes, r.duracaoNs);
+        });
+    return relatorio;
+}
+
+// Um destino de executar_backup_multiplo, com o que for dele: índice de
+// estado, armazém, pacotes e o contexto das cópias para ele.
+struct DestinoExecucao {
+    std::unique_ptr<IndiceEstado> indice;
+    std::unique_ptr<ArmazemChunks> armazem;
+    std::unique_ptr<EscritorPacotes> pacotes;
+    std::unique_ptr<LeitorPacotes> pacotesPen;
+    std::unique_ptr<ContextoBackup> ctx;
+    uint64_t bytesPacotesLiberados = 0;  // pela compactação no fim
+    // Cópias deste destino, protegidas pelo mtxEstrategias do ctx; unidas
+    // às dos outros em EstatisticasBackup::estrategias no fim
+    std::vector<std::pair<std::string, int>> estrategias;
+};
 
-        fs::path caminhoHD = fs::path(dirHD) / nomeArquivo;
-        fs::path caminhoPen = fs::path(dirPen) / nomeArquivo;
-        fs::path caminhoDestino = fs::path(dirDestino) / nomeArquivo;
+/***************************************************************************
+* Função: processar_entrada_multipla
+* Descrição:
+*   Trata uma linha para todos os destinos: o HD é sondado uma vez, o Pen
+*   de cada destino é sondado (ou tirado do índice dele) e a tabela de
+*   decisão é aplicada a cada um, de modo que as ações podem diferir
+*   entre eles. Os destinos com A1 em cópia comum recebem o arquivo de
+*   uma só leitura (copiar_para_varios), com as gravações de cada bloco
+*   em paralelo pelo pool de partes enquanto o seguinte é lido; os dos
+*   modos especiais (cifra, pacotes, armazém, delta, compressão) são
+*   copiados um a um.
+*
+* Parâmetros:
+*   janelas - uma janela por destino, com as mesmas linhas; recebem a
+*             ação e os bytes gravados
+*   k - posição da linha nas janelas
+*   destinos - destinos da execução, na ordem de janelas
+*   bytesLidos - acumula os bytes lidos do HD nas cópias
+***************************************************************************/
 
-        bool existeHD = fs::exists(caminhoHD);
-        bool existePen = fs::exists(caminhoPen);
+static void processar_entrada_multipla(
+    std::vector<std::vector<ResultadoEntrada>> *janelas, size_t k,
+    const std::vector<std::unique_ptr<DestinoExecucao>> &destinos,
+    std::atomic<uint64_t> *bytesLidos) {
+    const ResultadoEntrada &entrada = (*janelas)[0][k];
+    const std::string &nome = entrada.nome;
+    ContextoBackup *primeiro = destinos[0]->ctx.get();
+    Metadados hd = sondar_lado(primeiro, primeiro->dirHD, nome);
+    primeiro->chamadasMetadados.fetch_add(1, std::memory_order_relaxed);
 
-        if (!existeHD && !existePen) {
-            resultados.emplace_back(nomeArquivo, A6_IMPOSSIVEL);
+    std::vector<std::string> caminhos;
+    std::vector<size_t> comuns;  // destinos da cópia de uma só leitura
+    for (size_t i = 0; i < destinos.size(); ++i) {
+        ContextoBackup *ctx = destinos[i]->ctx.get();
+        ResultadoEntrada &r = (*janelas)[i][k];
+        Metadados pen;
+        if (!pen_pelo_indice(ctx, nome, hd, &pen)) {
+            pen = sondar_lado(ctx, ctx->dirPen, nome);
+            ctx->chamadasMetadados.fetch_add(1, std::memory_order_relaxed);
+        }
+        pen_do_pacote(ctx, nome, &pen);
+        Acao acao = decidir_entrada(entrada, ctx, hd, pen);
+        r.acao = static_cast<int>(acao);
+        if (acao != A1_COPIAR_HD_PEN)
+            continue;
+        if (eh_copia_especial(ctx, nome, acao, hd, pen)) {
+            r.bytes = copiar_entrada(entrada, ctx, acao, hd, pen);
+            bytesLidos->fetch_add(r.bytes, std::memory_order_relaxed);
             continue;
         }
+        if (entrada.expandida)
+            garantir_pai_destino(ctx, nome);
+        caminhos.push_back((fs::path(ctx->dirDestino) / nome).string());
+        comuns.push_back(i);
+    }
+    if (comuns.empty())
+        return;
 
-        auto dataHD = existeHD ? fs::last_write_time(caminhoHD) :
-        fs::file_time_type::min();
-        auto dataPen = existePen ? fs::last_write_time(caminhoPen) :
-        fs::file_time_type::min();
-
-        if (backupSolicitado) {
-            if (existeHD && !existePen) {
-                fs::copy_file(caminhoHD, caminhoDestino,
-                fs::copy_options::overwrite_existing, ec);
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A1_COPIAR_HD_PEN));
-            } else if (existeHD && existePen && dataHD > dataPen) {
-                fs::copy_file(caminhoHD, caminhoDestino,
-                    fs::copy_options::overwrite_existing, ec);
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A1_COPIAR_HD_PEN));
-            } else if (existeHD && existePen && dataPen > dataHD) {
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A5_ERRO));
-            } else {
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A4_NADA));
-            }
-        } else {  // modo restauração
-            if (!existeHD && !existePen) {
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A6_IMPOSSIVEL));
-            } else if (!existeHD && existePen) {
-                fs::copy_file(caminhoPen, caminhoDestino,
-                fs::copy_options::overwrite_existing, ec);
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A2_COPIAR_PEN_HD));
-            } else if (existeHD && existePen && dataPen > dataHD) {
-                fs::copy_file(caminhoPen, caminhoDestino,
-                fs::copy_options::overwrite_existing, ec);
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A2_COPIAR_PEN_HD));
-            } else if (existeHD && existePen && dataPen == dataHD) {
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A4_NADA));
-            } else {
-                resultados.emplace_back(nomeArquivo, static_cast<int>
-                (Acao::A4_NADA));
+    // Para um destino só, a cópia comum (reflink, copy_file_range...)
+    EstrategiaCopia estrategia;
+    std::vector<bool> copiados;
+    if (comuns.size() == 1) {
+        estrategia = copiar_para_destino(destinos[comuns[0]]->ctx.get(),
+                                         primeiro->dirHD, nome);
+        copiados.assign(1, estrategia != COPIA_FALHOU);
+    } else {
+        // As gravações vão para o pool de partes, e não para o das
+        // linhas, que é o desta thread
+        estrategia = copiar_para_varios(
+            (fs::path(primeiro->dirHD) / nome).string(), caminhos,
+            primeiro->poolPartes, &copiados);
+    }
+    if (estrategia != COPIA_FALHOU)
+        bytesLidos->fetch_add(hd.tamanho, std::memory_order_relaxed);
+    for (size_t j = 0; j < comuns.size(); ++j) {
+        ContextoBackup *ctx = destinos[comuns[j]]->ctx.get();
+        registrar_copia(ctx, nome, copiados[j] ? estrategia : COPIA_FALHOU);
+        if (!copiados[j])
+            continue;
+        (*janelas)[comuns[j]][k].bytes = hd.tamanho;
+        registrar_gravado(ctx, nome, A1_COPIAR_HD_PEN);
+    }
+}
+
+// Soma os contadores de um destino nas estatísticas da execução.
+static void somar_destino(const DestinoExecucao &d,
+                          EstatisticasBackup *est) {
+    const ContextoBackup &ctx = *d.ctx;
+    est->chamadasMetadados += ctx.chamadasMetadados;
+    est->sondagensPenEvitadas += ctx.sondagensPenEvitadas;
+    est->arquivosHasheados += ctx.arquivosHasheados;
+    est->bytesHasheados += ctx.bytesHasheados;
+    est->digestsReaproveitados += ctx.digestsReaproveitados;
+    est->bytesDeltaEscritos += ctx.bytesDeltaEscritos;
+    est->bytesDeltaReaproveitados += ctx.bytesDeltaReaproveitados;
+    est->arquivosComprimidos += ctx.arquivosComprimidos;
+    est->arquivosIncomprimiveis += ctx.arquivosIncomprimiveis;
+    est->bytesOrigemComprimidos += ctx.bytesOrigemComprimidos;
+    est->bytesComprimidosGravados += ctx.bytesComprimidosGravados;
+    est->arquivosCifrados += ctx.arquivosCifrados;
+    est->bytesCifrados += ctx.bytesCifrados;
+    if (d.armazem) {
+        EstatisticasArmazem ea = d.armazem->estatisticas();
+        est->bytesDeduplicados += ea.bytesLogicos;
+        est->bytesChunksGravados += ea.bytesGravados;
+        est->chunksNovos += ea.chunksNovos;
+        est->chunksReaproveitados += ea.chunksReaproveitados;
+    }
+    if (d.pacotes) {
+        EstatisticasPacotes ep = d.pacotes->estatisticas();
+        est->arquivosEmpacotados += ep.arquivos;
+        est->bytesEmpacotados += ep.bytes;
+        est->pacotesCriados += ep.pacotes;
+        est->bytesPacotesLiberados += d.bytesPacotesLiberados;
+    }
+}
+
+/***************************************************************************
+* Função: executar_backup_multiplo
+* Descrição:
+*   Backup (HD → Pen) para vários destinos em uma única passada pelo
+*   Backup.parm, em vez de uma execução por destino: os metadados do HD
+*   são obtidos uma vez por linha, a decisão é tomada para cada destino
+*   com o Pen dele, e um arquivo que precisa ir para vários destinos é
+*   lido uma só vez e gravado em todos (ver processar_entrada_multipla).
+*   Cada destino tem o seu índice de estado, armazém e pacotes, como se
+*   fosse uma execução separada. As linhas repetidas de uma janela são
+*   tratadas depois das outras, uma a uma (ver separar_repetidas). As
+*   linhas-padrão são expandidas com o HD e o Pen do primeiro destino.
+*   As opções de io_uring, pipeline, listagem de diretórios e cópia em
+*   partes não se aplicam, e semCachePaginas só vale para os arquivos
+*   que vão a um único destino.
+*
+* Parâmetros:
+*   backupParm, dirHD - como em executar_backup
+*   destinos - Pen e diretório de destino de cada destino
+*   opcoes - como em executar_backup; as estatísticas somam os destinos,
+*            bytesCopiados conta os bytes lidos do HD uma vez e
+*            bytesGravadosDestinos, os gravados em todos eles
+*
+* Valor retornado:
+*   Um vetor por destino, na ordem de destinos, com os pares <nome do
+*   arquivo, código da ação> na ordem do Backup.parm. Sem o Backup.parm,
+*   cada um tem só {"Backup.parm", A6_IMPOSSIVEL}.
+*
+* Assertivas de entrada:
+*   backupParm != "" && dirHD != "" && destinos não vazio
+*   nenhum dirPen ou dirDestino == ""
+*   opcoes.chaveCifra vazia ou com kTamanhoChaveCifra bytes
+***************************************************************************/
+
+std::vector<std::vector<std::pair<std::string, int>>>
+executar_backup_multiplo(const std::string &backupParm,
+                         const std::string &dirHD,
+                         const std::vector<DestinoBackup> &destinos,
+                         const OpcoesBackup &opcoes) {
+    assert(!backupParm.empty());
+    assert(!dirHD.empty());
+    assert(!destinos.empty());
+    assert(opcoes.chaveCifra.empty() ||
+           opcoes.chaveCifra.size() == kTamanhoChaveCifra);
+
+    const size_t n = destinos.size();
+    std::vector<std::vector<std::pair<std::string, int>>> resultados(n);
+    std::error_code ec;
+    if (!fs::exists(fs::path(backupParm), ec)) {
+        for (auto &r : resultados)
+            r.emplace_back("Backup.parm", static_cast<int>(A6_IMPOSSIVEL));
+        return resultados;
+    }
+    auto inicio = std::chrono::steady_clock::now();
+    EstatisticasBuffers buffersAntes = PoolBuffers::global().estatisticas();
+    PoolBuffers::global().reiniciar_pico();
+
+    std::unique_ptr<PoolTarefas> poolPercurso;
+    if (opcoes.threadsPercurso > 0)
+        poolPercurso.reset(new PoolTarefas(opcoes.threadsPercurso));
+    FonteManifesto fonte(backupParm, opcoes.manifestoCompilado, dirHD,
+                         destinos[0].dirPen, poolPercurso.get());
+    std::unique_ptr<CacheDiretorios> diretorios;
+    if (opcoes.cacheDiretorios > 0)
+        diretorios.reset(new CacheDiretorios(opcoes.cacheDiretorios));
+    PoolTarefas pool(opcoes.numThreads);
+    // Gravações de um bloco nos vários destinos, digests e cifra: as
+    // linhas esperam por ele sem ocupar os trabalhadores delas
+    PoolTarefas poolPartes(std::max<unsigned>(pool.tamanho(),
+                                              static_cast<unsigned>(n)));
+
+    std::vector<std::unique_ptr<DestinoExecucao>> execucoes;
+    for (const DestinoBackup &destino : destinos) {
+        assert(!destino.dirPen.empty() && !destino.dirDestino.empty());
+        std::unique_ptr<DestinoExecucao> d(new DestinoExecucao);
+        if (opcoes.usarIndiceEstado || opcoes.verificarConteudo)
+            d->indice.reset(new IndiceEstado(destino.dirDestino));
+        if (opcoes.deduplicar)
+            d->armazem.reset(new ArmazemChunks(destino.dirDestino));
+        if (opcoes.empacotarAte > 0)
+            d->pacotes.reset(new EscritorPacotes(destino.dirDestino));
+        if (fs::exists(fs::path(destino.dirPen) / ".pacotes", ec)) {
+            d->pacotesPen.reset(new LeitorPacotes(destino.dirPen));
+            if (d->pacotesPen->tamanho() == 0)
+                d->pacotesPen.reset();
+        }
+        d->ctx.reset(new ContextoBackup{dirHD, destino.dirPen,
+            destino.dirDestino, true,
+            opcoes.estatisticas ? &d->estrategias : nullptr, d->indice.get(),
+            d->armazem.get(), diretorios.get(), false,
+            opcoes.usarIndiceEstado, opcoes.copiaDelta, false,
+            opcoes.verificarConteudo, opcoes.verificacaoMmap, &pool});
+        ContextoBackup &ctx = *d->ctx;
+        ctx.poolPartes = &poolPartes;
+        ctx.pacotes = d->pacotes.get();
+        ctx.empacotarAte = opcoes.empacotarAte;
+        ctx.pacotesPen = d->pacotesPen.get();
+        ctx.comprimir = opcoes.comprimir;
+        ctx.chaveCifra = opcoes.chaveCifra;
+        ctx.algoritmoCifra = algoritmo_preferido();
+        ctx.semCache = opcoes.semCachePaginas;
+        ctx.destinoEhPen = mesmo_diretorio(destino.dirDestino,
+                                           destino.dirPen);
+        ctx.penTransformado =
+            fs::exists(fs::path(destino.dirPen) / kMarcaTransformados, ec);
+        ctx.nivelCompressao = opcoes.nivelCompressao;
+        ctx.threadsCompressao = threads_compressao(
+            opcoes.threadsCompressao, pool.tamanho());
+        execucoes.push_back(std::move(d));
+    }
+
+    std::vector<std::vector<ResultadoEntrada>> janelas(n), repetidas;
+    std::vector<size_t> posicoesRepetidas;
+    std::atomic<uint64_t> bytesLidos{0};
+    uint64_t entradas = 0, bytesGravados = 0;
+    while (fonte.proxima_janela(kEntradasPorJanela, &janelas[0])) {
+        // As linhas repetidas ficam para depois, como em executar_backup
+        repetidas.assign(1, {});
+        separar_repetidas(&janelas[0], &posicoesRepetidas, &repetidas[0]);
+        for (size_t i = 1; i < n; ++i)
+            janelas[i] = janelas[0];
+        GrupoTarefas grupo;
+        for (size_t ini = 0; ini < janelas[0].size();
+             ini += kEntradasPorTarefa) {
+            size_t fim = std::min(ini + kEntradasPorTarefa,
+                                  janelas[0].size());
+            pool.submeter(&grupo, [&janelas, &execucoes, &bytesLidos, ini,
+                                   fim] {
+                for (size_t k = ini; k < fim; ++k)
+                    processar_entrada_multipla(&janelas, k, execucoes,
+                                               &bytesLidos);
+            });
+        }
+        pool.aguardar(&grupo);
+        if (!posicoesRepetidas.empty()) {
+            repetidas.resize(n, repetidas[0]);
+            for (size_t k = 0; k < repetidas[0].size(); ++k)
+                processar_entrada_multipla(&repetidas, k, execucoes,
+                                           &bytesLidos);
+            for (size_t i = 0; i < n; ++i)
+                reinserir_repetidas(&janelas[i], posicoesRepetidas,
+                                    &repetidas[i]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            for (const ResultadoEntrada &r : janelas[i]) {
+                bytesGravados += r.bytes;
+                resultados[i].emplace_back(r.nome, r.acao);
             }
         }
+        entradas += janelas[0].size();
+    }
+
+    for (auto &d : execucoes) {
+        if (d->indice)
+            d->indice->salvar();
+        if (d->pacotes && d->pacotes->fechar())
+            d->bytesPacotesLiberados =
+                compactar_pacotes(d->ctx->dirDestino);
+    }
+
+    if (opcoes.estatisticas != nullptr) {
+        EstatisticasBackup &est = *opcoes.estatisticas;
+        est = EstatisticasBackup();
+        for (auto &d : execucoes) {
+            somar_destino(*d, &est);
+            est.estrategias.insert(est.estrategias.end(),
+                std::make_move_iterator(d->estrategias.begin()),
+                std::make_move_iterator(d->estrategias.end()));
+        }
+        est.entradas = entradas;
+        est.manifestoCompiladoUsado = fonte.compiladoUsado();
+        est.arquivosExpandidos = fonte.arquivosExpandidos();
+        est.diretoriosPercorridos = fonte.diretoriosPercorridos();
+        if (diretorios) {
+            EstatisticasCacheDiretorios ed = diretorios->estatisticas();
+            est.diretoriosAbertos = ed.aberturas;
+            est.acertosCacheDiretorios = ed.acertos;
+        }
+        uint64_t duracaoNs = std::max<uint64_t>(ns_desde(inicio), 1);
+        est.bytesCopiados = bytesLidos;
+        est.bytesGravadosDestinos = bytesGravados;
+        est.duracaoNs = duracaoNs;
+        est.mbPorSegundo = est.bytesCopiados * 1e3 / duracaoNs;
+        preencher_buffers(buffersAntes, &est);
     }
     return resultados;
 }
@@ -0,0 +1,614 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/blake3.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
+
+static constexpr size_t kTamanhoChunk = 1024;
+static constexpr size_t kTamanhoBloco = 64;
+// Chunks inteiros por tarefa quando o hash é dividido entre threads.
+static constexpr size_t kChunksPorTarefa = 256;
+// Tamanho das leituras no modo sem mmap (um bloco de
+// PoolBuffers::global()).
+static constexpr size_t kTamanhoLeitura = 2 << 20;
+
+enum : uint32_t {
+    CHUNK_START = 1,
+    CHUNK_END = 2,
+    PARENT = 4,
+    ROOT = 8
+};
+
+static constexpr uint32_t kIV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+// Índices das palavras da mensagem usadas em cada uma das 7 rodadas,
+// já com a permutação aplicada rodada a rodada.
+struct Escalonamento {
+    uint8_t m[7][16];
+};
+
+static constexpr Escalonamento montar_escalonamento() {
+    constexpr uint8_t kPermutacao[16] = {
+        2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8
+    };
+    Escalonamento e{};
+    for (int i = 0; i < 16; ++i)
+        e.m[0][i] = static_cast<uint8_t>(i);
+    for (int r = 1; r < 7; ++r)
+        for (int i = 0; i < 16; ++i)
+            e.m[r][i] = e.m[r - 1][kPermutacao[i]];
+    return e;
+}
+
+static constexpr Escalonamento kEscalonamento = montar_escalonamento();
+
+static inline uint32_t ler32(const uint8_t *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+        (uint32_t(p[3]) << 24);
+}
+
+static inline void palavras_bloco(const uint8_t *bloco, uint32_t m[16]) {
+    for (int i = 0; i < 16; ++i)
+        m[i] = ler32(bloco + 4 * i);
+}
+
+static inline uint32_t rotr(uint32_t w, int c) {
+    return (w >> c) | (w << (32 - c));
+}
+
+static inline void g(uint32_t *s, int a, int b, int c, int d, uint32_t x,
+                     uint32_t y) {
+    s[a] = s[a] + s[b] + x;
+    s[d] = rotr(s[d] ^ s[a], 16);
+    s[c] = s[c] + s[d];
+    s[b] = rotr(s[b] ^ s[c], 12);
+    s[a] = s[a] + s[b] + y;
+    s[d] = rotr(s[d] ^ s[a], 8);
+    s[c] = s[c] + s[d];
+    s[b] = rotr(s[b] ^ s[c], 7);
+}
+
+/***************************************************************************
+* Função: comprimir
+* Descrição:
+*   Função de compressão do BLAKE3 (versão escalar): 7 rodadas sobre o
+*   estado de 16 palavras formado pelo valor de encadeamento, o IV, o
+*   contador, o tamanho do bloco e os flags.
+*
+* Parâmetros:
+*   cv - valor de encadeamento de entrada
+*   m - 16 palavras do bloco
+*   contador - índice do chunk (0 para nós pai)
+*   tamanhoBloco - bytes válidos do bloco
+*   flags - combinação de CHUNK_START, CHUNK_END, PARENT e ROOT
+*   saida - recebe as 16 palavras de saída; as 8 primeiras são o novo cv
+***************************************************************************/
+
+static void comprimir(const uint32_t cv[8], const uint32_t m[16],
+                      uint64_t contador, uint32_t tamanhoBloco,
+                      uint32_t flags, uint32_t saida[16]) {
+    uint32_t s[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        kIV[0], kIV[1], kIV[2], kIV[3],
+        static_cast<uint32_t>(contador), static_cast<uint32_t>(contador >> 32),
+        tamanhoBloco, flags
+    };
+    for (int r = 0; r < 7; ++r) {
+        const uint8_t *e = kEscalonamento.m[r];
+        g(s, 0, 4, 8, 12, m[e[0]], m[e[1]]);
+        g(s, 1, 5, 9, 13, m[e[2]], m[e[3]]);
+        g(s, 2, 6, 10, 14, m[e[4]], m[e[5]]);
+        g(s, 3, 7, 11, 15, m[e[6]], m[e[7]]);
+        g(s, 0, 5, 10, 15, m[e[8]], m[e[9]]);
+        g(s, 1, 6, 11, 12, m[e[10]], m[e[11]]);
+        g(s, 2, 7, 8, 13, m[e[12]], m[e[13]]);
+        g(s, 3, 4, 9, 14, m[e[14]], m[e[15]]);
+    }
+    for (int i = 0; i < 8; ++i) {
+        saida[i] = s[i] ^ s[i + 8];
+        saida[i + 8] = s[i + 8] ^ cv[i];
+    }
+}
+
+static void cv_pai(const uint32_t esquerdo[8], const uint32_t direito[8],
+                   uint32_t flagsExtras, uint32_t saida[16]) {
+    uint32_t m[16];
+    std::memcpy(m, esquerdo, 32);
+    std::memcpy(m + 8, direito, 32);
+    comprimir(kIV, m, 0, kTamanhoBloco, PARENT | flagsExtras, saida);
+}
+
+/***************************************************************************
+* Função: hash_chunks_portavel
+* Descrição:
+*   Calcula o valor de encadeamento de n chunks inteiros consecutivos,
+*   um de cada vez. Referência para as rotinas vetoriais e usada para os
+*   chunks que sobram delas.
+*
+* Parâmetros:
+*   entrada - n * 1024 bytes
+*   n - quantidade de chunks
+*   contador - índice do primeiro chunk
+*   cvs - recebe os n valores de encadeamento
+***************************************************************************/
+
+static void hash_chunks_portavel(const uint8_t *entrada, size_t n,
+                                 uint64_t contador, uint32_t (*cvs)[8]) {
+    for (size_t k = 0; k < n; ++k) {
+        uint32_t cv[8];
+        std::memcpy(cv, kIV, sizeof(cv));
+        const uint8_t *chunk = entrada + k * kTamanhoChunk;
+        for (size_t b = 0; b < kTamanhoChunk / kTamanhoBloco; ++b) {
+            uint32_t m[16], saida[16];
+            palavras_bloco(chunk + b * kTamanhoBloco, m);
+            uint32_t flags = (b == 0 ? CHUNK_START : 0) |
+                (b == kTamanhoChunk / kTamanhoBloco - 1 ? CHUNK_END : 0);
+            comprimir(cv, m, contador + k, kTamanhoBloco, flags, saida);
+            std::memcpy(cv, saida, sizeof(cv));
+        }
+        std::memcpy(cvs[k], cv, sizeof(cv));
+    }
+}
+
+#if defined(__x86_64__)
+// Cada vetor guarda a mesma palavra de estado de N chunks diferentes
+// (uma faixa por chunk), de modo que as rodadas não precisam de shuffles.
+#define ROTR128(x, c) \
+    _mm_or_si128(_mm_srli_epi32((x), (c)), _mm_slli_epi32((x), 32 - (c)))
+#define G128(a, b, c, d, x, y) do { \
+    a = _mm_add_epi32(_mm_add_epi32(a, b), x); \
+    d = ROTR128(_mm_xor_si128(d, a), 16); \
+    c = _mm_add_epi32(c, d); \
+    b = ROTR128(_mm_xor_si128(b, c), 12); \
+    a = _mm_add_epi32(_mm_add_epi32(a, b), y); \
+    d = ROTR128(_mm_xor_si128(d, a), 8); \
+    c = _mm_add_epi32(c, d); \
+    b = ROTR128(_mm_xor_si128(b, c), 7); \
+} while (0)
+
+static void hash4_sse2(const uint8_t *entrada, uint64_t contador,
+                       uint32_t (*cvs)[8]) {
+    __m128i h[8];
+    for (int i = 0; i < 8; ++i)
+        h[i] = _mm_set1_epi32(static_cast<int>(kIV[i]));
+    uint32_t lo[4], hi[4];
+    for (int l = 0; l < 4; ++l) {
+        lo[l] = static_cast<uint32_t>(contador + l);
+        hi[l] = static_cast<uint32_t>((contador + l) >> 32);
+    }
+    const __m128i ctrLo = _mm_loadu_si128(reinterpret_cast<__m128i *>(lo));
+    const __m128i ctrHi = _mm_loadu_si128(reinterpret_cast<__m128i *>(hi));
+
+    for (size_t b = 0; b < kTamanhoChunk / kTamanhoBloco; ++b) {
+        __m128i m[16];
+        const uint8_t *p = entrada + b * kTamanhoBloco;
+        for (int j = 0; j < 16; ++j)
+            m[j] = _mm_set_epi32(
+                static_cast<int>(ler32(p + 3 * kTamanhoChunk + 4 * j)),
+                static_cast<int>(ler32(p + 2 * kTamanhoChunk + 4 * j)),
+                static_cast<int>(ler32(p + kTamanhoChunk + 4 * j)),
+                static_cast<int>(ler32(p + 4 * j)));
+        uint32_t flags = (b == 0 ? CHUNK_START : 0) |
+            (b == kTamanhoChunk / kTamanhoBloco - 1 ? CHUNK_END : 0);
+        __m128i v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm_set1_epi32(static_cast<int>(kIV[0])),
+            _mm_set1_epi32(static_cast<int>(kIV[1])),
+            _mm_set1_epi32(static_cast<int>(kIV[2])),
+            _mm_set1_epi32(static_cast<int>(kIV[3])),
+            ctrLo, ctrHi, _mm_set1_epi32(kTamanhoBloco),
+            _mm_set1_epi32(static_cast<int>(flags))
+        };
+        for (int r = 0; r < 7; ++r) {
+            const uint8_t *e = kEscalonamento.m[r];
+            G128(v[0], v[4], v[8], v[12], m[e[0]], m[e[1]]);
+            G128(v[1], v[5], v[9], v[13], m[e[2]], m[e[3]]);
+            G128(v[2], v[6], v[10], v[14], m[e[4]], m[e[5]]);
+            G128(v[3], v[7], v[11], v[15], m[e[6]], m[e[7]]);
+            G128(v[0], v[5], v[10], v[15], m[e[8]], m[e[9]]);
+            G128(v[1], v[6], v[11], v[12], m[e[10]], m[e[11]]);
+            G128(v[2], v[7], v[8], v[13], m[e[12]], m[e[13]]);
+            G128(v[3], v[4], v[9], v[14], m[e[14]], m[e[15]]);
+        }
+        for (int i = 0; i < 8; ++i)
+            h[i] = _mm_xor_si128(v[i], v[i + 8]);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        uint32_t faixas[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(faixas), h[i]);
+        for (int l = 0; l < 4; ++l)
+            cvs[l][i] = faixas[l];
+    }
+}
+
+#define ROTR256(x, c) _mm256_or_si256(_mm256_srli_epi32((x), (c)), \
+    _mm256_slli_epi32((x), 32 - (c)))
+#define G256(a, b, c, d, x, y) do { \
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), x); \
+    d = ROTR256(_mm256_xor_si256(d, a), 16); \
+    c = _mm256_add_epi32(c, d); \
+    b = ROTR256(_mm256_xor_si256(b, c), 12); \
+    a = _mm256_add_epi32(_mm256_add_epi32(a, b), y); \
+    d = ROTR256(_mm256_xor_si256(d, a), 8); \
+    c = _mm256_add_epi32(c, d); \
+    b = ROTR256(_mm256_xor_si256(b, c), 7); \
+} while (0)
+
+__attribute__((target("avx2")))
+static void hash8_avx2(const uint8_t *entrada, uint64_t contador,
+                       uint32_t (*cvs)[8]) {
+    __m256i h[8];
+    for (int i = 0; i < 8; ++i)
+        h[i] = _mm256_set1_epi32(static_cast<int>(kIV[i]));
+    uint32_t lo[8], hi[8];
+    for (int l = 0; l < 8; ++l) {
+        lo[l] = static_cast<uint32_t>(contador + l);
+        hi[l] = static_cast<uint32_t>((contador + l) >> 32);
+    }
+    const __m256i ctrLo =
+        _mm256_loadu_si256(reinterpret_cast<__m256i *>(lo));
+    const __m256i ctrHi =
+        _mm256_loadu_si256(reinterpret_cast<__m256i *>(hi));
+    // Deslocamento, em palavras, de cada chunk em relação ao primeiro
+    const __m256i deslocamentos = _mm256_setr_epi32(0, 256, 512, 768, 1024,
+                                                    1280, 1536, 1792);
+
+    for (size_t b = 0; b < kTamanhoChunk / kTamanhoBloco; ++b) {
+        __m256i m[16];
+        const int *p = reinterpret_cast<const int *>(
+            entrada + b * kTamanhoBloco);
+        for (int j = 0; j < 16; ++j)
+            m[j] = _mm256_i32gather_epi32(p + j, deslocamentos, 4);
+        uint32_t flags = (b == 0 ? CHUNK_START : 0) |
+            (b == kTamanhoChunk / kTamanhoBloco - 1 ? CHUNK_END : 0);
+        __m256i v[16] = {
+            h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7],
+            _mm256_set1_epi32(static_cast<int>(kIV[0])),
+            _mm256_set1_epi32(static_cast<int>(kIV[1])),
+            _mm256_set1_epi32(static_cast<int>(kIV[2])),
+            _mm256_set1_epi32(static_cast<int>(kIV[3])),
+            ctrLo, ctrHi, _mm256_set1_epi32(kTamanhoBloco),
+            _mm256_set1_epi32(static_cast<int>(flags))
+        };
+        for (int r = 0; r < 7; ++r) {
+            const uint8_t *e = kEscalonamento.m[r];
+            G256(v[0], v[4], v[8], v[12], m[e[0]], m[e[1]]);
+            G256(v[1], v[5], v[9], v[13], m[e[2]], m[e[3]]);
+            G256(v[2], v[6], v[10], v[14], m[e[4]], m[e[5]]);
+            G256(v[3], v[7], v[11], v[15], m[e[6]], m[e[7]]);
+            G256(v[0], v[5], v[10], v[15], m[e[8]], m[e[9]]);
+            G256(v[1], v[6], v[11], v[12], m[e[10]], m[e[11]]);
+            G256(v[2], v[7], v[8], v[13], m[e[12]], m[e[13]]);
+            G256(v[3], v[4], v[9], v[14], m[e[14]], m[e[15]]);
+        }
+        for (int i = 0; i < 8; ++i)
+            h[i] = _mm256_xor_si256(v[i], v[i + 8]);
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        uint32_t faixas[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(faixas), h[i]);
+        for (int l = 0; l < 8; ++l)
+            cvs[l][i] = faixas[l];
+    }
+}
+#endif
+
+/***************************************************************************
+* Função: resolver_nucleo
+* Descrição:
+*   Escolhe a rotina efetiva: AUTOMATICO vira AVX2 ou SSE2 conforme a
+*   CPU, e pedidos não suportados caem para a melhor alternativa.
+***************************************************************************/
+
+static NucleoBlake3 resolver_nucleo(NucleoBlake3 pedido) {
+#if defined(__x86_64__)
+    bool temAvx2 = __builtin_cpu_supports("avx2");
+    if (pedido == NucleoBlake3::AUTOMATICO ||
+        (pedido == NucleoBlake3::AVX2 && !temAvx2))
+        return temAvx2 ? NucleoBlake3::AVX2 : NucleoBlake3::SSE2;
+    return pedido;
+#else
+    (void)pedido;
+    return NucleoBlake3::PORTAVEL;
+#endif
+}
+
+/***************************************************************************
+* Função: hash_chunks
+* Descrição:
+*   Calcula os valores de encadeamento de n chunks inteiros, usando a
+*   rotina vetorial mais larga disponível e a portável para o resto.
+***************************************************************************/
+
+static void hash_chunks(const uint8_t *entrada, size_t n, uint64_t contador,
+                        uint32_t (*cvs)[8], NucleoBlake3 nucleo) {
+#if defined(__x86_64__)
+    if (nucleo == NucleoBlake3::AVX2) {
+        for (; n >= 8; n -= 8, contador += 8, cvs += 8) {
+            hash8_avx2(entrada, contador, cvs);
+            entrada += 8 * kTamanhoChunk;
+        }
+    }
+    if (nucleo == NucleoBlake3::AVX2 || nucleo == NucleoBlake3::SSE2) {
+        for (; n >= 4; n -= 4, contador += 4, cvs += 4) {
+            hash4_sse2(entrada, contador, cvs);
+            entrada += 4 * kTamanhoChunk;
+        }
+    }
+#endif
+    hash_chunks_portavel(entrada, n, contador, cvs);
+}
+
+/***************************************************************************
+* Função: HasherBlake3::HasherBlake3
+* Descrição:
+*   Cria um hasher BLAKE3 (modo hash, saída de 32 bytes) vazio.
+*
+* Parâmetros:
+*   pool - se não for nulo, trechos grandes são divididos entre as
+*          threads do pool; quem chama atualizar não deve ser uma delas,
+*          pois esperaria os trechos dentro de uma tarefa
+*   nucleo - rotina vetorial (AUTOMATICO por padrão)
+***************************************************************************/
+
+HasherBlake3::HasherBlake3(PoolTarefas *pool, NucleoBlake3 nucleo)
+    : pool_(pool), nucleo_(resolver_nucleo(nucleo)) {
+    std::memcpy(cvChunk_, kIV, sizeof(cvChunk_));
+}
+
+/***************************************************************************
+* Função: HasherBlake3::empilhar_cv
+* Descrição:
+*   Acrescenta o valor de encadeamento de um chunk concluído à árvore,
+*   fundindo as subárvores completas: cada zero à direita em totalChunks
+*   corresponde a um par de irmãos que pode virar nó pai.
+*
+* Parâmetros:
+*   cv - valor do chunk concluído
+*   totalChunks - chunks concluídos, incluindo este
+***************************************************************************/
+
+void HasherBlake3::empilhar_cv(const uint32_t cv[8], uint64_t totalChunks) {
+    uint32_t novo[16];
+    std::memcpy(novo, cv, 32);
+    while ((totalChunks & 1) == 0) {
+        assert(alturaPilha_ > 0);
+        --alturaPilha_;
+        cv_pai(pilha_[alturaPilha_], novo, 0, novo);
+        totalChunks >>= 1;
+    }
+    std::memcpy(pilha_[alturaPilha_++], novo, 32);
+}
+
+void HasherBlake3::concluir_chunk() {
+    uint32_t m[16], saida[16];
+    palavras_bloco(bloco_, m);
+    uint32_t flags = (blocosComprimidos_ == 0 ? CHUNK_START : 0) | CHUNK_END;
+    comprimir(cvChunk_, m, chunksConcluidos_, tamanhoBloco_, flags, saida);
+    ++chunksConcluidos_;
+    empilhar_cv(saida, chunksConcluidos_);
+
+    std::memcpy(cvChunk_, kIV, sizeof(cvChunk_));
+    std::memset(bloco_, 0, sizeof(bloco_));
+    tamanhoBloco_ = 0;
+    blocosComprimidos_ = 0;
+}
+
+/***************************************************************************
+* Função: HasherBlake3::atualizar_chunk
+* Descrição:
+*   Acrescenta bytes ao chunk corrente. Um bloco cheio só é comprimido
+*   quando chegam mais bytes, pois o último bloco do chunk leva o flag
+*   CHUNK_END.
+*
+* Assertivas de entrada:
+*   bytes no chunk + tamanho <= 1024
+***************************************************************************/
+
+void HasherBlake3::atualizar_chunk(const uint8_t *dados, size_t tamanho) {
+    while (tamanho > 0) {
+        if (tamanhoBloco_ == kTamanhoBloco) {
+            uint32_t m[16], saida[16];
+            palavras_bloco(bloco_, m);
+            comprimir(cvChunk_, m, chunksConcluidos_, kTamanhoBloco,
+                      blocosComprimidos_ == 0 ? CHUNK_START : 0, saida);
+            std::memcpy(cvChunk_, saida, sizeof(cvChunk_));
+            ++blocosComprimidos_;
+            std::memset(bloco_, 0, sizeof(bloco_));
+            tamanhoBloco_ = 0;
+        }
+        size_t n = std::min(kTamanhoBloco - tamanhoBloco_, tamanho);
+        std::memcpy(bloco_ + tamanhoBloco_, dados, n);
+        tamanhoBloco_ += static_cast<uint32_t>(n);
+        dados += n;
+        tamanho -= n;
+    }
+}
+
+/***************************************************************************
+* Função: HasherBlake3::atualizar
+* Descrição:
+*   Acrescenta dados ao hash. Sequências de chunks inteiros que começam
+*   numa fronteira de chunk são comprimidas em lote pelas rotinas
+*   vetoriais (e divididas entre as threads do pool, se houver); o último
+*   chunk fica sempre pendente, pois pode ser a raiz.
+*
+* Parâmetros:
+*   dados - bytes a acrescentar
+*   tamanho - quantidade de bytes
+***************************************************************************/
+
+void HasherBlake3::atualizar(const void *dados, size_t tamanho) {
+    const uint8_t *p = static_cast<const uint8_t *>(dados);
+    std::vector<uint32_t> palavras;
+
+    while (tamanho > 0) {
+        size_t noChunk = blocosComprimidos_ * kTamanhoBloco + tamanhoBloco_;
+        if (noChunk == kTamanhoChunk) {
+            concluir_chunk();
+            noChunk = 0;
+        }
+        if (noChunk == 0 && tamanho > kTamanhoChunk) {
+            size_t n = (tamanho - 1) / kTamanhoChunk;
+            palavras.resize(8 * n);
+            auto cvs = reinterpret_cast<uint32_t (*)[8]>(palavras.data());
+            uint64_t base = chunksConcluidos_;
+            if (pool_ != nullptr && n >= 2 * kChunksPorTarefa) {
+                GrupoTarefas grupo;
+                for (size_t i = 0; i < n; i += kChunksPorTarefa) {
+                    size_t k = std::min(kChunksPorTarefa, n - i);
+                    pool_->submeter(&grupo, [=] {
+                        hash_chunks(p + i * kTamanhoChunk, k, base + i,
+                                    &cvs[i], nucleo_);
+                    });
+                }
+                pool_->aguardar(&grupo);
+            } else {
+                hash_chunks(p, n, base, cvs, nucleo_);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                ++chunksConcluidos_;
+                empilhar_cv(cvs[i], chunksConcluidos_);
+            }
+            p += n * kTamanhoChunk;
+            tamanho -= n * kTamanhoChunk;
+            continue;
+        }
+        size_t n = std::min(kTamanhoChunk - noChunk, tamanho);
+        atualizar_chunk(p, n);
+        p += n;
+        tamanho -= n;
+    }
+}
+
+/***************************************************************************
+* Função: HasherBlake3::finalizar
+* Descrição:
+*   Calcula o digest dos dados acrescentados até agora, sem alterar o
+*   estado (é possível continuar acrescentando depois). O chunk pendente
+*   é fundido com a pilha de subárvores da direita para a esquerda, e a
+*   última compressão leva o flag ROOT.
+*
+* Valor retornado:
+*   Digest de 32 bytes.
+***************************************************************************/
+
+DigestBlake3 HasherBlake3::finalizar() const {
+    // Saída pendente: entradas da última compressão, ainda sem ROOT
+    uint32_t cv[8], m[16];
+    uint64_t contador = chunksConcluidos_;
+    uint32_t tamanhoBloco = tamanhoBloco_;
+    uint32_t flags = (blocosComprimidos_ == 0 ? CHUNK_START : 0) | CHUNK_END;
+    std::memcpy(cv, cvChunk_, sizeof(cv));
+    palavras_bloco(bloco_, m);
+
+    for (size_t i = alturaPilha_; i > 0; --i) {
+        uint32_t saida[16];
+        comprimir(cv, m, contador, tamanhoBloco, flags, saida);
+        std::memcpy(m, pilha_[i - 1], 32);
+        std::memcpy(m + 8, saida, 32);
+        std::memcpy(cv, kIV, sizeof(cv));
+        contador = 0;
+        tamanhoBloco = kTamanhoBloco;
+        flags = PARENT;
+    }
+
+    uint32_t saida[16];
+    comprimir(cv, m, contador, tamanhoBloco, flags | ROOT, saida);
+    DigestBlake3 digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<uint8_t>(saida[i]);
+        digest[4 * i + 1] = static_cast<uint8_t>(saida[i] >> 8);
+        digest[4 * i + 2] = static_cast<uint8_t>(saida[i] >> 16);
+        digest[4 * i + 3] = static_cast<uint8_t>(saida[i] >> 24);
+    }
+    return digest;
+}
+
+std::string hex_digest(const DigestBlake3 &digest) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string s;
+    s.reserve(2 * digest.size());
+    for (uint8_t b : digest) {
+        s.push_back(kHex[b >> 4]);
+        s.push_back(kHex[b & 15]);
+    }
+    return s;
+}
+
+/***************************************************************************
+* Função: blake3_arquivo
+* Descrição:
+*   Calcula o BLAKE3 do conteúdo de um arquivo, mapeando-o em memória ou
+*   lendo-o em blocos de 2 MiB.
+*
+* Parâmetros:
+*   caminho - arquivo a ler
+*   digest - recebe o resultado
+*   pool - threads para dividir o hash (opcional; o chamador não deve
+*          ser uma delas)
+*   usarMmap - mapeia o arquivo em vez de usar read()
+*
+* Valor retornado:
+*   false se o arquivo não pôde ser lido
+*
+* Assertivas de entrada:
+*   digest != nullptr
+***************************************************************************/
+
+bool blake3_arquivo(const std::string &caminho, DigestBlake3 *digest,
+                    PoolTarefas *pool, bool usarMmap) {
+    assert(digest != nullptr);
+
+    int fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    HasherBlake3 hasher(pool);
+
+    struct stat st;
+    if (usarMmap && fstat(fd, &st) == 0 && st.st_size > 0) {
+        size_t tamanho = static_cast<size_t>(st.st_size);
+        void *mapa = mmap(nullptr, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapa != MAP_FAILED) {
+            madvise(mapa, tamanho, MADV_SEQUENTIAL);
+            hasher.atualizar(mapa, tamanho);
+            munmap(mapa, tamanho);
+            close(fd);
+            *digest = hasher.finalizar();
+            return true;
+        }
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    BlocoBuffer buffer = PoolBuffers::global().obter(kTamanhoLeitura);
+    for (;;) {
+        ssize_t n = buffer ? read(fd, buffer.dados(), kTamanhoLeitura) : -1;
+        if (n < 0) {
+            close(fd);
+            return false;
+        }
+        if (n == 0)
+            break;
+        hasher.atualizar(buffer.dados(), static_cast<size_t>(n));
+    }
+    close(fd);
+    *digest = hasher.finalizar();
+    return true;
+}
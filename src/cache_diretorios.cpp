@@ -0,0 +1,159 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/cache_diretorios.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cassert>
+#include <cerrno>
+#include <string>
+#include <string_view>
+#include <utility>
+
+DescritorDiretorio::~DescritorDiretorio() {
+    close(fd_);
+}
+
+CacheDiretorios::CacheDiretorios(size_t capacidade)
+    : capacidade_(capacidade) {
+    assert(capacidade > 0);
+}
+
+/***************************************************************************
+* Função: CacheDiretorios::abrir
+* Descrição:
+*   Devolve o descritor do diretório 'raiz/relativo', do cache se ele já
+*   estiver aberto. Senão, abre o pai pelo mesmo caminho (recursivamente,
+*   até a raiz) e o diretório com um openat relativo a ele: cada
+*   componente de um caminho é resolvido uma única vez, e diretórios
+*   irmãos compartilham os ancestrais. A abertura é feita fora da trava;
+*   se duas threads abrirem o mesmo diretório, fica o primeiro inserido.
+*   O diretório menos usado recentemente sai quando o limite é excedido.
+*
+* Parâmetros:
+*   raiz - diretório raiz (HD, Pen ou destino)
+*   relativo - caminho relativo à raiz, sem barra final ("" = a raiz)
+*
+* Valor retornado:
+*   Descritor compartilhado, ou nulo se algum componente não existir ou
+*   não puder ser aberto (errno indica o motivo).
+*
+* Assertivas de entrada:
+*   raiz != ""
+***************************************************************************/
+
+DiretorioAberto CacheDiretorios::abrir(const std::string &raiz,
+                                       std::string_view relativo) {
+    assert(!raiz.empty());
+
+    std::string chave;
+    chave.reserve(raiz.size() + 1 + relativo.size());
+    chave.append(raiz).push_back('\0');
+    chave.append(relativo);
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        auto it = porChave_.find(chave);
+        if (it != porChave_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            ++estatisticas_.acertos;
+            return it->second->second;
+        }
+    }
+
+    int fd;
+    if (relativo.empty()) {
+        fd = open(raiz.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    } else {
+        size_t barra = relativo.rfind('/');
+        DiretorioAberto pai = abrir(raiz, (barra == std::string_view::npos) ?
+            std::string_view() : relativo.substr(0, barra));
+        if (pai == nullptr)
+            return nullptr;
+        std::string componente(relativo.substr(
+            (barra == std::string_view::npos) ? 0 : barra + 1));
+        fd = openat(pai->fd(), componente.c_str(),
+                    O_PATH | O_DIRECTORY | O_CLOEXEC);
+    }
+    if (fd < 0)
+        return nullptr;
+    DiretorioAberto novo = std::make_shared<DescritorDiretorio>(fd);
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    ++estatisticas_.aberturas;
+    auto it = porChave_.find(chave);
+    if (it != porChave_.end())
+        return it->second->second;
+    lru_.emplace_front(std::move(chave), novo);
+    porChave_.emplace(lru_.front().first, lru_.begin());
+    while (lru_.size() > capacidade_) {
+        porChave_.erase(lru_.back().first);
+        lru_.pop_back();
+        ++estatisticas_.descartes;
+    }
+    return novo;
+}
+
+/***************************************************************************
+* Função: CacheDiretorios::pai
+* Descrição:
+*   Abre o diretório pai de um nome relativo à raiz e separa o nome base,
+*   para uso com as chamadas *at.
+*
+* Parâmetros:
+*   raiz - diretório raiz
+*   nome - nome relativo do arquivo
+*   base - recebe o último componente de nome
+*
+* Valor retornado:
+*   Descritor do diretório pai, ou nulo se ele não puder ser aberto.
+*
+* Assertivas de entrada:
+*   nome != "" e sem barra final
+***************************************************************************/
+
+DiretorioAberto CacheDiretorios::pai(const std::string &raiz,
+                                     std::string_view nome,
+                                     std::string *base) {
+    assert(!nome.empty() && nome.back() != '/');
+
+    size_t barra = nome.rfind('/');
+    if (barra == std::string_view::npos) {
+        base->assign(nome);
+        return abrir(raiz, std::string_view());
+    }
+    base->assign(nome.substr(barra + 1));
+    return abrir(raiz, nome.substr(0, barra));
+}
+
+/***************************************************************************
+* Função: CacheDiretorios::sondar
+* Descrição:
+*   Metadados de 'raiz/nome' com um statx relativo ao pai em cache. Se o
+*   pai não existe, o arquivo também não; outras falhas ao abri-lo (como
+*   falta de descritores) caem na sondagem pelo caminho completo.
+*
+* Valor retornado:
+*   Registro Metadados, como em sondar_metadados.
+***************************************************************************/
+
+Metadados CacheDiretorios::sondar(const std::string &raiz,
+                                  std::string_view nome) {
+    std::string base;
+    DiretorioAberto dir = pai(raiz, nome, &base);
+    if (dir != nullptr)
+        return sondar_metadados_em(dir->fd(), base.c_str());
+    if (errno == ENOENT || errno == ENOTDIR)
+        return Metadados();
+    std::string caminho(raiz);
+    caminho.append("/").append(nome);
+    return sondar_metadados(caminho);
+}
+
+size_t CacheDiretorios::tamanho() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return lru_.size();
+}
+
+EstatisticasCacheDiretorios CacheDiretorios::estatisticas() const {
+    std::lock_guard<std::mutex> lk(mtx_);
+    return estatisticas_;
+}
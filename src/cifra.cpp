@@ -0,0 +1,375 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/cifra.hpp"
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
+
+// Cabeçalho (32 bytes, inteiros na ordem de bytes da máquina):
+//   magica[8] algoritmo:u8 reservado[3] bloco:u32 tamanho:u64 prefixo[8]
+// Bloco i: min(bloco, resto) bytes cifrados + etiqueta de 16 bytes, com
+// nonce = prefixo || i (u32) e o cabeçalho inteiro como dado associado,
+// de modo que trocar, reordenar ou truncar blocos e alterar o cabeçalho
+// fazem a decifração falhar.
+static constexpr char kMagica[8] = {'B', 'K', 'P', 'C', 'I', 'F', '0', '1'};
+static constexpr size_t kCabecalho = kTamanhoCabecalhoCifra;
+static constexpr size_t kEtiqueta = 16;
+static constexpr size_t kPrefixoNonce = 8;
+static constexpr uint32_t kBloco = 1 << 20;
+static constexpr uint32_t kBlocoMaximo = 64 << 20;
+// Blocos por tarefa do pool.
+static constexpr uint64_t kBlocosPorTarefa = 8;
+static constexpr char kSufixoTemporario[] = ".parcial";
+
+struct CabecalhoCifra {
+    AlgoritmoCifra algoritmo = CIFRA_AES_256_GCM;
+    uint32_t bloco = kBloco;
+    uint64_t tamanho = 0;  // do arquivo original
+    unsigned char prefixo[kPrefixoNonce] = {};
+    unsigned char bytes[kCabecalho] = {};  // serializado
+};
+
+static void serializar(CabecalhoCifra *c) {
+    std::memset(c->bytes, 0, sizeof(c->bytes));
+    std::memcpy(c->bytes, kMagica, sizeof(kMagica));
+    c->bytes[8] = c->algoritmo;
+    std::memcpy(c->bytes + 12, &c->bloco, sizeof(c->bloco));
+    std::memcpy(c->bytes + 16, &c->tamanho, sizeof(c->tamanho));
+    std::memcpy(c->bytes + 24, c->prefixo, sizeof(c->prefixo));
+}
+
+static bool interpretar(const unsigned char *bytes, CabecalhoCifra *c) {
+    if (std::memcmp(bytes, kMagica, sizeof(kMagica)) != 0 ||
+        (bytes[8] != CIFRA_AES_256_GCM &&
+         bytes[8] != CIFRA_CHACHA20_POLY1305))
+        return false;
+    c->algoritmo = static_cast<AlgoritmoCifra>(bytes[8]);
+    std::memcpy(&c->bloco, bytes + 12, sizeof(c->bloco));
+    std::memcpy(&c->tamanho, bytes + 16, sizeof(c->tamanho));
+    std::memcpy(c->prefixo, bytes + 24, sizeof(c->prefixo));
+    std::memcpy(c->bytes, bytes, kCabecalho);
+    return c->bloco > 0 && c->bloco <= kBlocoMaximo;
+}
+
+// Um arquivo vazio ainda tem um bloco, para que o cabeçalho seja
+// autenticado.
+static uint64_t num_blocos(const CabecalhoCifra &c) {
+    return std::max<uint64_t>((c.tamanho + c.bloco - 1) / c.bloco, 1);
+}
+
+static uint64_t tamanho_cifrado(const CabecalhoCifra &c) {
+    return kCabecalho + num_blocos(c) * kEtiqueta + c.tamanho;
+}
+
+static const EVP_CIPHER *cifra_evp(AlgoritmoCifra algoritmo) {
+    return (algoritmo == CIFRA_AES_256_GCM) ? EVP_aes_256_gcm() :
+        EVP_chacha20_poly1305();
+}
+
+/***************************************************************************
+* Função: algoritmo_preferido
+* Descrição:
+*   Escolhe o AES-256-GCM quando a CPU tem as instruções AES-NI e PCLMUL,
+*   com as quais o OpenSSL cifra e autentica a vários GB/s por núcleo;
+*   sem elas, o ChaCha20-Poly1305, mais rápido em software.
+***************************************************************************/
+
+AlgoritmoCifra algoritmo_preferido() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool temAes = __builtin_cpu_supports("aes") &&
+        __builtin_cpu_supports("pclmul");
+    return temAes ? CIFRA_AES_256_GCM : CIFRA_CHACHA20_POLY1305;
+#else
+    return CIFRA_AES_256_GCM;
+#endif
+}
+
+static bool ler_exato(int fd, unsigned char *dados, size_t tamanho,
+                      uint64_t deslocamento) {
+    size_t lidos = 0;
+    while (lidos < tamanho) {
+        ssize_t n = pread(fd, dados + lidos, tamanho - lidos,
+                          static_cast<off_t>(deslocamento + lidos));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        lidos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool gravar_exato(int fd, const unsigned char *dados, size_t tamanho,
+                         uint64_t deslocamento) {
+    size_t feitos = 0;
+    while (feitos < tamanho) {
+        ssize_t n = pwrite(fd, dados + feitos, tamanho - feitos,
+                           static_cast<off_t>(deslocamento + feitos));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        feitos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool cabecalho_cifrado(const char *dados, size_t tamanho,
+                       uint64_t *tamanhoOriginal) {
+    CabecalhoCifra c;
+    if (tamanho < kCabecalho ||
+        !interpretar(reinterpret_cast<const unsigned char *>(dados), &c))
+        return false;
+    *tamanhoOriginal = c.tamanho;
+    return true;
+}
+
+bool arquivo_cifrado(const std::string &caminho) {
+    int fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    unsigned char cabecalho[kCabecalho];
+    uint64_t tamanho;
+    bool ok = ler_exato(fd, cabecalho, sizeof(cabecalho), 0) &&
+        cabecalho_cifrado(reinterpret_cast<const char *>(cabecalho),
+                          sizeof(cabecalho), &tamanho);
+    close(fd);
+    return ok;
+}
+
+/***************************************************************************
+* Função: processar_blocos
+* Descrição:
+*   Cifra ou decifra os blocos [primeiro, fim) com um contexto EVP
+*   próprio, lendo e gravando por posição (pread/pwrite), de modo que
+*   faixas disjuntas podem ser tratadas por threads diferentes. Na
+*   decifração, a etiqueta de cada bloco é conferida antes de ele ser
+*   considerado bom.
+*
+* Valor retornado:
+*   false se algum bloco não pôde ser lido, gravado ou autenticado
+***************************************************************************/
+
+static bool processar_blocos(const CabecalhoCifra &c,
+                             const unsigned char *chave, bool cifrar,
+                             int entrada, int saida, uint64_t primeiro,
+                             uint64_t fim) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx != nullptr &&
+        EVP_CipherInit_ex(ctx, cifra_evp(c.algoritmo), nullptr, chave,
+                          nullptr, cifrar ? 1 : 0) == 1;
+    BlocoBuffer bufEntrada = PoolBuffers::global().obter(c.bloco + kEtiqueta);
+    BlocoBuffer bufSaida = PoolBuffers::global().obter(c.bloco + kEtiqueta);
+    ok = ok && bufEntrada && bufSaida;
+    unsigned char *in = reinterpret_cast<unsigned char *>(bufEntrada.dados());
+    unsigned char *out = reinterpret_cast<unsigned char *>(bufSaida.dados());
+    for (uint64_t i = primeiro; ok && i < fim; ++i) {
+        uint64_t posClaro = i * c.bloco;
+        uint64_t posCifrado = kCabecalho + i * (c.bloco + kEtiqueta);
+        int claro = static_cast<int>(
+            std::min<uint64_t>(c.bloco, c.tamanho - posClaro));
+        unsigned char nonce[kPrefixoNonce + sizeof(uint32_t)];
+        uint32_t indice = static_cast<uint32_t>(i);
+        std::memcpy(nonce, c.prefixo, kPrefixoNonce);
+        std::memcpy(nonce + kPrefixoNonce, &indice, sizeof(indice));
+        int n = 0;
+        ok = (cifrar ? ler_exato(entrada, in, claro, posClaro) :
+              ler_exato(entrada, in, claro + kEtiqueta, posCifrado)) &&
+            EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, nonce, -1) == 1 &&
+            EVP_CipherUpdate(ctx, nullptr, &n, c.bytes, kCabecalho) == 1 &&
+            (claro == 0 ||
+             EVP_CipherUpdate(ctx, out, &n, in, claro) == 1);
+        if (ok && !cifrar)
+            ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, kEtiqueta,
+                                     in + claro) == 1;
+        ok = ok && EVP_CipherFinal_ex(ctx, out + claro, &n) == 1;
+        if (ok && cifrar)
+            ok = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, kEtiqueta,
+                                     out + claro) == 1;
+        ok = ok && (cifrar ?
+            gravar_exato(saida, out, claro + kEtiqueta, posCifrado) :
+            gravar_exato(saida, out, claro, posClaro));
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+// Todos os blocos, em faixas de kBlocosPorTarefa pelo pool, se houver.
+static bool processar(const CabecalhoCifra &c, const unsigned char *chave,
+                      bool cifrar, int entrada, int saida,
+                      PoolTarefas *pool) {
+    uint64_t n = num_blocos(c);
+    if (pool == nullptr || n <= kBlocosPorTarefa)
+        return processar_blocos(c, chave, cifrar, entrada, saida, 0, n);
+    std::atomic<bool> ok{true};
+    GrupoTarefas grupo;
+    for (uint64_t i = 0; i < n; i += kBlocosPorTarefa) {
+        uint64_t fim = std::min(i + kBlocosPorTarefa, n);
+        pool->submeter(&grupo, [&, i, fim] {
+            if (!processar_blocos(c, chave, cifrar, entrada, saida, i, fim))
+                ok.store(false, std::memory_order_relaxed);
+        });
+    }
+    pool->aguardar(&grupo);
+    return ok;
+}
+
+// Temporário ao lado do destino, já com o tamanho final (os blocos são
+// gravados por posição).
+static int criar_temporario(const std::string &temporario,
+                            uint64_t tamanho) {
+    int fd = open(temporario.c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd >= 0 && ftruncate(fd, static_cast<off_t>(tamanho)) != 0) {
+        close(fd);
+        unlink(temporario.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+// Aplica as permissões, fecha e renomeia o temporário sobre o destino;
+// em qualquer falha, o temporário é removido.
+static bool concluir_temporario(int fd, bool ok, unsigned modo,
+                                const std::string &temporario,
+                                const std::string &destino) {
+    ok = fchmod(fd, modo & 07777) == 0 && ok;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || rename(temporario.c_str(), destino.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: cifrar_arquivo
+* Descrição:
+*   Grava em destino a origem cifrada em blocos de 1 MiB com AEAD
+*   (AES-256-GCM ou ChaCha20-Poly1305), lendo a origem uma única vez: a
+*   cifra é aplicada durante a cópia, sem uma segunda passada sobre o
+*   destino. O prefixo do nonce é sorteado a cada arquivo, então a mesma
+*   chave pode cifrar muitos arquivos.
+*
+* Parâmetros:
+*   origem, destino - caminhos completos
+*   chave - kTamanhoChaveCifra bytes
+*   algoritmo - ver algoritmo_preferido
+*   pool - divide os blocos de arquivos grandes; pode ser nulo, e o
+*          chamador não deve ser um dos trabalhadores dele
+*
+* Valor retornado:
+*   COPIA_CIFRADA, ou COPIA_FALHOU (destino anterior intacto).
+*
+* Assertivas de entrada:
+*   origem != "" && destino != "" && chave.size() == kTamanhoChaveCifra
+***************************************************************************/
+
+EstrategiaCopia cifrar_arquivo(const std::string &origem,
+                               const std::string &destino,
+                               const std::string &chave,
+                               AlgoritmoCifra algoritmo,
+                               PoolTarefas *pool) {
+    assert(!origem.empty() && !destino.empty());
+    assert(chave.size() == kTamanhoChaveCifra);
+
+    if (chave.size() != kTamanhoChaveCifra)
+        return COPIA_FALHOU;
+    int entrada = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entrada < 0)
+        return COPIA_FALHOU;
+    struct stat st;
+    CabecalhoCifra c;
+    c.algoritmo = algoritmo;
+    if (fstat(entrada, &st) != 0 || !S_ISREG(st.st_mode) ||
+        RAND_bytes(c.prefixo, sizeof(c.prefixo)) != 1) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    c.tamanho = static_cast<uint64_t>(st.st_size);
+    serializar(&c);
+    assert(num_blocos(c) <= UINT32_MAX);
+
+    std::string temporario = destino + kSufixoTemporario;
+    int saida = criar_temporario(temporario, tamanho_cifrado(c));
+    if (saida < 0) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    bool ok = gravar_exato(saida, c.bytes, kCabecalho, 0) &&
+        processar(c, reinterpret_cast<const unsigned char *>(chave.data()),
+                  true, entrada, saida, pool);
+    close(entrada);
+    return concluir_temporario(saida, ok, st.st_mode, temporario, destino) ?
+        COPIA_CIFRADA : COPIA_FALHOU;
+}
+
+/***************************************************************************
+* Função: decifrar_arquivo
+* Descrição:
+*   Recria em destino o conteúdo original de um arquivo gravado por
+*   cifrar_arquivo. O tamanho do arquivo precisa bater com o cabeçalho e
+*   todos os blocos precisam ser autenticados com a chave; senão (chave
+*   errada, dados alterados ou truncados), o destino anterior fica
+*   intacto.
+*
+* Parâmetros:
+*   origem - arquivo cifrado
+*   destino - arquivo a gerar
+*   chave - kTamanhoChaveCifra bytes
+*   pool - divide os blocos de arquivos grandes; pode ser nulo, e o
+*          chamador não deve ser um dos trabalhadores dele
+*
+* Valor retornado:
+*   COPIA_DECIFRADA, ou COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && destino != ""
+***************************************************************************/
+
+EstrategiaCopia decifrar_arquivo(const std::string &origem,
+                                 const std::string &destino,
+                                 const std::string &chave,
+                                 PoolTarefas *pool) {
+    assert(!origem.empty() && !destino.empty());
+
+    if (chave.size() != kTamanhoChaveCifra)
+        return COPIA_FALHOU;
+    int entrada = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entrada < 0)
+        return COPIA_FALHOU;
+    struct stat st;
+    unsigned char bytes[kCabecalho];
+    CabecalhoCifra c;
+    if (fstat(entrada, &st) != 0 ||
+        !ler_exato(entrada, bytes, sizeof(bytes), 0) ||
+        !interpretar(bytes, &c) ||
+        static_cast<uint64_t>(st.st_size) != tamanho_cifrado(c)) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+
+    std::string temporario = destino + kSufixoTemporario;
+    int saida = criar_temporario(temporario, c.tamanho);
+    if (saida < 0) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    bool ok = processar(c,
+        reinterpret_cast<const unsigned char *>(chave.data()), false,
+        entrada, saida, pool);
+    close(entrada);
+    return concluir_temporario(saida, ok, st.st_mode, temporario, destino) ?
+        COPIA_DECIFRADA : COPIA_FALHOU;
+}
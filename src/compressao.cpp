@@ -0,0 +1,394 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/compressao.hpp"
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "../include/pool_buffers.hpp"
+
+// Subconjunto da API estável do zstd (zstd.h, 1.4 em diante) usado aqui;
+// declarado localmente porque a biblioteca é carregada por dlopen.
+struct EntradaZstd {
+    const void *src;
+    size_t size;
+    size_t pos;
+};
+
+struct SaidaZstd {
+    void *dst;
+    size_t size;
+    size_t pos;
+};
+
+enum ParametroZstd : int {
+    ZSTD_NIVEL = 100,          // ZSTD_c_compressionLevel
+    ZSTD_CHECKSUM = 201,       // ZSTD_c_checksumFlag
+    ZSTD_TRABALHADORES = 400   // ZSTD_c_nbWorkers
+};
+
+enum DiretivaZstd : int {
+    ZSTD_CONTINUAR = 0,  // ZSTD_e_continue
+    ZSTD_TERMINAR = 2    // ZSTD_e_end
+};
+
+struct ApiZstd {
+    void *(*createCCtx)();
+    size_t (*freeCCtx)(void *);
+    size_t (*setParameter)(void *, int, int);
+    size_t (*setPledgedSrcSize)(void *, unsigned long long);  // NOLINT
+    size_t (*compressStream2)(void *, SaidaZstd *, EntradaZstd *, int);
+    size_t (*compress)(void *, size_t, const void *, size_t, int);
+    size_t (*compressBound)(size_t);
+    void *(*createDCtx)();
+    size_t (*freeDCtx)(void *);
+    size_t (*decompressStream)(void *, SaidaZstd *, EntradaZstd *);
+    unsigned (*isError)(size_t);
+};
+
+static constexpr char kMagica[8] = {'B', 'K', 'P', 'Z', 'S', 'T', '0', '1'};
+static constexpr size_t kCabecalho = sizeof(kMagica) + sizeof(uint64_t);
+static_assert(kCabecalho == kTamanhoCabecalhoCompressao,
+              "cabeçalho da compressão");
+static constexpr char kSufixoTemporario[] = ".parcial";
+// Bytes do início comprimidos para decidir se vale a pena comprimir, e
+// o ganho mínimo exigido da amostra (em décimos).
+static constexpr size_t kAmostra = 128 * 1024;
+static constexpr size_t kDecimosMaximos = 9;
+static constexpr size_t kBloco = 1 << 20;
+// A partir deste tamanho a compressão usa os trabalhadores do zstd.
+static constexpr uint64_t kLimiteTrabalhadores = uint64_t(8) << 20;
+
+template <typename F>
+static bool simbolo(void *biblioteca, const char *nome, F *funcao) {
+    *funcao = reinterpret_cast<F>(dlsym(biblioteca, nome));
+    return *funcao != nullptr;
+}
+
+/***************************************************************************
+* Função: carregar_zstd
+* Descrição:
+*   Abre a libzstd do sistema e resolve as funções usadas. A biblioteca
+*   fica carregada até o fim do processo.
+*
+* Valor retornado:
+*   Tabela de funções, ou nullptr se a biblioteca (ou alguma função)
+*   não estiver disponível.
+***************************************************************************/
+
+static const ApiZstd *carregar_zstd() {
+    static ApiZstd api;
+    void *b = dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (b == nullptr)
+        return nullptr;
+    if (simbolo(b, "ZSTD_createCCtx", &api.createCCtx) &&
+        simbolo(b, "ZSTD_freeCCtx", &api.freeCCtx) &&
+        simbolo(b, "ZSTD_CCtx_setParameter", &api.setParameter) &&
+        simbolo(b, "ZSTD_CCtx_setPledgedSrcSize", &api.setPledgedSrcSize) &&
+        simbolo(b, "ZSTD_compressStream2", &api.compressStream2) &&
+        simbolo(b, "ZSTD_compress", &api.compress) &&
+        simbolo(b, "ZSTD_compressBound", &api.compressBound) &&
+        simbolo(b, "ZSTD_createDCtx", &api.createDCtx) &&
+        simbolo(b, "ZSTD_freeDCtx", &api.freeDCtx) &&
+        simbolo(b, "ZSTD_decompressStream", &api.decompressStream) &&
+        simbolo(b, "ZSTD_isError", &api.isError))
+        return &api;
+    dlclose(b);
+    return nullptr;
+}
+
+static const ApiZstd *api_zstd() {
+    static const ApiZstd *api = carregar_zstd();
+    return api;
+}
+
+bool zstd_disponivel() {
+    return api_zstd() != nullptr;
+}
+
+static bool gravar_tudo(int fd, const char *dados, size_t tamanho) {
+    while (tamanho > 0) {
+        ssize_t n = write(fd, dados, tamanho);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        dados += n;
+        tamanho -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lê até 'tamanho' bytes; devolve quantos foram lidos (menos só no fim).
+static ssize_t ler_ate(int fd, char *dados, size_t tamanho) {
+    size_t lidos = 0;
+    while (lidos < tamanho) {
+        ssize_t n = read(fd, dados + lidos, tamanho - lidos);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+        lidos += static_cast<size_t>(n);
+    }
+    return static_cast<ssize_t>(lidos);
+}
+
+bool cabecalho_comprimido(const char *dados, size_t tamanho,
+                          uint64_t *tamanhoOriginal) {
+    if (tamanho < kCabecalho ||
+        std::memcmp(dados, kMagica, sizeof(kMagica)) != 0)
+        return false;
+    std::memcpy(tamanhoOriginal, dados + sizeof(kMagica),
+                sizeof(*tamanhoOriginal));
+    return true;
+}
+
+bool arquivo_comprimido(const std::string &caminho) {
+    int fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    char cabecalho[kCabecalho];
+    uint64_t tamanho;
+    bool ok = pread(fd, cabecalho, sizeof(cabecalho), 0) ==
+        static_cast<ssize_t>(sizeof(cabecalho)) &&
+        cabecalho_comprimido(cabecalho, sizeof(cabecalho), &tamanho);
+    close(fd);
+    return ok;
+}
+
+// A amostra diminui o bastante no nível mais rápido?
+static bool amostra_comprimivel(const ApiZstd *z, const char *dados,
+                                size_t tamanho) {
+    size_t limite = z->compressBound(tamanho);
+    BlocoBuffer saida = PoolBuffers::global().obter(limite);
+    if (!saida)
+        return false;
+    size_t r = z->compress(saida.dados(), limite, dados, tamanho, 1);
+    return !z->isError(r) && r * 10 < tamanho * kDecimosMaximos;
+}
+
+// Aplica as permissões, fecha e renomeia o temporário sobre o destino;
+// em qualquer falha, o temporário é removido.
+static bool concluir_temporario(int fd, bool ok, unsigned modo,
+                                const std::string &temporario,
+                                const std::string &destino) {
+    ok = fchmod(fd, modo & 07777) == 0 && ok;
+    ok = (close(fd) == 0) && ok;
+    if (!ok || rename(temporario.c_str(), destino.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: comprimir_arquivo
+* Descrição:
+*   Grava em destino a origem comprimida em fluxo (zstd, com checksum),
+*   precedida do cabeçalho com o tamanho original. Antes, os primeiros
+*   128 KiB são comprimidos no nível 1: se não diminuírem ao menos 10%
+*   (dados já comprimidos ou aleatórios), ou sem a libzstd, o arquivo é
+*   copiado sem compressão. Arquivos a partir de 8 MiB usam 'threads'
+*   trabalhadores do zstd. A saída vai para um temporário renomeado
+*   sobre o destino no fim.
+*
+* Parâmetros:
+*   origem, destino - caminhos completos
+*   nivel - nível de compressão do zstd
+*   threads - trabalhadores do zstd para arquivos grandes (0/1 = nenhum)
+*   resultado - recebe se houve compressão e os bytes lidos e gravados
+*
+* Valor retornado:
+*   COPIA_COMPRIMIDA, a estratégia da cópia sem compressão, ou
+*   COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && destino != "" && resultado != nullptr
+***************************************************************************/
+
+EstrategiaCopia comprimir_arquivo(const std::string &origem,
+                                  const std::string &destino, int nivel,
+                                  unsigned threads,
+                                  ResultadoCompressao *resultado) {
+    assert(!origem.empty() && !destino.empty() && resultado != nullptr);
+
+    *resultado = ResultadoCompressao();
+    int entrada = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entrada < 0)
+        return COPIA_FALHOU;
+    struct stat st;
+    if (fstat(entrada, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    uint64_t tamanho = static_cast<uint64_t>(st.st_size);
+
+    const ApiZstd *z = api_zstd();
+    BlocoBuffer bloco = PoolBuffers::global().obter(kBloco);
+    ssize_t amostra = (z == nullptr || !bloco) ? -1 :
+        pread(entrada, bloco.dados(), std::min<uint64_t>(kAmostra, tamanho),
+              0);
+    if (amostra < 0 ||
+        !amostra_comprimivel(z, bloco.dados(), static_cast<size_t>(amostra))) {
+        close(entrada);
+        bloco.liberar();
+        EstrategiaCopia estrategia = copiar_arquivo(origem, destino);
+        if (estrategia != COPIA_FALHOU)
+            resultado->bytesOrigem = resultado->bytesGravados = tamanho;
+        return estrategia;
+    }
+
+    std::string temporario = destino + kSufixoTemporario;
+    int saida = open(temporario.c_str(),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (saida < 0) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    char cabecalho[kCabecalho];
+    std::memcpy(cabecalho, kMagica, sizeof(kMagica));
+    std::memcpy(cabecalho + sizeof(kMagica), &tamanho, sizeof(tamanho));
+    bool ok = gravar_tudo(saida, cabecalho, sizeof(cabecalho));
+    uint64_t gravados = sizeof(cabecalho);
+
+    void *cctx = z->createCCtx();
+    ok = ok && cctx != nullptr &&
+        !z->isError(z->setParameter(cctx, ZSTD_NIVEL, nivel)) &&
+        !z->isError(z->setParameter(cctx, ZSTD_CHECKSUM, 1)) &&
+        !z->isError(z->setPledgedSrcSize(cctx, tamanho));
+    // Sem suporte a threads na biblioteca, o parâmetro é recusado e a
+    // compressão segue em uma thread
+    if (ok && threads > 1 && tamanho >= kLimiteTrabalhadores)
+        z->setParameter(cctx, ZSTD_TRABALHADORES, static_cast<int>(threads));
+
+    BlocoBuffer comprimido = PoolBuffers::global().obter(kBloco);
+    ok = ok && comprimido;
+    for (bool fim = false; ok && !fim;) {
+        ssize_t n = ler_ate(entrada, bloco.dados(), kBloco);
+        if (n < 0) {
+            ok = false;
+            break;
+        }
+        fim = static_cast<size_t>(n) < kBloco;
+        int diretiva = fim ? ZSTD_TERMINAR : ZSTD_CONTINUAR;
+        EntradaZstd in{bloco.dados(), static_cast<size_t>(n), 0};
+        for (;;) {
+            SaidaZstd out{comprimido.dados(), kBloco, 0};
+            size_t r = z->compressStream2(cctx, &out, &in, diretiva);
+            if (z->isError(r) || !gravar_tudo(saida, comprimido.dados(),
+                                               out.pos)) {
+                ok = false;
+                break;
+            }
+            gravados += out.pos;
+            if (fim ? r == 0 : in.pos == in.size)
+                break;
+        }
+    }
+    if (cctx != nullptr)
+        z->freeCCtx(cctx);
+    close(entrada);
+    if (!concluir_temporario(saida, ok, st.st_mode, temporario, destino))
+        return COPIA_FALHOU;
+    resultado->comprimido = true;
+    resultado->bytesOrigem = tamanho;
+    resultado->bytesGravados = gravados;
+    return COPIA_COMPRIMIDA;
+}
+
+/***************************************************************************
+* Função: descomprimir_arquivo
+* Descrição:
+*   Recria em destino o conteúdo original de um arquivo gravado por
+*   comprimir_arquivo, com as permissões dele. O quadro precisa terminar
+*   e o tamanho descomprimido conferir com o do cabeçalho (o checksum do
+*   zstd é verificado pela própria biblioteca); senão, o destino
+*   anterior fica intacto.
+*
+* Parâmetros:
+*   origem - arquivo comprimido
+*   destino - arquivo a gerar
+*   resultado - recebe os bytes lidos e gravados
+*
+* Valor retornado:
+*   COPIA_DESCOMPRIMIDA, ou COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && destino != "" && resultado != nullptr
+***************************************************************************/
+
+EstrategiaCopia descomprimir_arquivo(const std::string &origem,
+                                     const std::string &destino,
+                                     ResultadoCompressao *resultado) {
+    assert(!origem.empty() && !destino.empty() && resultado != nullptr);
+
+    *resultado = ResultadoCompressao();
+    const ApiZstd *z = api_zstd();
+    if (z == nullptr)
+        return COPIA_FALHOU;
+    int entrada = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entrada < 0)
+        return COPIA_FALHOU;
+    struct stat st;
+    char cabecalho[kCabecalho];
+    uint64_t tamanho = 0;
+    if (fstat(entrada, &st) != 0 ||
+        ler_ate(entrada, cabecalho, sizeof(cabecalho)) !=
+            static_cast<ssize_t>(sizeof(cabecalho)) ||
+        std::memcmp(cabecalho, kMagica, sizeof(kMagica)) != 0) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    std::memcpy(&tamanho, cabecalho + sizeof(kMagica), sizeof(tamanho));
+
+    std::string temporario = destino + kSufixoTemporario;
+    int saida = open(temporario.c_str(),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (saida < 0) {
+        close(entrada);
+        return COPIA_FALHOU;
+    }
+    void *dctx = z->createDCtx();
+    BlocoBuffer bloco = PoolBuffers::global().obter(kBloco);
+    BlocoBuffer descomprimido = PoolBuffers::global().obter(kBloco);
+    bool ok = dctx != nullptr && bloco && descomprimido;
+    size_t pendente = 1;  // 0 quando o quadro termina
+    uint64_t escritos = 0;
+    while (ok) {
+        ssize_t n = ler_ate(entrada, bloco.dados(), kBloco);
+        if (n <= 0) {
+            ok = n == 0;
+            break;
+        }
+        EntradaZstd in{bloco.dados(), static_cast<size_t>(n), 0};
+        SaidaZstd out;
+        do {
+            out = SaidaZstd{descomprimido.dados(), kBloco, 0};
+            pendente = z->decompressStream(dctx, &out, &in);
+            if (z->isError(pendente) ||
+                !gravar_tudo(saida, descomprimido.dados(), out.pos)) {
+                ok = false;
+                break;
+            }
+            escritos += out.pos;
+        } while (in.pos < in.size || out.pos == out.size);
+    }
+    if (dctx != nullptr)
+        z->freeDCtx(dctx);
+    close(entrada);
+    ok = ok && pendente == 0 && escritos == tamanho;
+    if (!concluir_temporario(saida, ok, st.st_mode, temporario, destino))
+        return COPIA_FALHOU;
+    resultado->comprimido = true;
+    resultado->bytesOrigem = escritos;
+    resultado->bytesGravados = static_cast<uint64_t>(st.st_size);
+    return COPIA_DESCOMPRIMIDA;
+}
@@ -0,0 +1,785 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/copia.hpp"
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
+
+// Buffer do último recurso (laço read/write).
+static constexpr size_t kBufferLeituraEscrita = 1 << 20;
+
+// Trecho copiado pelo cache entre descartes (copiar_sem_cache).
+static constexpr uint64_t kJanelaSemCache = 8 << 20;
+
+// Máximo transferido por chamada de copy_file_range/sendfile.
+static constexpr size_t kMaximoPorChamada = 1 << 30;
+
+// Sufixo do temporário de CopiaParticionada, no diretório do destino.
+static constexpr char kSufixoTemporario[] = ".parcial";
+
+const char *nome_estrategia(EstrategiaCopia estrategia) {
+    switch (estrategia) {
+    case COPIA_REFLINK: return "reflink";
+    case COPIA_COPY_FILE_RANGE: return "copy_file_range";
+    case COPIA_SENDFILE: return "sendfile";
+    case COPIA_LEITURA_ESCRITA: return "read/write";
+    case COPIA_IO_URING: return "io_uring";
+    case COPIA_DEDUPLICADA: return "deduplicada";
+    case COPIA_DELTA: return "delta";
+    case COPIA_PARTICIONADA: return "particionada";
+    case COPIA_EMPACOTADA: return "empacotada";
+    case COPIA_DESEMPACOTADA: return "desempacotada";
+    case COPIA_COMPRIMIDA: return "comprimida";
+    case COPIA_DESCOMPRIMIDA: return "descomprimida";
+    case COPIA_CIFRADA: return "cifrada";
+    case COPIA_DECIFRADA: return "decifrada";
+    case COPIA_MULTIPLA: return "multipla";
+    case COPIA_DIRETA: return "direta";
+    default: return "falhou";
+    }
+}
+
+/***************************************************************************
+* Função: erro_de_suporte
+* Descrição:
+*   Indica se o erro significa que a estratégia não se aplica a este par
+*   de arquivos (e a próxima da cadeia deve ser tentada), em vez de uma
+*   falha real de E/S.
+***************************************************************************/
+
+static bool erro_de_suporte(int erro) {
+    return erro == EXDEV || erro == ENOSYS || erro == EOPNOTSUPP ||
+        erro == ENOTTY || erro == EINVAL || erro == EBADF ||
+        erro == ETXTBSY || erro == EPERM;
+}
+
+/***************************************************************************
+* Função: copiar_com_copy_file_range
+* Descrição:
+*   Copia de *deslocamento até 'tamanho' (o fim da origem ou de um
+*   intervalo) com copy_file_range, sem passar os dados pelo espaço de
+*   usuário.
+*
+* Valor retornado:
+*   0 em sucesso, ou o errno que interrompeu a cópia; *deslocamento
+*   indica até onde os dados já foram copiados.
+***************************************************************************/
+
+static int copiar_com_copy_file_range(int fdOrigem, int fdDestino,
+                                      uint64_t tamanho,
+                                      uint64_t *deslocamento) {
+    while (*deslocamento < tamanho) {
+        loff_t posOrigem = static_cast<loff_t>(*deslocamento);
+        loff_t posDestino = posOrigem;
+        size_t pedido = static_cast<size_t>(std::min<uint64_t>(
+            kMaximoPorChamada, tamanho - *deslocamento));
+        ssize_t n = copy_file_range(fdOrigem, &posOrigem, fdDestino,
+                                    &posDestino, pedido, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return errno;
+        if (n == 0)
+            break;  // origem encolheu durante a cópia
+        *deslocamento += static_cast<uint64_t>(n);
+    }
+    return 0;
+}
+
+static int copiar_com_sendfile(int fdOrigem, int fdDestino,
+                               uint64_t tamanho, uint64_t *deslocamento) {
+    if (lseek(fdDestino, static_cast<off_t>(*deslocamento), SEEK_SET) < 0)
+        return errno;
+    while (*deslocamento < tamanho) {
+        off_t pos = static_cast<off_t>(*deslocamento);
+        ssize_t n = sendfile(fdDestino, fdOrigem, &pos, kMaximoPorChamada);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return errno;
+        if (n == 0)
+            break;
+        *deslocamento += static_cast<uint64_t>(n);
+    }
+    return 0;
+}
+
+// Laço pread/pwrite de *deslocamento até 'fim' ou até o fim da origem.
+static int copiar_com_leitura_escrita(int fdOrigem, int fdDestino,
+                                      uint64_t fim, uint64_t *deslocamento) {
+    BlocoBuffer buffer = PoolBuffers::global().obter(kBufferLeituraEscrita);
+    if (!buffer)
+        return ENOMEM;
+    while (*deslocamento < fim) {
+        size_t pedido = static_cast<size_t>(std::min<uint64_t>(
+            kBufferLeituraEscrita, fim - *deslocamento));
+        ssize_t lidos = pread(fdOrigem, buffer.dados(), pedido,
+                              static_cast<off_t>(*deslocamento));
+        if (lidos < 0 && errno == EINTR)
+            continue;
+        if (lidos < 0)
+            return errno;
+        if (lidos == 0)
+            return 0;
+        ssize_t escritos = 0;
+        while (escritos < lidos) {
+            ssize_t n = pwrite(fdDestino, buffer.dados() + escritos,
+                lidos - escritos,
+                static_cast<off_t>(*deslocamento + escritos));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                return errno;
+            escritos += n;
+        }
+        *deslocamento += static_cast<uint64_t>(lidos);
+    }
+    return 0;
+}
+
+/***************************************************************************
+* Função: copiar_arquivo_em
+* Descrição:
+*   Copia um arquivo regular sobrescrevendo o destino, como
+*   fs::copy_file(..., overwrite_existing), mas tentando as estratégias
+*   mais baratas primeiro:
+*     1. reflink (FICLONE): origem e destino no mesmo sistema CoW;
+*     2. copy_file_range: cópia dentro do kernel;
+*     3. sendfile;
+*     4. laço pread/pwrite com buffer grande.
+*   Uma estratégia que falha por falta de suporte passa a vez à próxima,
+*   que continua do ponto em que a anterior parou. As permissões da
+*   origem são aplicadas ao destino.
+*
+* Parâmetros:
+*   dirOrigem, dirDestino - diretórios aos quais os nomes são relativos
+*                           (AT_FDCWD: o corrente)
+*   origem - arquivo a copiar
+*   destino - arquivo a criar ou sobrescrever
+*
+* Valor retornado:
+*   Estratégia que concluiu a cópia, ou COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && destino != ""
+*
+* Assertivas de saída:
+*   Se o retorno != COPIA_FALHOU, destino tem o conteúdo da origem.
+*   Origem e destino sendo o mesmo arquivo resulta em COPIA_FALHOU, sem
+*   truncar nada.
+***************************************************************************/
+
+EstrategiaCopia copiar_arquivo_em(int dirOrigem, const char *origem,
+                                  int dirDestino, const char *destino) {
+    assert(*origem != '\0' && *destino != '\0');
+
+    int fdOrigem = openat(dirOrigem, origem, O_RDONLY | O_CLOEXEC);
+    if (fdOrigem < 0)
+        return COPIA_FALHOU;
+    struct stat stOrigem, stDestino;
+    if (fstat(fdOrigem, &stOrigem) != 0 || !S_ISREG(stOrigem.st_mode) ||
+        (fstatat(dirDestino, destino, &stDestino, 0) == 0 &&
+         stDestino.st_dev == stOrigem.st_dev &&
+         stDestino.st_ino == stOrigem.st_ino)) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+
+    int fdDestino = openat(dirDestino, destino,
+                           O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                           stOrigem.st_mode & 07777);
+    if (fdDestino < 0) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+
+    EstrategiaCopia estrategia = COPIA_FALHOU;
+    uint64_t tamanho = static_cast<uint64_t>(stOrigem.st_size);
+    uint64_t deslocamento = 0;
+
+    if (ioctl(fdDestino, FICLONE, fdOrigem) == 0) {
+        estrategia = COPIA_REFLINK;
+    } else {
+        int erro = copiar_com_copy_file_range(fdOrigem, fdDestino, tamanho,
+                                              &deslocamento);
+        if (erro == 0) {
+            estrategia = COPIA_COPY_FILE_RANGE;
+        } else if (erro_de_suporte(erro)) {
+            erro = copiar_com_sendfile(fdOrigem, fdDestino, tamanho,
+                                       &deslocamento);
+            if (erro == 0)
+                estrategia = COPIA_SENDFILE;
+        }
+        if (estrategia == COPIA_FALHOU && erro_de_suporte(erro)) {
+            if (copiar_com_leitura_escrita(fdOrigem, fdDestino, UINT64_MAX,
+                                           &deslocamento) == 0)
+                estrategia = COPIA_LEITURA_ESCRITA;
+        }
+    }
+
+    fchmod(fdDestino, stOrigem.st_mode & 07777);
+    if (close(fdDestino) != 0)
+        estrategia = COPIA_FALHOU;
+    close(fdOrigem);
+    return estrategia;
+}
+
+EstrategiaCopia copiar_arquivo(const std::string &origem,
+                               const std::string &destino) {
+    assert(!origem.empty() && !destino.empty());
+    return copiar_arquivo_em(AT_FDCWD, origem.c_str(), AT_FDCWD,
+                             destino.c_str());
+}
+
+/***************************************************************************
+* Função: alinhamento_direto
+* Descrição:
+*   Alinhamento que o O_DIRECT exige do deslocamento, do tamanho e do
+*   endereço do buffer em um arquivo: o informado pelo statx
+*   (STATX_DIOALIGN, Linux 6.1 em diante) ou, sem ele, o tamanho do
+*   setor lógico do dispositivo em /sys/dev/block (para uma partição,
+*   o do disco dela); 4096 se nada disso estiver disponível.
+*
+* Valor retornado:
+*   Alinhamento em bytes, ou 0 se o sistema de arquivos não aceita
+*   O_DIRECT.
+***************************************************************************/
+
+static size_t alinhamento_direto(int fd) {
+#ifdef STATX_DIOALIGN
+    struct statx stx;
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+        (stx.stx_mask & STATX_DIOALIGN) != 0)
+        return stx.stx_dio_offset_align == 0 ? 0 :
+            std::max(stx.stx_dio_offset_align, stx.stx_dio_mem_align);
+#endif
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        return 0;
+    std::string dispositivo = "/sys/dev/block/" +
+        std::to_string(major(st.st_dev)) + ":" +
+        std::to_string(minor(st.st_dev));
+    for (const char *sufixo : {"/queue/logical_block_size",
+                               "/../queue/logical_block_size"}) {
+        FILE *f = fopen((dispositivo + sufixo).c_str(), "re");
+        if (f == nullptr)
+            continue;
+        unsigned long setor = 0;  // NOLINT(runtime/int)
+        bool lido = fscanf(f, "%lu", &setor) == 1 && setor > 0;
+        fclose(f);
+        if (lido)
+            return setor;
+    }
+    return 4096;
+}
+
+// Liga ou desliga O_DIRECT em um descritor já aberto.
+static bool definir_direto(int fd, bool direto) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0)
+        return false;
+    flags = direto ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+    return fcntl(fd, F_SETFL, flags) == 0;
+}
+
+// Alguma página de [inicio, inicio + n) do arquivo está no cache?
+static bool alguma_pagina_no_cache(int fd, uint64_t inicio, uint64_t n) {
+    const uint64_t pagina = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    uint64_t base = inicio & ~(pagina - 1);
+    size_t tamanho = static_cast<size_t>(inicio + n - base);
+    void *mapa = mmap(nullptr, tamanho, PROT_READ, MAP_SHARED, fd,
+                      static_cast<off_t>(base));
+    if (mapa == MAP_FAILED)
+        return true;  // na dúvida, não descarta nada
+    std::vector<unsigned char> residentes((tamanho + pagina - 1) / pagina);
+    bool alguma = mincore(mapa, tamanho, residentes.data()) != 0;
+    for (size_t i = 0; !alguma && i < residentes.size(); ++i)
+        alguma = (residentes[i] & 1) != 0;
+    munmap(mapa, tamanho);
+    return alguma;
+}
+
+/***************************************************************************
+* Função: copiar_sem_cache
+* Descrição:
+*   Laço pread/pwrite pelo cache de páginas que não o deixa cheio do
+*   arquivo copiado: a cada janela de kJanelaSemCache bytes, o trecho
+*   gravado no destino é escrito no disco (sync_file_range) e descartado
+*   do cache (posix_fadvise DONTNEED), e o lido da origem também, se
+*   nenhuma página dele estava no cache antes da leitura (as páginas
+*   que outros processos já usavam ficam).
+*
+* Parâmetros:
+*   fdOrigem, fdDestino - abertos sem O_DIRECT
+*   deslocamento - de onde começar; termina no fim da origem
+*
+* Valor retornado:
+*   0, ou o errno da falha.
+***************************************************************************/
+
+static int copiar_sem_cache(int fdOrigem, int fdDestino,
+                            uint64_t *deslocamento) {
+    const uint64_t pagina = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    for (;;) {
+        uint64_t inicio = *deslocamento;
+        bool estavaNoCache = alguma_pagina_no_cache(fdOrigem, inicio,
+                                                    kJanelaSemCache);
+        int erro = copiar_com_leitura_escrita(fdOrigem, fdDestino,
+                                              inicio + kJanelaSemCache,
+                                              deslocamento);
+        if (erro != 0)
+            return erro;
+        uint64_t n = *deslocamento - inicio;
+        bool fim = n < kJanelaSemCache;
+        if (n > 0) {
+            // O DONTNEED só descarta páginas inteiras do intervalo: ele
+            // começa na página do início e, no fim do arquivo, vai até o
+            // fim dele (0), para levar também a última página parcial
+            off_t base = static_cast<off_t>(inicio & ~(pagina - 1));
+            off_t comprimento = fim ? 0 :
+                static_cast<off_t>(*deslocamento) - base;
+            if (sync_file_range(fdDestino, base, comprimento,
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                    SYNC_FILE_RANGE_WAIT_AFTER) != 0)
+                return errno;
+            posix_fadvise(fdDestino, base, comprimento, POSIX_FADV_DONTNEED);
+            if (!estavaNoCache)
+                posix_fadvise(fdOrigem, base, comprimento,
+                              POSIX_FADV_DONTNEED);
+        }
+        if (fim)
+            return 0;
+    }
+}
+
+/***************************************************************************
+* Função: copiar_arquivo_direto
+* Descrição:
+*   Copia um arquivo regular sem passar pelo cache de páginas: a parte
+*   alinhada ao setor (ver alinhamento_direto) é lida e gravada com
+*   O_DIRECT, em blocos do pool de buffers (alinhados a página); o resto
+*   que não completa um setor, ou o arquivo inteiro quando origem ou
+*   destino não aceitam O_DIRECT (tmpfs, por exemplo), vai pelo laço de
+*   copiar_sem_cache, que descarta do cache o que passou por ele. As
+*   mesmas recusas de copiar_arquivo_em se aplicam.
+*
+* Parâmetros:
+*   origem - arquivo a copiar
+*   destino - arquivo a criar ou sobrescrever
+*
+* Valor retornado:
+*   COPIA_DIRETA se a parte alinhada foi com O_DIRECT,
+*   COPIA_LEITURA_ESCRITA se tudo foi pelo cache (e descartado), ou
+*   COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && destino != ""
+***************************************************************************/
+
+EstrategiaCopia copiar_arquivo_direto(const std::string &origem,
+                                      const std::string &destino) {
+    assert(!origem.empty() && !destino.empty());
+
+    int fdOrigem = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdOrigem < 0)
+        return COPIA_FALHOU;
+    struct stat stOrigem, stDestino;
+    if (fstat(fdOrigem, &stOrigem) != 0 || !S_ISREG(stOrigem.st_mode) ||
+        (stat(destino.c_str(), &stDestino) == 0 &&
+         stDestino.st_dev == stOrigem.st_dev &&
+         stDestino.st_ino == stOrigem.st_ino)) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+    int fdDestino = open(destino.c_str(),
+                         O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                         stOrigem.st_mode & 07777);
+    if (fdDestino < 0) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+
+    uint64_t tamanho = static_cast<uint64_t>(stOrigem.st_size);
+    size_t alinhamento = std::max(alinhamento_direto(fdOrigem),
+                                  alinhamento_direto(fdDestino));
+    uint64_t alinhado = (alinhamento == 0) ? 0 :
+        tamanho - tamanho % alinhamento;
+    // Os blocos do pool são alinhados a página e o laço lê
+    // kBufferLeituraEscrita bytes por vez
+    bool direto = alinhado > 0 &&
+        kBufferLeituraEscrita % alinhamento == 0 &&
+        alinhamento <= static_cast<size_t>(sysconf(_SC_PAGESIZE)) &&
+        definir_direto(fdOrigem, true) && definir_direto(fdDestino, true);
+
+    EstrategiaCopia estrategia = COPIA_FALHOU;
+    uint64_t deslocamento = 0;
+    int erro = 0;
+    if (direto) {
+        erro = copiar_com_leitura_escrita(fdOrigem, fdDestino, alinhado,
+                                          &deslocamento);
+        // EINVAL: o O_DIRECT foi recusado no meio; o resto vai pelo cache
+        if (erro == 0 || erro == EINVAL) {
+            erro = 0;
+            if (deslocamento > 0)
+                estrategia = COPIA_DIRETA;
+        }
+    }
+    if (erro == 0 && (!direto || (definir_direto(fdOrigem, false) &&
+                                  definir_direto(fdDestino, false)))) {
+        erro = copiar_sem_cache(fdOrigem, fdDestino, &deslocamento);
+        if (erro == 0 && estrategia == COPIA_FALHOU)
+            estrategia = COPIA_LEITURA_ESCRITA;
+    }
+    if (erro != 0)
+        estrategia = COPIA_FALHOU;
+
+    fchmod(fdDestino, stOrigem.st_mode & 07777);
+    if (close(fdDestino) != 0)
+        estrategia = COPIA_FALHOU;
+    close(fdOrigem);
+    return estrategia;
+}
+
+// Grava 'n' bytes de buffer em fd a partir de 'deslocamento'.
+static bool gravar_tudo(int fd, const char *buffer, size_t n,
+                        uint64_t deslocamento) {
+    size_t escritos = 0;
+    while (escritos < n) {
+        ssize_t r = pwrite(fd, buffer + escritos, n - escritos,
+                           static_cast<off_t>(deslocamento + escritos));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            return false;
+        escritos += static_cast<size_t>(r);
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: copiar_para_varios
+* Descrição:
+*   Copia um arquivo regular para vários destinos lendo a origem uma só
+*   vez: cada bloco lido vai para um de dois buffers compartilhados e é
+*   gravado em todos os destinos. Com o pool, as gravações de um bloco
+*   são tarefas (uma por destino) que rodam enquanto o bloco seguinte é
+*   lido no outro buffer; sem ele, são feitas em sequência. Um destino
+*   que falha é abandonado sem interromper os demais. Cada destino é
+*   gravado em um temporário ao lado dele, com as permissões da origem,
+*   renomeado sobre o destino só quando completo: uma falha deixa o
+*   destino anterior intacto. Um destino que seja o próprio arquivo de
+*   origem é recusado sem ser tocado.
+*
+* Parâmetros:
+*   origem - arquivo a copiar
+*   destinos - arquivos a criar ou sobrescrever
+*   pool - trabalhadores para as gravações (nullptr: sequenciais); o
+*          chamador não deve ser um deles, pois esperaria as gravações
+*          dentro de uma tarefa
+*   copiados - se != nullptr, recebe, na ordem de destinos, se cada um
+*              ficou com o conteúdo da origem
+*
+* Valor retornado:
+*   COPIA_MULTIPLA se algum destino foi copiado, senão COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   origem != "" && nenhum destino == ""
+***************************************************************************/
+
+EstrategiaCopia copiar_para_varios(const std::string &origem,
+                                   const std::vector<std::string> &destinos,
+                                   PoolTarefas *pool,
+                                   std::vector<bool> *copiados) {
+    assert(!origem.empty());
+    const size_t n = destinos.size();
+    if (copiados != nullptr)
+        copiados->assign(n, false);
+
+    int fdOrigem = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdOrigem < 0)
+        return COPIA_FALHOU;
+    struct stat stOrigem;
+    if (fstat(fdOrigem, &stOrigem) != 0 || !S_ISREG(stOrigem.st_mode)) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+    posix_fadvise(fdOrigem, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    std::vector<int> fds(n, -1);
+    // Lidas e escritas por tarefas diferentes (um destino pode ter
+    // gravações de dois blocos em andamento).
+    std::unique_ptr<std::atomic<bool>[]> ok(new std::atomic<bool>[n]);
+    for (size_t i = 0; i < n; ++i) {
+        assert(!destinos[i].empty());
+        ok[i] = false;
+        struct stat stDestino;
+        if (stat(destinos[i].c_str(), &stDestino) == 0 &&
+            stDestino.st_dev == stOrigem.st_dev &&
+            stDestino.st_ino == stOrigem.st_ino)
+            continue;
+        fds[i] = open((destinos[i] + kSufixoTemporario).c_str(),
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                      stOrigem.st_mode & 07777);
+        ok[i] = fds[i] >= 0;
+    }
+
+    // Com um destino só, ou um arquivo que cabe em um bloco, não há
+    // gravações para sobrepor à leitura.
+    if (n < 2 || static_cast<uint64_t>(stOrigem.st_size) <=
+        kBufferLeituraEscrita)
+        pool = nullptr;
+
+    BlocoBuffer buffers[2];
+    buffers[0] = PoolBuffers::global().obter(kBufferLeituraEscrita);
+    if (pool != nullptr)
+        buffers[1] = PoolBuffers::global().obter(kBufferLeituraEscrita);
+    if (!buffers[0] || (pool != nullptr && !buffers[1])) {
+        for (int fd : fds) {
+            if (fd >= 0)
+                close(fd);
+        }
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+    GrupoTarefas grupos[2];
+    bool erroLeitura = false;
+    uint64_t deslocamento = 0;
+    for (int atual = 0;; atual = pool != nullptr ? atual ^ 1 : 0) {
+        // As gravações que ainda usam este buffer terminam antes de ele
+        // receber o próximo bloco.
+        if (pool != nullptr)
+            pool->aguardar(&grupos[atual]);
+        char *buffer = buffers[atual].dados();
+        ssize_t lidos;
+        do {
+            lidos = pread(fdOrigem, buffer, kBufferLeituraEscrita,
+                          static_cast<off_t>(deslocamento));
+        } while (lidos < 0 && errno == EINTR);
+        if (lidos <= 0) {
+            erroLeitura = lidos < 0;
+            break;
+        }
+        bool algum = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (!ok[i])
+                continue;
+            algum = true;
+            auto gravar = [&ok, &fds, i, buffer, lidos, deslocamento] {
+                if (!gravar_tudo(fds[i], buffer, static_cast<size_t>(lidos),
+                                 deslocamento))
+                    ok[i] = false;
+            };
+            if (pool != nullptr)
+                pool->submeter(&grupos[atual], gravar);
+            else
+                gravar();
+        }
+        if (!algum)
+            break;
+        deslocamento += static_cast<uint64_t>(lidos);
+    }
+    if (pool != nullptr) {
+        pool->aguardar(&grupos[0]);
+        pool->aguardar(&grupos[1]);
+    }
+
+    EstrategiaCopia estrategia = COPIA_FALHOU;
+    for (size_t i = 0; i < n; ++i) {
+        if (fds[i] < 0)
+            continue;
+        fchmod(fds[i], stOrigem.st_mode & 07777);
+        bool copiado = ok[i] && !erroLeitura;
+        if (close(fds[i]) != 0)
+            copiado = false;
+        std::string temporario = destinos[i] + kSufixoTemporario;
+        if (copiado && rename(temporario.c_str(), destinos[i].c_str()) != 0)
+            copiado = false;
+        if (!copiado)
+            unlink(temporario.c_str());
+        if (copiado)
+            estrategia = COPIA_MULTIPLA;
+        if (copiados != nullptr)
+            (*copiados)[i] = copiado;
+    }
+    close(fdOrigem);
+    return estrategia;
+}
+
+// Um temporário que não chegou a ser renomeado é removido.
+CopiaParticionada::~CopiaParticionada() {
+    if (fdDestino_ >= 0)
+        close(fdDestino_);
+    if (fdOrigem_ >= 0)
+        close(fdOrigem_);
+    if (!temporario_.empty())
+        unlinkat(dirDestino_, temporario_.c_str(), 0);
+}
+
+/***************************************************************************
+* Função: CopiaParticionada::abrir
+* Descrição:
+*   Abre a origem e cria, no diretório do destino, um temporário já com
+*   o tamanho da origem reservado (fallocate, ou ftruncate onde o sistema
+*   de arquivos não o suporta), para que os intervalos possam ser
+*   gravados em qualquer ordem sem estender o arquivo a cada escrita. O
+*   destino só é trocado em concluir. As mesmas recusas de
+*   copiar_arquivo_em se aplicam: origem que não é arquivo regular e
+*   origem e destino sendo o mesmo arquivo.
+*
+* Parâmetros:
+*   dirOrigem, dirDestino - diretórios aos quais os nomes são relativos
+*   origem - arquivo a copiar
+*   destino - arquivo a criar ou substituir
+*
+* Valor retornado:
+*   false se a cópia não pôde ser preparada
+*
+* Assertivas de entrada:
+*   origem != "" && destino != "" && ainda não aberta
+***************************************************************************/
+
+bool CopiaParticionada::abrir(int dirOrigem, const char *origem,
+                              int dirDestino, const char *destino) {
+    assert(*origem != '\0' && *destino != '\0' && fdOrigem_ < 0);
+
+    fdOrigem_ = openat(dirOrigem, origem, O_RDONLY | O_CLOEXEC);
+    if (fdOrigem_ < 0)
+        return false;
+    struct stat stOrigem, stDestino;
+    if (fstat(fdOrigem_, &stOrigem) != 0 || !S_ISREG(stOrigem.st_mode) ||
+        (fstatat(dirDestino, destino, &stDestino, 0) == 0 &&
+         stDestino.st_dev == stOrigem.st_dev &&
+         stDestino.st_ino == stOrigem.st_ino))
+        return false;
+    modo_ = stOrigem.st_mode & 07777;
+    tamanho_ = static_cast<uint64_t>(stOrigem.st_size);
+
+    // Um temporário deixado por uma execução interrompida é descartado
+    dirDestino_ = dirDestino;
+    destino_ = destino;
+    std::string temporario = destino_ + kSufixoTemporario;
+    unlinkat(dirDestino, temporario.c_str(), 0);
+    fdDestino_ = openat(dirDestino, temporario.c_str(),
+                        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fdDestino_ < 0)
+        return false;
+    temporario_ = std::move(temporario);
+    if (tamanho_ == 0)
+        return true;
+    off_t tamanho = static_cast<off_t>(tamanho_);
+    return fallocate(fdDestino_, 0, 0, tamanho) == 0 ||
+        ftruncate(fdDestino_, tamanho) == 0;
+}
+
+/***************************************************************************
+* Função: CopiaParticionada::copiar_intervalo
+* Descrição:
+*   Copia os bytes [inicio, fim) da origem para a mesma posição do
+*   temporário, com copy_file_range ou, sem suporte, com pread/pwrite.
+*   Pode ser chamada por várias threads ao mesmo tempo, com intervalos
+*   disjuntos.
+*
+* Valor retornado:
+*   false se o intervalo não pôde ser copiado (a cópia inteira falha)
+***************************************************************************/
+
+bool CopiaParticionada::copiar_intervalo(uint64_t inicio, uint64_t fim) {
+    assert(fdDestino_ >= 0 && inicio <= fim);
+
+    uint64_t deslocamento = inicio;
+    int erro = copiar_com_copy_file_range(fdOrigem_, fdDestino_, fim,
+                                          &deslocamento);
+    if (erro != 0 && erro_de_suporte(erro))
+        erro = copiar_com_leitura_escrita(fdOrigem_, fdDestino_, fim,
+                                          &deslocamento);
+    if (erro != 0 || deslocamento < fim)
+        falhou_.store(true, std::memory_order_relaxed);
+    return erro == 0 && deslocamento == fim;
+}
+
+/***************************************************************************
+* Função: CopiaParticionada::concluir
+* Descrição:
+*   Depois que todos os intervalos foram copiados, aplica as permissões
+*   da origem ao temporário e o renomeia sobre o destino, de modo que
+*   quem abre o destino vê o arquivo antigo ou o novo inteiro, nunca um
+*   parcial. Se algum intervalo falhou, o temporário é removido.
+*
+* Valor retornado:
+*   COPIA_PARTICIONADA, ou COPIA_FALHOU.
+***************************************************************************/
+
+EstrategiaCopia CopiaParticionada::concluir() {
+    if (fdDestino_ < 0)
+        return COPIA_FALHOU;
+    fchmod(fdDestino_, modo_);
+    bool ok = close(fdDestino_) == 0 && !falhou_.load();
+    fdDestino_ = -1;
+    close(fdOrigem_);
+    fdOrigem_ = -1;
+    ok = ok && renameat(dirDestino_, temporario_.c_str(), dirDestino_,
+                        destino_.c_str()) == 0;
+    if (!ok)
+        unlinkat(dirDestino_, temporario_.c_str(), 0);
+    temporario_.clear();
+    return ok ? COPIA_PARTICIONADA : COPIA_FALHOU;
+}
+
+/***************************************************************************
+* Função: copiar_arquivo_em_partes
+* Descrição:
+*   Copia um arquivo grande como vários intervalos simultâneos, um por
+*   tarefa do pool, em vez de um único fluxo com uma E/S pendente por
+*   vez; em discos rápidos (NVMe) várias requisições em andamento
+*   aproximam a cópia da banda do dispositivo. O destino é substituído
+*   de forma atômica (ver CopiaParticionada).
+*
+* Parâmetros:
+*   dirOrigem, dirDestino - diretórios aos quais os nomes são relativos
+*   origem - arquivo a copiar
+*   destino - arquivo a criar ou substituir
+*   pool - executa as partes (o chamador também ajuda); o chamador não
+*          deve ser um trabalhador dele, pois esperaria as partes dentro
+*          de uma tarefa
+*   tamanhoParte - bytes por tarefa
+*
+* Valor retornado:
+*   COPIA_PARTICIONADA, ou COPIA_FALHOU.
+*
+* Assertivas de entrada:
+*   pool != nullptr && tamanhoParte > 0
+***************************************************************************/
+
+EstrategiaCopia copiar_arquivo_em_partes(int dirOrigem, const char *origem,
+                                         int dirDestino, const char *destino,
+                                         PoolTarefas *pool,
+                                         uint64_t tamanhoParte) {
+    assert(pool != nullptr && tamanhoParte > 0);
+
+    CopiaParticionada copia;
+    if (!copia.abrir(dirOrigem, origem, dirDestino, destino))
+        return COPIA_FALHOU;
+    GrupoTarefas grupo;
+    for (uint64_t ini = 0; ini < copia.tamanho(); ini += tamanhoParte) {
+        uint64_t fim = std::min(ini + tamanhoParte, copia.tamanho());
+        pool->submeter(&grupo, [&copia, ini, fim] {
+            copia.copiar_intervalo(ini, fim);
+        });
+    }
+    pool->aguardar(&grupo);
+    return copia.concluir();
+}
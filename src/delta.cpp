@@ -0,0 +1,333 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/delta.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../include/blake3.hpp"
+
+static constexpr size_t kBlocoMinimo = 2048;
+static constexpr size_t kBlocoMaximo = 128 << 10;
+// Acima desta fração do arquivo a regravar, a cópia inteira (que pode
+// usar reflink ou copy_file_range) sai mais barata que o delta.
+static constexpr double kFracaoMaxima = 0.5;
+
+size_t tamanho_bloco_delta(uint64_t tamanho) {
+    size_t bloco = kBlocoMinimo;
+    while (bloco < kBlocoMaximo && uint64_t(bloco) * bloco < tamanho)
+        bloco *= 2;
+    return bloco;
+}
+
+// Soma fraca do rsync (estilo Adler-32, módulo 2^16) sobre uma janela de
+// tamanho fixo, atualizável em O(1) ao deslizar um byte.
+class SomaRolante {
+ public:
+    void iniciar(const uint8_t *p, size_t n) {
+        a_ = b_ = 0;
+        n_ = static_cast<uint32_t>(n);
+        for (size_t i = 0; i < n; ++i) {
+            a_ += p[i];
+            b_ += static_cast<uint32_t>(n - i) * p[i];
+        }
+    }
+    void rolar(uint8_t sai, uint8_t entra) {
+        a_ += static_cast<uint32_t>(entra) - sai;
+        b_ += a_ - n_ * sai;
+    }
+    uint32_t valor() const { return (a_ & 0xFFFF) | (b_ << 16); }
+
+ private:
+    uint32_t a_ = 0, b_ = 0, n_ = 0;
+};
+
+// Trecho do arquivo novo: literal ou cópia de um bloco do destino atual.
+struct Trecho {
+    uint64_t deslocamento;  // no arquivo novo
+    uint64_t tamanho;
+    int64_t bloco;          // bloco do destino; -1 = literal
+};
+
+struct Assinaturas {
+    size_t tamanhoBloco;
+    std::vector<std::pair<uint32_t, uint32_t>> fracas;  // <soma, bloco>
+    std::vector<DigestBlake3> fortes;
+    std::vector<bool> filtro;  // 2^16 posições indexadas pela soma
+
+    static uint32_t posicao(uint32_t fraca) {
+        return (fraca ^ (fraca >> 16)) & 0xFFFF;
+    }
+};
+
+static DigestBlake3 digest_bloco(const uint8_t *p, size_t n) {
+    HasherBlake3 h;
+    h.atualizar(p, n);
+    return h.finalizar();
+}
+
+/***************************************************************************
+* Função: assinar
+* Descrição:
+*   Calcula a soma fraca e o digest forte (BLAKE3) de cada bloco inteiro
+*   do destino atual. O resto final, menor que um bloco, não é assinado.
+***************************************************************************/
+
+static Assinaturas assinar(const uint8_t *antigo, size_t tamanho,
+                           size_t tamanhoBloco) {
+    Assinaturas a;
+    a.tamanhoBloco = tamanhoBloco;
+    a.filtro.assign(1 << 16, false);
+    size_t blocos = tamanho / tamanhoBloco;
+    a.fracas.reserve(blocos);
+    a.fortes.reserve(blocos);
+    for (size_t i = 0; i < blocos; ++i) {
+        SomaRolante s;
+        s.iniciar(antigo + i * tamanhoBloco, tamanhoBloco);
+        a.fracas.emplace_back(s.valor(), static_cast<uint32_t>(i));
+        a.fortes.push_back(digest_bloco(antigo + i * tamanhoBloco,
+                                        tamanhoBloco));
+        a.filtro[Assinaturas::posicao(s.valor())] = true;
+    }
+    std::sort(a.fracas.begin(), a.fracas.end());
+    return a;
+}
+
+/***************************************************************************
+* Função: procurar_bloco
+* Descrição:
+*   Procura um bloco do destino igual à janela que começa em 'pos' no
+*   arquivo novo. Como o delta é aplicado no próprio destino, em ordem
+*   crescente, só servem blocos que estão em 'pos' ou depois (ainda não
+*   sobrescritos); o bloco na mesma posição é preferido, pois dispensa
+*   escrita.
+*
+* Valor retornado:
+*   Índice do bloco, ou -1 se não houver.
+***************************************************************************/
+
+static int64_t procurar_bloco(const Assinaturas &a, uint32_t fraca,
+                              const uint8_t *janela, uint64_t pos) {
+    if (!a.filtro[Assinaturas::posicao(fraca)])
+        return -1;
+    auto it = std::lower_bound(a.fracas.begin(), a.fracas.end(),
+                               std::make_pair(fraca, uint32_t(0)));
+    bool temForte = false;
+    DigestBlake3 forte;
+    int64_t achado = -1;
+    for (; it != a.fracas.end() && it->first == fraca; ++it) {
+        uint64_t origem = uint64_t(it->second) * a.tamanhoBloco;
+        if (origem < pos)
+            continue;
+        if (!temForte) {
+            forte = digest_bloco(janela, a.tamanhoBloco);
+            temForte = true;
+        }
+        if (forte != a.fortes[it->second])
+            continue;
+        if (origem == pos)
+            return it->second;
+        if (achado < 0)
+            achado = it->second;
+    }
+    return achado;
+}
+
+/***************************************************************************
+* Função: calcular_trechos
+* Descrição:
+*   Percorre o arquivo novo com a soma rolante, byte a byte, e o
+*   descreve como uma sequência de literais e blocos do destino atual.
+***************************************************************************/
+
+static std::vector<Trecho> calcular_trechos(const Assinaturas &a,
+                                            const uint8_t *novo,
+                                            uint64_t tamanho) {
+    const size_t bloco = a.tamanhoBloco;
+    std::vector<Trecho> trechos;
+    uint64_t pos = 0, inicioLiteral = 0;
+    SomaRolante soma;
+    bool somaValida = false;
+
+    while (!a.fracas.empty() && pos + bloco <= tamanho) {
+        if (!somaValida) {
+            soma.iniciar(novo + pos, bloco);
+            somaValida = true;
+        }
+        int64_t achado = procurar_bloco(a, soma.valor(), novo + pos, pos);
+        if (achado >= 0) {
+            if (inicioLiteral < pos)
+                trechos.push_back({inicioLiteral, pos - inicioLiteral, -1});
+            trechos.push_back({pos, bloco, achado});
+            pos += bloco;
+            inicioLiteral = pos;
+            somaValida = false;
+            continue;
+        }
+        if (pos + bloco < tamanho)
+            soma.rolar(novo[pos], novo[pos + bloco]);
+        ++pos;
+    }
+    if (inicioLiteral < tamanho)
+        trechos.push_back({inicioLiteral, tamanho - inicioLiteral, -1});
+    return trechos;
+}
+
+static bool escrever_tudo(int fd, const uint8_t *p, uint64_t n,
+                          uint64_t deslocamento) {
+    while (n > 0) {
+        ssize_t k = pwrite(fd, p, n, static_cast<off_t>(deslocamento));
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return false;
+        p += k;
+        n -= static_cast<uint64_t>(k);
+        deslocamento += static_cast<uint64_t>(k);
+    }
+    return true;
+}
+
+static void *mapear(int fd, size_t tamanho) {
+    if (tamanho == 0)
+        return nullptr;
+    void *m = mmap(nullptr, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m == MAP_FAILED)
+        return nullptr;
+    madvise(m, tamanho, MADV_SEQUENTIAL);
+    return m;
+}
+
+/***************************************************************************
+* Função: copiar_delta
+* Descrição:
+*   Atualiza o destino para ficar igual à origem regravando apenas o que
+*   mudou, no estilo do rsync: o destino atual é assinado por blocos
+*   (soma fraca rolante + BLAKE3), a origem é percorrida com a soma
+*   rolante e os trechos encontrados no destino não são reescritos. O
+*   resultado é aplicado no próprio arquivo (pwrite + ftruncate), o que
+*   em arquivos que só crescem no fim grava pouco mais que o acréscimo.
+*
+*   Se o destino não existir ou se mais da metade do arquivo precisar
+*   ser regravada, faz a cópia completa com copiar_arquivo.
+*
+* Parâmetros:
+*   origem - arquivo novo
+*   destino - cópia anterior, atualizada no lugar
+*   resultado - recebe bytes escritos e reaproveitados
+*   tamanhoBloco - 0 = escolhido pelo tamanho do destino
+*
+* Valor retornado:
+*   COPIA_DELTA, a estratégia usada pela cópia completa ou COPIA_FALHOU
+*
+* Assertivas de entrada:
+*   origem != "" && destino != "" && resultado != nullptr
+***************************************************************************/
+
+EstrategiaCopia copiar_delta(const std::string &origem,
+                             const std::string &destino,
+                             ResultadoDelta *resultado,
+                             size_t tamanhoBloco) {
+    assert(!origem.empty() && !destino.empty() && resultado != nullptr);
+    *resultado = ResultadoDelta();
+
+    int fdOrigem = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fdOrigem < 0)
+        return COPIA_FALHOU;
+    struct stat stOrigem, stDestino;
+    if (fstat(fdOrigem, &stOrigem) != 0 || !S_ISREG(stOrigem.st_mode)) {
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+    uint64_t tamanhoNovo = static_cast<uint64_t>(stOrigem.st_size);
+
+    auto copia_completa = [&](int fdDestino) {
+        if (fdDestino >= 0)
+            close(fdDestino);
+        close(fdOrigem);
+        resultado->bytesEscritos = tamanhoNovo;
+        return copiar_arquivo(origem, destino);
+    };
+
+    int fdDestino = open(destino.c_str(), O_RDWR | O_CLOEXEC);
+    if (fdDestino < 0 || fstat(fdDestino, &stDestino) != 0 ||
+        !S_ISREG(stDestino.st_mode) || stDestino.st_size == 0)
+        return copia_completa(fdDestino);
+    if (stDestino.st_dev == stOrigem.st_dev &&
+        stDestino.st_ino == stOrigem.st_ino) {
+        close(fdDestino);
+        close(fdOrigem);
+        return COPIA_FALHOU;
+    }
+    uint64_t tamanhoAntigo = static_cast<uint64_t>(stDestino.st_size);
+    if (tamanhoBloco == 0)
+        tamanhoBloco = tamanho_bloco_delta(tamanhoAntigo);
+    resultado->tamanhoBloco = tamanhoBloco;
+
+    auto *antigo = static_cast<const uint8_t *>(
+        mapear(fdDestino, tamanhoAntigo));
+    auto *novo = static_cast<const uint8_t *>(mapear(fdOrigem, tamanhoNovo));
+    if (antigo == nullptr || (novo == nullptr && tamanhoNovo > 0)) {
+        if (antigo != nullptr)
+            munmap(const_cast<uint8_t *>(antigo), tamanhoAntigo);
+        if (novo != nullptr)
+            munmap(const_cast<uint8_t *>(novo), tamanhoNovo);
+        return copia_completa(fdDestino);
+    }
+
+    std::vector<Trecho> trechos;
+    if (tamanhoNovo > 0)
+        trechos = calcular_trechos(
+            assinar(antigo, tamanhoAntigo, tamanhoBloco), novo, tamanhoNovo);
+    uint64_t aEscrever = 0;
+    for (const Trecho &t : trechos)
+        if (t.bloco < 0 || uint64_t(t.bloco) * tamanhoBloco != t.deslocamento)
+            aEscrever += t.tamanho;
+
+    if (aEscrever > kFracaoMaxima * tamanhoNovo) {
+        munmap(const_cast<uint8_t *>(antigo), tamanhoAntigo);
+        if (novo != nullptr)
+            munmap(const_cast<uint8_t *>(novo), tamanhoNovo);
+        return copia_completa(fdDestino);
+    }
+
+    // Aplica em ordem crescente: cada bloco copiado vem de uma posição
+    // >= à de escrita, ainda intacta. O bloco passa por um buffer
+    // porque origem e destino da cópia podem se sobrepor.
+    bool ok = true;
+    std::vector<uint8_t> buffer(tamanhoBloco);
+    for (const Trecho &t : trechos) {
+        if (!ok)
+            break;
+        if (t.bloco < 0) {
+            ok = escrever_tudo(fdDestino, novo + t.deslocamento, t.tamanho,
+                               t.deslocamento);
+            resultado->bytesEscritos += t.tamanho;
+            continue;
+        }
+        uint64_t fonte = uint64_t(t.bloco) * tamanhoBloco;
+        if (fonte != t.deslocamento) {
+            std::memcpy(buffer.data(), antigo + fonte, tamanhoBloco);
+            ok = escrever_tudo(fdDestino, buffer.data(), tamanhoBloco,
+                               t.deslocamento);
+            resultado->bytesEscritos += tamanhoBloco;
+        }
+        resultado->bytesReaproveitados += tamanhoBloco;
+    }
+    munmap(const_cast<uint8_t *>(antigo), tamanhoAntigo);
+    if (novo != nullptr)
+        munmap(const_cast<uint8_t *>(novo), tamanhoNovo);
+
+    ok = ok && ftruncate(fdDestino, static_cast<off_t>(tamanhoNovo)) == 0;
+    fchmod(fdDestino, stOrigem.st_mode & 07777);
+    ok = (close(fdDestino) == 0) && ok;
+    close(fdOrigem);
+    return ok ? COPIA_DELTA : COPIA_FALHOU;
+}
@@ -0,0 +1,236 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/indice_estado.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+// Nome do índice dentro do diretório destino.
+static constexpr char kArquivoIndice[] = ".backup_indice";
+static constexpr char kMagica[8] = {'B', 'K', 'P', 'I', 'D', 'X', '0', '2'};
+
+/***************************************************************************
+* Função: mesmo_arquivo
+* Descrição:
+*   Indica se dois registros de metadados descrevem o mesmo arquivo sem
+*   alterações: mesmo inode e dispositivo, mesmo tamanho e mesma data de
+*   modificação (em nanossegundos).
+***************************************************************************/
+
+bool mesmo_arquivo(const Metadados &a, const Metadados &b) {
+    return a.existe && b.existe && a.tamanho == b.tamanho &&
+        a.mtimeNs == b.mtimeNs && a.inode == b.inode &&
+        a.dispositivo == b.dispositivo;
+}
+
+template <typename T>
+static void anexar(std::string *saida, T v) {
+    saida->append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T>
+static bool ler(const std::string &dados, size_t *pos, T *v) {
+    if (*pos + sizeof(T) > dados.size())
+        return false;
+    std::memcpy(v, dados.data() + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return true;
+}
+
+static void anexar_metadados(std::string *saida, const Metadados &m) {
+    anexar(saida, static_cast<uint8_t>(m.existe));
+    anexar(saida, m.tamanho);
+    anexar(saida, m.mtimeNs);
+    anexar(saida, m.inode);
+    anexar(saida, m.dispositivo);
+    anexar(saida, m.modo);
+}
+
+static bool ler_metadados(const std::string &dados, size_t *pos,
+                          Metadados *m) {
+    uint8_t existe = 0;
+    bool ok = ler(dados, pos, &existe) && ler(dados, pos, &m->tamanho) &&
+        ler(dados, pos, &m->mtimeNs) && ler(dados, pos, &m->inode) &&
+        ler(dados, pos, &m->dispositivo) && ler(dados, pos, &m->modo);
+    m->existe = existe != 0;
+    return ok;
+}
+
+/***************************************************************************
+* Função: IndiceEstado::IndiceEstado
+* Descrição:
+*   Carrega o índice de estado do diretório destino, que guarda, para
+*   cada arquivo tratado em execuções anteriores, os metadados do HD e do
+*   Pen e os digests do conteúdo de cada lado. Um índice ausente ou
+*   corrompido (ou de versão anterior) é tratado como vazio.
+*
+* Parâmetros:
+*   dirDestino - diretório destino ao qual o índice pertence
+*
+* Assertivas de entrada:
+*   dirDestino != ""
+***************************************************************************/
+
+IndiceEstado::IndiceEstado(const std::string &dirDestino)
+    : caminho_((fs::path(dirDestino) / kArquivoIndice).string()) {
+    assert(!dirDestino.empty());
+
+    std::ifstream in(caminho_, std::ios::binary);
+    std::string dados((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    if (dados.size() < sizeof(kMagica) ||
+        std::memcmp(dados.data(), kMagica, sizeof(kMagica)) != 0)
+        return;
+
+    size_t pos = sizeof(kMagica);
+    uint64_t quantidade;
+    if (!ler(dados, &pos, &quantidade))
+        return;
+    anterior_.reserve(std::min<uint64_t>(quantidade, dados.size() / 64));
+    for (uint64_t i = 0; i < quantidade; ++i) {
+        uint16_t n;
+        RegistroIndice r;
+        uint8_t temDigest, temDigestPen;
+        if (!ler(dados, &pos, &n) || pos + n > dados.size()) {
+            anterior_.clear();
+            return;
+        }
+        std::string nome(dados, pos, n);
+        pos += n;
+        if (!ler_metadados(dados, &pos, &r.hd) ||
+            !ler_metadados(dados, &pos, &r.pen) ||
+            !ler(dados, &pos, &temDigest) || !ler(dados, &pos, &r.digest) ||
+            !ler(dados, &pos, &temDigestPen) ||
+            !ler(dados, &pos, &r.digestPen)) {
+            anterior_.clear();
+            return;
+        }
+        r.temDigest = temDigest != 0;
+        r.temDigestPen = temDigestPen != 0;
+        anterior_.emplace(std::move(nome), r);
+    }
+}
+
+/***************************************************************************
+* Função: IndiceEstado::buscar
+* Descrição:
+*   Consulta o registro de um arquivo como estava no início da execução.
+*   Pode ser chamada de várias threads ao mesmo tempo, inclusive durante
+*   atualizações, pois estas vão para uma tabela separada.
+*
+* Valor retornado:
+*   Ponteiro para o registro, ou nullptr se o arquivo não estiver no índice.
+***************************************************************************/
+
+const RegistroIndice *IndiceEstado::buscar(const std::string &nome) const {
+    auto it = anterior_.find(nome);
+    return (it == anterior_.end()) ? nullptr : &it->second;
+}
+
+void IndiceEstado::atualizar(const std::string &nome,
+                             const RegistroIndice &registro) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    novo_[nome] = registro;
+}
+
+/***************************************************************************
+* Função: IndiceEstado::atualizar_lado
+* Descrição:
+*   Corrige o registro desta execução de um arquivo que acabou de ser
+*   copiado para o HD ou o Pen: os metadados do lado gravado passam a ser
+*   os do arquivo novo. Os digests são sempre do conteúdo original (o
+*   de um arquivo comprimido ou cifrado é o do conteúdo antes disso), e
+*   a cópia reproduz o do outro lado: o lado gravado recebe o digest
+*   dele, ou os dois recebem 'conteudo', se dado. Sem registro nesta
+*   execução (o arquivo não existia no HD), nada é feito: um registro só
+*   com o lado gravado daria o outro como ausente.
+*
+* Parâmetros:
+*   nome - nome relativo do arquivo
+*   ladoPen - true se a cópia gravou o Pen, false se gravou o HD
+*   meta - metadados do arquivo gravado
+*   conteudo - digest do conteúdo copiado; pode ser nulo
+*
+* Valor retornado:
+*   true se o lado gravado ficou com digest
+***************************************************************************/
+
+bool IndiceEstado::atualizar_lado(const std::string &nome, bool ladoPen,
+                                  const Metadados &meta,
+                                  const std::array<uint8_t, 32> *conteudo) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto it = novo_.find(nome);
+    if (it == novo_.end())
+        return false;
+    RegistroIndice &r = it->second;
+    if (conteudo != nullptr) {
+        r.temDigest = r.temDigestPen = true;
+        r.digest = r.digestPen = *conteudo;
+    } else if (ladoPen) {
+        r.temDigestPen = r.temDigest;
+        r.digestPen = r.digest;
+    } else {
+        r.temDigest = r.temDigestPen;
+        r.digest = r.digestPen;
+    }
+    (ladoPen ? r.pen : r.hd) = meta;
+    return ladoPen ? r.temDigestPen : r.temDigest;
+}
+
+/***************************************************************************
+* Função: IndiceEstado::salvar
+* Descrição:
+*   Junta as atualizações da execução ao índice carregado e grava o
+*   resultado de forma atômica (arquivo temporário + rename). Registros
+*   não tocados nesta execução são mantidos.
+*
+* Valor retornado:
+*   true se o índice foi gravado
+***************************************************************************/
+
+bool IndiceEstado::salvar() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (auto &par : novo_)
+        anterior_[par.first] = par.second;
+    novo_.clear();
+
+    uint64_t quantidade = 0;
+    for (const auto &par : anterior_)
+        quantidade += par.first.size() <= UINT16_MAX;
+
+    std::string dados(kMagica, sizeof(kMagica));
+    anexar(&dados, quantidade);
+    for (const auto &par : anterior_) {
+        if (par.first.size() > UINT16_MAX)
+            continue;
+        anexar(&dados, static_cast<uint16_t>(par.first.size()));
+        dados.append(par.first);
+        anexar_metadados(&dados, par.second.hd);
+        anexar_metadados(&dados, par.second.pen);
+        anexar(&dados, static_cast<uint8_t>(par.second.temDigest));
+        anexar(&dados, par.second.digest);
+        anexar(&dados, static_cast<uint8_t>(par.second.temDigestPen));
+        anexar(&dados, par.second.digestPen);
+    }
+
+    std::string temporario = caminho_ + ".tmp";
+    FILE *f = fopen(temporario.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+    bool ok = fwrite(dados.data(), 1, dados.size(), f) == dados.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(temporario.c_str(), caminho_.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
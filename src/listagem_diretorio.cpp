@@ -0,0 +1,121 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/listagem_diretorio.hpp"
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Buffer de cada chamada getdents64 (algumas centenas de entradas).
+static constexpr size_t kBufferListagem = 64 * 1024;
+// Bytes de diretório cuja leitura custa o mesmo que um statx: cada
+// registro do getdents64 tem 24 a 40 bytes, e ler e ordenar algumas
+// dezenas deles sai mais barato que uma resolução de nome no kernel.
+// (ext4 e xfs contam os blocos do diretório em st_size; tmpfs conta
+// 20 bytes por entrada.)
+static constexpr uint64_t kBytesPorConsulta = 1024;
+
+// Formato de cada registro devolvido por getdents64.
+struct RegistroDirent64 {
+    uint64_t inode;
+    int64_t proximo;
+    uint16_t tamanho;
+    uint8_t tipo;
+    char nome[1];
+};
+
+/***************************************************************************
+* Função: ListagemDiretorio::ler
+* Descrição:
+*   Lê todos os nomes de um diretório com getdents64, em blocos de 64 KiB,
+*   e os ordena para consultas por busca binária. O tipo de cada entrada
+*   (d_type) fica no byte anterior ao nome. "." e ".." são descartados.
+*
+* Parâmetros:
+*   dirfd - diretório ao qual caminho é relativo (AT_FDCWD: o corrente)
+*   caminho - diretório a listar ("." para o próprio dirfd)
+*
+* Valor retornado:
+*   false se o diretório não puder ser aberto ou lido
+***************************************************************************/
+
+bool ListagemDiretorio::ler(int dirfd, const char *caminho) {
+    nomes_.clear();
+    posicoes_.clear();
+
+    int fd = openat(dirfd, caminho, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    std::unique_ptr<char[]> buffer(new char[kBufferListagem]);
+    bool ok = true;
+    for (;;) {
+        long lidos = syscall(SYS_getdents64, fd, buffer.get(),
+                             kBufferListagem);
+        if (lidos <= 0) {
+            ok = lidos == 0;
+            break;
+        }
+        for (long pos = 0; pos < lidos;) {
+            const RegistroDirent64 *d =
+                reinterpret_cast<const RegistroDirent64 *>(buffer.get() + pos);
+            pos += d->tamanho;
+            if (std::strcmp(d->nome, ".") == 0 ||
+                std::strcmp(d->nome, "..") == 0)
+                continue;
+            nomes_.push_back(static_cast<char>(d->tipo));
+            posicoes_.push_back(static_cast<uint32_t>(nomes_.size()));
+            nomes_.append(d->nome).push_back('\0');
+        }
+    }
+    close(fd);
+    if (!ok || nomes_.size() > UINT32_MAX) {
+        nomes_.clear();
+        posicoes_.clear();
+        return false;
+    }
+    const char *base = nomes_.data();
+    std::sort(posicoes_.begin(), posicoes_.end(),
+        [base](uint32_t a, uint32_t b) {
+            return std::strcmp(base + a, base + b) < 0;
+        });
+    return true;
+}
+
+std::string_view ListagemDiretorio::nome(size_t i) const {
+    return std::string_view(nomes_.data() + posicoes_[i]);
+}
+
+uint8_t ListagemDiretorio::tipo(size_t i) const {
+    return static_cast<uint8_t>(nomes_[posicoes_[i] - 1]);
+}
+
+bool ListagemDiretorio::contem(std::string_view nome) const {
+    const char *base = nomes_.data();
+    auto it = std::lower_bound(posicoes_.begin(), posicoes_.end(), nome,
+        [base](uint32_t p, std::string_view n) {
+            return std::string_view(base + p) < n;
+        });
+    return it != posicoes_.end() && std::string_view(base + *it) == nome;
+}
+
+/***************************************************************************
+* Função: vale_enumerar
+* Descrição:
+*   Decide entre ler o diretório inteiro e sondar as entradas uma a uma,
+*   comparando o tamanho do diretório (st_size, que cresce com o número
+*   de entradas) com o custo das sondagens que a listagem evitaria.
+*
+* Parâmetros:
+*   consultas - entradas do Backup.parm no diretório
+*   tamanhoDiretorio - st_size do diretório
+***************************************************************************/
+
+bool vale_enumerar(size_t consultas, uint64_t tamanhoDiretorio) {
+    return consultas >= 2 &&
+        tamanhoDiretorio <= consultas * kBytesPorConsulta;
+}
@@ -0,0 +1,212 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/manifesto.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <cassert>
+#include <string>
+#include <string_view>
+
+// Bytes examinados de uma vez para montar a máscara de quebras.
+static constexpr size_t kBloco = 64;
+
+const char *nome_nucleo(NucleoQuebras nucleo) {
+    switch (nucleo) {
+    case NucleoQuebras::ESCALAR: return "escalar";
+    case NucleoQuebras::SSE2: return "sse2";
+    case NucleoQuebras::AVX2: return "avx2";
+    default: return "automatico";
+    }
+}
+
+/***************************************************************************
+* Função: mascara_escalar
+* Descrição:
+*   Monta a máscara de quebras de linha de até 64 bytes, byte a byte. É
+*   usada fora do x86-64 e para o trecho final do arquivo.
+*
+* Parâmetros:
+*   p - início do bloco
+*   n - bytes válidos a partir de p (n <= 64)
+*
+* Valor retornado:
+*   Bit i ligado se p[i] == '\n'.
+***************************************************************************/
+
+static uint64_t mascara_escalar(const char *p, size_t n) {
+    uint64_t m = 0;
+    for (size_t i = 0; i < n; ++i)
+        m |= static_cast<uint64_t>(p[i] == '\n') << i;
+    return m;
+}
+
+#if defined(__x86_64__)
+static uint64_t mascara_sse2(const char *p) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    uint64_t m = 0;
+    for (int k = 0; k < 4; ++k) {
+        __m128i v = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(p + 16 * k));
+        uint32_t bits = static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+        m |= static_cast<uint64_t>(bits) << (16 * k);
+    }
+    return m;
+}
+
+__attribute__((target("avx2")))
+static uint64_t mascara_avx2(const char *p) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i b = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(p + 32));
+    uint32_t ma = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, nl)));
+    uint32_t mb = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, nl)));
+    return ma | (static_cast<uint64_t>(mb) << 32);
+}
+#endif
+
+/***************************************************************************
+* Função: resolver_nucleo
+* Descrição:
+*   Escolhe a rotina efetiva: AUTOMATICO vira AVX2 ou SSE2 conforme a
+*   CPU, e pedidos não suportados caem para a melhor alternativa.
+***************************************************************************/
+
+static NucleoQuebras resolver_nucleo(NucleoQuebras pedido) {
+#if defined(__x86_64__)
+    bool temAvx2 = __builtin_cpu_supports("avx2");
+    if (pedido == NucleoQuebras::AUTOMATICO ||
+        (pedido == NucleoQuebras::AVX2 && !temAvx2))
+        return temAvx2 ? NucleoQuebras::AVX2 : NucleoQuebras::SSE2;
+    return pedido;
+#else
+    (void)pedido;
+    return NucleoQuebras::ESCALAR;
+#endif
+}
+
+/***************************************************************************
+* Função: LeitorManifesto::LeitorManifesto
+* Descrição:
+*   Mapeia o Backup.parm em memória (somente leitura) para que as linhas
+*   possam ser entregues como std::string_view, sem cópia nem alocação
+*   por linha.
+*
+* Parâmetros:
+*   caminho - arquivo de parâmetros
+*   nucleo - rotina de busca de quebras (AUTOMATICO por padrão)
+*
+* Assertivas de saída:
+*   aberto() == true se o arquivo existe e pôde ser lido
+***************************************************************************/
+
+LeitorManifesto::LeitorManifesto(const std::string &caminho,
+                                 NucleoQuebras nucleo)
+    : nucleo_(resolver_nucleo(nucleo)) {
+    int fd = open(caminho.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+    tamanho_ = static_cast<size_t>(st.st_size);
+    if (tamanho_ > 0) {
+        void *mapa = mmap(nullptr, tamanho_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapa == MAP_FAILED) {
+            close(fd);
+            return;
+        }
+        madvise(mapa, tamanho_, MADV_SEQUENTIAL);
+        dados_ = static_cast<const char *>(mapa);
+    }
+    close(fd);
+
+    aberto_ = true;
+    fim_ = dados_ + tamanho_;
+    posicao_ = bloco_ = dados_;
+    if (tamanho_ > 0)
+        carregar_bloco();
+}
+
+LeitorManifesto::~LeitorManifesto() {
+    if (dados_ != nullptr)
+        munmap(const_cast<char *>(dados_), tamanho_);
+}
+
+/***************************************************************************
+* Função: LeitorManifesto::carregar_bloco
+* Descrição:
+*   Calcula a máscara de quebras do bloco de 64 bytes que começa em
+*   bloco_, com a rotina vetorial escolhida. O último bloco, incompleto,
+*   é tratado pela rotina escalar para não ler além do mapeamento.
+***************************************************************************/
+
+void LeitorManifesto::carregar_bloco() {
+    size_t resto = static_cast<size_t>(fim_ - bloco_);
+    if (resto < kBloco) {
+        mascara_ = mascara_escalar(bloco_, resto);
+        return;
+    }
+    switch (nucleo_) {
+#if defined(__x86_64__)
+    case NucleoQuebras::AVX2: mascara_ = mascara_avx2(bloco_); break;
+    case NucleoQuebras::SSE2: mascara_ = mascara_sse2(bloco_); break;
+#endif
+    default: mascara_ = mascara_escalar(bloco_, kBloco); break;
+    }
+}
+
+/***************************************************************************
+* Função: LeitorManifesto::proxima_linha
+* Descrição:
+*   Entrega a próxima linha do arquivo, sem o '\n', com a mesma divisão
+*   de std::getline: linhas vazias também são entregues e a última linha
+*   não precisa terminar em '\n'.
+*
+* Parâmetros:
+*   linha - recebe a visão da linha; válida enquanto o leitor existir
+*
+* Valor retornado:
+*   false quando não há mais linhas
+*
+* Assertivas de entrada:
+*   aberto()
+***************************************************************************/
+
+bool LeitorManifesto::proxima_linha(std::string_view *linha) {
+    assert(aberto_);
+
+    while (bloco_ < fim_) {
+        if (mascara_ != 0) {
+            const char *quebra = bloco_ + __builtin_ctzll(mascara_);
+            mascara_ &= mascara_ - 1;
+            *linha = std::string_view(posicao_,
+                static_cast<size_t>(quebra - posicao_));
+            posicao_ = quebra + 1;
+            return true;
+        }
+        if (static_cast<size_t>(fim_ - bloco_) <= kBloco) {
+            bloco_ = fim_;
+        } else {
+            bloco_ += kBloco;
+            carregar_bloco();
+        }
+    }
+    if (posicao_ < fim_) {
+        *linha = std::string_view(posicao_,
+            static_cast<size_t>(fim_ - posicao_));
+        posicao_ = fim_;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,333 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/manifesto_binario.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../include/manifesto.hpp"
+#include "../include/metadados.hpp"
+
+// Formato (inteiros na ordem de bytes da máquina):
+//   cabeçalho   magica[8] tamanhoTexto:u64 mtimeTextoNs:i64
+//               numDiretorios:u32 numEntradas:u32 tamanhoNomes:u64
+//   diretórios  numDiretorios x deslocamento:u32 (em nomes)
+//   entradas    numEntradas x {ordem:u32 diretorio:u32 base:u32}
+//   posições    numEntradas x posição:u32 (na tabela de entradas), por
+//               ordem do Backup.parm
+//   nomes       cadeias [tamanho:u16][bytes]
+// Os diretórios são deduplicados e ordenados; as entradas vêm agrupadas
+// por diretório e, dentro dele, na ordem do Backup.parm. O diretório de
+// uma linha absoluta guarda a '/' inicial ("/" para "/arquivo").
+static constexpr char kMagica[8] = {'B', 'K', 'P', 'M', 'A', 'N', '0', '2'};
+static constexpr size_t kTamanhoCabecalho = 40;
+static constexpr size_t kTamanhoEntrada = 12;
+
+template <typename T>
+static T ler(const char *p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+template <typename T>
+static void anexar(std::string *saida, T v) {
+    saida->append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+std::string EntradaCompilada::nome() const {
+    if (pai.empty())
+        return std::string(base);
+    std::string n;
+    n.reserve(pai.size() + 1 + base.size());
+    n.append(pai);
+    if (pai.back() != '/')
+        n.push_back('/');
+    n.append(base);
+    return n;
+}
+
+/***************************************************************************
+* Função: compilar_manifesto
+* Descrição:
+*   Converte o Backup.parm textual em um arquivo binário compacto, com os
+*   diretórios pai deduplicados e as entradas agrupadas por diretório,
+*   para que execuções seguintes possam carregá-lo por mmap sem reler e
+*   dividir o texto. Uma tabela com a posição de cada linha permite
+*   percorrê-las na ordem do Backup.parm sem montar nada ao carregar. O
+*   tamanho e a data do texto são gravados no cabeçalho para detectar
+*   quando o binário fica desatualizado. A gravação é atômica (arquivo
+*   temporário + rename).
+*
+* Parâmetros:
+*   parmTexto - Backup.parm de origem
+*   parmBinario - arquivo binário a gerar
+*
+* Valor retornado:
+*   true se o binário foi gravado
+*
+* Assertivas de entrada:
+*   parmTexto != "" && parmBinario != ""
+***************************************************************************/
+
+bool compilar_manifesto(const std::string &parmTexto,
+                        const std::string &parmBinario) {
+    assert(!parmTexto.empty() && !parmBinario.empty());
+
+    Metadados meta = sondar_metadados(parmTexto);
+    LeitorManifesto leitor(parmTexto);
+    if (!meta.existe || !leitor.aberto())
+        return false;
+
+    struct Linha {
+        uint32_t ordem;
+        uint32_t diretorio;
+        std::string_view base;
+    };
+    std::vector<Linha> linhas;
+    std::vector<std::string_view> diretorios;
+    std::unordered_map<std::string_view, uint32_t> indiceDiretorio;
+
+    std::string_view linha;
+    while (leitor.proxima_linha(&linha)) {
+        if (linha.empty())
+            continue;
+        size_t barra = linha.rfind('/');
+        // "/arquivo" fica com pai "/", para continuar absoluto
+        std::string_view pai = (barra == std::string_view::npos) ?
+            std::string_view() :
+            linha.substr(0, std::max<size_t>(barra, 1));
+        std::string_view base = (barra == std::string_view::npos) ?
+            linha : linha.substr(barra + 1);
+        if (pai.size() > UINT16_MAX || base.size() > UINT16_MAX)
+            return false;
+        auto it = indiceDiretorio.emplace(pai,
+            static_cast<uint32_t>(diretorios.size())).first;
+        if (it->second == diretorios.size())
+            diretorios.push_back(pai);
+        linhas.push_back({static_cast<uint32_t>(linhas.size()), it->second,
+                          base});
+    }
+
+    // Renumera os diretórios em ordem lexicográfica
+    std::vector<uint32_t> porNome(diretorios.size());
+    for (uint32_t i = 0; i < porNome.size(); ++i)
+        porNome[i] = i;
+    std::sort(porNome.begin(), porNome.end(), [&](uint32_t a, uint32_t b) {
+        return diretorios[a] < diretorios[b];
+    });
+    std::vector<uint32_t> novoIndice(diretorios.size());
+    for (uint32_t i = 0; i < porNome.size(); ++i)
+        novoIndice[porNome[i]] = i;
+    for (Linha &l : linhas)
+        l.diretorio = novoIndice[l.diretorio];
+    std::stable_sort(linhas.begin(), linhas.end(),
+        [](const Linha &a, const Linha &b) {
+            return a.diretorio < b.diretorio;
+        });
+
+    std::string nomes;
+    auto anexar_cadeia = [&nomes](std::string_view c) {
+        uint32_t desloc = static_cast<uint32_t>(nomes.size());
+        anexar(&nomes, static_cast<uint16_t>(c.size()));
+        nomes.append(c);
+        return desloc;
+    };
+
+    std::string corpo;
+    for (uint32_t d : porNome)
+        anexar(&corpo, anexar_cadeia(diretorios[d]));
+    std::vector<uint32_t> posicao(linhas.size());
+    for (uint32_t i = 0; i < linhas.size(); ++i) {
+        const Linha &l = linhas[i];
+        anexar(&corpo, l.ordem);
+        anexar(&corpo, l.diretorio);
+        anexar(&corpo, anexar_cadeia(l.base));
+        posicao[l.ordem] = i;
+    }
+    for (uint32_t p : posicao)
+        anexar(&corpo, p);
+    if (nomes.size() > UINT32_MAX)
+        return false;
+
+    std::string cabecalho(kMagica, sizeof(kMagica));
+    anexar(&cabecalho, meta.tamanho);
+    anexar(&cabecalho, meta.mtimeNs);
+    anexar(&cabecalho, static_cast<uint32_t>(diretorios.size()));
+    anexar(&cabecalho, static_cast<uint32_t>(linhas.size()));
+    anexar(&cabecalho, static_cast<uint64_t>(nomes.size()));
+    assert(cabecalho.size() == kTamanhoCabecalho);
+
+    std::string temporario = parmBinario + ".tmp";
+    FILE *f = fopen(temporario.c_str(), "wb");
+    if (f == nullptr)
+        return false;
+    bool ok = fwrite(cabecalho.data(), 1, cabecalho.size(), f) ==
+            cabecalho.size() &&
+        fwrite(corpo.data(), 1, corpo.size(), f) == corpo.size() &&
+        fwrite(nomes.data(), 1, nomes.size(), f) == nomes.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(temporario.c_str(), parmBinario.c_str()) != 0) {
+        unlink(temporario.c_str());
+        return false;
+    }
+    return true;
+}
+
+/***************************************************************************
+* Função: ManifestoBinario::ManifestoBinario
+* Descrição:
+*   Mapeia o manifesto compilado e valida o cabeçalho em tempo
+*   constante: mágica, limites das tabelas e se o Backup.parm textual
+*   ainda tem o tamanho e a data registrados na compilação. As entradas
+*   só são conferidas quando lidas (ver entrada e entrada_na_ordem).
+*
+* Parâmetros:
+*   parmBinario - manifesto compilado
+*   parmTexto - Backup.parm que o originou
+*
+* Assertivas de saída:
+*   valido() == false se o binário não existe, está corrompido ou está
+*   desatualizado em relação ao texto; nesse caso o chamador deve ler o
+*   texto.
+***************************************************************************/
+
+ManifestoBinario::ManifestoBinario(const std::string &parmBinario,
+                                   const std::string &parmTexto) {
+    int fd = open(parmBinario.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < kTamanhoCabecalho) {
+        close(fd);
+        return;
+    }
+    tamanho_ = static_cast<size_t>(st.st_size);
+    void *mapa = mmap(nullptr, tamanho_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED)
+        return;
+    dados_ = static_cast<const char *>(mapa);
+
+    if (std::memcmp(dados_, kMagica, sizeof(kMagica)) != 0)
+        return;
+    Metadados texto = sondar_metadados(parmTexto);
+    if (!texto.existe || texto.tamanho != ler<uint64_t>(dados_ + 8) ||
+        texto.mtimeNs != ler<int64_t>(dados_ + 16))
+        return;
+
+    numDiretorios_ = ler<uint32_t>(dados_ + 24);
+    numEntradas_ = ler<uint32_t>(dados_ + 28);
+    uint64_t tamanhoNomes = ler<uint64_t>(dados_ + 32);
+    uint64_t esperado = kTamanhoCabecalho +
+        uint64_t(numDiretorios_) * 4 +
+        uint64_t(numEntradas_) * (kTamanhoEntrada + 4) + tamanhoNomes;
+    if (esperado != tamanho_)
+        return;
+
+    diretorios_ = dados_ + kTamanhoCabecalho;
+    entradas_ = diretorios_ + size_t(numDiretorios_) * 4;
+    posicoes_ = entradas_ + size_t(numEntradas_) * kTamanhoEntrada;
+    nomes_ = posicoes_ + size_t(numEntradas_) * 4;
+    tamanhoNomes_ = static_cast<size_t>(tamanhoNomes);
+    valido_ = true;
+}
+
+ManifestoBinario::~ManifestoBinario() {
+    if (dados_ != nullptr)
+        munmap(const_cast<char *>(dados_), tamanho_);
+}
+
+/***************************************************************************
+* Função: ManifestoBinario::cadeia
+* Descrição:
+*   Lê a cadeia com prefixo de tamanho no deslocamento indicado da área
+*   de nomes, verificando os limites.
+*
+* Valor retornado:
+*   A cadeia, ou uma visão nula (data() == nullptr) se estiver fora dos
+*   limites.
+***************************************************************************/
+
+std::string_view ManifestoBinario::cadeia(uint64_t deslocamento) const {
+    if (deslocamento + 2 > tamanhoNomes_)
+        return std::string_view();
+    uint16_t n = ler<uint16_t>(nomes_ + deslocamento);
+    if (deslocamento + 2 + n > tamanhoNomes_)
+        return std::string_view();
+    return std::string_view(nomes_ + deslocamento + 2, n);
+}
+
+std::string_view ManifestoBinario::diretorio(uint32_t indice) const {
+    assert(valido_ && indice < numDiretorios_);
+    return cadeia(ler<uint32_t>(diretorios_ + size_t(indice) * 4));
+}
+
+/***************************************************************************
+* Função: ManifestoBinario::entrada
+* Descrição:
+*   Decodifica a i-ésima entrada (na ordem agrupada por diretório). As
+*   visões apontam para o mapeamento, sem cópia.
+*
+* Parâmetros:
+*   indice - posição na tabela de entradas
+*   saida - recebe a entrada
+*
+* Valor retornado:
+*   false se a entrada estiver corrompida
+*
+* Assertivas de entrada:
+*   valido() && indice < numEntradas()
+***************************************************************************/
+
+bool ManifestoBinario::entrada(uint32_t indice,
+                               EntradaCompilada *saida) const {
+    assert(valido_ && indice < numEntradas_);
+
+    const char *p = entradas_ + size_t(indice) * kTamanhoEntrada;
+    saida->ordem = ler<uint32_t>(p);
+    saida->diretorio = ler<uint32_t>(p + 4);
+    if (saida->ordem >= numEntradas_ || saida->diretorio >= numDiretorios_)
+        return false;
+    saida->pai = diretorio(saida->diretorio);
+    saida->base = cadeia(ler<uint32_t>(p + 8));
+    return saida->pai.data() != nullptr && saida->base.data() != nullptr;
+}
+
+/***************************************************************************
+* Função: ManifestoBinario::entrada_na_ordem
+* Descrição:
+*   Decodifica a linha na posição 'ordem' do Backup.parm (contando só as
+*   não vazias), pela tabela de posições. Confere que a entrada apontada
+*   é mesmo dessa linha, de modo que uma tabela corrompida não entrega a
+*   mesma entrada duas vezes.
+*
+* Parâmetros:
+*   ordem - linha procurada
+*   saida - recebe a entrada
+*
+* Valor retornado:
+*   false se a tabela ou a entrada estiverem corrompidas
+*
+* Assertivas de entrada:
+*   valido() && ordem < numEntradas()
+***************************************************************************/
+
+bool ManifestoBinario::entrada_na_ordem(uint32_t ordem,
+                                        EntradaCompilada *saida) const {
+    assert(valido_ && ordem < numEntradas_);
+
+    uint32_t posicao = ler<uint32_t>(posicoes_ + size_t(ordem) * 4);
+    return posicao < numEntradas_ && entrada(posicao, saida) &&
+        saida->ordem == ordem;
+}
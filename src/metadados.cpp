@@ -0,0 +1,84 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/metadados.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <cassert>
+#include <cerrno>
+#include <string>
+
+#ifdef STATX_BASIC_STATS
+/***************************************************************************
+* Função: metadados_de_statx
+* Descrição:
+*   Converte o resultado de um statx bem-sucedido em Metadados.
+*
+* Parâmetros:
+*   stx - estrutura preenchida pelo kernel
+*
+* Valor retornado:
+*   Registro Metadados com existe == true.
+***************************************************************************/
+
+Metadados metadados_de_statx(const struct statx &stx) {
+    Metadados m;
+    m.existe = true;
+    m.tamanho = stx.stx_size;
+    m.mtimeNs = static_cast<int64_t>(stx.stx_mtime.tv_sec) * 1000000000 +
+        stx.stx_mtime.tv_nsec;
+    m.inode = stx.stx_ino;
+    m.dispositivo = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    m.modo = stx.stx_mode;
+    return m;
+}
+#endif
+
+/***************************************************************************
+* Função: sondar_metadados_em
+* Descrição:
+*   Obtém, com uma única chamada statx, a existência, o tamanho, a data de
+*   modificação (em nanossegundos), o inode e o dispositivo de um arquivo.
+*   Se o kernel não oferecer statx, usa fstatat, também em uma única
+*   chamada. Links simbólicos são seguidos, como em fs::exists.
+*
+* Parâmetros:
+*   dirfd - diretório ao qual nome é relativo (AT_FDCWD: o corrente)
+*   nome - caminho do arquivo a consultar
+*
+* Valor retornado:
+*   Registro Metadados; existe == false se o caminho não puder ser
+*   resolvido.
+*
+* Assertivas de entrada:
+*   nome != nullptr && *nome != '\0'
+***************************************************************************/
+
+Metadados sondar_metadados_em(int dirfd, const char *nome) {
+    assert(nome != nullptr && *nome != '\0');
+
+    Metadados m;
+#ifdef STATX_BASIC_STATS
+    struct statx stx;
+    if (statx(dirfd, nome, 0, kMascaraStatx, &stx) == 0)
+        return metadados_de_statx(stx);
+    if (errno != ENOSYS)
+        return m;
+#endif
+    struct stat st;
+    if (fstatat(dirfd, nome, &st, 0) != 0)
+        return m;
+    m.existe = true;
+    m.tamanho = static_cast<uint64_t>(st.st_size);
+    m.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+        st.st_mtim.tv_nsec;
+    m.inode = st.st_ino;
+    m.dispositivo = st.st_dev;
+    m.modo = st.st_mode;
+    return m;
+}
+
+Metadados sondar_metadados(const std::string &caminho) {
+    assert(!caminho.empty());
+    return sondar_metadados_em(AT_FDCWD, caminho.c_str());
+}
@@ -0,0 +1,546 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/pacotes.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>  // NOLINT(build/c++17)
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Índice (inteiros na ordem de bytes da máquina):
+//   magica[8]
+//   registros {pacote:u32 deslocamento:u64 tamanho:u64 mtimeNs:i64
+//              modo:u32 tamanhoNome:u16 nome}
+// Um registro incompleto no fim (execução interrompida) é ignorado.
+static constexpr char kMagica[8] = {'B', 'K', 'P', 'P', 'A', 'C', '0', '1'};
+static constexpr size_t kTamanhoRegistro = 34;  // sem o nome
+static constexpr char kDirPacotes[] = ".pacotes";
+static constexpr char kArquivoIndice[] = "indice";
+// Registros acumulados em memória antes de serem anexados ao índice.
+static constexpr size_t kLimiteRegistros = 1 << 20;
+// Sufixo do índice regravado pela compactação antes do rename.
+static constexpr char kSufixoTemporario[] = ".tmp";
+
+template <typename T>
+static void anexar(std::string *saida, T v) {
+    saida->append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template <typename T>
+static T ler(const char *p) {
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static std::string caminho_pacote(const std::string &dir, uint32_t n) {
+    char nome[32];
+    snprintf(nome, sizeof(nome), "pacote-%06u.dat", n);
+    return (fs::path(dir) / nome).string();
+}
+
+// Grava todo o buffer a partir de 'deslocamento' (-1 = posição corrente).
+static bool gravar_tudo(int fd, const char *dados, size_t tamanho,
+                        int64_t deslocamento) {
+    size_t feitos = 0;
+    while (feitos < tamanho) {
+        ssize_t n = (deslocamento < 0) ?
+            write(fd, dados + feitos, tamanho - feitos) :
+            pwrite(fd, dados + feitos, tamanho - feitos,
+                   static_cast<off_t>(deslocamento + feitos));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        feitos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool ler_tudo(int fd, char *dados, size_t tamanho,
+                     uint64_t deslocamento) {
+    size_t lidos = 0;
+    while (lidos < tamanho) {
+        ssize_t n = pread(fd, dados + lidos, tamanho - lidos,
+                          static_cast<off_t>(deslocamento + lidos));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        lidos += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Número do pacote pelo nome do arquivo ("pacote-NNNNNN.dat"); false se
+// o nome não é de um pacote.
+static bool numero_pacote(const std::string &nome, uint32_t *n) {
+    if (nome.size() < 11 || nome.compare(0, 7, "pacote-") != 0 ||
+        nome.compare(nome.size() - 4, 4, ".dat") != 0)
+        return false;
+    *n = static_cast<uint32_t>(std::strtoul(nome.c_str() + 7, nullptr, 10));
+    return true;
+}
+
+// Lê o índice de um diretório de pacotes; false se ele não existe ou não
+// começa pela mágica.
+static bool carregar_indice(const std::string &dirPacotes,
+                            std::string *dados) {
+    std::ifstream in(fs::path(dirPacotes) / kArquivoIndice,
+                     std::ios::binary);
+    dados->assign((std::istreambuf_iterator<char>(in)),
+                  std::istreambuf_iterator<char>());
+    return dados->size() >= sizeof(kMagica) &&
+        std::memcmp(dados->data(), kMagica, sizeof(kMagica)) == 0;
+}
+
+/***************************************************************************
+* Função: percorrer_indice
+* Descrição:
+*   Decodifica os registros do índice já carregado, na ordem em que foram
+*   anexados, parando no primeiro incompleto (execução interrompida).
+*
+* Parâmetros:
+*   dados - índice inteiro, começando pela mágica
+*   visitar - chamado com o nome e o registro de cada um
+*
+* Valor retornado:
+*   Tamanho da parte válida do índice (até o último registro completo)
+***************************************************************************/
+
+template <typename Visitante>
+static size_t percorrer_indice(const std::string &dados, Visitante visitar) {
+    size_t pos = sizeof(kMagica);
+    while (pos + kTamanhoRegistro <= dados.size()) {
+        const char *p = dados.data() + pos;
+        RegistroPacote r;
+        r.pacote = ler<uint32_t>(p);
+        r.deslocamento = ler<uint64_t>(p + 4);
+        r.tamanho = ler<uint64_t>(p + 12);
+        r.mtimeNs = ler<int64_t>(p + 20);
+        r.modo = ler<uint32_t>(p + 28);
+        uint16_t n = ler<uint16_t>(p + 32);
+        if (pos + kTamanhoRegistro + n > dados.size())
+            break;
+        visitar(std::string_view(p + kTamanhoRegistro, n), r);
+        pos += kTamanhoRegistro + n;
+    }
+    return pos;
+}
+
+// Registro vigente de cada nome (os posteriores substituem os
+// anteriores); 'lidos' recebe quantos registros o índice tem, contando
+// os substituídos.
+static bool ler_indice(
+    const std::string &dirPacotes,
+    std::unordered_map<std::string, RegistroPacote> *registros,
+    size_t *lidos) {
+    std::string dados;
+    if (!carregar_indice(dirPacotes, &dados))
+        return false;
+    size_t n = 0;
+    percorrer_indice(dados, [&](std::string_view nome,
+                                const RegistroPacote &r) {
+        (*registros)[std::string(nome)] = r;
+        ++n;
+    });
+    if (lidos != nullptr)
+        *lidos = n;
+    return true;
+}
+
+Metadados metadados_de_pacote(const RegistroPacote &registro) {
+    Metadados m;
+    m.existe = true;
+    m.tamanho = registro.tamanho;
+    m.mtimeNs = registro.mtimeNs;
+    m.modo = registro.modo;
+    return m;
+}
+
+bool veio_de_pacote(const Metadados &meta) {
+    return meta.existe && meta.inode == 0;
+}
+
+/***************************************************************************
+* Função: EscritorPacotes::EscritorPacotes
+* Descrição:
+*   Prepara <dir>/.pacotes e abre o índice para anexar registros. O
+*   número do próximo pacote é o seguinte ao maior já existente; o
+*   pacote só é criado quando o primeiro arquivo é adicionado.
+*
+* Parâmetros:
+*   dir - diretório destino
+*   tamanhoMaximo - tamanho a partir do qual um novo pacote é começado
+*
+* Assertivas de entrada:
+*   dir != "" && tamanhoMaximo > 0
+***************************************************************************/
+
+EscritorPacotes::EscritorPacotes(const std::string &dir,
+                                 uint64_t tamanhoMaximo)
+    : dir_((fs::path(dir) / kDirPacotes).string()),
+      tamanhoMaximo_(tamanhoMaximo) {
+    assert(!dir.empty() && tamanhoMaximo > 0);
+
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    for (const auto &e : fs::directory_iterator(dir_, ec)) {
+        uint32_t n;
+        if (numero_pacote(e.path().filename().string(), &n) && n >= pacote_)
+            pacote_ = n + 1;
+    }
+
+    // Um registro incompleto no fim (execução interrompida) é cortado,
+    // senão os anexados depois dele ficariam ilegíveis
+    std::string indice = (fs::path(dir_) / kArquivoIndice).string();
+    fdIndice_ = open(indice.c_str(),
+                     O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    std::string dados;
+    if (fdIndice_ < 0 || fstat(fdIndice_, &st) != 0) {
+        falhou_ = true;
+        return;
+    }
+    size_t valido = 0;
+    if (st.st_size > 0 && carregar_indice(dir_, &dados))
+        valido = percorrer_indice(dados,
+            [](std::string_view, const RegistroPacote &) {});
+    if (valido < static_cast<size_t>(st.st_size) &&
+        ftruncate(fdIndice_, static_cast<off_t>(valido)) != 0)
+        falhou_ = true;
+    if (valido == 0)
+        registros_.assign(kMagica, sizeof(kMagica));
+}
+
+EscritorPacotes::~EscritorPacotes() {
+    fechar();
+}
+
+bool EscritorPacotes::abrir_pacote() {
+    if (fdPacote_ >= 0)
+        close(fdPacote_);
+    fdPacote_ = open(caminho_pacote(dir_, pacote_).c_str(),
+                     O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fdPacote_ < 0)
+        return false;
+    ++pacote_;
+    ocupado_ = 0;
+    pacotes_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool EscritorPacotes::gravar_indice() {
+    bool ok = gravar_tudo(fdIndice_, registros_.data(), registros_.size(),
+                          -1);
+    registros_.clear();
+    return ok;
+}
+
+/***************************************************************************
+* Função: EscritorPacotes::adicionar
+* Descrição:
+*   Anexa o conteúdo de um arquivo ao pacote corrente e registra-o no
+*   índice. A leitura da origem é feita fora da trava, em paralelo entre
+*   as threads; só a escrita no fim do pacote é serializada, de modo que
+*   o destino recebe uma gravação sequencial em vez de um arquivo novo
+*   (inode, abertura, escrita e fechamento) por origem. Os dados vão
+*   para o pacote antes de o registro ir para o índice.
+*
+* Parâmetros:
+*   origem - arquivo a guardar (deve caber na memória)
+*   nome - nome relativo registrado no índice
+*
+* Valor retornado:
+*   false se a origem não pôde ser lida ou o pacote/índice gravado
+***************************************************************************/
+
+bool EscritorPacotes::adicionar(const std::string &origem,
+                                const std::string &nome) {
+    if (nome.empty() || nome.size() > UINT16_MAX)
+        return false;
+    int fd = open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    std::string conteudo;
+    bool ok = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (ok) {
+        conteudo.resize(static_cast<size_t>(st.st_size));
+        ok = ler_tudo(fd, &conteudo[0], conteudo.size(), 0);
+    }
+    close(fd);
+    if (!ok)
+        return false;
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (falhou_)
+        return false;
+    if (fdPacote_ < 0 ||
+        (ocupado_ > 0 && ocupado_ + conteudo.size() > tamanhoMaximo_)) {
+        if (!abrir_pacote())
+            return false;
+    }
+    if (!gravar_tudo(fdPacote_, conteudo.data(), conteudo.size(),
+                     static_cast<int64_t>(ocupado_)))
+        return false;
+    anexar(&registros_, pacote_ - 1);
+    anexar(&registros_, ocupado_);
+    anexar(&registros_, static_cast<uint64_t>(conteudo.size()));
+    anexar(&registros_, int64_t(st.st_mtim.tv_sec) * 1000000000 +
+                        st.st_mtim.tv_nsec);
+    anexar(&registros_, static_cast<uint32_t>(st.st_mode));
+    anexar(&registros_, static_cast<uint16_t>(nome.size()));
+    registros_.append(nome);
+    ocupado_ += conteudo.size();
+    if (registros_.size() >= kLimiteRegistros && !gravar_indice()) {
+        falhou_ = true;
+        return false;
+    }
+    arquivos_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(conteudo.size(), std::memory_order_relaxed);
+    return true;
+}
+
+bool EscritorPacotes::fechar() {
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (fdIndice_ < 0)
+        return !falhou_;
+    bool ok = !falhou_ && gravar_indice();
+    ok = (close(fdIndice_) == 0) && ok;
+    fdIndice_ = -1;
+    if (fdPacote_ >= 0)
+        ok = (close(fdPacote_) == 0) && ok;
+    fdPacote_ = -1;
+    falhou_ = !ok;
+    return ok;
+}
+
+EstatisticasPacotes EscritorPacotes::estatisticas() const {
+    EstatisticasPacotes e;
+    e.arquivos = arquivos_;
+    e.bytes = bytes_;
+    e.pacotes = pacotes_;
+    return e;
+}
+
+/***************************************************************************
+* Função: LeitorPacotes::LeitorPacotes
+* Descrição:
+*   Carrega o índice de <dir>/.pacotes, se houver, e abre os pacotes
+*   referenciados por ele. Registros posteriores do mesmo nome substituem
+*   os anteriores; um registro incompleto no fim é ignorado.
+*
+* Parâmetros:
+*   dir - diretório que contém os pacotes (destino de um backup anterior)
+***************************************************************************/
+
+LeitorPacotes::LeitorPacotes(const std::string &dir)
+    : dir_((fs::path(dir) / kDirPacotes).string()) {
+    if (!ler_indice(dir_, &registros_, nullptr))
+        return;
+    for (const auto &par : registros_) {
+        if (pacotes_.count(par.second.pacote) == 0)
+            pacotes_[par.second.pacote] = open(
+                caminho_pacote(dir_, par.second.pacote).c_str(),
+                O_RDONLY | O_CLOEXEC);
+    }
+}
+
+LeitorPacotes::~LeitorPacotes() {
+    for (const auto &par : pacotes_) {
+        if (par.second >= 0)
+            close(par.second);
+    }
+}
+
+const RegistroPacote *LeitorPacotes::buscar(const std::string &nome) const {
+    auto it = registros_.find(nome);
+    return (it == registros_.end()) ? nullptr : &it->second;
+}
+
+/***************************************************************************
+* Função: LeitorPacotes::extrair
+* Descrição:
+*   Recria um arquivo guardado em pacote, com as permissões registradas.
+*   Os pacotes ficam abertos enquanto o leitor existir, então cada
+*   extração custa só a leitura do intervalo e a criação do destino.
+*
+* Parâmetros:
+*   nome - nome relativo registrado no índice
+*   destino - arquivo a gerar
+*
+* Valor retornado:
+*   false se o nome não está no índice ou o pacote não pôde ser lido
+***************************************************************************/
+
+bool LeitorPacotes::extrair(const std::string &nome,
+                            const std::string &destino) const {
+    const RegistroPacote *r = buscar(nome);
+    if (r == nullptr)
+        return false;
+    auto it = pacotes_.find(r->pacote);
+    if (it == pacotes_.end() || it->second < 0)
+        return false;
+    std::string conteudo(static_cast<size_t>(r->tamanho), '\0');
+    if (!ler_tudo(it->second, &conteudo[0], conteudo.size(),
+                  r->deslocamento))
+        return false;
+
+    int saida = open(destino.c_str(),
+                     O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (saida < 0)
+        return false;
+    bool ok = gravar_tudo(saida, conteudo.data(), conteudo.size(), 0);
+    ok = fchmod(saida, r->modo & 07777) == 0 && ok;
+    return (close(saida) == 0) && ok;
+}
+
+/***************************************************************************
+* Função: compactar_pacotes
+* Descrição:
+*   Os pacotes e o índice só crescem: um arquivo alterado ganha um
+*   registro novo e o conteúdo antigo continua no pacote. Quando os
+*   bytes substituídos passam dos vigentes, ou os registros substituídos
+*   passam dos vigentes, os arquivos vigentes são copiados, na ordem em
+*   que estão nos pacotes, para pacotes novos (numerados depois dos
+*   existentes), o índice é regravado só com eles (temporário + rename)
+*   e os pacotes que ele não referencia são apagados. Uma interrupção
+*   antes do rename deixa o índice antigo valendo; depois dele, só
+*   pacotes sem uso, apagados na compactação seguinte.
+*
+* Parâmetros:
+*   dir - diretório destino (o que contém .pacotes)
+*   tamanhoMaximo - tamanho a partir do qual um novo pacote é começado
+*
+* Valor retornado:
+*   Bytes liberados nos pacotes; 0 se não havia o que compactar ou se a
+*   compactação falhou (nesse caso, nada muda)
+*
+* Assertivas de entrada:
+*   dir != "" && tamanhoMaximo > 0
+***************************************************************************/
+
+uint64_t compactar_pacotes(const std::string &dir, uint64_t tamanhoMaximo) {
+    assert(!dir.empty() && tamanhoMaximo > 0);
+
+    std::string dirPacotes = (fs::path(dir) / kDirPacotes).string();
+    std::unordered_map<std::string, RegistroPacote> registros;
+    size_t lidos = 0;
+    if (!ler_indice(dirPacotes, &registros, &lidos))
+        return 0;
+
+    uint64_t total = 0, vigentes = 0;
+    uint32_t proximo = 0;
+    std::vector<uint32_t> existentes;
+    std::error_code ec;
+    for (const auto &e : fs::directory_iterator(dirPacotes, ec)) {
+        uint32_t n;
+        if (!numero_pacote(e.path().filename().string(), &n))
+            continue;
+        existentes.push_back(n);
+        total += e.file_size(ec);
+        proximo = std::max(proximo, n + 1);
+    }
+    for (const auto &par : registros)
+        vigentes += par.second.tamanho;
+    if (ec || (total - std::min(total, vigentes) <= vigentes &&
+               lidos - registros.size() <= registros.size()))
+        return 0;
+
+    // Ordem dos pacotes: leituras sequenciais em cada um
+    std::vector<std::pair<const std::string *, RegistroPacote *>> ordem;
+    ordem.reserve(registros.size());
+    for (auto &par : registros)
+        ordem.emplace_back(&par.first, &par.second);
+    std::sort(ordem.begin(), ordem.end(), [](const auto &a, const auto &b) {
+        return std::make_pair(a.second->pacote, a.second->deslocamento) <
+            std::make_pair(b.second->pacote, b.second->deslocamento);
+    });
+
+    std::unordered_set<uint32_t> novos;
+    std::string indice(kMagica, sizeof(kMagica)), conteudo;
+    int fdOrigem = -1, fdDestino = -1;
+    uint32_t origem = 0;
+    uint64_t ocupado = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < ordem.size(); ++i) {
+        RegistroPacote &r = *ordem[i].second;
+        if (fdOrigem < 0 || r.pacote != origem) {
+            if (fdOrigem >= 0)
+                close(fdOrigem);
+            origem = r.pacote;
+            fdOrigem = open(caminho_pacote(dirPacotes, origem).c_str(),
+                            O_RDONLY | O_CLOEXEC);
+        }
+        if (fdDestino < 0 ||
+            (ocupado > 0 && ocupado + r.tamanho > tamanhoMaximo)) {
+            if (fdDestino >= 0)
+                ok = close(fdDestino) == 0;
+            fdDestino = open(caminho_pacote(dirPacotes, proximo).c_str(),
+                             O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            novos.insert(proximo++);
+            ocupado = 0;
+        }
+        conteudo.resize(static_cast<size_t>(r.tamanho));
+        ok = ok && fdOrigem >= 0 && fdDestino >= 0 &&
+            ler_tudo(fdOrigem, &conteudo[0], conteudo.size(),
+                     r.deslocamento) &&
+            gravar_tudo(fdDestino, conteudo.data(), conteudo.size(),
+                        static_cast<int64_t>(ocupado));
+        r.pacote = proximo - 1;
+        r.deslocamento = ocupado;
+        ocupado += r.tamanho;
+
+        anexar(&indice, r.pacote);
+        anexar(&indice, r.deslocamento);
+        anexar(&indice, r.tamanho);
+        anexar(&indice, r.mtimeNs);
+        anexar(&indice, r.modo);
+        anexar(&indice, static_cast<uint16_t>(ordem[i].first->size()));
+        indice.append(*ordem[i].first);
+    }
+    if (fdOrigem >= 0)
+        close(fdOrigem);
+    if (fdDestino >= 0)
+        ok = (close(fdDestino) == 0) && ok;
+
+    std::string caminhoIndice = (fs::path(dirPacotes) / kArquivoIndice)
+        .string();
+    std::string temporario = caminhoIndice + kSufixoTemporario;
+    if (ok) {
+        int fd = open(temporario.c_str(),
+                      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        ok = fd >= 0 && gravar_tudo(fd, indice.data(), indice.size(), 0);
+        ok = (fd >= 0 && close(fd) == 0) && ok;
+        ok = ok && rename(temporario.c_str(), caminhoIndice.c_str()) == 0;
+    }
+    if (!ok) {
+        unlink(temporario.c_str());
+        for (uint32_t n : novos)
+            unlink(caminho_pacote(dirPacotes, n).c_str());
+        return 0;
+    }
+
+    uint64_t restante = 0;
+    for (uint32_t n : existentes)
+        unlink(caminho_pacote(dirPacotes, n).c_str());
+    for (uint32_t n : novos)
+        restante += fs::file_size(caminho_pacote(dirPacotes, n), ec);
+    return total - std::min(total, restante);
+}
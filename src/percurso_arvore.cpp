@@ -0,0 +1,390 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/percurso_arvore.hpp"
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <cassert>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Nomes que o percurso paralelo pode adiantar ao consumidor.
+static constexpr size_t kCapacidadeFila = 4096;
+
+// Componentes de um caminho relativo separados por '/'.
+static std::vector<std::string> componentes(std::string_view caminho) {
+    std::vector<std::string> partes;
+    size_t ini = 0;
+    while (ini <= caminho.size()) {
+        size_t fim = caminho.find('/', ini);
+        if (fim == std::string_view::npos)
+            fim = caminho.size();
+        partes.emplace_back(caminho.substr(ini, fim - ini));
+        ini = fim + 1;
+    }
+    return partes;
+}
+
+static bool tem_curinga(std::string_view segmento) {
+    return segmento.find_first_of("*?[") != std::string_view::npos;
+}
+
+static std::string juntar(const std::string &raiz,
+                          const std::string &relativo) {
+    return relativo.empty() ? raiz : raiz + "/" + relativo;
+}
+
+bool eh_padrao(std::string_view linha) {
+    return !linha.empty() && (linha.back() == '/' || tem_curinga(linha));
+}
+
+static bool casar_segmentos(const std::vector<std::string> &padrao,
+                            size_t i, const std::vector<std::string> &nome,
+                            size_t j) {
+    for (; i < padrao.size(); ++i, ++j) {
+        if (padrao[i] == "**") {
+            for (size_t k = j; k <= nome.size(); ++k)
+                if (casar_segmentos(padrao, i + 1, nome, k))
+                    return true;
+            return false;
+        }
+        if (j == nome.size() ||
+            fnmatch(padrao[i].c_str(), nome[j].c_str(), 0) != 0)
+            return false;
+    }
+    return j == nome.size();
+}
+
+/***************************************************************************
+* Função: casar_padrao
+* Descrição:
+*   Verifica se um nome relativo casa com um padrão do Backup.parm. Cada
+*   componente do padrão casa com um componente do nome pelas regras do
+*   fnmatch (*, ? e [...] não atravessam '/', e casam também com nomes
+*   iniciados por '.'); o componente "**" casa com zero ou mais
+*   componentes.
+*
+* Parâmetros:
+*   padrao - padrão já normalizado (sem '/' no fim)
+*   nome - nome relativo a testar
+***************************************************************************/
+
+bool casar_padrao(std::string_view padrao, std::string_view nome) {
+    return casar_segmentos(componentes(padrao), 0, componentes(nome), 0);
+}
+
+PercursoArvore::PercursoArvore(const std::string &raiz,
+                               const std::string &inicio,
+                               const std::string *raizExcluida)
+    : raiz_(raiz), raizExcluida_(raizExcluida) {
+    entrar(inicio);
+}
+
+/***************************************************************************
+* Função: PercursoArvore::entrar
+* Descrição:
+*   Lê o diretório (e, se houver, o de mesmo nome na raiz excluída) e o
+*   empilha. Um diretório que não pode ser lido é ignorado.
+***************************************************************************/
+
+void PercursoArvore::entrar(const std::string &relativo) {
+    Quadro q;
+    q.relativo = relativo;
+    if (!q.listagem.ler(AT_FDCWD, juntar(raiz_, relativo).c_str()))
+        return;
+    ++diretoriosLidos_;
+    if (raizExcluida_ != nullptr)
+        q.excluidos.ler(AT_FDCWD, juntar(*raizExcluida_, relativo).c_str());
+    pilha_.push_back(std::move(q));
+}
+
+/***************************************************************************
+* Função: pode_descer
+* Descrição:
+*   Indica se algum arquivo dentro do diretório pode casar com o padrão
+*   de poda: os componentes do diretório precisam casar com os primeiros
+*   do padrão até um "**", e o padrão precisa ter mais componentes que o
+*   diretório. Sem padrão, todo diretório pode.
+***************************************************************************/
+
+static bool pode_descer(const std::string &padrao,
+                        const std::string &relativo) {
+    if (padrao.empty())
+        return true;
+    std::vector<std::string> segmentos = componentes(padrao);
+    std::vector<std::string> partes = componentes(relativo);
+    for (size_t i = 0; i < partes.size(); ++i) {
+        if (i >= segmentos.size())
+            return false;
+        if (segmentos[i] == "**")
+            return true;
+        if (fnmatch(segmentos[i].c_str(), partes[i].c_str(), 0) != 0)
+            return false;
+    }
+    return partes.size() < segmentos.size();
+}
+
+/***************************************************************************
+* Função: tipo_efetivo
+* Descrição:
+*   Tipo de uma entrada para o percurso, a partir do d_type da listagem:
+*   entradas de tipo desconhecido e links simbólicos custam um stat.
+*
+* Valor retornado:
+*   DT_DIR para descer, DT_REG para um arquivo (inclusive link para
+*   arquivo) ou DT_UNKNOWN para pular (links para diretórios, links
+*   quebrados, fifos, sockets e dispositivos).
+***************************************************************************/
+
+static uint8_t tipo_efetivo(const std::string &raiz,
+                            const std::string &relativo, uint8_t tipo) {
+    struct stat st;
+    if (tipo == DT_UNKNOWN) {
+        if (fstatat(AT_FDCWD, juntar(raiz, relativo).c_str(), &st,
+                    AT_SYMLINK_NOFOLLOW) != 0)
+            return DT_UNKNOWN;
+        tipo = S_ISDIR(st.st_mode) ? DT_DIR :
+            S_ISLNK(st.st_mode) ? DT_LNK :
+            S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+    }
+    if (tipo == DT_LNK)
+        return (stat(juntar(raiz, relativo).c_str(), &st) == 0 &&
+                S_ISREG(st.st_mode)) ? DT_REG : DT_UNKNOWN;
+    return (tipo == DT_DIR || tipo == DT_REG) ? tipo : DT_UNKNOWN;
+}
+
+static std::string filho(const std::string &relativo,
+                         std::string_view base) {
+    return relativo.empty() ? std::string(base) :
+        relativo + "/" + std::string(base);
+}
+
+/***************************************************************************
+* Função: PercursoArvore::proximo
+* Descrição:
+*   Avança o percurso até o próximo arquivo. Diretórios são empilhados
+*   ao serem encontrados, de modo que o primeiro nome sai sem que a
+*   árvore inteira tenha sido lida (ver tipo_efetivo para o que é
+*   pulado).
+*
+* Parâmetros:
+*   nome - recebe o nome relativo à raiz
+*
+* Valor retornado:
+*   false quando o percurso terminou
+***************************************************************************/
+
+bool PercursoArvore::proximo(std::string *nome) {
+    while (!pilha_.empty()) {
+        Quadro &q = pilha_.back();
+        if (q.proximo == q.listagem.tamanho()) {
+            pilha_.pop_back();
+            continue;
+        }
+        size_t i = q.proximo++;
+        std::string_view base = q.listagem.nome(i);
+        std::string relativo = filho(q.relativo, base);
+
+        uint8_t tipo = tipo_efetivo(raiz_, relativo, q.listagem.tipo(i));
+        if (tipo == DT_DIR) {
+            if (pode_descer(padrao_, relativo))
+                entrar(relativo);  // invalida q
+            continue;
+        }
+        if (tipo != DT_REG || q.excluidos.contem(base) ||
+            (!padrao_.empty() && !casar_padrao(padrao_, relativo)))
+            continue;
+        *nome = std::move(relativo);
+        return true;
+    }
+    return false;
+}
+
+// Padrão com '/' final trocado por "/**".
+static std::string normalizar(std::string_view linha) {
+    std::string padrao(linha);
+    if (!padrao.empty() && padrao.back() == '/')
+        padrao += "**";
+    return padrao;
+}
+
+// Componentes iniciais do padrão sem curinga (o diretório a percorrer).
+static std::string prefixo_fixo(const std::string &padrao) {
+    std::vector<std::string> segmentos = componentes(padrao);
+    std::string prefixo;
+    for (size_t i = 0; i + 1 < segmentos.size(); ++i) {
+        if (tem_curinga(segmentos[i]))
+            break;
+        if (!prefixo.empty())
+            prefixo.push_back('/');
+        prefixo += segmentos[i];
+    }
+    return prefixo;
+}
+
+/***************************************************************************
+* Função: PercursoParalelo::PercursoParalelo
+* Descrição:
+*   Prepara um percurso concorrente sobre o pool dado.
+*
+* Parâmetros:
+*   pool - pool exclusivo do percurso
+*   capacidadeFila - quantos nomes podem aguardar o consumidor
+*
+* Assertivas de entrada:
+*   pool != nullptr && capacidadeFila > 0
+***************************************************************************/
+
+PercursoParalelo::PercursoParalelo(PoolTarefas *pool, size_t capacidadeFila)
+    : pool_(pool), fila_(capacidadeFila) {
+    assert(pool != nullptr && capacidadeFila > 0);
+}
+
+// Um percurso abandonado no meio cancela as tarefas restantes.
+PercursoParalelo::~PercursoParalelo() {
+    cancelar_.store(true, std::memory_order_relaxed);
+    pool_->aguardar(&grupo_);
+}
+
+void PercursoParalelo::iniciar(const std::string &raiz,
+                               const std::string &inicio,
+                               const std::string *raizExcluida,
+                               const std::string &padrao) {
+    raizes_.push_back({raiz, raizExcluida, padrao});
+    const Raiz *r = &raizes_.back();
+    pool_->submeter(&grupo_, [this, r, inicio] { visitar(r, inicio); });
+}
+
+/***************************************************************************
+* Função: PercursoParalelo::visitar
+* Descrição:
+*   Tarefa de um diretório: lê a listagem (e a do lado excluído), submete
+*   cada subdiretório que ainda pode casar como uma nova tarefa e entrega
+*   os arquivos aceitos na fila. Os subdiretórios vão para a fila do
+*   próprio trabalhador, de onde saem em profundidade, e os ociosos os
+*   roubam pela outra ponta.
+*
+* Parâmetros:
+*   raiz - raiz do percurso a que o diretório pertence
+*   relativo - diretório relativo à raiz ("" = a própria raiz)
+***************************************************************************/
+
+void PercursoParalelo::visitar(const Raiz *raiz,
+                               const std::string &relativo) {
+    if (cancelar_.load(std::memory_order_relaxed))
+        return;
+    ListagemDiretorio listagem, excluidos;
+    if (!listagem.ler(AT_FDCWD, juntar(raiz->raiz, relativo).c_str()))
+        return;
+    diretoriosLidos_.fetch_add(1, std::memory_order_relaxed);
+    if (raiz->raizExcluida != nullptr)
+        excluidos.ler(AT_FDCWD,
+                      juntar(*raiz->raizExcluida, relativo).c_str());
+
+    for (size_t i = 0; i < listagem.tamanho(); ++i) {
+        if (cancelar_.load(std::memory_order_relaxed))
+            return;
+        std::string_view base = listagem.nome(i);
+        std::string nome = filho(relativo, base);
+        uint8_t tipo = tipo_efetivo(raiz->raiz, nome, listagem.tipo(i));
+        if (tipo == DT_DIR) {
+            if (pode_descer(raiz->padrao, nome))
+                pool_->submeter(&grupo_, [this, raiz, nome] {
+                    visitar(raiz, nome);
+                });
+            continue;
+        }
+        if (tipo == DT_UNKNOWN || excluidos.contem(base))
+            continue;
+        if (!raiz->padrao.empty() && !casar_padrao(raiz->padrao, nome))
+            continue;
+        entregar(std::move(nome));
+    }
+}
+
+// Com a fila cheia, o trabalhador cede a vez até o consumidor retirar.
+void PercursoParalelo::entregar(std::string nome) {
+    while (!fila_.inserir(std::move(nome))) {
+        if (cancelar_.load(std::memory_order_relaxed))
+            return;
+        std::this_thread::yield();
+    }
+}
+
+/***************************************************************************
+* Função: PercursoParalelo::proximo
+* Descrição:
+*   Retira o próximo arquivo encontrado, esperando enquanto houver
+*   diretórios em andamento. Como um diretório só deixa de contar como
+*   pendente depois de entregar seus arquivos e submeter seus filhos,
+*   pendentes == 0 com a fila vazia significa que o percurso acabou.
+*
+* Valor retornado:
+*   false quando todos os arquivos já foram retirados
+***************************************************************************/
+
+bool PercursoParalelo::proximo(std::string *nome) {
+    for (;;) {
+        if (fila_.retirar(nome))
+            return true;
+        if (grupo_.pendentes.load(std::memory_order_acquire) == 0)
+            return fila_.retirar(nome);
+        std::this_thread::yield();
+    }
+}
+
+/***************************************************************************
+* Função: ExpansaoEntrada::ExpansaoEntrada
+* Descrição:
+*   Prepara a expansão de uma linha-padrão do Backup.parm: o percurso
+*   começa no diretório fixo do padrão (os componentes antes do primeiro
+*   curinga), no HD e no Pen, e só desce aos diretórios que ainda podem
+*   casar.
+*
+* Parâmetros:
+*   dirHD, dirPen - raízes dos dois lados
+*   linha - linha do Backup.parm
+*   pool - pool exclusivo para o percurso paralelo; nulo = sequencial
+*
+* Assertivas de entrada:
+*   eh_padrao(linha)
+***************************************************************************/
+
+ExpansaoEntrada::ExpansaoEntrada(const std::string &dirHD,
+                                 const std::string &dirPen,
+                                 std::string_view linha, PoolTarefas *pool)
+    : dirHD_(dirHD), dirPen_(dirPen), padrao_(normalizar(linha)),
+      prefixo_(prefixo_fixo(padrao_)) {
+    assert(eh_padrao(linha));
+    if (pool != nullptr) {
+        paralelo_.reset(new PercursoParalelo(pool, kCapacidadeFila));
+        paralelo_->iniciar(dirHD_, prefixo_, nullptr, padrao_);
+        paralelo_->iniciar(dirPen_, prefixo_, &dirHD_, padrao_);
+        return;
+    }
+    hd_.reset(new PercursoArvore(dirHD_, prefixo_));
+    pen_.reset(new PercursoArvore(dirPen_, prefixo_, &dirHD_));
+    hd_->podar_por(padrao_);
+    pen_->podar_por(padrao_);
+}
+
+bool ExpansaoEntrada::proximo(std::string *nome) {
+    if (paralelo_)
+        return paralelo_->proximo(nome);
+    if (!noPen_) {
+        if (hd_->proximo(nome))
+            return true;
+        noPen_ = true;
+    }
+    return pen_->proximo(nome);
+}
+
+size_t ExpansaoEntrada::diretoriosLidos() const {
+    if (paralelo_)
+        return paralelo_->diretoriosLidos();
+    return hd_->diretoriosLidos() + pen_->diretoriosLidos();
+}
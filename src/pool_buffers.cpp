@@ -0,0 +1,294 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/pool_buffers.hpp"
+#include <sys/mman.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+// Caches por thread: cada thread usa o de índice (número da thread %
+// kCaches), então até kCaches threads não disputam nenhum.
+static constexpr size_t kCaches = 64;
+
+// Blocos guardados no cache de uma thread; os demais vão para a lista
+// global.
+static constexpr size_t kBlocosPorCache = 4;
+
+// Tamanho de uma página enorme (x86-64 e aarch64 com páginas de 4 KiB).
+static constexpr size_t kPaginaEnorme = 2 << 20;
+
+// Pool das cópias do backup.
+static constexpr size_t kBlocoGlobal = 2 << 20;
+static constexpr size_t kLimiteGlobal = 256 << 20;
+
+static std::atomic<unsigned> proximaThread{0};
+static thread_local unsigned indiceThread = proximaThread++;
+
+// Buffers do pool (não excedentes) em poder da thread, em todos os pools.
+static thread_local unsigned buffersDaThread = 0;
+
+BlocoBuffer &BlocoBuffer::operator=(BlocoBuffer &&outro) noexcept {
+    if (this != &outro) {
+        liberar();
+        dono_ = outro.dono_;
+        dados_ = outro.dados_;
+        tamanho_ = outro.tamanho_;
+        excedente_ = outro.excedente_;
+        outro.dono_ = nullptr;
+        outro.dados_ = nullptr;
+        outro.tamanho_ = 0;
+    }
+    return *this;
+}
+
+void BlocoBuffer::liberar() {
+    if (dados_ != nullptr)
+        dono_->devolver(this);
+    dono_ = nullptr;
+    dados_ = nullptr;
+    tamanho_ = 0;
+}
+
+PoolBuffers &PoolBuffers::global() {
+    static PoolBuffers pool(kBlocoGlobal, kLimiteGlobal);
+    return pool;
+}
+
+/***************************************************************************
+* Função: PoolBuffers::PoolBuffers
+* Descrição:
+*   Cria o pool vazio: os blocos só são mapeados quando pedidos.
+*
+* Parâmetros:
+*   tamanhoBloco - bytes de cada bloco (arredondado para 4 KiB)
+*   limiteBytes - máximo de memória em blocos do pool; ao menos um bloco
+*   paginasEnormes - tenta páginas enormes nos blocos múltiplos de 2 MiB
+*
+* Assertivas de entrada:
+*   tamanhoBloco > 0
+***************************************************************************/
+
+PoolBuffers::PoolBuffers(size_t tamanhoBloco, size_t limiteBytes,
+                         bool paginasEnormes)
+    : tamanhoBloco_((tamanhoBloco + 4095) & ~size_t(4095)),
+      limiteBlocos_(std::max<size_t>(limiteBytes / tamanhoBloco_, 1)),
+      paginasEnormes_(paginasEnormes &&
+                      tamanhoBloco_ % kPaginaEnorme == 0),
+      caches_(new CacheThread[kCaches]) {
+    assert(tamanhoBloco > 0);
+}
+
+// Nenhum buffer pode estar em uso.
+PoolBuffers::~PoolBuffers() {
+    assert(bytesEmUso_ == 0);
+    for (char *bloco : reservados_)
+        munmap(bloco, tamanhoBloco_);
+}
+
+PoolBuffers::CacheThread &PoolBuffers::cache_da_thread() {
+    return caches_[indiceThread % kCaches];
+}
+
+/***************************************************************************
+* Função: PoolBuffers::mapear
+* Descrição:
+*   Mapeia memória anônima para um bloco (ou excedente). Com páginas
+*   enormes, tenta MAP_HUGETLB, que só funciona se o administrador as
+*   reservou (vm.nr_hugepages); senão, mapeia 2 MiB a mais, recorta a
+*   região para começar em um múltiplo de 2 MiB e pede ao kernel páginas
+*   enormes transparentes (MADV_HUGEPAGE).
+*
+* Valor retornado:
+*   Início da região, alinhado a 4 KiB (2 MiB com páginas enormes), ou
+*   nullptr.
+***************************************************************************/
+
+char *PoolBuffers::mapear(size_t tamanho, bool *paginasEnormes) {
+    *paginasEnormes = false;
+    const int prot = PROT_READ | PROT_WRITE;
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (!paginasEnormes_ || tamanho % kPaginaEnorme != 0) {
+        void *p = mmap(nullptr, tamanho, prot, flags, -1, 0);
+        return p == MAP_FAILED ? nullptr : static_cast<char *>(p);
+    }
+#ifdef MAP_HUGETLB
+    void *p = mmap(nullptr, tamanho, prot, flags | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        *paginasEnormes = true;
+        return static_cast<char *>(p);
+    }
+#endif
+    void *r = mmap(nullptr, tamanho + kPaginaEnorme, prot, flags, -1, 0);
+    if (r == MAP_FAILED)
+        return nullptr;
+    uintptr_t inicio = reinterpret_cast<uintptr_t>(r);
+    uintptr_t alinhado = (inicio + kPaginaEnorme - 1) & ~(kPaginaEnorme - 1);
+    if (alinhado > inicio)
+        munmap(r, alinhado - inicio);
+    size_t sobra = kPaginaEnorme - (alinhado - inicio);
+    if (sobra > 0)
+        munmap(reinterpret_cast<char *>(alinhado + tamanho), sobra);
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<char *>(alinhado), tamanho, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<char *>(alinhado);
+}
+
+// Um bloco livre do cache de qualquer thread, ou nullptr.
+char *PoolBuffers::roubar_de_caches() {
+    for (size_t i = 0; i < kCaches; ++i) {
+        std::lock_guard<std::mutex> lk(caches_[i].mtx);
+        if (!caches_[i].livres.empty()) {
+            char *bloco = caches_[i].livres.back();
+            caches_[i].livres.pop_back();
+            return bloco;
+        }
+    }
+    return nullptr;
+}
+
+/***************************************************************************
+* Função: PoolBuffers::obter
+* Descrição:
+*   Entrega um bloco, na ordem: o cache da thread, a lista global, um
+*   bloco novo (abaixo do limite) ou o cache de outra thread. No limite,
+*   a thread que não tem nenhum buffer do pool espera um ser devolvido;
+*   a que já tem recebe um excedente, mapeado só para ela, para que duas
+*   threads nunca fiquem esperando uma pela outra.
+*
+* Parâmetros:
+*   tamanho - bytes necessários (0 = um bloco); acima do tamanho do
+*             bloco, o buffer é um excedente com o tamanho pedido
+*
+* Valor retornado:
+*   Buffer com pelo menos 'tamanho' bytes; vazio só se o mapeamento de
+*   memória falhar.
+***************************************************************************/
+
+BlocoBuffer PoolBuffers::obter(size_t tamanho) {
+    pedidos_.fetch_add(1, std::memory_order_relaxed);
+    BlocoBuffer b;
+    b.dono_ = this;
+    b.tamanho_ = tamanhoBloco_;
+    bool enorme;
+
+    if (tamanho > tamanhoBloco_) {
+        b.tamanho_ = tamanho;
+        b.excedente_ = true;
+    }
+    if (!b.excedente_) {
+        CacheThread &cache = cache_da_thread();
+        std::lock_guard<std::mutex> lk(cache.mtx);
+        if (!cache.livres.empty()) {
+            b.dados_ = cache.livres.back();
+            cache.livres.pop_back();
+            acertosCache_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!b.excedente_ && b.dados_ == nullptr) {
+        std::unique_lock<std::mutex> lk(mtx_);
+        if (!livres_.empty()) {
+            b.dados_ = livres_.back();
+            livres_.pop_back();
+            acertosGlobal_.fetch_add(1, std::memory_order_relaxed);
+        } else if (reservados_.size() < limiteBlocos_) {
+            b.dados_ = mapear(tamanhoBloco_, &enorme);
+            if (b.dados_ == nullptr)
+                return BlocoBuffer();
+            reservados_.push_back(b.dados_);
+            blocosPaginasEnormes_ += enorme;
+            alocacoes_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (!b.excedente_ && b.dados_ == nullptr) {
+        // Quem devolver a partir daqui manda o bloco para a lista global
+        esperando_.fetch_add(1);
+        b.dados_ = roubar_de_caches();
+        if (b.dados_ != nullptr) {
+            acertosGlobal_.fetch_add(1, std::memory_order_relaxed);
+        } else if (buffersDaThread > 0) {
+            b.excedente_ = true;
+        } else {
+            std::unique_lock<std::mutex> lk(mtx_);
+            esperas_.fetch_add(1, std::memory_order_relaxed);
+            cvLivre_.wait(lk, [this] { return !livres_.empty(); });
+            b.dados_ = livres_.back();
+            livres_.pop_back();
+            acertosGlobal_.fetch_add(1, std::memory_order_relaxed);
+        }
+        esperando_.fetch_sub(1);
+    }
+    if (b.excedente_) {
+        b.tamanho_ = (b.tamanho_ + 4095) & ~size_t(4095);
+        b.dados_ = mapear(b.tamanho_, &enorme);
+        if (b.dados_ == nullptr)
+            return BlocoBuffer();
+        excedentes_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        ++buffersDaThread;
+    }
+
+    uint64_t emUso = bytesEmUso_.fetch_add(b.tamanho_) + b.tamanho_;
+    uint64_t pico = picoBytesEmUso_.load(std::memory_order_relaxed);
+    while (emUso > pico &&
+           !picoBytesEmUso_.compare_exchange_weak(pico, emUso)) {
+    }
+    return b;
+}
+
+/***************************************************************************
+* Função: PoolBuffers::devolver
+* Descrição:
+*   Recebe um buffer de volta: um excedente é desmapeado; um bloco vai
+*   para o cache da thread, ou para a lista global se o cache estiver
+*   cheio ou houver alguém esperando.
+***************************************************************************/
+
+void PoolBuffers::devolver(BlocoBuffer *buffer) {
+    bytesEmUso_.fetch_sub(buffer->tamanho_);
+    if (buffer->excedente_) {
+        munmap(buffer->dados_, buffer->tamanho_);
+        return;
+    }
+    if (buffersDaThread > 0)
+        --buffersDaThread;
+    {
+        CacheThread &cache = cache_da_thread();
+        std::lock_guard<std::mutex> lk(cache.mtx);
+        if (esperando_.load() == 0 &&
+            cache.livres.size() < kBlocosPorCache) {
+            cache.livres.push_back(buffer->dados_);
+            return;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        livres_.push_back(buffer->dados_);
+    }
+    cvLivre_.notify_one();
+}
+
+EstatisticasBuffers PoolBuffers::estatisticas() const {
+    EstatisticasBuffers e;
+    e.pedidos = pedidos_;
+    e.acertosCache = acertosCache_;
+    e.acertosGlobal = acertosGlobal_;
+    e.alocacoes = alocacoes_;
+    e.esperas = esperas_;
+    e.excedentes = excedentes_;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        e.blocosReservados = reservados_.size();
+        e.blocosPaginasEnormes = blocosPaginasEnormes_;
+    }
+    e.bytesEmUso = bytesEmUso_;
+    e.picoBytesEmUso = picoBytesEmUso_;
+    if (e.pedidos > 0)
+        e.taxaAcerto = double(e.acertosCache + e.acertosGlobal) / e.pedidos;
+    return e;
+}
+
+// O pico volta a ser o uso atual.
+void PoolBuffers::reiniciar_pico() {
+    picoBytesEmUso_ = bytesEmUso_.load();
+}
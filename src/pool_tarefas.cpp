@@ -0,0 +1,201 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/pool_tarefas.hpp"
+#include <cassert>
+#include <utility>
+
+// Pool e fila da thread corrente, usados para que tarefas submetidas por
+// um trabalhador entrem na sua própria fila.
+static thread_local const PoolTarefas *poolAtual = nullptr;
+static thread_local size_t filaAtual = 0;
+
+/***************************************************************************
+* Função: PoolTarefas::PoolTarefas
+* Descrição:
+*   Cria o pool com uma fila (deque) por trabalhador. Cada trabalhador
+*   consome a própria fila pelo fim (LIFO) e, quando ela esvazia, rouba
+*   tarefas do início das filas dos demais (FIFO).
+*
+* Parâmetros:
+*   numThreads - quantidade de trabalhadores; 0 usa o número de núcleos
+*
+* Assertivas de saída:
+*   tamanho() >= 1
+***************************************************************************/
+
+PoolTarefas::PoolTarefas(unsigned numThreads) {
+    if (numThreads == 0)
+        numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0)
+        numThreads = 1;
+
+    for (unsigned i = 0; i < numThreads; ++i)
+        filas_.emplace_back(new Fila());
+    for (unsigned i = 0; i < numThreads; ++i)
+        threads_.emplace_back(&PoolTarefas::laco_trabalhador, this, i);
+}
+
+/***************************************************************************
+* Função: PoolTarefas::~PoolTarefas
+* Descrição:
+*   Sinaliza o término, deixa os trabalhadores esvaziarem as filas e
+*   aguarda todas as threads.
+***************************************************************************/
+
+PoolTarefas::~PoolTarefas() {
+    {
+        std::lock_guard<std::mutex> lk(mtxSono_);
+        parar_ = true;
+    }
+    cvSono_.notify_all();
+    for (auto &t : threads_)
+        t.join();
+}
+
+unsigned PoolTarefas::tamanho() const {
+    return static_cast<unsigned>(threads_.size());
+}
+
+/***************************************************************************
+* Função: PoolTarefas::submeter
+* Descrição:
+*   Enfileira uma tarefa pertencente ao grupo informado. Chamadas feitas
+*   por um trabalhador do próprio pool usam a fila dele; as demais são
+*   distribuídas em rodízio.
+*
+* Parâmetros:
+*   grupo - grupo cujo contador de pendentes é incrementado
+*   tarefa - função a executar
+*
+* Assertivas de entrada:
+*   grupo != nullptr
+***************************************************************************/
+
+void PoolTarefas::submeter(GrupoTarefas *grupo, std::function<void()> tarefa) {
+    assert(grupo != nullptr);
+
+    size_t indice = (poolAtual == this) ? filaAtual :
+        proximaFila_.fetch_add(1, std::memory_order_relaxed) % filas_.size();
+
+    grupo->pendentes.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lk(filas_[indice]->mtx);
+        filas_[indice]->tarefas.push_back({grupo, std::move(tarefa)});
+    }
+    disponiveis_.fetch_add(1, std::memory_order_release);
+    bool acordarEsperas;
+    {
+        std::lock_guard<std::mutex> lk(mtxSono_);
+        acordarEsperas = esperando_ > 0;
+    }
+    cvSono_.notify_one();
+    if (acordarEsperas)
+        cvEspera_.notify_all();
+}
+
+/***************************************************************************
+* Função: PoolTarefas::aguardar
+* Descrição:
+*   Bloqueia até que todas as tarefas do grupo terminem. Enquanto espera,
+*   a thread chamadora também executa tarefas pendentes, o que permite
+*   submeter e aguardar grupos de dentro de outra tarefa; sem nenhuma
+*   para executar, dorme até uma tarefa ser submetida ou o grupo
+*   terminar.
+*
+* Parâmetros:
+*   grupo - grupo a aguardar
+*
+* Assertivas de saída:
+*   grupo->pendentes == 0
+***************************************************************************/
+
+void PoolTarefas::aguardar(GrupoTarefas *grupo) {
+    assert(grupo != nullptr);
+
+    size_t indice = (poolAtual == this) ? filaAtual : 0;
+    while (grupo->pendentes.load(std::memory_order_acquire) > 0) {
+        Tarefa tarefa;
+        if (obter_tarefa(indice, &tarefa)) {
+            executar(&tarefa);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(mtxSono_);
+        ++esperando_;
+        cvEspera_.wait(lk, [this, grupo] {
+            return grupo->pendentes.load(std::memory_order_acquire) == 0 ||
+                disponiveis_.load(std::memory_order_acquire) > 0;
+        });
+        --esperando_;
+    }
+}
+
+/***************************************************************************
+* Função: PoolTarefas::obter_tarefa
+* Descrição:
+*   Retira a próxima tarefa da fila indicada (pelo fim) ou, se ela estiver
+*   vazia, rouba do início das demais filas.
+*
+* Valor retornado:
+*   true se uma tarefa foi obtida
+***************************************************************************/
+
+bool PoolTarefas::obter_tarefa(size_t indice, Tarefa *tarefa) {
+    const size_t n = filas_.size();
+    for (size_t k = 0; k < n; ++k) {
+        Fila &fila = *filas_[(indice + k) % n];
+        std::lock_guard<std::mutex> lk(fila.mtx);
+        if (fila.tarefas.empty())
+            continue;
+        if (k == 0) {
+            *tarefa = std::move(fila.tarefas.back());
+            fila.tarefas.pop_back();
+        } else {
+            *tarefa = std::move(fila.tarefas.front());
+            fila.tarefas.pop_front();
+        }
+        disponiveis_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// Executa a tarefa e, se ela era a última do grupo, acorda quem o
+// aguarda.
+void PoolTarefas::executar(Tarefa *tarefa) {
+    tarefa->funcao();
+    if (tarefa->grupo->pendentes.fetch_sub(1, std::memory_order_acq_rel) > 1)
+        return;
+    bool acordarEsperas;
+    {
+        std::lock_guard<std::mutex> lk(mtxSono_);
+        acordarEsperas = esperando_ > 0;
+    }
+    if (acordarEsperas)
+        cvEspera_.notify_all();
+}
+
+/***************************************************************************
+* Função: PoolTarefas::laco_trabalhador
+* Descrição:
+*   Laço principal de cada trabalhador: executa tarefas enquanto houver e
+*   dorme quando todas as filas estão vazias.
+***************************************************************************/
+
+void PoolTarefas::laco_trabalhador(size_t indice) {
+    poolAtual = this;
+    filaAtual = indice;
+
+    for (;;) {
+        Tarefa tarefa;
+        if (obter_tarefa(indice, &tarefa)) {
+            executar(&tarefa);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(mtxSono_);
+        cvSono_.wait(lk, [this] {
+            return parar_ || disponiveis_.load(std::memory_order_acquire) > 0;
+        });
+        if (parar_ && disponiveis_.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
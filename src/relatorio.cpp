@@ -0,0 +1,148 @@
+// Copyright 2025 Íthalo Júnio Medeiros de Oliveira Nóbrega
+
+#include "../include/relatorio.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Tamanho de cada bloco da arena (o deslocamento alcança até 2^20).
+static constexpr size_t kTamanhoBlocoArena = size_t(1) << 18;
+// Maior texto representável (campo de 16 bits).
+static constexpr size_t kMaiorTexto = UINT16_MAX;
+
+RelatorioBackup::RelatorioBackup(bool detalhado) : detalhado_(detalhado) {}
+
+void RelatorioBackup::reservar(size_t entradas) {
+    bases_.reserve(entradas);
+    diretorioDe_.reserve(entradas);
+    acoes_.reserve(entradas);
+    if (detalhado_) {
+        bytes_.reserve(entradas);
+        duracoes_.reserve(entradas);
+    }
+}
+
+/***************************************************************************
+* Função: RelatorioBackup::guardar
+* Descrição:
+*   Copia um texto para a arena. Os textos são gravados um após o outro
+*   no bloco corrente; quando ele enche, um novo bloco é criado, sem
+*   mover os já gravados.
+*
+* Valor retornado:
+*   Posição do texto (bloco, deslocamento e tamanho em 64 bits).
+*
+* Assertivas de entrada:
+*   texto.size() <= 65535
+***************************************************************************/
+
+uint64_t RelatorioBackup::guardar(std::string_view texto) {
+    assert(texto.size() <= kMaiorTexto);
+
+    if (blocos_.empty() || usadoNoBloco_ + texto.size() > kTamanhoBlocoArena) {
+        blocos_.emplace_back(new char[kTamanhoBlocoArena]);
+        usadoNoBloco_ = 0;
+    }
+    uint64_t posicao = (uint64_t(blocos_.size() - 1) << 36) |
+        (uint64_t(usadoNoBloco_) << 16) | texto.size();
+    std::memcpy(blocos_.back().get() + usadoNoBloco_, texto.data(),
+                texto.size());
+    usadoNoBloco_ += texto.size();
+    return posicao;
+}
+
+std::string_view RelatorioBackup::texto(uint64_t posicao) const {
+    const char *bloco = blocos_[posicao >> 36].get();
+    return std::string_view(bloco + ((posicao >> 16) & 0xFFFFF),
+                            posicao & 0xFFFF);
+}
+
+/***************************************************************************
+* Função: RelatorioBackup::adicionar
+* Descrição:
+*   Acrescenta uma entrada. O nome é separado em diretório pai, guardado
+*   uma única vez por diretório distinto, e nome base, copiado para a
+*   arena.
+*
+* Parâmetros:
+*   nome - nome relativo do arquivo
+*   acao - código da ação (enum Acao)
+*   bytes - bytes copiados (guardado só se detalhado)
+*   duracaoNs - tempo gasto na entrada (guardado só se detalhado)
+*
+* Assertivas de entrada:
+*   0 <= acao <= 255; diretório e nome base com até 65535 bytes
+***************************************************************************/
+
+void RelatorioBackup::adicionar(std::string_view nome, int acao,
+                                uint64_t bytes, uint64_t duracaoNs) {
+    assert(acao >= 0 && acao <= UINT8_MAX);
+
+    size_t barra = nome.rfind('/');
+    std::string_view pai = (barra == std::string_view::npos) ?
+        std::string_view() : nome.substr(0, barra);
+    std::string_view base = (barra == std::string_view::npos) ?
+        nome : nome.substr(barra + 1);
+
+    auto it = indiceDiretorio_.find(pai);
+    if (it == indiceDiretorio_.end()) {
+        uint64_t posicao = guardar(pai);
+        diretorios_.push_back(posicao);
+        it = indiceDiretorio_.emplace(texto(posicao),
+            static_cast<uint32_t>(diretorios_.size() - 1)).first;
+    }
+    diretorioDe_.push_back(it->second);
+    bases_.push_back(guardar(base));
+    acoes_.push_back(static_cast<uint8_t>(acao));
+    if (detalhado_) {
+        bytes_.push_back(bytes);
+        duracoes_.push_back(duracaoNs);
+    }
+}
+
+std::string_view RelatorioBackup::diretorio(size_t i) const {
+    assert(i < tamanho());
+    return texto(diretorios_[diretorioDe_[i]]);
+}
+
+std::string_view RelatorioBackup::base(size_t i) const {
+    assert(i < tamanho());
+    return texto(bases_[i]);
+}
+
+std::string RelatorioBackup::nome(size_t i) const {
+    std::string_view pai = diretorio(i);
+    std::string n;
+    n.reserve(pai.size() + 1 + base(i).size());
+    if (!pai.empty())
+        n.append(pai).push_back('/');
+    n.append(base(i));
+    return n;
+}
+
+size_t RelatorioBackup::contar(int acao) const {
+    return static_cast<size_t>(std::count(acoes_.begin(), acoes_.end(),
+                                          static_cast<uint8_t>(acao)));
+}
+
+uint64_t RelatorioBackup::bytesTotais() const {
+    uint64_t total = 0;
+    for (uint64_t b : bytes_)
+        total += b;
+    return total;
+}
+
+size_t RelatorioBackup::memoria() const {
+    // Nó da tabela de diretórios: chave, valor, hash e ponteiro
+    const size_t porDiretorio = sizeof(std::string_view) + 3 * 8;
+    return sizeof(*this) + blocos_.size() * kTamanhoBlocoArena +
+        blocos_.capacity() * sizeof(blocos_[0]) +
+        bases_.capacity() * sizeof(uint64_t) +
+        diretorioDe_.capacity() * sizeof(uint32_t) + acoes_.capacity() +
+        (bytes_.capacity() + duracoes_.capacity()) * sizeof(uint64_t) +
+        diretorios_.capacity() * sizeof(uint64_t) +
+        indiceDiretorio_.bucket_count() * sizeof(void *) +
+        indiceDiretorio_.size() * porDiretorio;
+}
@@ -2,15 +2,46 @@
 
 #define CATCH_CONFIG_MAIN
 
+// C system headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
 // C++ system headers
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstring>
 #include <filesystem>  // NOLINT(build/c++17)
 #include <fstream>
+#include <iterator>
 #include <string>
 #include <system_error>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 // Other headers
+#include "../include/anel_io_uring.hpp"
+#include "../include/armazem_chunks.hpp"
+#include "../include/backup.hpp"
+#include "../include/blake3.hpp"
+#include "../include/cache_diretorios.hpp"
+#include "../include/cifra.hpp"
+#include "../include/compressao.hpp"
+#include "../include/copia.hpp"
+#include "../include/delta.hpp"
+#include "../include/fila_limitada.hpp"
+#include "../include/listagem_diretorio.hpp"
+#include "../include/manifesto.hpp"
+#include "../include/manifesto_binario.hpp"
+#include "../include/metadados.hpp"
+#include "../include/pacotes.hpp"
+#include "../include/percurso_arvore.hpp"
+#include "../include/pool_buffers.hpp"
+#include "../include/pool_tarefas.hpp"
 #include "../src/catch_amalgamated.hpp"
 
 namespace fs = std::filesystem;
@@ -376,6 +407,2244 @@ TEST_CASE("Caso 10 arquivo não existe nem no HD nem no Pen",
     REQUIRE(!fs::exists(destino / "arquivo_inexistente.txt"));
 }
 
+TEST_CASE("Caso 11 motor paralelo mantém a ordem do Backup.parm",
+    "[C11]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_11";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    // Backup.parm com 300 arquivos; os de índice par existem só no HD
+    fs::path parm = base / "Backup.parm";
+    {
+        std::ofstream out(parm);
+        for (int i = 0; i < 300; ++i) {
+            std::string nome = "arq" + std::to_string(i) + ".txt";
+            out << nome << std::endl;
+            if (i % 2 == 0)
+                std::ofstream(base / "hd" / nome) << "conteudo " << i;
+        }
+    }
+
+    OpcoesBackup opcoes;
+    opcoes.numThreads = 4;
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+
+    REQUIRE(res.size() == 300);
+    bool ordemOk = true;
+    for (int i = 0; i < 300; ++i) {
+        int esperado = (i % 2 == 0) ? A1_COPIAR_HD_PEN : A6_IMPOSSIVEL;
+        if (res[i].first != "arq" + std::to_string(i) + ".txt" ||
+            res[i].second != esperado)
+            ordemOk = false;
+    }
+    REQUIRE(ordemOk);
+    REQUIRE(fs::exists(destino / "arq298.txt"));
+    REQUIRE(!fs::exists(destino / "arq299.txt"));
+
+    // Linha repetida com destino = Pen: cada repetição vê o que a
+    // anterior gravou, como na execução seguinte, e não copia de novo
+    fs::path parmRepetido = base / "Backup_repetido.parm";
+    {
+        std::ofstream out(parmRepetido);
+        for (int i = 0; i < 200; ++i)
+            out << "arq0.txt\n";
+    }
+    fs::path pen = base / "pen";
+    fs::remove(pen / "arq0.txt");
+    auto primeira = executar_backup(parm.string(), (base / "hd").string(),
+        pen.string(), pen.string(), true, opcoes);
+    auto seguinte = executar_backup(parm.string(), (base / "hd").string(),
+        pen.string(), pen.string(), true, opcoes);
+    REQUIRE(primeira[0].second == A1_COPIAR_HD_PEN);
+    for (unsigned threads : {1u, 4u}) {
+        fs::remove(pen / "arq0.txt");
+        opcoes.numThreads = threads;
+        res = executar_backup(parmRepetido.string(),
+            (base / "hd").string(), pen.string(), pen.string(), true,
+            opcoes);
+        REQUIRE(res.size() == 200);
+        REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+        int iguais = 0;
+        for (size_t i = 1; i < res.size(); ++i)
+            iguais += res[i].second == seguinte[0].second;
+        REQUIRE(iguais == 199);
+    }
+
+    // Quem aguarda um grupo sem tarefas para executar dorme, em vez de
+    // consumir a CPU até a tarefa longa terminar
+    auto cpu_thread = [] {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return std::chrono::seconds(ts.tv_sec) +
+            std::chrono::nanoseconds(ts.tv_nsec);
+    };
+    PoolTarefas pool(1);
+    GrupoTarefas grupo;
+    pool.submeter(&grupo, [] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto antes = cpu_thread();
+    pool.aguardar(&grupo);
+    REQUIRE(grupo.pendentes == 0);
+    REQUIRE(cpu_thread() - antes < std::chrono::milliseconds(100));
+}
+
+TEST_CASE("Caso 12 sondagem única de metadados por lado",
+    "[C12]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_12";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "a.txt" << std::endl << "b.txt" << std::endl;
+
+    fs::path arquivoHD = base / "hd" / "a.txt";
+    std::ofstream(arquivoHD) << "12345";
+    std::ofstream(base / "pen" / "b.txt") << "pen";
+
+    Metadados m = sondar_metadados(arquivoHD.string());
+    REQUIRE(m.existe);
+    REQUIRE(m.tamanho == 5);
+    REQUIRE(m.inode != 0);
+    REQUIRE(!sondar_metadados((base / "pen" / "a.txt").string()).existe);
+
+    EstatisticasBackup est;
+    OpcoesBackup opcoes;
+    opcoes.estatisticas = &est;
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+
+    REQUIRE(res.size() == 2);
+    REQUIRE(est.entradas == 2);
+    // Uma chamada por lado: HD e Pen
+    REQUIRE(est.chamadasMetadados == 2 * est.entradas);
+}
+
+TEST_CASE("Caso 13 lotes via io_uring com retorno ao caminho síncrono",
+    "[C13]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_13";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "grande.bin" << std::endl
+        << "igual.txt" << std::endl << "fantasma.txt" << std::endl;
+    for (int i = 0; i < 40; ++i)
+        std::ofstream(parm, std::ios::app) << "ausente" << i << std::endl;
+
+    // Arquivo maior que um pedaço de cópia do anel
+    std::string grande(300 * 1024 + 7, '\0');
+    for (size_t i = 0; i < grande.size(); ++i)
+        grande[i] = static_cast<char>(i * 31 + 7);
+    std::ofstream(base / "hd" / "grande.bin", std::ios::binary) << grande;
+
+    std::ofstream(base / "hd" / "igual.txt") << "mesmo";
+    std::ofstream(base / "pen" / "igual.txt") << "mesmo";
+    auto agora = fs::file_time_type::clock::now();
+    fs::last_write_time(base / "hd" / "igual.txt", agora);
+    fs::last_write_time(base / "pen" / "igual.txt", agora);
+
+    EstatisticasBackup est;
+    OpcoesBackup opcoes;
+    opcoes.usarIoUring = true;
+    opcoes.estatisticas = &est;
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+
+    REQUIRE(res.size() == 43);
+    REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+    REQUIRE(res[1].second == A4_NADA);
+    REQUIRE(res[2].second == A6_IMPOSSIVEL);
+
+    std::ifstream in(destino / "grande.bin", std::ios::binary);
+    std::string copiado((std::istreambuf_iterator<char>(in)),
+                        std::istreambuf_iterator<char>());
+    REQUIRE(copiado == grande);
+
+    // Com io_uring, as 86 sondagens saem em bem menos chamadas
+    if (AnelIoUring(8).disponivel())
+        REQUIRE(est.chamadasIoUring < est.chamadasMetadados);
+
+    // O arquivo mudou de tamanho depois da sondagem: a cópia vai até a
+    // leitura que devolve 0, e não até o tamanho sondado
+    AnelIoUring anel(8);
+    if (anel.disponivel()) {
+        std::vector<CopiaLote> copias(3);
+        copias[0].meta.tamanho = 1000;            // cresceu
+        copias[1].meta.tamanho = grande.size() + 4096;  // encolheu
+        copias[2].meta.tamanho = 0;               // era vazio
+        for (size_t i = 0; i < copias.size(); ++i) {
+            copias[i].origem = (base / "hd" / "grande.bin").string();
+            copias[i].destino =
+                (destino / ("lote" + std::to_string(i))).string();
+            copias[i].meta.modo = 0644;
+        }
+        std::vector<bool> copiadoLote;
+        copiar_lote_io_uring(&anel, copias, &copiadoLote);
+        for (size_t i = 0; i < copias.size(); ++i) {
+            REQUIRE(copiadoLote[i]);
+            std::ifstream lote(copias[i].destino, std::ios::binary);
+            REQUIRE(std::string(std::istreambuf_iterator<char>(lote),
+                                std::istreambuf_iterator<char>()) ==
+                    grande);
+        }
+    }
+}
+
+TEST_CASE("Caso 14 cadeia de estratégias de cópia",
+    "[C14]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_14";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "dados.bin" << std::endl;
+
+    std::string conteudo(2 * 1024 * 1024 + 3, 'x');
+    fs::path origem = base / "hd" / "dados.bin";
+    std::ofstream(origem, std::ios::binary) << conteudo;
+    fs::permissions(origem, fs::perms::owner_read | fs::perms::owner_write |
+        fs::perms::group_read);
+
+    // Destino pré-existente e maior deve ser truncado
+    std::ofstream(destino / "dados.bin") << std::string(3 * 1024 * 1024, 'y');
+
+    EstatisticasBackup est;
+    OpcoesBackup opcoes;
+    opcoes.estatisticas = &est;
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+
+    REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.estrategias.size() == 1);
+    REQUIRE(est.estrategias[0].first == "dados.bin");
+    REQUIRE(est.estrategias[0].second != COPIA_FALHOU);
+    REQUIRE(fs::file_size(destino / "dados.bin") == conteudo.size());
+    REQUIRE(fs::status(destino / "dados.bin").permissions() ==
+        fs::status(origem).permissions());
+
+    // Copiar um arquivo sobre ele mesmo falha sem truncá-lo
+    REQUIRE(copiar_arquivo(origem.string(), origem.string()) == COPIA_FALHOU);
+    REQUIRE(fs::file_size(origem) == conteudo.size());
+    REQUIRE(copiar_arquivo((base / "hd" / "nao_existe").string(),
+        (destino / "x").string()) == COPIA_FALHOU);
+}
+
+TEST_CASE("Caso 15 leitor mapeado divide linhas como std::getline",
+    "[C15]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_15";
+    fs::remove_all(base);
+    fs::create_directories(base);
+
+    // Linhas de 0 a 149 bytes, cruzando fronteiras de bloco, sem '\n' final
+    fs::path parm = base / "Backup.parm";
+    {
+        std::ofstream out(parm, std::ios::binary);
+        for (int i = 0; i < 150; ++i)
+            out << std::string(i, static_cast<char>('a' + i % 26)) << '\n';
+        out << "ultima\r";
+    }
+
+    std::vector<std::string> esperado;
+    std::ifstream in(parm);
+    for (std::string l; std::getline(in, l);)
+        esperado.push_back(l);
+
+    for (NucleoQuebras nucleo : {NucleoQuebras::ESCALAR, NucleoQuebras::SSE2,
+                                 NucleoQuebras::AVX2,
+                                 NucleoQuebras::AUTOMATICO}) {
+        LeitorManifesto leitor(parm.string(), nucleo);
+        REQUIRE(leitor.aberto());
+        std::vector<std::string> lidas;
+        std::string_view linha;
+        while (leitor.proxima_linha(&linha))
+            lidas.emplace_back(linha);
+        REQUIRE(lidas == esperado);
+    }
+
+    std::ofstream(base / "vazio.parm");
+    LeitorManifesto vazio((base / "vazio.parm").string());
+    std::string_view linha;
+    REQUIRE(vazio.aberto());
+    REQUIRE(!vazio.proxima_linha(&linha));
+    REQUIRE(!LeitorManifesto((base / "nao_existe").string()).aberto());
+}
+
+TEST_CASE("Caso 16 manifesto compilado e detecção de desatualização",
+    "[C16]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_16";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd" / "a");
+    fs::create_directories(base / "hd" / "b");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino / "a");
+    fs::create_directories(destino / "b");
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "b/x.txt\na/y.txt\n\nraiz.txt\nb/z.txt\n";
+    for (const char *nome : {"b/x.txt", "a/y.txt", "b/z.txt"})
+        std::ofstream(base / "hd" / nome) << nome;
+
+    fs::path compilado = base / "Backup.parm.bin";
+    REQUIRE(compilar_manifesto(parm.string(), compilado.string()));
+
+    ManifestoBinario bin(compilado.string(), parm.string());
+    REQUIRE(bin.valido());
+    REQUIRE(bin.numEntradas() == 4);
+    REQUIRE(bin.numDiretorios() == 3);
+    // Entradas agrupadas por diretório, em ordem: "", "a", "b"
+    EntradaCompilada e;
+    REQUIRE(bin.entrada(0, &e));
+    REQUIRE(e.nome() == "raiz.txt");
+    REQUIRE(e.ordem == 2);
+    REQUIRE(bin.entrada(3, &e));
+    REQUIRE(e.pai == "b");
+    REQUIRE(e.nome() == "b/z.txt");
+
+    EstatisticasBackup est;
+    OpcoesBackup opcoes;
+    opcoes.estatisticas = &est;
+    opcoes.manifestoCompilado = compilado.string();
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+    auto resTexto = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true);
+
+    REQUIRE(est.manifestoCompiladoUsado);
+    REQUIRE(res == resTexto);
+    REQUIRE(res[0].first == "b/x.txt");
+    REQUIRE(fs::exists(destino / "b" / "z.txt"));
+
+    // Tabela de posições corrompida: a linha 1 aponta para a entrada da
+    // linha 0; a leitura continua pelo texto a partir dela
+    {
+        std::fstream f(compilado, std::ios::in | std::ios::out |
+                                  std::ios::binary);
+        uint32_t posicao0;
+        f.seekg(40 + 3 * 4 + 4 * 12);
+        f.read(reinterpret_cast<char *>(&posicao0), sizeof(posicao0));
+        f.seekp(40 + 3 * 4 + 4 * 12 + 4);
+        f.write(reinterpret_cast<const char *>(&posicao0),
+                sizeof(posicao0));
+    }
+    res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+    REQUIRE(res == resTexto);
+
+    // Linhas absolutas continuam absolutas no binário
+    fs::path parmAbs = base / "Backup_abs.parm";
+    std::string absoluto = fs::absolute(base / "hd" / "a" / "y.txt")
+        .lexically_normal().string();
+    std::ofstream(parmAbs) << absoluto << "\nb/x.txt\n";
+    fs::path compiladoAbs = base / "Backup_abs.parm.bin";
+    REQUIRE(compilar_manifesto(parmAbs.string(), compiladoAbs.string()));
+    opcoes.manifestoCompilado = compiladoAbs.string();
+    res = executar_backup(parmAbs.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+    REQUIRE(est.manifestoCompiladoUsado);
+    resTexto = executar_backup(parmAbs.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true);
+    REQUIRE(res == resTexto);
+    REQUIRE(res[0].first == absoluto);
+    opcoes.manifestoCompilado = compilado.string();
+
+    // Texto alterado depois da compilação: volta a ler o texto
+    std::ofstream(parm, std::ios::app) << "novo.txt\n";
+    res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true, opcoes);
+    REQUIRE(!est.manifestoCompiladoUsado);
+    REQUIRE(res.size() == 5);
+    REQUIRE(res[4].first == "novo.txt");
+}
+
+TEST_CASE("Caso 17 índice de estado dispensa a sondagem do Pen",
+    "[C17]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_17";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "a.txt\nb.txt\nc.txt\n";
+    auto agora = fs::file_time_type::clock::now();
+    for (const char *nome : {"a.txt", "b.txt", "c.txt"}) {
+        std::ofstream(base / "hd" / nome) << "hd " << nome;
+        std::ofstream(base / "pen" / nome) << "pen " << nome;
+        fs::last_write_time(base / "hd" / nome, agora);
+        fs::last_write_time(base / "pen" / nome, agora);
+    }
+
+    for (bool ioUring : {false, true}) {
+        fs::remove(destino / ".backup_indice");
+        EstatisticasBackup est;
+        OpcoesBackup opcoes;
+        opcoes.estatisticas = &est;
+        opcoes.usarIndiceEstado = true;
+        opcoes.usarIoUring = ioUring;
+
+        // Primeira execução: sem índice, sonda os dois lados
+        auto res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A4_NADA);
+        REQUIRE(est.chamadasMetadados == 6);
+        REQUIRE(est.sondagensPenEvitadas == 0);
+        REQUIRE(fs::exists(destino / ".backup_indice"));
+
+        // HD de b.txt alterado: só ele volta a sondar o Pen
+        fs::last_write_time(base / "hd" / "b.txt",
+            agora + std::chrono::hours(1));
+        res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(est.sondagensPenEvitadas == 2);
+        REQUIRE(est.chamadasMetadados == 4);
+        REQUIRE(res[0].second == A4_NADA);
+        REQUIRE(res[1].second == A1_COPIAR_HD_PEN);
+        REQUIRE(res[2].second == A4_NADA);
+        fs::last_write_time(base / "hd" / "b.txt", agora);
+    }
+
+    // Destino é o próprio Pen: o índice registra o arquivo copiado, e a
+    // execução seguinte decide como se sondasse o Pen (A4, ou A5 se a
+    // cópia ficou com data posterior à do HD), sem copiá-lo de novo
+    fs::path parmNovo = base / "Backup_novo.parm";
+    std::ofstream(parmNovo) << "novo.txt\n";
+    std::ofstream(base / "hd" / "novo.txt") << "hd novo";
+    for (bool ioUring : {false, true}) {
+        fs::remove(base / "pen" / ".backup_indice");
+        fs::remove(base / "pen" / "novo.txt");
+        EstatisticasBackup est;
+        OpcoesBackup opcoes;
+        opcoes.estatisticas = &est;
+        opcoes.usarIndiceEstado = true;
+        opcoes.usarIoUring = ioUring;
+        auto res = executar_backup(parmNovo.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            (base / "pen").string(), true, opcoes);
+        REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+        int esperada = executar_backup(parmNovo.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            (base / "pen").string(), true)[0].second;
+        REQUIRE(esperada != A1_COPIAR_HD_PEN);
+        for (int execucao = 0; execucao < 2; ++execucao) {
+            res = executar_backup(parmNovo.string(),
+                (base / "hd").string(), (base / "pen").string(),
+                (base / "pen").string(), true, opcoes);
+            REQUIRE(res[0].second == esperada);
+            REQUIRE(est.sondagensPenEvitadas == 1);
+        }
+    }
+}
+
+TEST_CASE("Caso 18 BLAKE3 e verificação de conteúdo", "[C18]") {
+    namespace fs = std::filesystem;
+
+    // Vetores de referência: entrada com byte i = i % 251
+    const std::vector<std::pair<size_t, std::string>> vetores = {
+        {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+        {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+        {1024,
+         "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+        {1025,
+         "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+        {8193,
+         "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+        {102400,
+         "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"}};
+    PoolTarefas pool(4);
+    for (const auto &v : vetores) {
+        std::vector<uint8_t> dados(v.first);
+        for (size_t i = 0; i < dados.size(); ++i)
+            dados[i] = static_cast<uint8_t>(i % 251);
+        for (NucleoBlake3 nucleo : {NucleoBlake3::PORTAVEL,
+                                    NucleoBlake3::SSE2, NucleoBlake3::AVX2}) {
+            HasherBlake3 h(nullptr, nucleo);
+            h.atualizar(dados.data(), dados.size());
+            REQUIRE(hex_digest(h.finalizar()) == v.second);
+        }
+        // Em pedaços de tamanhos irregulares e com o pool
+        HasherBlake3 h(&pool);
+        for (size_t pos = 0, passo = 1; pos < dados.size();
+             passo = passo * 3 + 7) {
+            size_t n = std::min(passo, dados.size() - pos);
+            h.atualizar(dados.data() + pos, n);
+            pos += n;
+        }
+        REQUIRE(hex_digest(h.finalizar()) == v.second);
+    }
+
+    fs::path base = fs::path("tests") / "tmp_case_18";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    // Arquivo grande o bastante para o hash ser dividido entre threads
+    std::string grande(3 << 20, 'x');
+    for (size_t i = 0; i < grande.size(); i += 4096)
+        grande[i] = static_cast<char>(i / 4096);
+    std::ofstream(base / "hd" / "grande.bin", std::ios::binary) << grande;
+    DigestBlake3 lido, mapeado;
+    HasherBlake3 h;
+    h.atualizar(grande.data(), grande.size());
+    REQUIRE(blake3_arquivo((base / "hd" / "grande.bin").string(), &lido,
+                           &pool, false));
+    REQUIRE(blake3_arquivo((base / "hd" / "grande.bin").string(), &mapeado,
+                           &pool, true));
+    REQUIRE(lido == h.finalizar());
+    REQUIRE(mapeado == lido);
+
+    // tocado.txt: mesmo conteúdo, HD mais novo (só a data mudou)
+    // trocado.txt: mesma data e tamanho, conteúdo diferente
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "tocado.txt\ntrocado.txt\n";
+    auto agora = fs::file_time_type::clock::now();
+    std::ofstream(base / "hd" / "tocado.txt") << "igual";
+    std::ofstream(base / "pen" / "tocado.txt") << "igual";
+    std::ofstream(base / "hd" / "trocado.txt") << "versao A";
+    std::ofstream(base / "pen" / "trocado.txt") << "versao B";
+    fs::last_write_time(base / "hd" / "tocado.txt",
+        agora + std::chrono::hours(1));
+    fs::last_write_time(base / "pen" / "tocado.txt", agora);
+    fs::last_write_time(base / "hd" / "trocado.txt", agora);
+    fs::last_write_time(base / "pen" / "trocado.txt", agora);
+
+    auto res = executar_backup(parm.string(), (base / "hd").string(),
+        (base / "pen").string(), destino.string(), true);
+    REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+    REQUIRE(res[1].second == A4_NADA);
+
+    for (bool ioUring : {false, true}) {
+        fs::remove(destino / ".backup_indice");
+        EstatisticasBackup est;
+        OpcoesBackup opcoes;
+        opcoes.estatisticas = &est;
+        opcoes.verificarConteudo = true;
+        opcoes.usarIoUring = ioUring;
+        opcoes.verificacaoMmap = ioUring;
+
+        res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A4_NADA);
+        REQUIRE(res[1].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.arquivosHasheados == 4);
+        REQUIRE(est.bytesHasheados == 2 * (5 + 8));
+        REQUIRE(est.digestsReaproveitados == 0);
+
+        // Segunda execução: os digests vêm do índice de estado
+        res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A4_NADA);
+        REQUIRE(res[1].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.arquivosHasheados == 0);
+        REQUIRE(est.digestsReaproveitados == 4);
+
+        // Restauração com conteúdo diferente e mesma data copia do Pen
+        res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), false, opcoes);
+        REQUIRE(res[0].second == A4_NADA);
+        REQUIRE(res[1].second == A2_COPIAR_PEN_HD);
+    }
+}
+
+TEST_CASE("Caso 19 chunks FastCDC e armazém deduplicado", "[C19]") {
+    namespace fs = std::filesystem;
+
+    std::vector<uint8_t> dados(1 << 20);
+    uint64_t x = 88172645463325252ULL;
+    for (uint8_t &b : dados) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        b = static_cast<uint8_t>(x);
+    }
+
+    ParametrosCdc p;
+    p.minimo = 2048;
+    p.medio = 8192;
+    p.maximo = 32768;
+    ChunkerFastCdc chunker(p);
+    auto dividir = [&chunker](const std::vector<uint8_t> &d) {
+        std::vector<std::string> chunks;
+        for (size_t pos = 0; pos < d.size();) {
+            size_t n = chunker.proximo_corte(d.data() + pos, d.size() - pos);
+            chunks.emplace_back(d.begin() + pos, d.begin() + pos + n);
+            pos += n;
+        }
+        return chunks;
+    };
+    auto chunks = dividir(dados);
+    size_t soma = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        soma += chunks[i].size();
+        REQUIRE(chunks[i].size() <= p.maximo);
+        if (i + 1 < chunks.size())
+            REQUIRE(chunks[i].size() >= p.minimo);
+    }
+    REQUIRE(soma == dados.size());
+    REQUIRE(chunks.size() > dados.size() / p.maximo);
+
+    // Inserir bytes no meio altera só os chunks vizinhos
+    std::vector<uint8_t> alterado(dados);
+    alterado.insert(alterado.begin() + 300000, 100, 0x55);
+    auto novos = dividir(alterado);
+    std::sort(chunks.begin(), chunks.end());
+    size_t diferentes = 0;
+    for (const auto &c : novos)
+        diferentes += !std::binary_search(chunks.begin(), chunks.end(), c);
+    REQUIRE(diferentes <= 2);
+
+    fs::path base = fs::path("tests") / "tmp_case_19";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd" / "vms");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "vms/imagem.img\n";
+    fs::path imagem = base / "hd" / "vms" / "imagem.img";
+    auto gravar = [&imagem](const std::vector<uint8_t> &d) {
+        std::ofstream(imagem, std::ios::binary).write(
+            reinterpret_cast<const char *>(d.data()), d.size());
+    };
+    auto ler = [](const fs::path &c) {
+        std::ifstream in(c, std::ios::binary);
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)),
+                                    std::istreambuf_iterator<char>());
+    };
+    std::vector<uint8_t> versao(dados);
+    versao.insert(versao.end(), dados.begin(), dados.end());
+    gravar(versao);
+
+    for (bool ioUring : {false, true}) {
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        EstatisticasBackup est;
+        OpcoesBackup opcoes;
+        opcoes.estatisticas = &est;
+        opcoes.deduplicar = true;
+        opcoes.usarIoUring = ioUring;
+
+        // Metade repetida: a segunda cópia dos dados é quase toda
+        // reaproveitada
+        auto res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.estrategias[0].second == COPIA_DEDUPLICADA);
+        REQUIRE(est.bytesDeduplicados == versao.size());
+        REQUIRE(est.bytesChunksGravados < versao.size() * 3 / 4);
+        REQUIRE(est.chunksReaproveitados > 0);
+        REQUIRE_FALSE(fs::exists(destino / "vms" / "imagem.img"));
+
+        ArmazemChunks armazem(destino.string());
+        REQUIRE(armazem.restaurar("vms/imagem.img",
+                                  (base / "restaurado.img").string()));
+        REQUIRE(ler(base / "restaurado.img") == versao);
+
+        // Alteração pequena: só os chunks ao redor dela são gravados
+        std::vector<uint8_t> editada(versao);
+        for (size_t i = 0; i < 10; ++i)
+            editada[1500000 + i] ^= 0xFF;
+        gravar(editada);
+        res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.chunksNovos >= 1);
+        REQUIRE(est.bytesChunksGravados <= 2 * ParametrosCdc().maximo);
+        REQUIRE(armazem.restaurar("vms/imagem.img",
+                                  (base / "restaurado.img").string()));
+        REQUIRE(ler(base / "restaurado.img") == editada);
+        gravar(versao);
+    }
+}
+
+TEST_CASE("Caso 20 cópia delta regrava só os blocos alterados", "[C20]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_20";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    std::string dados(1 << 20, '\0');
+    uint64_t x = 88172645463325252ULL;
+    for (char &c : dados) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        c = static_cast<char>(x);
+    }
+    auto gravar = [](const fs::path &c, const std::string &d) {
+        std::ofstream(c, std::ios::binary) << d;
+    };
+    auto ler = [](const fs::path &c) {
+        std::ifstream in(c, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    fs::path origem = base / "hd" / "log.db";
+    fs::path copia = destino / "log.db";
+    const size_t bloco = tamanho_bloco_delta(dados.size());
+
+    // Acréscimo no fim: grava o acréscimo e o último bloco incompleto
+    gravar(copia, dados);
+    std::string novo = dados + std::string(65536, 'z');
+    gravar(origem, novo);
+    ResultadoDelta r;
+    REQUIRE(copiar_delta(origem.string(), copia.string(), &r) ==
+            COPIA_DELTA);
+    REQUIRE(ler(copia) == novo);
+    REQUIRE(r.tamanhoBloco == bloco);
+    REQUIRE(r.bytesEscritos <= 65536 + bloco);
+    REQUIRE(r.bytesReaproveitados >= dados.size() - bloco);
+
+    // Alteração no meio e truncamento
+    novo = dados.substr(0, 700000);
+    novo.replace(300000, 10, "0123456789");
+    gravar(origem, novo);
+    REQUIRE(copiar_delta(origem.string(), copia.string(), &r) ==
+            COPIA_DELTA);
+    REQUIRE(ler(copia) == novo);
+    REQUIRE(r.bytesEscritos <= 2 * bloco);
+
+    // Remoção no início: blocos deslocados para trás são regravados a
+    // partir do próprio destino
+    gravar(copia, dados);
+    novo = dados.substr(100, 200000) + dados.substr(200100 + 3 * bloco);
+    gravar(origem, novo);
+    REQUIRE(copiar_delta(origem.string(), copia.string(), &r) !=
+            COPIA_FALHOU);
+    REQUIRE(ler(copia) == novo);
+
+    // Inserção no início: nada pode ser aproveitado no lugar
+    gravar(copia, dados);
+    novo = "cabecalho" + dados;
+    gravar(origem, novo);
+    REQUIRE(copiar_delta(origem.string(), copia.string(), &r) !=
+            COPIA_DELTA);
+    REQUIRE(ler(copia) == novo);
+    REQUIRE(r.bytesEscritos == novo.size());
+
+    // Pelo executar_backup: HD mais novo que o Pen, destino existente
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "log.db\n";
+    gravar(base / "pen" / "log.db", dados);
+    gravar(copia, dados);
+    gravar(origem, dados + "nova linha\n");
+    auto agora = fs::file_time_type::clock::now();
+    fs::last_write_time(base / "pen" / "log.db", agora);
+    fs::last_write_time(origem, agora + std::chrono::hours(1));
+    for (bool ioUring : {false, true}) {
+        gravar(copia, dados);
+        EstatisticasBackup est;
+        OpcoesBackup opcoes;
+        opcoes.estatisticas = &est;
+        opcoes.copiaDelta = true;
+        opcoes.usarIoUring = ioUring;
+        auto res = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        REQUIRE(res[0].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.estrategias[0].second == COPIA_DELTA);
+        REQUIRE(est.bytesDeltaEscritos <= bloco + 11);
+        REQUIRE(ler(copia) == dados + "nova linha\n");
+    }
+}
+
+TEST_CASE("Caso 21 resultados entregues em fluxo, na ordem", "[C21]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_21";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    // Mais linhas que uma janela; só a última existe no HD
+    const size_t linhas = 20000;
+    fs::path parm = base / "Backup.parm";
+    {
+        std::ofstream out(parm);
+        for (size_t i = 0; i < linhas; ++i)
+            out << "dir" << i % 7 << "/ausente_" << i << ".txt\n";
+        out << "ultimo.txt\n";
+    }
+    std::ofstream(base / "hd" / "ultimo.txt") << "fim";
+    REQUIRE(compilar_manifesto(parm.string(),
+                               (base / "Backup.parm.bin").string()));
+
+    for (bool compilado : {false, true}) {
+        for (bool ioUring : {false, true}) {
+            fs::remove(destino / "ultimo.txt");
+            OpcoesBackup opcoes;
+            opcoes.usarIoUring = ioUring;
+            if (compilado)
+                opcoes.manifestoCompilado =
+                    (base / "Backup.parm.bin").string();
+
+            std::vector<std::pair<std::string, int>> recebidos;
+            bool ultimoJaCopiado = true;
+            executar_backup(parm.string(), (base / "hd").string(),
+                (base / "pen").string(), destino.string(), true, opcoes,
+                [&](const std::string &nome, int acao) {
+                    if (recebidos.empty())
+                        ultimoJaCopiado = fs::exists(destino / "ultimo.txt");
+                    recebidos.emplace_back(nome, acao);
+                });
+
+            // O primeiro resultado chegou antes de a última linha ser
+            // processada
+            REQUIRE_FALSE(ultimoJaCopiado);
+            REQUIRE(recebidos.size() == linhas + 1);
+            REQUIRE(recebidos[0].first == "dir0/ausente_0.txt");
+            REQUIRE(recebidos[12345].first == "dir4/ausente_12345.txt");
+            REQUIRE(recebidos[12345].second == A6_IMPOSSIVEL);
+            REQUIRE(recebidos.back().first == "ultimo.txt");
+            REQUIRE(recebidos.back().second == A1_COPIAR_HD_PEN);
+            REQUIRE(fs::exists(destino / "ultimo.txt"));
+
+            fs::remove(destino / "ultimo.txt");
+            REQUIRE(executar_backup(parm.string(), (base / "hd").string(),
+                (base / "pen").string(), destino.string(), true, opcoes) ==
+                recebidos);
+        }
+    }
+
+    std::vector<std::pair<std::string, int>> semParm;
+    executar_backup((base / "nao_existe.parm").string(),
+        (base / "hd").string(), (base / "pen").string(), destino.string(),
+        true, OpcoesBackup(), [&](const std::string &nome, int acao) {
+            semParm.emplace_back(nome, acao);
+        });
+    REQUIRE(semParm.size() == 1);
+    REQUIRE(semParm[0].second == A6_IMPOSSIVEL);
+}
+
+TEST_CASE("Caso 22 relatório compacto com arena de nomes", "[C22]") {
+    namespace fs = std::filesystem;
+
+    // Nomes atravessando vários blocos da arena continuam válidos
+    RelatorioBackup grande;
+    std::vector<std::pair<std::string, int>> vetorGrande;
+    const size_t n = 100000;
+    for (size_t i = 0; i < n; ++i) {
+        std::string nome = "projeto/modulo/arquivo_numero_" +
+            std::to_string(i) + ".txt";
+        grande.adicionar(nome, 1 + i % 6);
+        vetorGrande.emplace_back(std::move(nome), 1 + i % 6);
+    }
+    REQUIRE(grande.tamanho() == n);
+    REQUIRE(grande.nome(0) == "projeto/modulo/arquivo_numero_0.txt");
+    REQUIRE(grande.nome(n - 1) == vetorGrande[n - 1].first);
+    REQUIRE(grande.diretorio(5) == "projeto/modulo");
+    REQUIRE(grande.base(5) == "arquivo_numero_5.txt");
+    REQUIRE(grande.numDiretorios() == 1);
+    REQUIRE(grande.acao(7) == 2);
+    REQUIRE(grande.contar(A1_COPIAR_HD_PEN) == n / 6 + (n % 6 > 0));
+    REQUIRE(grande.bytesTotais() == 0);
+    // O vetor de pares paga 40 bytes por par mais a alocação de cada nome
+    // longo (ao menos 48 bytes na glibc)
+    size_t memoriaVetor = vetorGrande.capacity() *
+        sizeof(vetorGrande[0]) + n * 48;
+    REQUIRE(grande.memoria() * 2 < memoriaVetor);
+
+    fs::path base = fs::path("tests") / "tmp_case_22";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "novo.txt\nigual.txt\nfalta.txt\n";
+    std::ofstream(base / "hd" / "novo.txt") << std::string(1000, 'n');
+    std::ofstream(base / "hd" / "igual.txt") << "igual";
+    std::ofstream(base / "pen" / "igual.txt") << "igual";
+    auto agora = fs::file_time_type::clock::now();
+    fs::last_write_time(base / "hd" / "igual.txt", agora);
+    fs::last_write_time(base / "pen" / "igual.txt", agora);
+
+    for (bool ioUring : {false, true}) {
+        OpcoesBackup opcoes;
+        opcoes.usarIoUring = ioUring;
+        auto vetor = executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+        RelatorioBackup r = executar_backup_relatorio(parm.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), true, opcoes, true);
+        REQUIRE(r.detalhado());
+        REQUIRE(r.tamanho() == vetor.size());
+        for (size_t i = 0; i < vetor.size(); ++i) {
+            REQUIRE(r.nome(i) == vetor[i].first);
+            REQUIRE(r.acao(i) == vetor[i].second);
+        }
+        REQUIRE(r.bytes(0) == 1000);
+        REQUIRE(r.bytes(1) == 0);
+        REQUIRE(r.bytesTotais() == 1000);
+        REQUIRE(r.duracaoNs(0) > 0);
+        REQUIRE(r.contar(A6_IMPOSSIVEL) == 1);
+
+        RelatorioBackup simples = executar_backup_relatorio(parm.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), true, opcoes);
+        REQUIRE_FALSE(simples.detalhado());
+        REQUIRE(simples.bytes(0) == 0);
+        REQUIRE(simples.colunaBytes().empty());
+        REQUIRE(simples.acoes() == r.acoes());
+    }
+}
+
+TEST_CASE("Caso 23 cache de diretórios abertos", "[C23]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_23";
+    fs::remove_all(base);
+    for (const char *d : {"hd/a/b", "hd/c", "pen/a/b", "pen/c"})
+        fs::create_directories(base / d);
+    fs::path destino = base / "backup-destino";
+    for (const char *d : {"a/b", "c"})
+        fs::create_directories(destino / d);
+    std::ofstream(base / "hd" / "a" / "b" / "x.txt") << "x";
+    std::ofstream(base / "hd" / "c" / "y.txt") << "y";
+    std::ofstream(base / "hd" / "raiz.txt") << "r";
+    std::ofstream(base / "pen" / "c" / "z.txt") << "z";
+    const std::string hd = (base / "hd").string();
+
+    // Ancestrais abertos uma vez e compartilhados; LRU limitado
+    CacheDiretorios cache(3);
+    REQUIRE(cache.sondar(hd, "a/b/x.txt").tamanho == 1);
+    REQUIRE(cache.estatisticas().aberturas == 3);  // raiz, a, a/b
+    DiretorioAberto ab = cache.abrir(hd, "a/b");
+    REQUIRE(ab != nullptr);
+    REQUIRE(cache.estatisticas().acertos >= 1);
+    REQUIRE(cache.sondar(hd, "c/y.txt").existe);
+    REQUIRE(cache.tamanho() == 3);
+    REQUIRE(cache.estatisticas().descartes == 1);
+    // Um diretório descartado segue válido para quem o segura
+    REQUIRE(sondar_metadados_em(ab->fd(), "x.txt").existe);
+    REQUIRE_FALSE(cache.sondar(hd, "nao/existe/w.txt").existe);
+    REQUIRE_FALSE(cache.sondar(hd, "raiz.txt/w.txt").existe);
+    REQUIRE(cache.abrir(hd, "nao") == nullptr);
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "a/b/x.txt\nc/y.txt\nraiz.txt\nc/z.txt\n"
+                           "a/ausente.txt\n";
+    auto executar = [&](size_t capacidade, bool ioUring,
+                        EstatisticasBackup *est) {
+        for (const char *n : {"a/b/x.txt", "c/y.txt", "raiz.txt"})
+            fs::remove(destino / n);
+        OpcoesBackup opcoes;
+        opcoes.cacheDiretorios = capacidade;
+        opcoes.usarIoUring = ioUring;
+        opcoes.estatisticas = est;
+        return executar_backup(parm.string(), hd, (base / "pen").string(),
+                               destino.string(), true, opcoes);
+    };
+    auto esperado = executar(0, false, nullptr);
+    REQUIRE(esperado[0].second == A1_COPIAR_HD_PEN);
+    REQUIRE(esperado.size() == 5);
+    for (bool ioUring : {false, true}) {
+        for (size_t capacidade : {size_t(1), size_t(64)}) {
+            EstatisticasBackup est;
+            REQUIRE(executar(capacidade, ioUring, &est) == esperado);
+            REQUIRE(est.diretoriosAbertos > 0);
+            std::ifstream in(destino / "a" / "b" / "x.txt");
+            std::string conteudo;
+            in >> conteudo;
+            REQUIRE(conteudo == "x");
+            REQUIRE(fs::exists(destino / "raiz.txt"));
+            if (capacidade == 64)
+                REQUIRE(est.acertosCacheDiretorios > 0);
+        }
+    }
+}
+
+TEST_CASE("Caso 24 listagem de diretórios no lugar de sondagens",
+          "[C24]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_24";
+    fs::remove_all(base);
+    for (const char *d : {"hd/denso", "hd/grande", "pen/denso"})
+        fs::create_directories(base / d);
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino / "denso");
+    fs::create_directories(destino / "grande");
+    for (int i = 0; i < 4; ++i)
+        std::ofstream(base / "hd" / "denso" / ("f" + std::to_string(i)))
+            << i;
+    std::ofstream(base / "pen" / "denso" / "f0") << 0;
+    for (int i = 0; i < 300; ++i)
+        std::ofstream(base / "hd" / "grande" / ("g" + std::to_string(i)));
+
+    ListagemDiretorio listagem;
+    REQUIRE(listagem.ler(AT_FDCWD, (base / "hd" / "denso").c_str()));
+    REQUIRE(listagem.tamanho() == 4);
+    REQUIRE(listagem.contem("f3"));
+    REQUIRE_FALSE(listagem.contem("f"));
+    REQUIRE_FALSE(listagem.contem("."));
+    REQUIRE_FALSE(listagem.ler(AT_FDCWD, (base / "nada").c_str()));
+    REQUIRE(vale_enumerar(6, 4096));
+    REQUIRE_FALSE(vale_enumerar(1, 4096));
+    REQUIRE_FALSE(vale_enumerar(2, 64 * 1024));
+
+    // denso: 6 linhas, 4 existem no HD e 1 no Pen; grande: 1 linha em
+    // 300 entradas; sem_pai: diretório inexistente nos dois lados
+    fs::path parm = base / "Backup.parm";
+    {
+        std::ofstream out(parm);
+        for (int i = 0; i < 6; ++i)
+            out << "denso/f" << i << "\n";
+        out << "grande/g7\nsem_pai/a\nsem_pai/b\n";
+    }
+    auto executar = [&](bool enumerar, bool ioUring,
+                        EstatisticasBackup *est) {
+        fs::remove_all(destino / "denso");
+        fs::remove_all(destino / "grande");
+        fs::create_directories(destino / "denso");
+        fs::create_directories(destino / "grande");
+        OpcoesBackup opcoes;
+        opcoes.enumerarDiretorios = enumerar;
+        opcoes.usarIoUring = ioUring;
+        opcoes.estatisticas = est;
+        return executar_backup(parm.string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), true, opcoes);
+    };
+    EstatisticasBackup semListagem;
+    auto esperado = executar(false, false, &semListagem);
+    REQUIRE(esperado.size() == 9);
+    REQUIRE(esperado[3].second == A1_COPIAR_HD_PEN);
+    REQUIRE(semListagem.chamadasMetadados == 18);
+
+    for (bool ioUring : {false, true}) {
+        EstatisticasBackup est;
+        REQUIRE(executar(true, ioUring, &est) == esperado);
+        REQUIRE(fs::exists(destino / "denso" / "f3"));
+        REQUIRE(fs::exists(destino / "grande" / "g7"));
+        // Listados: denso no HD e no Pen; grande fica para a sondagem
+        REQUIRE(est.diretoriosListados == 2);
+        // denso: 2 no HD e 5 no Pen; grande não existe no Pen; sem_pai:
+        // 2 em cada lado
+        REQUIRE(est.sondagensEvitadasListagem == 12);
+        REQUIRE(est.chamadasMetadados == 18 - 12);
+    }
+
+    // Destino = Pen: denso/f1, copiado na primeira janela, volta na
+    // segunda; a listagem guardada de denso não pode mais dizê-lo ausente
+    fs::path parmRepetido = base / "Backup_repetido.parm";
+    {
+        std::ofstream out(parmRepetido);
+        for (int i = 0; i < 6; ++i)
+            out << "denso/f" << i << "\n";
+        for (int i = 0; i < 8192; ++i)
+            out << "sem_pai/" << i << "\n";
+        out << "denso/f1\n";
+    }
+    std::vector<std::pair<std::string, int>> semCache;
+    for (bool enumerar : {false, true}) {
+        fs::remove_all(base / "pen_destino");
+        fs::copy(base / "pen", base / "pen_destino",
+                 fs::copy_options::recursive);
+        OpcoesBackup opcoes;
+        opcoes.enumerarDiretorios = enumerar;
+        std::string pen = (base / "pen_destino").string();
+        auto res = executar_backup(parmRepetido.string(),
+            (base / "hd").string(), pen, pen, true, opcoes);
+        REQUIRE(res.size() == 6 + 8192 + 1);
+        REQUIRE(res[1].second == A1_COPIAR_HD_PEN);
+        REQUIRE(res.back().second != A1_COPIAR_HD_PEN);
+        if (!enumerar)
+            semCache = res;
+        else
+            REQUIRE(res == semCache);
+    }
+}
+
+TEST_CASE("Caso 25 linhas de diretório e padrões no Backup.parm",
+          "[C25]") {
+    namespace fs = std::filesystem;
+
+    REQUIRE(eh_padrao("proj/"));
+    REQUIRE(eh_padrao("src/*.cpp"));
+    REQUIRE_FALSE(eh_padrao("proj/a.txt"));
+    REQUIRE(casar_padrao("**/*.log", "a/b/c.log"));
+    REQUIRE(casar_padrao("**/*.log", "c.log"));
+    REQUIRE(casar_padrao("d/**", "d/x/y"));
+    REQUIRE(casar_padrao("src/?.[ch]", "src/a.h"));
+    REQUIRE_FALSE(casar_padrao("src/*.cpp", "src/a/b.cpp"));
+    REQUIRE_FALSE(casar_padrao("**/*.log", "a/b.txt"));
+
+    fs::path base = fs::path("tests") / "tmp_case_25";
+    fs::remove_all(base);
+    for (const char *d : {"hd/proj/sub/deep", "hd/outros", "pen/proj/sub"})
+        fs::create_directories(base / d);
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+    for (const char *n : {"proj/.oculto", "proj/a.txt", "proj/sub/b.log",
+                          "proj/sub/deep/c.log", "outros/e.log",
+                          "solto.txt"})
+        std::ofstream(base / "hd" / n) << n;
+    for (const char *n : {"proj/a.txt", "proj/so_pen.log", "proj/sub/d.log"})
+        std::ofstream(base / "pen" / n) << n;
+    fs::last_write_time(base / "pen" / "proj" / "a.txt",
+        fs::last_write_time(base / "hd" / "proj" / "a.txt") -
+        std::chrono::hours(1));
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "proj/\n**/*.log\nsolto.txt\nnada/\n";
+    const std::vector<std::string> nomes = {
+        "proj/.oculto", "proj/a.txt", "proj/sub/b.log",
+        "proj/sub/deep/c.log", "proj/so_pen.log", "proj/sub/d.log",
+        "outros/e.log", "proj/sub/b.log", "proj/sub/deep/c.log",
+        "proj/so_pen.log", "proj/sub/d.log", "solto.txt"};
+
+    std::vector<std::pair<std::string, int>> anterior;
+    for (bool ioUring : {false, true}) {
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.usarIoUring = ioUring;
+        opcoes.estatisticas = &est;
+        auto resultado = executar_backup(parm.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), true, opcoes);
+        REQUIRE(resultado.size() == nomes.size());
+        for (size_t i = 0; i < nomes.size(); ++i)
+            REQUIRE(resultado[i].first == nomes[i]);
+        REQUIRE(resultado[1].second == A1_COPIAR_HD_PEN);
+        REQUIRE(est.arquivosExpandidos == 11);
+        // Os diretórios pai das entradas expandidas são criados
+        std::ifstream in(destino / "proj" / "sub" / "deep" / "c.log");
+        std::string conteudo;
+        in >> conteudo;
+        REQUIRE(conteudo == "proj/sub/deep/c.log");
+        REQUIRE(fs::exists(destino / "outros" / "e.log"));
+        REQUIRE(fs::exists(destino / "solto.txt"));
+        if (ioUring)
+            REQUIRE(resultado == anterior);
+        anterior = resultado;
+    }
+}
+
+TEST_CASE("Caso 26 percurso paralelo das linhas-padrão", "[C26]") {
+    namespace fs = std::filesystem;
+
+    // Fila limitada: cheia e vazia, e nada se perde entre vários
+    // produtores e consumidores
+    FilaLimitada<int> pequena(3);
+    REQUIRE(pequena.capacidade() == 4);
+    int v = 0;
+    REQUIRE_FALSE(pequena.retirar(&v));
+    for (int i = 0; i < 4; ++i)
+        REQUIRE(pequena.inserir(int(i)));
+    REQUIRE_FALSE(pequena.inserir(99));
+    REQUIRE(pequena.retirar(&v));
+    REQUIRE(v == 0);
+
+    FilaLimitada<int> fila(64);
+    std::atomic<long> soma{0};
+    std::atomic<int> produtoresAtivos{4};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 4; ++p)
+        threads.emplace_back([&, p] {
+            for (int i = 1; i <= 5000; ++i)
+                while (!fila.inserir(p * 5000 + i))
+                    std::this_thread::yield();
+            --produtoresAtivos;
+        });
+    for (int c = 0; c < 3; ++c)
+        threads.emplace_back([&] {
+            int x;
+            while (produtoresAtivos > 0 || fila.ocupacao() > 0)
+                if (fila.retirar(&x))
+                    soma += x;
+                else
+                    std::this_thread::yield();
+        });
+    for (auto &t : threads)
+        t.join();
+    REQUIRE(soma == 20000L * 20001 / 2);
+
+    fs::path base = fs::path("tests") / "tmp_case_26";
+    fs::remove_all(base);
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+    for (int d = 0; d < 20; ++d) {
+        std::string dir = "arv/d" + std::to_string(d % 4) + "/s" +
+            std::to_string(d);
+        fs::create_directories(base / "hd" / dir);
+        fs::create_directories(base / "pen" / dir);
+        for (int f = 0; f < 5; ++f) {
+            std::string n = dir + "/f" + std::to_string(f) +
+                (f % 2 ? ".log" : ".txt");
+            std::ofstream(base / (f < 4 ? "hd" : "pen") / n) << n;
+        }
+    }
+
+    // Mesmo conjunto de arquivos que o percurso sequencial
+    std::vector<std::string> sequencial, paralelo;
+    std::string nome;
+    PercursoArvore arvore((base / "hd").string(), "arv");
+    while (arvore.proximo(&nome))
+        sequencial.push_back(nome);
+    {
+        PoolTarefas pool(3);
+        PercursoParalelo percurso(&pool, 8);
+        percurso.iniciar((base / "hd").string(), "arv");
+        while (percurso.proximo(&nome))
+            paralelo.push_back(nome);
+        REQUIRE(percurso.diretoriosLidos() == 25);
+    }
+    REQUIRE(sequencial.size() == 80);
+    std::sort(sequencial.begin(), sequencial.end());
+    std::sort(paralelo.begin(), paralelo.end());
+    REQUIRE(paralelo == sequencial);
+
+    // Abandonado no meio, o percurso cancela as tarefas restantes
+    {
+        PoolTarefas pool(2);
+        PercursoParalelo percurso(&pool, 2);
+        percurso.iniciar((base / "hd").string(), "");
+        REQUIRE(percurso.proximo(&nome));
+    }
+
+    fs::path parm = base / "Backup.parm";
+    std::ofstream(parm) << "arv/\n**/*.log\n";
+    std::vector<std::pair<std::string, int>> esperado;
+    for (unsigned threads : {0u, 3u})
+        for (bool ioUring : {false, true}) {
+            fs::remove_all(destino);
+            fs::create_directories(destino);
+            OpcoesBackup opcoes;
+            EstatisticasBackup est;
+            opcoes.threadsPercurso = threads;
+            opcoes.usarIoUring = ioUring;
+            opcoes.estatisticas = &est;
+            auto resultado = executar_backup(parm.string(),
+                (base / "hd").string(), (base / "pen").string(),
+                destino.string(), true, opcoes);
+            REQUIRE(resultado.size() == 100 + 40);
+            REQUIRE(est.arquivosExpandidos == 140);
+            REQUIRE(est.diretoriosPercorridos == 2 * (25 + 26));
+            REQUIRE(fs::exists(destino / "arv" / "d3" / "s19" / "f3.log"));
+            std::sort(resultado.begin(), resultado.end());
+            if (esperado.empty())
+                esperado = resultado;
+            REQUIRE(resultado == esperado);
+        }
+}
+
+TEST_CASE("Caso 27 pipeline metadados, decisão e cópia", "[C27]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_27";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::path parm = base / "Backup.parm";
+    {
+        std::ofstream out(parm);
+        auto agora = fs::file_time_type::clock::now();
+        // i % 5: só no HD, HD mais novo, Pen mais novo, iguais, só no Pen
+        for (int i = 0; i < 300; ++i) {
+            std::string n = "f" + std::to_string(i);
+            out << n << "\n";
+            if (i % 5 != 4)
+                std::ofstream(base / "hd" / n) << "hd " << n;
+            if (i % 5 == 0)
+                continue;
+            std::ofstream(base / "pen" / n) << "pen " << n;
+            if (i % 5 == 4)
+                continue;
+            fs::last_write_time(base / "hd" / n, agora);
+            fs::last_write_time(base / "pen" / n, agora +
+                std::chrono::hours(i % 5 == 1 ? -1 : i % 5 == 2 ? 1 : 0));
+        }
+        out << "nenhum\n";
+    }
+
+    for (bool backup : {true, false}) {
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        auto esperado = executar_backup(parm.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), backup);
+        REQUIRE(esperado.back().second == A6_IMPOSSIVEL);
+
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.pipeline = true;
+        opcoes.trabalhadoresMetadados = 2;
+        opcoes.trabalhadoresCopia = 3;
+        opcoes.capacidadeFilaPipeline = 2;  // força a contrapressão
+        opcoes.estatisticas = &est;
+        auto resultado = executar_backup(parm.string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), backup, opcoes);
+        REQUIRE(resultado == esperado);
+
+        size_t copias = 0;
+        for (const auto &r : resultado)
+            copias += r.second == A1_COPIAR_HD_PEN ||
+                r.second == A2_COPIAR_PEN_HD;
+        REQUIRE(copias == 120);
+        std::ifstream in(destino / (backup ? "f1" : "f2"));
+        std::string lado;
+        in >> lado;
+        REQUIRE(lado == (backup ? "hd" : "pen"));
+
+        REQUIRE(est.estagios[0].trabalhadores == 2);
+        REQUIRE(est.estagios[1].trabalhadores == 1);
+        REQUIRE(est.estagios[2].trabalhadores == 3);
+        REQUIRE(est.estagios[0].itens == 301);
+        REQUIRE(est.estagios[1].itens == 301);
+        REQUIRE(est.estagios[2].itens == copias);
+        for (const EstatisticasEstagio &e : est.estagios) {
+            REQUIRE(e.capacidadeFila == 2);
+            REQUIRE(e.filaPico <= 2);
+            REQUIRE(e.filaMedia <= 2);
+            REQUIRE(e.utilizacao >= 0);
+            REQUIRE(e.utilizacao <= 1);
+        }
+    }
+
+    // Relatório detalhado: duração medida do primeiro estágio ao fim
+    OpcoesBackup opcoes;
+    opcoes.pipeline = true;
+    RelatorioBackup relatorio = executar_backup_relatorio(parm.string(),
+        (base / "hd").string(), (base / "pen").string(),
+        destino.string(), true, opcoes, true);
+    REQUIRE(relatorio.tamanho() == 301);
+    REQUIRE(relatorio.duracaoNs(0) > 0);
+}
+
+TEST_CASE("Caso 28 escalonamento da cópia por tamanho", "[C28]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_28";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+
+    auto conteudo = [](size_t tamanho, unsigned semente) {
+        std::string s(tamanho, '\0');
+        for (size_t i = 0; i < tamanho; ++i)
+            s[i] = static_cast<char>((i * 2654435761u + semente) >> 13);
+        return s;
+    };
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+
+    // Intervalos copiados em qualquer ordem formam o arquivo inteiro
+    std::ofstream(base / "hd" / "g0", std::ios::binary) <<
+        conteudo(1000000, 0);
+    {
+        CopiaParticionada copia;
+        REQUIRE(copia.abrir(AT_FDCWD, (base / "hd" / "g0").c_str(),
+                            AT_FDCWD, (base / "avulso").c_str()));
+        REQUIRE(copia.tamanho() == 1000000);
+        REQUIRE(copia.copiar_intervalo(600000, 1000000));
+        REQUIRE(copia.copiar_intervalo(0, 600000));
+        REQUIRE(copia.concluir() == COPIA_PARTICIONADA);
+        REQUIRE(ler(base / "avulso") == ler(base / "hd" / "g0"));
+    }
+    {
+        CopiaParticionada copia;
+        REQUIRE_FALSE(copia.abrir(AT_FDCWD, (base / "nada").c_str(),
+                                  AT_FDCWD, (base / "avulso").c_str()));
+        REQUIRE(copia.concluir() == COPIA_FALHOU);
+        CopiaParticionada mesmo;
+        REQUIRE_FALSE(mesmo.abrir(AT_FDCWD, (base / "avulso").c_str(),
+                                  AT_FDCWD, (base / "avulso").c_str()));
+    }
+
+    // Três arquivos grandes no HD, um só no Pen e 200 pequenos
+    const size_t tamanhos[3] = {1000000, 1 << 20, 3000001};
+    std::ofstream parm(base / "Backup.parm");
+    for (unsigned g = 0; g < 3; ++g) {
+        std::string n = "g" + std::to_string(g);
+        std::ofstream(base / "hd" / n, std::ios::binary) <<
+            conteudo(tamanhos[g], g);
+        parm << n << "\n";
+    }
+    std::ofstream(base / "pen" / "gpen", std::ios::binary) <<
+        conteudo(2500000, 7);
+    parm << "gpen\n";
+    for (int i = 0; i < 200; ++i) {
+        std::string n = "p" + std::to_string(i);
+        std::ofstream(base / "hd" / n) << n;
+        parm << n << "\n";
+    }
+    parm.close();
+
+    for (bool backup : {true, false}) {
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.pipeline = true;
+        opcoes.trabalhadoresCopia = 2;
+        opcoes.trabalhadoresGrandes = 2;
+        opcoes.limiteArquivoGrande = 1000000;
+        opcoes.tamanhoParteCopia = 300000;
+        opcoes.capacidadeFilaPipeline = 4;  // partes também copiadas
+        opcoes.estatisticas = &est;          // por quem abriu o arquivo
+        auto resultado = executar_backup(
+            (base / "Backup.parm").string(), (base / "hd").string(),
+            (base / "pen").string(), destino.string(), backup, opcoes);
+        REQUIRE(resultado.size() == 204);
+
+        size_t grandes = 0;
+        for (const auto &e : est.estrategias)
+            grandes += e.second == COPIA_PARTICIONADA;
+        if (backup) {
+            for (unsigned g = 0; g < 3; ++g) {
+                std::string n = "g" + std::to_string(g);
+                REQUIRE(ler(destino / n) == ler(base / "hd" / n));
+            }
+            REQUIRE(ler(destino / "p7") == "p7");
+            REQUIRE(est.copiasGrandes == 3);
+            REQUIRE(est.partesCopia == 4 + 4 + 11);
+            REQUIRE(est.estagios[2].trabalhadores == 4);
+            REQUIRE(est.estagios[2].itens == 203);
+        } else {
+            REQUIRE(ler(destino / "gpen") == ler(base / "pen" / "gpen"));
+            REQUIRE(est.copiasGrandes == 1);
+            REQUIRE(est.partesCopia == 9);
+        }
+        REQUIRE(grandes == est.copiasGrandes);
+    }
+}
+
+TEST_CASE("Caso 29 cópia paralela de arquivos grandes", "[C29]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_29";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    fs::path destino = base / "backup-destino";
+    fs::create_directories(destino);
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    std::string dados(5000000, '\0');
+    for (size_t i = 0; i < dados.size(); ++i)
+        dados[i] = static_cast<char>(i * 131 + (i >> 12));
+    std::ofstream(base / "hd" / "grande", std::ios::binary) << dados;
+    fs::permissions(base / "hd" / "grande", fs::perms::owner_read |
+                    fs::perms::group_read);
+    std::ofstream(base / "hd" / "vazio");
+
+    // Partes no pool, temporário pré-alocado renomeado sobre o destino
+    PoolTarefas pool(3);
+    std::ofstream(destino / "antigo") << "conteudo anterior";
+    REQUIRE(copiar_arquivo_em_partes(AT_FDCWD,
+        (base / "hd" / "grande").c_str(), AT_FDCWD,
+        (destino / "antigo").c_str(), &pool, 1 << 20) ==
+        COPIA_PARTICIONADA);
+    REQUIRE(ler(destino / "antigo") == dados);
+    REQUIRE(fs::status(destino / "antigo").permissions() ==
+            (fs::perms::owner_read | fs::perms::group_read));
+    REQUIRE_FALSE(fs::exists(destino / "antigo.parcial"));
+    REQUIRE(copiar_arquivo_em_partes(AT_FDCWD,
+        (base / "hd" / "vazio").c_str(), AT_FDCWD,
+        (destino / "vazio").c_str(), &pool, 1 << 20) == COPIA_PARTICIONADA);
+    REQUIRE(fs::file_size(destino / "vazio") == 0);
+
+    // Falha ao abrir a origem: o destino anterior fica intacto
+    std::ofstream(destino / "mantido") << "mantido";
+    REQUIRE(copiar_arquivo_em_partes(AT_FDCWD,
+        (base / "hd" / "nada").c_str(), AT_FDCWD,
+        (destino / "mantido").c_str(), &pool, 1 << 20) == COPIA_FALHOU);
+    REQUIRE(ler(destino / "mantido") == "mantido");
+    REQUIRE_FALSE(fs::exists(destino / "mantido.parcial"));
+
+    // Um intervalo que passa do fim da origem faz a cópia inteira falhar
+    {
+        CopiaParticionada copia;
+        REQUIRE(copia.abrir(AT_FDCWD, (base / "hd" / "grande").c_str(),
+                            AT_FDCWD, (destino / "mantido").c_str()));
+        REQUIRE(fs::exists(destino / "mantido.parcial"));
+        REQUIRE(fs::file_size(destino / "mantido.parcial") == dados.size());
+        REQUIRE_FALSE(copia.copiar_intervalo(0, dados.size() + 10));
+        REQUIRE(copia.concluir() == COPIA_FALHOU);
+    }
+    REQUIRE(ler(destino / "mantido") == "mantido");
+    REQUIRE_FALSE(fs::exists(destino / "mantido.parcial"));
+
+    // Pelo executar_backup, com o pool e com o pipeline
+    std::ofstream(base / "Backup.parm") << "grande\nvazio\n";
+    for (bool pipeline : {false, true}) {
+        fs::remove_all(destino);
+        fs::create_directories(destino);
+        OpcoesBackup opcoes;
+        EstatisticasBackup est;
+        opcoes.numThreads = 2;
+        opcoes.pipeline = pipeline;
+        opcoes.limiteArquivoGrande = 1;
+        opcoes.tamanhoParteCopia = 1 << 20;
+        opcoes.estatisticas = &est;
+        auto resultado = executar_backup((base / "Backup.parm").string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), true, opcoes);
+        REQUIRE(resultado.size() == 2);
+        REQUIRE(resultado[0].second == A1_COPIAR_HD_PEN);
+        REQUIRE(ler(destino / "grande") == dados);
+        REQUIRE(est.copiasGrandes == 1);
+        REQUIRE(est.partesCopia == 5);
+        REQUIRE(est.estrategias.size() == 2);
+        for (const auto &e : est.estrategias)
+            REQUIRE((e.second == COPIA_PARTICIONADA) ==
+                    (e.first == "grande"));
+    }
+}
+
+TEST_CASE("Caso 30 empacotamento de arquivos pequenos", "[C30]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_30";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    std::ofstream(base / "hd" / "p1") << "primeiro";
+    std::ofstream(base / "hd" / "p2") << "segundo arquivo";
+    std::string grande(100000, 'g');
+    std::ofstream(base / "hd" / "grande") << grande;
+    std::ofstream(base / "Backup.parm") << "p1\np2\ngrande\n";
+
+    // O Pen é o próprio destino: os pequenos vão para um pacote
+    auto executar = [&](bool backup, const fs::path &destino,
+                        EstatisticasBackup *est) {
+        OpcoesBackup opcoes;
+        opcoes.numThreads = 2;
+        opcoes.empacotarAte = 1000;
+        opcoes.estatisticas = est;
+        return executar_backup((base / "Backup.parm").string(),
+            (base / "hd").string(), (base / "pen").string(),
+            destino.string(), backup, opcoes);
+    };
+    EstatisticasBackup est;
+    auto resultado = executar(true, base / "pen", &est);
+    REQUIRE(resultado.size() == 3);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.arquivosEmpacotados == 2);
+    REQUIRE(est.bytesEmpacotados == 8 + 15);
+    REQUIRE(est.pacotesCriados == 1);
+    for (const auto &e : est.estrategias)
+        REQUIRE((e.second == COPIA_EMPACOTADA) == (e.first != "grande"));
+    REQUIRE_FALSE(fs::exists(base / "pen" / "p1"));
+    REQUIRE(ler(base / "pen" / "grande") == grande);
+    {
+        LeitorPacotes leitor((base / "pen").string());
+        REQUIRE(leitor.tamanho() == 2);
+        REQUIRE(leitor.buscar("p2") != nullptr);
+        REQUIRE(leitor.buscar("p2")->tamanho == 15);
+        REQUIRE(leitor.buscar("grande") == nullptr);
+    }
+
+    // Os arquivos dos pacotes contam como presentes no Pen, com a data
+    // do HD registrada
+    resultado = executar(true, base / "pen", &est);
+    REQUIRE(resultado[0].second == A4_NADA);
+    REQUIRE(resultado[1].second == A4_NADA);
+    REQUIRE(est.pacotesCriados == 0);
+
+    // Um arquivo alterado vai para um pacote novo e o substitui
+    std::ofstream(base / "hd" / "p1") << "alterado";
+    fs::last_write_time(base / "hd" / "p1",
+        fs::file_time_type::clock::now() + std::chrono::hours(1));
+    resultado = executar(true, base / "pen", &est);
+    REQUIRE(resultado[0].second == A1_COPIAR_HD_PEN);
+    REQUIRE(resultado[1].second == A4_NADA);
+    REQUIRE(est.pacotesCriados == 1);
+    REQUIRE(fs::exists(base / "pen" / ".pacotes" / "pacote-000001.dat"));
+
+    // Restauração: A2 extrai dos pacotes
+    fs::remove(base / "hd" / "p1");
+    fs::remove(base / "hd" / "p2");
+    resultado = executar(false, base / "hd", &est);
+    REQUIRE(resultado[0].second == A2_COPIAR_PEN_HD);
+    REQUIRE(resultado[1].second == A2_COPIAR_PEN_HD);
+    REQUIRE(est.arquivosDesempacotados == 2);
+    REQUIRE(ler(base / "hd" / "p1") == "alterado");
+    REQUIRE(ler(base / "hd" / "p2") == "segundo arquivo");
+    REQUIRE_FALSE(fs::exists(base / "hd" / ".pacotes"));
+
+    // Índice com um registro incompleto no fim: o resto é aproveitado
+    std::ofstream(base / "pen" / ".pacotes" / "indice",
+                  std::ios::binary | std::ios::app) << "lixo";
+    LeitorPacotes leitor((base / "pen").string());
+    REQUIRE(leitor.tamanho() == 2);
+    REQUIRE(leitor.extrair("p1", (base / "extraido").string()));
+    REQUIRE(ler(base / "extraido") == "alterado");
+    REQUIRE_FALSE(leitor.extrair("nada", (base / "extraido").string()));
+
+    // p2 alterado: os substituídos (p1 e p2 antigos, 23 bytes) passam dos
+    // vigentes (13) e os pacotes são regravados em um só
+    std::ofstream(base / "hd" / "p2") << "p2 v2";
+    fs::last_write_time(base / "hd" / "p2",
+        fs::file_time_type::clock::now() + std::chrono::hours(2));
+    resultado = executar(true, base / "pen", &est);
+    REQUIRE(resultado[0].second != A1_COPIAR_HD_PEN);
+    REQUIRE(resultado[1].second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.bytesPacotesLiberados == 23);
+    size_t arquivosPacote = 0;
+    for (const auto &e :
+         fs::directory_iterator(base / "pen" / ".pacotes")) {
+        std::string nome = e.path().filename().string();
+        if (nome.compare(0, 7, "pacote-") == 0) {
+            ++arquivosPacote;
+            REQUIRE(e.file_size() == 8 + 5);
+        }
+    }
+    REQUIRE(arquivosPacote == 1);
+    REQUIRE(fs::file_size(base / "pen" / ".pacotes" / "indice") ==
+            8 + 2 * 34 + 2 + 2);
+    LeitorPacotes compactado((base / "pen").string());
+    REQUIRE(compactado.tamanho() == 2);
+    REQUIRE(compactado.extrair("p1", (base / "extraido").string()));
+    REQUIRE(ler(base / "extraido") == "alterado");
+    REQUIRE(compactado.extrair("p2", (base / "extraido").string()));
+    REQUIRE(ler(base / "extraido") == "p2 v2");
+
+    // Nada mais a recuperar
+    REQUIRE(compactar_pacotes((base / "pen").string()) == 0);
+}
+
+TEST_CASE("Caso 31 compressão zstd no destino", "[C31]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_31";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    std::string texto;
+    for (int i = 0; texto.size() < 300000; ++i)
+        texto += "linha " + std::to_string(i % 977) + " do relatorio\n";
+    std::string aleatorio(300000, '\0');
+    uint32_t x = 12345;
+    for (char &c : aleatorio) {
+        x = x * 1664525 + 1013904223;
+        c = static_cast<char>(x >> 24);
+    }
+    std::ofstream(base / "hd" / "texto", std::ios::binary) << texto;
+    std::ofstream(base / "hd" / "aleatorio", std::ios::binary) << aleatorio;
+    std::ofstream(base / "hd" / "vazio");
+    fs::permissions(base / "hd" / "texto", fs::perms::owner_read |
+                    fs::perms::owner_write | fs::perms::group_read);
+
+    // Sem a libzstd, tudo é copiado sem compressão
+    ResultadoCompressao rc;
+    EstrategiaCopia e = comprimir_arquivo((base / "hd" / "texto").string(),
+        (base / "texto.z").string(), 3, 2, &rc);
+    if (!zstd_disponivel()) {
+        REQUIRE(e != COPIA_FALHOU);
+        REQUIRE_FALSE(rc.comprimido);
+        REQUIRE(ler(base / "texto.z") == texto);
+        return;
+    }
+    REQUIRE(e == COPIA_COMPRIMIDA);
+    REQUIRE(rc.comprimido);
+    REQUIRE(rc.bytesOrigem == texto.size());
+    REQUIRE(rc.bytesGravados == fs::file_size(base / "texto.z"));
+    REQUIRE(rc.bytesGravados < texto.size() / 4);
+    REQUIRE(arquivo_comprimido((base / "texto.z").string()));
+    REQUIRE(descomprimir_arquivo((base / "texto.z").string(),
+        (base / "texto.d").string(), &rc) == COPIA_DESCOMPRIMIDA);
+    REQUIRE(ler(base / "texto.d") == texto);
+    REQUIRE(fs::status(base / "texto.d").permissions() ==
+            fs::status(base / "hd" / "texto").permissions());
+
+    // Dados que não comprimem são copiados como estão
+    REQUIRE(comprimir_arquivo((base / "hd" / "aleatorio").string(),
+        (base / "aleatorio.z").string(), 3, 2, &rc) != COPIA_FALHOU);
+    REQUIRE_FALSE(rc.comprimido);
+    REQUIRE_FALSE(arquivo_comprimido((base / "aleatorio.z").string()));
+    REQUIRE(ler(base / "aleatorio.z") == aleatorio);
+
+    // Um arquivo comprimido truncado não substitui o destino
+    fs::resize_file(base / "texto.z", fs::file_size(base / "texto.z") - 8);
+    REQUIRE(descomprimir_arquivo((base / "texto.z").string(),
+        (base / "texto.d").string(), &rc) == COPIA_FALHOU);
+    REQUIRE(ler(base / "texto.d") == texto);
+    REQUIRE_FALSE(fs::exists(base / "texto.d.parcial"));
+
+    // Backup comprimido no Pen e restauração descomprimindo
+    std::ofstream(base / "Backup.parm") << "texto\naleatorio\nvazio\n";
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.comprimir = true;
+    opcoes.verificarConteudo = true;
+    opcoes.estatisticas = &est;
+    auto resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "pen").string(), true, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.arquivosComprimidos == 1);
+    REQUIRE(est.arquivosIncomprimiveis == 2);
+    REQUIRE(est.bytesOrigemComprimidos == texto.size() + aleatorio.size());
+    REQUIRE(est.bytesComprimidosGravados <
+            texto.size() / 4 + aleatorio.size());
+    REQUIRE(est.bytesCopiados == texto.size() + aleatorio.size());
+    REQUIRE(est.mbPorSegundo > 0);
+    REQUIRE(arquivo_comprimido((base / "pen" / "texto").string()));
+
+    // A verificação confere o comprimido pelo tamanho original e pelo
+    // digest registrado na cópia, sem descomprimir
+    resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "pen").string(), true, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A4_NADA);
+    REQUIRE(est.arquivosComprimidos == 0);
+
+    for (const char *n : {"texto", "aleatorio", "vazio"})
+        fs::remove(base / "hd" / n);
+    opcoes.comprimir = false;
+    resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "hd").string(), false, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A2_COPIAR_PEN_HD);
+    REQUIRE(est.arquivosDescomprimidos == 1);
+    REQUIRE(ler(base / "hd" / "texto") == texto);
+    REQUIRE(ler(base / "hd" / "aleatorio") == aleatorio);
+    REQUIRE(fs::file_size(base / "hd" / "vazio") == 0);
+
+    // Sem a marca no Pen, o cabeçalho não é lido e a cópia é a comum
+    REQUIRE(fs::remove(base / "pen" / ".backup_transformados"));
+    fs::remove(base / "hd" / "texto");
+    resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "hd").string(), false, opcoes);
+    REQUIRE(resultado[0].second == A2_COPIAR_PEN_HD);
+    REQUIRE(est.arquivosDescomprimidos == 0);
+    REQUIRE(arquivo_comprimido((base / "hd" / "texto").string()));
+}
+
+TEST_CASE("Caso 32 cifra autenticada em blocos", "[C32]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_32";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    std::string dados(10 * 1048576 + 123, '\0');
+    for (size_t i = 0; i < dados.size(); ++i)
+        dados[i] = static_cast<char>(i * 31 + (i >> 16));
+    std::ofstream(base / "hd" / "grande", std::ios::binary) << dados;
+    std::ofstream(base / "hd" / "pequeno") << "segredo";
+    std::ofstream(base / "hd" / "vazio");
+    const std::string chave(kTamanhoChaveCifra, 'k');
+    const std::string outra(kTamanhoChaveCifra, 'x');
+
+    // Os dois algoritmos, com e sem o pool, ida e volta
+    PoolTarefas pool(3);
+    for (AlgoritmoCifra a : {CIFRA_AES_256_GCM, CIFRA_CHACHA20_POLY1305}) {
+        for (PoolTarefas *p : {static_cast<PoolTarefas *>(nullptr), &pool}) {
+            REQUIRE(cifrar_arquivo((base / "hd" / "grande").string(),
+                (base / "c").string(), chave, a, p) == COPIA_CIFRADA);
+            REQUIRE(arquivo_cifrado((base / "c").string()));
+            std::string cifrado = ler(base / "c");
+            REQUIRE(cifrado.size() == 32 + 11 * 16 + dados.size());
+            REQUIRE(cifrado.find(dados.substr(0, 64)) == std::string::npos);
+            REQUIRE(decifrar_arquivo((base / "c").string(),
+                (base / "d").string(), chave, p) == COPIA_DECIFRADA);
+            REQUIRE(ler(base / "d") == dados);
+        }
+    }
+    REQUIRE(cifrar_arquivo((base / "hd" / "vazio").string(),
+        (base / "cv").string(), chave, algoritmo_preferido()) ==
+        COPIA_CIFRADA);
+    REQUIRE(decifrar_arquivo((base / "cv").string(),
+        (base / "dv").string(), chave) == COPIA_DECIFRADA);
+    REQUIRE(fs::file_size(base / "dv") == 0);
+
+    // Chave errada, bloco alterado ou arquivo truncado: nada é gravado
+    std::ofstream(base / "d") << "anterior";
+    REQUIRE(decifrar_arquivo((base / "c").string(), (base / "d").string(),
+                             outra, &pool) == COPIA_FALHOU);
+    {
+        std::fstream f(base / "c", std::ios::in | std::ios::out |
+                       std::ios::binary);
+        f.seekp(5 * 1048576);
+        f.put('\x7f');
+    }
+    REQUIRE(decifrar_arquivo((base / "c").string(), (base / "d").string(),
+                             chave, &pool) == COPIA_FALHOU);
+    fs::resize_file(base / "cv", fs::file_size(base / "cv") - 1);
+    REQUIRE(decifrar_arquivo((base / "cv").string(), (base / "d").string(),
+                             chave) == COPIA_FALHOU);
+    REQUIRE(ler(base / "d") == "anterior");
+    REQUIRE_FALSE(fs::exists(base / "d.parcial"));
+
+    // Backup cifrado no Pen, inclusive os pequenos com empacotamento
+    // pedido, e restauração decifrando
+    std::ofstream(base / "Backup.parm") << "grande\npequeno\nvazio\n";
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.chaveCifra = chave;
+    opcoes.empacotarAte = 1000;
+    opcoes.verificarConteudo = true;
+    opcoes.estatisticas = &est;
+    auto resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "pen").string(), true, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.arquivosCifrados == 3);
+    REQUIRE(est.bytesCifrados == dados.size() + 7);
+    REQUIRE(est.arquivosEmpacotados == 0);
+    REQUIRE(ler(base / "pen" / "pequeno").find("segredo") ==
+            std::string::npos);
+
+    // Verificados pelo digest registrado na cópia: nada a refazer
+    resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "pen").string(), true, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A4_NADA);
+    REQUIRE(est.arquivosCifrados == 0);
+    REQUIRE(est.arquivosHasheados == 0);
+    REQUIRE(est.digestsReaproveitados == 6);
+
+    for (const char *n : {"grande", "pequeno", "vazio"})
+        fs::remove(base / "hd" / n);
+    resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "hd").string(), false, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A2_COPIAR_PEN_HD);
+    REQUIRE(est.arquivosDecifrados == 3);
+    REQUIRE(ler(base / "hd" / "grande") == dados);
+    REQUIRE(ler(base / "hd" / "pequeno") == "segredo");
+}
+
+TEST_CASE("Caso 33 backup para vários destinos", "[C33]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_33";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen1");
+    fs::create_directories(base / "pen2");
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    std::string dados(3 * 1048576 + 77, '\0');
+    for (size_t i = 0; i < dados.size(); ++i)
+        dados[i] = static_cast<char>(i * 7 + (i >> 12));
+    std::ofstream(base / "hd" / "a", std::ios::binary) << dados;
+    std::ofstream(base / "hd" / "b") << "hd b";
+    std::ofstream(base / "hd" / "c") << "hd c";
+    auto agora = fs::file_time_type::clock::now();
+    for (const char *nome : {"a", "b", "c"})
+        fs::last_write_time(base / "hd" / nome, agora - std::chrono::hours(1));
+
+    // pen2: b mais novo que o HD (A5) e c igual ao do HD (A4)
+    std::ofstream(base / "pen2" / "b") << "pen b";
+    fs::last_write_time(base / "pen2" / "b", agora);
+    fs::copy_file(base / "hd" / "c", base / "pen2" / "c");
+    fs::last_write_time(base / "pen2" / "c",
+                        fs::last_write_time(base / "hd" / "c"));
+
+    // Uma leitura, vários destinos; o destino que é a própria origem é
+    // recusado sem ser truncado. Cada destino é gravado em um temporário
+    // renomeado no fim: o link de x1 continua com o conteúdo antigo, e x3,
+    // cujo temporário não pode ser criado, falha sem perder o anterior
+    std::ofstream(base / "x1") << "x1 antigo";
+    fs::create_hard_link(base / "x1", base / "x1_link");
+    std::ofstream(base / "x3") << "x3 antigo";
+    fs::create_directory(base / "x3.parcial");
+    PoolTarefas pool(2);
+    std::vector<bool> copiados;
+    REQUIRE(copiar_para_varios((base / "hd" / "a").string(),
+        {(base / "x1").string(), (base / "hd" / "a").string(),
+         (base / "x2").string(), (base / "x3").string()}, &pool,
+        &copiados) == COPIA_MULTIPLA);
+    REQUIRE(copiados == std::vector<bool>{true, false, true, false});
+    REQUIRE(ler(base / "x1") == dados);
+    REQUIRE(ler(base / "x1_link") == "x1 antigo");
+    REQUIRE(ler(base / "x2") == dados);
+    REQUIRE(ler(base / "x3") == "x3 antigo");
+    REQUIRE(ler(base / "hd" / "a") == dados);
+    REQUIRE_FALSE(fs::exists(base / "x1.parcial"));
+    REQUIRE_FALSE(fs::exists(base / "x2.parcial"));
+    REQUIRE_FALSE(fs::exists(base / "hd" / "a.parcial"));
+
+    // Sem pool (como nas tarefas de executar_backup_multiplo)
+    copiados.clear();
+    REQUIRE(copiar_para_varios((base / "hd" / "a").string(),
+        {(base / "x4").string(), (base / "x5").string()}, nullptr,
+        &copiados) == COPIA_MULTIPLA);
+    REQUIRE(copiados == std::vector<bool>{true, true});
+    REQUIRE(ler(base / "x4") == dados);
+    REQUIRE(ler(base / "x5") == dados);
+
+    std::ofstream(base / "Backup.parm") << "a\nb\nc\n";
+    std::vector<DestinoBackup> destinos = {
+        {(base / "pen1").string(), (base / "pen1").string()},
+        {(base / "pen2").string(), (base / "pen2").string()}};
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.numThreads = 2;
+    opcoes.estatisticas = &est;
+    auto resultados = executar_backup_multiplo(
+        (base / "Backup.parm").string(), (base / "hd").string(), destinos,
+        opcoes);
+    REQUIRE(resultados.size() == 2);
+    using Resultado = std::vector<std::pair<std::string, int>>;
+    REQUIRE(resultados[0] == Resultado{{"a", A1_COPIAR_HD_PEN},
+        {"b", A1_COPIAR_HD_PEN}, {"c", A1_COPIAR_HD_PEN}});
+    REQUIRE(resultados[1] == Resultado{{"a", A1_COPIAR_HD_PEN},
+        {"b", A5_ERRO}, {"c", A4_NADA}});
+    REQUIRE(ler(base / "pen1" / "a") == dados);
+    REQUIRE(ler(base / "pen2" / "a") == dados);
+    REQUIRE(ler(base / "pen1" / "b") == "hd b");
+    REQUIRE(ler(base / "pen2" / "b") == "pen b");
+
+    // "a" foi lido uma vez e gravado nos dois destinos
+    REQUIRE(est.entradas == 3);
+    REQUIRE(est.chamadasMetadados == 3 + 3 * 2);
+    REQUIRE(est.bytesCopiados == dados.size() + 8);
+    REQUIRE(est.bytesGravadosDestinos == 2 * dados.size() + 8);
+    size_t multiplas = 0;
+    for (const auto &e : est.estrategias)
+        if (e.first == "a" && e.second == COPIA_MULTIPLA)
+            ++multiplas;
+    REQUIRE(multiplas == 2);
+    REQUIRE(est.estrategias.size() == 4);
+
+    // Cada destino anota as suas cópias à parte: com vários trabalhadores
+    // gravando nos dois ao mesmo tempo, nenhuma se perde
+    {
+        std::ofstream parm(base / "Backup_muitos.parm");
+        for (int i = 0; i < 300; ++i) {
+            std::string nome = "m" + std::to_string(i);
+            std::ofstream(base / "hd" / nome) << nome;
+            parm << nome << "\n";
+        }
+    }
+    std::vector<DestinoBackup> novos = {
+        {(base / "pen3").string(), (base / "pen3").string()},
+        {(base / "pen4").string(), (base / "pen4").string()}};
+    fs::create_directories(base / "pen3");
+    fs::create_directories(base / "pen4");
+    opcoes.numThreads = 4;
+    executar_backup_multiplo((base / "Backup_muitos.parm").string(),
+        (base / "hd").string(), novos, opcoes);
+    REQUIRE(est.estrategias.size() == 2 * 300);
+
+    // Linha repetida: as repetições são tratadas depois das outras, uma a
+    // uma, e veem o que a anterior gravou, como a execução seguinte
+    std::ofstream(base / "Backup_um.parm") << "a\n";
+    {
+        std::ofstream parm(base / "Backup_repetido.parm");
+        for (int i = 0; i < 40; ++i)
+            parm << "a\nb\n";
+    }
+    executar_backup_multiplo((base / "Backup_um.parm").string(),
+        (base / "hd").string(), novos, opcoes);
+    auto seguinte = executar_backup_multiplo(
+        (base / "Backup_um.parm").string(), (base / "hd").string(), novos,
+        opcoes);
+    fs::remove(base / "pen3" / "a");
+    fs::remove(base / "pen4" / "a");
+    auto repetido = executar_backup_multiplo(
+        (base / "Backup_repetido.parm").string(), (base / "hd").string(),
+        novos, opcoes);
+    for (size_t i = 0; i < 2; ++i) {
+        REQUIRE(repetido[i].size() == 80);
+        REQUIRE(repetido[i][0].second == A1_COPIAR_HD_PEN);
+        int iguais = 0;
+        for (size_t k = 2; k < repetido[i].size(); k += 2)
+            iguais += repetido[i][k].second == seguinte[i][0].second;
+        REQUIRE(iguais == 39);
+    }
+    REQUIRE(ler(base / "pen3" / "a") == dados);
+    REQUIRE(ler(base / "pen4" / "a") == dados);
+    REQUIRE_FALSE(fs::exists(base / "pen3" / "a.parcial"));
+    opcoes.numThreads = 2;
+
+    // Sem o Backup.parm, A6 para cada destino
+    auto sem = executar_backup_multiplo((base / "nao_existe").string(),
+        (base / "hd").string(), destinos, opcoes);
+    REQUIRE(sem.size() == 2);
+    REQUIRE(sem[1] == Resultado{{"Backup.parm", A6_IMPOSSIVEL}});
+
+    fs::remove_all(base);
+}
+
+TEST_CASE("Caso 34 pool de buffers com limite de memória", "[C34]") {
+    namespace fs = std::filesystem;
+
+    // Blocos alinhados e reaproveitados pela mesma thread
+    PoolBuffers pool(64 * 1024, 4 * 64 * 1024, false);
+    {
+        BlocoBuffer b = pool.obter();
+        REQUIRE(b);
+        REQUIRE(b.tamanho() == 64 * 1024);
+        REQUIRE(reinterpret_cast<uintptr_t>(b.dados()) % 4096 == 0);
+        std::memset(b.dados(), 1, b.tamanho());
+    }
+    {
+        BlocoBuffer b = pool.obter(1000);
+        REQUIRE(b.tamanho() == 64 * 1024);
+    }
+    EstatisticasBuffers e = pool.estatisticas();
+    REQUIRE(e.pedidos == 2);
+    REQUIRE(e.alocacoes == 1);
+    REQUIRE(e.acertosCache == 1);
+    REQUIRE(e.bytesEmUso == 0);
+
+    // No limite, a thread que já tem buffers recebe excedentes, e um
+    // pedido maior que o bloco também
+    {
+        std::vector<BlocoBuffer> tidos;
+        for (int i = 0; i < 5; ++i)
+            tidos.push_back(pool.obter());
+        BlocoBuffer grande = pool.obter(100 * 1024);
+        REQUIRE(grande.tamanho() >= 100 * 1024);
+        e = pool.estatisticas();
+        REQUIRE(e.blocosReservados == 4);
+        REQUIRE(e.excedentes == 2);
+        REQUIRE(e.bytesEmUso == 5 * 64 * 1024 + grande.tamanho());
+        REQUIRE(e.picoBytesEmUso == e.bytesEmUso);
+
+        // Uma thread sem buffers espera até que um seja devolvido
+        std::atomic<bool> obteve{false};
+        std::thread outra([&pool, &obteve] {
+            BlocoBuffer b = pool.obter();
+            obteve = b.dados() != nullptr;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        REQUIRE_FALSE(obteve);
+        tidos.clear();
+        outra.join();
+        REQUIRE(obteve);
+        REQUIRE(pool.estatisticas().esperas == 1);
+    }
+    e = pool.estatisticas();
+    REQUIRE(e.bytesEmUso == 0);
+    REQUIRE(e.blocosReservados == 4);
+    pool.reiniciar_pico();
+    REQUIRE(pool.estatisticas().picoBytesEmUso == 0);
+
+    // Muitas threads ao mesmo tempo não passam do limite sem excedentes
+    {
+        PoolBuffers disputado(4096, 8 * 4096, false);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&disputado] {
+                for (int i = 0; i < 500; ++i) {
+                    BlocoBuffer b = disputado.obter();
+                    b.dados()[0] = static_cast<char>(i);
+                }
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+        e = disputado.estatisticas();
+        REQUIRE(e.pedidos == 4000);
+        REQUIRE(e.excedentes == 0);
+        REQUIRE(e.blocosReservados <= 8);
+        REQUIRE(e.picoBytesEmUso <= 8 * 4096);
+        REQUIRE(e.taxaAcerto > 0.9);
+    }
+
+    // As cópias do backup usam o pool global: a cifra pega dois buffers
+    // por arquivo e os devolve
+    fs::path base = fs::path("tests") / "tmp_case_34";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+    for (int i = 0; i < 20; ++i)
+        std::ofstream(base / "hd" / ("f" + std::to_string(i))) << i;
+    std::ofstream parm(base / "Backup.parm");
+    for (int i = 0; i < 20; ++i)
+        parm << "f" << i << '\n';
+    parm.close();
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.numThreads = 2;
+    opcoes.chaveCifra = std::string(kTamanhoChaveCifra, 'k');
+    opcoes.estatisticas = &est;
+    executar_backup((base / "Backup.parm").string(), (base / "hd").string(),
+                    (base / "pen").string(), (base / "pen").string(), true,
+                    opcoes);
+    REQUIRE(est.arquivosCifrados == 20);
+    REQUIRE(est.pedidosBuffers == 40);
+    // Com dois trabalhadores e o chamador, no máximo seis em uso
+    REQUIRE(est.acertosBuffers >= 40 - 6);
+    REQUIRE(est.taxaAcertoBuffers > 0.8);
+    REQUIRE(est.picoBytesBuffers <= 6 * PoolBuffers::global().tamanhoBloco());
+    REQUIRE(PoolBuffers::global().estatisticas().bytesEmUso == 0);
+
+    fs::remove_all(base);
+}
+
+TEST_CASE("Caso 35 cópia sem cache de páginas (O_DIRECT)", "[C35]") {
+    namespace fs = std::filesystem;
+
+    fs::path base = fs::path("tests") / "tmp_case_35";
+    fs::remove_all(base);
+    fs::create_directories(base / "hd");
+    fs::create_directories(base / "pen");
+
+    auto ler = [](const fs::path &p) {
+        std::ifstream in(p, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    };
+    // Páginas do arquivo presentes no cache de páginas
+    auto paginas_no_cache = [](const fs::path &p) {
+        int fd = open(p.c_str(), O_RDONLY | O_CLOEXEC);
+        size_t tamanho = fs::file_size(p), pagina = sysconf(_SC_PAGESIZE);
+        size_t n = 0;
+        void *m = tamanho ? mmap(nullptr, tamanho, PROT_READ, MAP_SHARED,
+                                 fd, 0) : MAP_FAILED;
+        if (m != MAP_FAILED) {
+            std::vector<unsigned char> v((tamanho + pagina - 1) / pagina);
+            mincore(m, tamanho, v.data());
+            for (unsigned char c : v)
+                n += c & 1;
+            munmap(m, tamanho);
+        }
+        close(fd);
+        return n;
+    };
+
+    // Só o resto, só a parte alinhada, as duas, vazio e vários blocos
+    const size_t tamanhos[] = {0, 100, 3 * 4096, 1048576 + 1234,
+                               3 * 1048576 + 7};
+    for (size_t tamanho : tamanhos) {
+        std::string dados(tamanho, '\0');
+        for (size_t i = 0; i < tamanho; ++i)
+            dados[i] = static_cast<char>(i * 13 + tamanho);
+        fs::path origem = base / "hd" / ("a" + std::to_string(tamanho));
+        fs::path destino = base / "pen" / origem.filename();
+        std::ofstream(origem, std::ios::binary) << dados;
+        fs::permissions(origem, fs::perms::owner_read |
+                        fs::perms::owner_write | fs::perms::group_read);
+        std::ofstream(destino) << "conteudo anterior, mais longo que 100";
+        EstrategiaCopia e = copiar_arquivo_direto(origem.string(),
+                                                  destino.string());
+        INFO("tamanho " << tamanho);
+        REQUIRE((e == COPIA_DIRETA || e == COPIA_LEITURA_ESCRITA));
+        if (tamanho < 512)
+            REQUIRE(e == COPIA_LEITURA_ESCRITA);
+        // Nada do destino fica no cache, pelo O_DIRECT ou pelo descarte
+        REQUIRE(paginas_no_cache(destino) == 0);
+        REQUIRE(ler(destino) == dados);
+        REQUIRE(fs::status(destino).permissions() ==
+                fs::status(origem).permissions());
+    }
+    fs::path mesmo = base / "hd" / "a100";
+    REQUIRE(copiar_arquivo_direto(mesmo.string(), mesmo.string()) ==
+            COPIA_FALHOU);
+    REQUIRE(fs::file_size(mesmo) == 100);
+    REQUIRE(copiar_arquivo_direto((base / "hd").string(),
+                                  (base / "x").string()) == COPIA_FALHOU);
+
+    // No backup, as cópias comuns usam o modo, também com o pool e
+    // arquivos grandes (que deixam de ser copiados em partes)
+    fs::remove_all(base / "pen");
+    fs::create_directories(base / "pen");
+    std::ofstream parm(base / "Backup.parm");
+    for (size_t tamanho : tamanhos)
+        parm << "a" << tamanho << '\n';
+    parm.close();
+    OpcoesBackup opcoes;
+    EstatisticasBackup est;
+    opcoes.semCachePaginas = true;
+    opcoes.limiteArquivoGrande = 1048576;
+    opcoes.tamanhoParteCopia = 65536;
+    opcoes.estatisticas = &est;
+    auto resultado = executar_backup((base / "Backup.parm").string(),
+        (base / "hd").string(), (base / "pen").string(),
+        (base / "pen").string(), true, opcoes);
+    for (const auto &r : resultado)
+        REQUIRE(r.second == A1_COPIAR_HD_PEN);
+    REQUIRE(est.copiasGrandes == 0);
+    REQUIRE(est.estrategias.size() == 5);
+    for (const auto &e : est.estrategias)
+        REQUIRE((e.second == COPIA_DIRETA ||
+                 e.second == COPIA_LEITURA_ESCRITA));
+    for (size_t tamanho : tamanhos) {
+        std::string nome = "a" + std::to_string(tamanho);
+        REQUIRE(ler(base / "pen" / nome) == ler(base / "hd" / nome));
+    }
+
+    fs::remove_all(base);
+}
+
 /********************************************************************
 * Função: executar_backup
 * Descrição